@@ -2,28 +2,62 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 
+#include <chrono>
+#include <string>
+#include <random>
 #include <vector>
+#include <map>
+#include <cstring>
 #include <iostream>
+#include <filesystem>
+#include <algorithm>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <glm/gtc/packing.hpp>
+
 #include "sources/graphics/vao.h"
 #include "sources/graphics/vbo.h"
 #include "sources/graphics/ibo.h"
 #include "sources/graphics/shader.h"
 #include "sources/graphics/texture.h"
+#include "sources/graphics/materiallibrary.h"
+#include "sources/graphics/textureloader.h"
 #include "sources/graphics/cubemap.h"
 #include "sources/graphics/framebuffer.h"
+#include "sources/graphics/gbuffer.h"
+#include "sources/graphics/pbo.h"
+#include "sources/graphics/ubo.h"
+#include "sources/graphics/ssbo.h"
+#include "sources/graphics/uniformblocks.h"
+#include "sources/graphics/clusteredlighting.h"
+#include "sources/graphics/objectculling.h"
+#include "sources/graphics/iblbaker.h"
+#include "sources/graphics/ggxsampletable.h"
+#include "sources/graphics/iblcache.h"
+#include "sources/graphics/iblupdatescheduler.h"
+#include "sources/graphics/reflectionprobes.h"
 
 #include "sources/utils/camera.h"
 #include "sources/utils/debug.h"
+#include "sources/utils/threadpool.h"
+#include "sources/utils/imagewriter.h"
+#include "sources/utils/bcencoder.h"
+#include "sources/utils/dds.h"
+#include "sources/utils/radiancehdr.h"
+#include "sources/utils/filewatcher.h"
+#include "sources/utils/profiler.h"
+#include "sources/utils/benchmark.h"
+#include "sources/utils/offscreencontext.h"
 
 // Global variables.
 int   WINDOW_WIDTH        = 1280;
 int   WINDOW_HEIGHT       = 720;
 float WINDOW_ASPECT_RATIO = (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT;
 float FIELD_OF_VIEW       = 45.0f;
+float NEAR_PLANE          = 0.1f;
+float FAR_PLANE           = 100.0f;
 float DELTA_TIME          = 0.0f;
 float LAST_FRAME          = 0.0f;
 float CAMERA_SPEED        = 7.5f;
@@ -32,8 +66,16 @@ float CURSOR_POS_X        = (float)WINDOW_WIDTH / 2.0f;
 float CURSOR_POS_Y        = (float)WINDOW_HEIGHT / 2.0f;
 bool  CURSOR_ATTACHED     = false;
 
+const int CONTEXT_MAJOR_VERSION = 4; // OpenGL core profile of the window and of the windowless context alike.
+const int CONTEXT_MINOR_VERSION = 5;
+
+bool        HEADLESS         = false; // Render offscreen and dump the frames instead of opening a window.
+int         HEADLESS_FRAMES  = 1;
+std::string MATERIAL_NAME    = "rusted_iron";
+std::string OUTPUT_DIRECTORY = "output";
+
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-glm::mat4 projectionMatrix = glm::perspective(glm::radians(FIELD_OF_VIEW), WINDOW_ASPECT_RATIO, 0.1f, 100.0f);
+glm::mat4 projectionMatrix = glm::perspective(glm::radians(FIELD_OF_VIEW), WINDOW_ASPECT_RATIO, NEAR_PLANE, FAR_PLANE);
 
 ShaderProgram* pbrShader;
 ShaderProgram* equirectangularToCubemapShader;
@@ -41,6 +83,45 @@ ShaderProgram* environmentShader;
 ShaderProgram* irradianceShader;
 ShaderProgram* prefilterShader;
 ShaderProgram* brdfShader;
+ShaderProgram* equirectangularToCubemapComputeShader;
+ShaderProgram* irradianceComputeShader;
+ShaderProgram* prefilterComputeShader;
+ShaderProgram* brdfComputeShader;
+ShaderProgram* depthPrepassShader;
+ShaderProgram* gBufferShader;
+ShaderProgram* deferredLightingShader;
+ShaderProgram* reflectionProbeCaptureShader;
+
+// Every permutation of the PBR programs (forward, G-buffer, deferred lighting and probe capture) built so far, by files and defines (see "createPBRShader").
+std::map<std::string, ShaderProgram*> pbrShaderPermutations;
+
+bool IBL_ENABLED             = true; // Ambient light from the IBL maps, a constant term otherwise.
+bool SHADER_BINARY_CACHE     = true; // Load the linked programs from "resources/cache/shaders" when they are there.
+bool PARALLEL_SHADER_COMPILE = true; // Let the driver compile the programs concurrently ("KHR_parallel_shader_compile").
+bool SHADER_HOT_RELOAD       = true; // Rebuild the programs whose files change under "sources/shaders", with a window only.
+
+bool DEPTH_PREPASS           = false; // Lay the depth of the spheres first, so the PBR shader runs once per pixel ("GL_EQUAL", no depth writes).
+bool DEPTH_PREPASS_BENCHMARK = false; // Count the fragment shader invocations and time the frame with and without the prepass, then exit.
+
+bool DEFERRED_SHADING           = false; // Fill a G-buffer with the spheres, then light it in a full-screen pass. Toggled with "G" in the window.
+bool DEFERRED_SHADING_BENCHMARK = false; // Time the forward and deferred paths over grid sizes and light counts, then exit.
+
+ReflectionProbes* reflectionProbes; // Only with "--reflection-probes" or "--benchmark".
+
+bool REFLECTION_PROBES        = false; // Specular ambient light from local probes between the spheres, over the prefilter map.
+int  PROBE_CAPTURES_PER_FRAME = 1;     // Probes captured and prefiltered per frame at most, the nearest first.
+int  REFLECTION_PROBE_SIZE    = 128;
+int  MAX_REFLECTION_PROBES    = 16;    // Cubemaps of the probe atlas.
+
+GBuffer* gBuffer;
+
+FileWatcher* shaderWatcher;
+
+std::string PROFILE_OUTPUT; // Chrome trace written at exit by "--profile", the profiler staying disabled without it.
+
+glm::vec3 CONSTANT_ALBEDO    = glm::vec3(0.5f, 0.0f, 0.0f); // Material of "--material none", without any map.
+float     CONSTANT_METALLIC  = 0.0f;
+float     CONSTANT_ROUGHNESS = 0.5f;
 
 VAO* sphereVAO;
 VBO* sphereVBO;
@@ -48,22 +129,50 @@ IBO* sphereIBO;
 
 unsigned int sphereIndexCount = 0;
 
+// Per-instance attributes of the sphere VAO (locations 3 to 10 of "2_pbr_texturized_vs.glsl").
+struct SphereInstance
+{
+	glm::mat4 model;
+	glm::vec4 normalMatrix[3]; // Columns, w unused.
+	glm::vec4 material;        // x = metallic, y = roughness, negative to sample the material maps. zw unused.
+};
+
+VBO* sphereInstanceVBO;
+
+// Same mesh, the per-instance attributes reading the instances left by the object culling.
+VAO* culledSphereVAO;
+
+ObjectCulling* objectCulling;
+
+bool OBJECT_CULLING    = true; // Frustum and Hi-Z occlusion culling of the instanced spheres, drawn with an indirect call.
+bool OCCLUSION_CULLING = true; // Test the spheres left by the frustum test against the depth of the previous frame.
+
+int  sphereInstanceCount  = 0;
+int  SPHERE_GRID_SIZE     = 1;     // Spheres per row and column, metallic increasing along the rows and roughness along the columns.
+bool INSTANCED_RENDERING  = true;  // One "glDrawElementsInstanced" for the whole grid instead of a draw call per sphere.
+bool INSTANCING_BENCHMARK = false; // Time both paths with 10x10, 50x50 and 100x100 grids, then exit.
+
 VAO* cubeVAO;
 VBO* cubeVBO;
 
 VAO* quadVAO;
 VBO* quadVBO;
 
-Texture* albedoTex;
-Texture* normalTex;
-Texture* metallicTex;
-Texture* roughnessTex;
-Texture* aoTex;
+MaterialLibrary* materialLibrary;
+TextureLoader*   textureLoader;
+
+int  MATERIAL_TEXTURE_SIZE = 1024; // Size every material map is resampled to, to share the texture arrays.
+bool PACKED_ORM            = true; // Occlusion, roughness and metallic packed in a single ORM array, fetched once.
+
 Texture* equirectangularHDRTex;
 Texture* brdfLUTTex;
 
 FrameBuffer* captureFB;
 
+// Target of every frame in the offscreen modes, a windowless context having no default framebuffer.
+Texture*     offscreenTex;
+FrameBuffer* offscreenFB;
+
 int CAPTURE_FB_WIDTH  = 512;
 int CAPTURE_FB_HEIGHT = 512;
 
@@ -71,6 +180,26 @@ CubeMap* environmentCM;
 CubeMap* irradianceCM;
 CubeMap* prefilterCM;
 
+SH9 irradianceSH;
+
+IBLBakeParameters IBL_PARAMETERS;
+
+GGXSampleTable* prefilterSampleTable; // Samples of the current parameters, uploaded to "prefilterSampleBuffer".
+SSBO*           prefilterSampleBuffer;
+
+bool  CPU_IBL_BAKE       = true;  // Bake the IBL maps on the CPU thread pool instead of the GPU.
+bool  COMPUTE_IBL_BAKE   = true;  // On the GPU, one compute dispatch per stage (per mip level for the prefilter) instead of the capture passes.
+bool  IBL_BAKE_BENCHMARK = false; // Time every GPU stage rasterized and in compute, then exit.
+bool  COMPRESSED_IBL     = false; // Use the BC6H maps written by "--compress-textures" for the HDR, environment and prefilter maps.
+bool  COMPRESS_TEXTURES  = false; // Encode every texture to a block-compressed DDS file, then exit.
+bool  VALIDATE_IBL_BAKE  = false; // Also run the GPU passes and compare both results.
+float IBL_BAKE_TOLERANCE = 0.05f;
+
+IBLUpdateScheduler* iblUpdateScheduler; // Rebakes the maps over several frames when the environment is swapped (key E).
+
+std::string ENVIRONMENT_FILEPATH = "resources/textures/environment/equirectangular_map.hdr"; // HDR of the maps in use, or of the ones being rebaked.
+float       IBL_UPDATE_BUDGET    = 1.0f; // GPU milliseconds per frame given to the rebake.
+
 glm::mat4 envProjectionMatrix = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
 glm::mat4 envViewMatrices[] = {
 	glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
@@ -95,6 +224,26 @@ glm::vec3 lightColors[] = {
 	glm::vec3(300.0f, 300.0f, 300.0f)
 };
 
+// Per-frame data shared by every program through uniform blocks, see "uniformblocks.h".
+UBO* cameraUBO;
+UBO* lightUBO;
+
+CameraData cameraData;
+LightData  lightData;
+
+ClusteredLighting* clusteredLighting;
+
+int  NUMBER_OF_LIGHTS        = 4;     // The four lights above, more are scattered randomly around the sphere.
+bool CPU_LIGHT_CULLING       = false; // Bin the lights on the thread pool instead of the compute shader.
+bool LIGHT_CULLING_BENCHMARK = false; // Time the light culling and the frame for 4 to 4096 lights, then exit.
+
+std::string BENCHMARK_OUTPUT;       // Report of "--benchmark", which renders fixed scenes offscreen along a fixed camera path, then exits.
+int         BENCHMARK_FRAMES = 120; // Frames per scene.
+
+std::string HDR_DECODE_BENCHMARK; // HDR decoded by "stbi_loadf" and "RadianceHDR" with "--benchmark-hdr-decode", then exit.
+
+BenchmarkReport* benchmarkReport; // Only with "--benchmark", filled by the setup and "runBenchmark".
+
 // GLFW window callbacks.
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 void keyboardCallback(GLFWwindow* window, int key, int scanCode, int action, int mods);
@@ -102,445 +251,2863 @@ void cursorPositionCallback(GLFWwindow* window, double xPos, double yPos);
 void scrollCallback(GLFWwindow* window, double xOffset, double yOffset);
 void processInput(GLFWwindow* window);
 
-void setupApplication()
+std::vector<PointLight> createLights(int numberOfLights)
 {
-	const unsigned int X_SEGMENTS = 64;
-	const unsigned int Y_SEGMENTS = 64;
-	const float PI = 3.14159265359f;
-
-	std::vector<glm::vec3> positions;
-	std::vector<glm::vec3> normals;
-	std::vector<glm::vec2> uvs;
-	std::vector<float> sphereVertices;
-	std::vector<unsigned int> sphereIndices;
+	std::vector<PointLight> lights;
 
-	for (unsigned int x = 0; x <= X_SEGMENTS; ++x)
+	for (int n = 0; n < numberOfLights && n < 4; ++n)
 	{
-		for (unsigned int y = 0; y <= Y_SEGMENTS; ++y)
-		{
-			float xSegment = (float)x / (float)X_SEGMENTS;
-			float ySegment = (float)y / (float)Y_SEGMENTS;
-			float xPos = std::cos(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
-			float yPos = std::cos(ySegment * PI);
-			float zPos = std::sin(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
-
-			positions.push_back(glm::vec3(xPos, yPos, zPos));
-			normals.push_back(glm::vec3(xPos, yPos, zPos));
-			uvs.push_back(glm::vec2(xSegment, ySegment));
-		}
+		lights.push_back({ glm::vec4(lightPositions[n], ClusteredLighting::computeLightRadius(lightColors[n])), glm::vec4(lightColors[n], 1.0f) });
 	}
 
-	for (unsigned int y = 0; y < Y_SEGMENTS; ++y)
+	// Fixed seed, so every run (and every benchmark) sees the same lights.
+	std::mt19937 generator(1337);
+	std::uniform_real_distribution<float> position(-8.0f, 8.0f);
+	std::uniform_real_distribution<float> hue(0.2f, 1.0f);
+
+	// The total power stays close to the one of the four default lights.
+	float intensity = 4.0f * 300.0f / std::max(numberOfLights, 4);
+
+	for (int n = 4; n < numberOfLights; ++n)
 	{
-		if (y % 2 == 0) // Even rows.
-		{
-			for (int x = 0; x <= X_SEGMENTS; ++x)
-			{
-				sphereIndices.push_back((y) * (X_SEGMENTS + 1) + x);
-				sphereIndices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
-			}
-		}
-		else // Odd rows.
-		{
-			for (int x = X_SEGMENTS; x >= 0; --x)
-			{
-				sphereIndices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
-				sphereIndices.push_back((y) * (X_SEGMENTS + 1) + x);
-			}
-		}
+		glm::vec3 color = glm::vec3(hue(generator), hue(generator), hue(generator)) * intensity;
+
+		lights.push_back({ glm::vec4(position(generator), position(generator), position(generator), ClusteredLighting::computeLightRadius(color)), glm::vec4(color, 1.0f) });
 	}
 
-	sphereIndexCount = static_cast<unsigned int>(sphereIndices.size());
+	return lights;
+}
 
-	for (unsigned int i = 0; i < positions.size(); ++i)
+// Points locations 3 to 10 of the bound VAO at the "SphereInstance" array of the bound vertex buffer. A matrix takes one location per column.
+void setSphereInstanceAttributes(VAO* vao)
+{
+	for (int column = 0; column < 4; ++column)
 	{
-		sphereVertices.push_back(positions[i].x);
-		sphereVertices.push_back(positions[i].y);
-		sphereVertices.push_back(positions[i].z);
-
-		if (normals.size() > 0)
-		{
-			sphereVertices.push_back(normals[i].x);
-			sphereVertices.push_back(normals[i].y);
-			sphereVertices.push_back(normals[i].z);
-		}
+		vao->setVertexAttribute(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance), (void*)(offsetof(SphereInstance, model) + column * sizeof(glm::vec4)), 1);
+	}
 
-		if (uvs.size() > 0)
-		{
-			sphereVertices.push_back(uvs[i].x);
-			sphereVertices.push_back(uvs[i].y);
-		}
+	for (int column = 0; column < 3; ++column)
+	{
+		vao->setVertexAttribute(7 + column, 3, GL_FLOAT, GL_FALSE, sizeof(SphereInstance), (void*)(offsetof(SphereInstance, normalMatrix) + column * sizeof(glm::vec4)), 1);
 	}
 
-	float cubeVertices[] = {
-		// back face
-		-1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
-		 1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
-		 1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right
-		 1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
-		-1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
-		-1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
-		// front face
-		-1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
-		 1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
-		 1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
-		 1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
-		-1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
-		-1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
-		// left face
-		-1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
-		-1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
-		-1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
-		-1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
-		-1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
-		-1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
-		// right face
-		 1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
-		 1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
-		 1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
-		 1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
-		 1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
-		 1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-		 // bottom face
-		-1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
-		 1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
-		 1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
-		 1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
-		-1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
-		-1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
-		 // top face
-		-1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
-		 1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-		 1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right
-		 1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-		-1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
-		-1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f  // bottom-left
-	};
+	vao->setVertexAttribute(10, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance), (void*)(offsetof(SphereInstance, material)), 1);
+}
 
-	float quadVertices[] = {
-		// positions        // texture coords
-		-1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
-		-1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
-		 1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
-		 1.0f, -1.0f, 0.0f, 1.0f, 0.0f
-	};
+// Probes in the gaps of the grid, each one covering a block of spheres (at most 4x4 probes), its parallax box around
+// the block. A single sphere has none, a probe inside it would see nothing else.
+std::vector<ReflectionProbes::Probe> createReflectionProbes(int gridSize)
+{
+	std::vector<ReflectionProbes::Probe> probes;
 
-	pbrShader = new ShaderProgram("sources/shaders/2_pbr_texturized_vs.glsl", "sources/shaders/2_pbr_texturized_fs.glsl");
-	equirectangularToCubemapShader = new ShaderProgram("sources/shaders/3_equirectangular2cubemap_vs.glsl", "sources/shaders/3_equirectangular2cubemap_fs.glsl");
-	environmentShader = new ShaderProgram("sources/shaders/3_environment_vs.glsl", "sources/shaders/3_environment_fs.glsl");
-	irradianceShader = new ShaderProgram("sources/shaders/3_irradiance_convolution_vs.glsl", "sources/shaders/3_irradiance_convolution_fs.glsl");
-	prefilterShader = new ShaderProgram("sources/shaders/4_prefilter_convolution_vs.glsl", "sources/shaders/4_prefilter_convolution_fs.glsl");
-	brdfShader = new ShaderProgram("sources/shaders/4_brdf_vs.glsl", "sources/shaders/4_brdf_fs.glsl");
+	if (gridSize <= 1)
+	{
+		return probes;
+	}
 
-	pbrShader->bind();
-	pbrShader->setUniform1i("uAlbedoMap", 0);
-	pbrShader->setUniform1i("uNormalMap", 1);
-	pbrShader->setUniform1i("uMetallicMap", 2);
-	pbrShader->setUniform1i("uRoughnessMap", 3);
-	pbrShader->setUniform1i("uAOMap", 4);
-	pbrShader->setUniform1i("uIrradianceMap", 5);
-	pbrShader->setUniform1i("uPrefilterMap", 6);
-	pbrShader->setUniform1i("uBRDFLUTMap", 7);
-	pbrShader->unbind();
+	float spacing = 2.5f;
+	int probesPerAxis = std::min((gridSize + 2) / 3, 4);
+	float blockSize = gridSize * spacing / probesPerAxis;
+	float gridStart = -gridSize * spacing / 2.0f;
 
-	equirectangularToCubemapShader->bind();
-	equirectangularToCubemapShader->setUniform1i("uEquirectangularMap", 0);
-	equirectangularToCubemapShader->setUniformMatrix4fv("uProjection", envProjectionMatrix);
-	equirectangularToCubemapShader->unbind();
+	for (int y = 0; y < probesPerAxis; ++y)
+	{
+		for (int x = 0; x < probesPerAxis; ++x)
+		{
+			glm::vec3 boxMin(gridStart + x * blockSize, gridStart + y * blockSize, -spacing);
+			glm::vec3 boxMax = boxMin + glm::vec3(blockSize, blockSize, 2.0f * spacing);
 
-	environmentShader->bind();
-	environmentShader->setUniform1i("uEnvironmentMap", 0);
-	environmentShader->unbind();
+			// Snapped to the nearest gap between four spheres, the sphere centers being half a spacing off the gaps.
+			glm::vec2 center = (glm::vec2(boxMin) + glm::vec2(boxMax)) / 2.0f;
+			glm::vec2 gap = glm::round((center - gridStart) / spacing) * spacing + gridStart;
 
-	irradianceShader->bind();
-	irradianceShader->setUniform1i("uEnvironmentMap", 0);
-	irradianceShader->setUniformMatrix4fv("uProjection", envProjectionMatrix);
-	irradianceShader->unbind();
+			probes.push_back({ glm::vec3(gap, 0.0f), blockSize, boxMin, boxMax });
+		}
+	}
 
-	prefilterShader->bind();
-	prefilterShader->setUniform1i("uEnvironmentMap", 0);
-	prefilterShader->setUniformMatrix4fv("uProjection", envProjectionMatrix);
-	prefilterShader->unbind();
+	return probes;
+}
 
-	albedoTex = new Texture("resources/textures/rusted_iron/albedo.png");
-	normalTex = new Texture("resources/textures/rusted_iron/normal.png");
-	metallicTex = new Texture("resources/textures/rusted_iron/metallic.png");
-	roughnessTex = new Texture("resources/textures/rusted_iron/roughness.png");
-	aoTex = new Texture("resources/textures/rusted_iron/ao.png");
+void createSphereGrid(int gridSize)
+{
+	std::vector<SphereInstance> instances;
 
-	sphereVAO = new VAO();
-	sphereVBO = new VBO(&sphereVertices[0], sphereVertices.size() * sizeof(float));
-	sphereIBO = new IBO(&sphereIndices[0], sphereIndices.size() * sizeof(unsigned int));
+	// With "--material all" every sphere picks the next material and keeps its maps, "--material none" uses none.
+	bool allMaterials = MATERIAL_NAME == "all";
+	int numberOfMaterials = std::max(materialLibrary->getNumberOfMaterials(), 1);
+	int materialLayer = allMaterials || MATERIAL_NAME == "none" ? 0 : materialLibrary->getMaterialIndex(MATERIAL_NAME);
 
-	sphereVAO->bind();
-	sphereVBO->bind();
-	sphereIBO->bind();
+	if (materialLayer < 0)
+	{
+		std::cout << "[ERROR] PROGRAM: Unknown material \"" << MATERIAL_NAME << "\"." << std::endl;
 
-	sphereVAO->setVertexAttribute(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(0));
-	sphereVAO->setVertexAttribute(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	sphereVAO->setVertexAttribute(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+		materialLayer = 0;
+	}
 
-	sphereVAO->unbind();
-	sphereVBO->unbind();
-	sphereIBO->unbind();
+	// A single sphere keeps the material maps, a grid overrides metallic and roughness like the README screenshots.
+	if (gridSize <= 1)
+	{
+		instances.push_back({ glm::mat4(1.0f), { glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.0f), glm::vec4(0.0f, 0.0f, 1.0f, 0.0f) }, glm::vec4(-1.0f, -1.0f, float(materialLayer), 0.0f) });
+	}
+	else
+	{
+		float spacing = 2.5f;
 
-	cubeVAO = new VAO();
-	cubeVBO = new VBO(cubeVertices, sizeof(cubeVertices));
+		for (int row = 0; row < gridSize; ++row)
+		{
+			for (int column = 0; column < gridSize; ++column)
+			{
+				glm::vec3 position((column - (gridSize - 1) / 2.0f) * spacing, (row - (gridSize - 1) / 2.0f) * spacing, 0.0f);
+				glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), position);
+				glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(modelMatrix)));
 
-	cubeVAO->bind();
-	cubeVBO->bind();
+				float metallic = allMaterials ? -1.0f : float(row) / float(gridSize - 1);
+				float roughness = allMaterials ? -1.0f : glm::clamp(float(column) / float(gridSize - 1), 0.05f, 1.0f);
+				float layer = float(allMaterials ? (row * gridSize + column) % numberOfMaterials : materialLayer);
 
-	cubeVAO->setVertexAttribute(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(0));
-	cubeVAO->setVertexAttribute(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	cubeVAO->setVertexAttribute(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+				instances.push_back({ modelMatrix, { glm::vec4(normalMatrix[0], 0.0f), glm::vec4(normalMatrix[1], 0.0f), glm::vec4(normalMatrix[2], 0.0f) }, glm::vec4(metallic, roughness, layer, 0.0f) });
+			}
+		}
+	}
 
-	cubeVAO->unbind();
-	cubeVBO->unbind();
+	sphereInstanceVBO->setData(instances.data(), static_cast<int>(instances.size() * sizeof(SphereInstance)));
+	sphereInstanceCount = static_cast<int>(instances.size());
 
-	quadVAO = new VAO();
-	quadVBO = new VBO(quadVertices, sizeof(quadVertices));
+	// Unit spheres, only translated.
+	std::vector<glm::vec4> boundingSpheres;
 
-	quadVAO->bind();
-	quadVBO->bind();
+	for (const SphereInstance& instance : instances)
+	{
+		boundingSpheres.push_back(glm::vec4(glm::vec3(instance.model[3]), 1.0f));
+	}
 
-	quadVAO->setVertexAttribute(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(0));
-	quadVAO->setVertexAttribute(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+	objectCulling->setObjects(boundingSpheres, instances.data(), sizeof(SphereInstance));
 
-	quadVAO->unbind();
-	quadVBO->unbind();
+	if (reflectionProbes)
+	{
+		reflectionProbes->setProbes(createReflectionProbes(gridSize));
+	}
+}
 
-	equirectangularHDRTex = new Texture("resources/textures/environment/equirectangular_map.hdr", true);
-	brdfLUTTex = new Texture(512, 512, GL_RG16F, GL_RG, GL_FLOAT);
+void frameSphereGrid(int gridSize)
+{
+	// Far enough to see the whole grid, with the far plane pushed behind it.
+	float distance = std::max(gridSize * 2.5f * 1.25f, 3.0f);
 
-	captureFB = new FrameBuffer(CAPTURE_FB_WIDTH, CAPTURE_FB_HEIGHT);
+	camera = Camera(glm::vec3(0.0f, 0.0f, distance), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 
-	environmentCM = new CubeMap(512, 512, GL_RGB16F, GL_RGB, GL_FLOAT);
-	irradianceCM = new CubeMap(32, 32, GL_RGB16F, GL_RGB, GL_FLOAT);
-	prefilterCM = new CubeMap(128, 128, GL_RGB16F, GL_RGB, GL_FLOAT, true);
+	FAR_PLANE = std::max(100.0f, distance * 2.0f);
+	projectionMatrix = glm::perspective(glm::radians(FIELD_OF_VIEW), WINDOW_ASPECT_RATIO, NEAR_PLANE, FAR_PLANE);
+}
 
-	// Convert the HDR equirectangular environment map to a cubemap.
+void loadEquirectangularHDR()
+{
+	if (!equirectangularHDRTex)
 	{
-		equirectangularToCubemapShader->bind();
-		captureFB->bind();
-		cubeVAO->bind();
-		equirectangularHDRTex->bind(0);
+		DDSImage equirectangularDDS;
+		std::string ddsFilepath = std::filesystem::path(ENVIRONMENT_FILEPATH).replace_extension(".dds").generic_string();
 
-		glViewport(0, 0, 512, 512);
-
-		for (unsigned int i = 0; i < 6; ++i)
+		if (COMPRESSED_IBL && std::filesystem::exists(ddsFilepath) && DDS::load(ddsFilepath, equirectangularDDS))
 		{
-			equirectangularToCubemapShader->setUniformMatrix4fv("uView", envViewMatrices[i]);
-			captureFB->bindColorBufferToFrameBuffer(environmentCM->getID(), 0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
-
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+			equirectangularHDRTex = new Texture(equirectangularDDS);
+		}
+		else
+		{
+			equirectangularHDRTex = new Texture(ENVIRONMENT_FILEPATH.c_str(), true);
 		}
-
-		equirectangularHDRTex->unbind();
-		cubeVAO->unbind();
-		captureFB->unbind();
-		equirectangularToCubemapShader->unbind();
 	}
+}
 
-	// Solve diffuse integral by convolution to create an irradiance (cube)map.
-	{
-		irradianceShader->bind();
-		captureFB->bind();
-		cubeVAO->bind();
-		environmentCM->bind(0);
+// Only the environment bake samples the HDR, it's loaded again by the next one.
+void freeEquirectangularHDR()
+{
+	delete equirectangularHDRTex;
 
-		// No need to resize the framebuffer's depth buffer.
+	equirectangularHDRTex = nullptr;
+}
 
-		glViewport(0, 0, 32, 32);
+// Convert the HDR equirectangular environment map to a cubemap.
+void bakeEnvironmentOnGPU()
+{
+	PROFILE_CPU("IBL environment (GPU bake)");
+	PROFILE_GPU("IBL environment");
 
-		for (unsigned int i = 0; i < 6; ++i)
-		{
-			irradianceShader->setUniformMatrix4fv("uView", envViewMatrices[i]);
-			captureFB->bindColorBufferToFrameBuffer(irradianceCM->getID(), 0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
+	loadEquirectangularHDR();
 
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	equirectangularToCubemapShader->bind();
+	captureFB->bind();
+	cubeVAO->bind();
+	equirectangularHDRTex->bind(0);
 
-			glDrawArrays(GL_TRIANGLES, 0, 36);
-		}
+	captureFB->resizeDepthBuffer(IBL_PARAMETERS.environmentSize, IBL_PARAMETERS.environmentSize);
 
-		environmentCM->unbind();
-		cubeVAO->unbind();
-		captureFB->unbind();
-		irradianceShader->unbind();
-	}
+	glViewport(0, 0, IBL_PARAMETERS.environmentSize, IBL_PARAMETERS.environmentSize);
 
-	// Run a quasi monte-carlo simulation on the environment lighting to create a prefilter (cube)map.
+	for (unsigned int i = 0; i < 6; ++i)
 	{
-		prefilterShader->bind();
-		captureFB->bind();
-		cubeVAO->bind();
-		environmentCM->bind(0);
+		equirectangularToCubemapShader->setUniformMatrix4fv("uView", envViewMatrices[i]);
+		captureFB->bindColorBufferToFrameBuffer(environmentCM->getID(), 0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
 
-		unsigned int maxMipLevels = 5;
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
-		{
-			float roughness = (float)mip / (float)(maxMipLevels - 1);
-			unsigned int mipWidth = static_cast<unsigned int>(128 * std::pow(0.5, mip));
-			unsigned int mipHeight = static_cast<unsigned int>(128 * std::pow(0.5, mip));
+		glDrawArrays(GL_TRIANGLES, 0, 36);
+	}
+
+	equirectangularHDRTex->unbind();
+	cubeVAO->unbind();
+	captureFB->unbind();
+	equirectangularToCubemapShader->unbind();
+
+	environmentCM->generateMipMaps();
+}
+
+// Solve diffuse integral by convolution to create an irradiance (cube)map.
+void bakeIrradianceOnGPU()
+{
+	PROFILE_CPU("IBL irradiance (GPU bake)");
+	PROFILE_GPU("IBL irradiance");
+
+	irradianceShader->bind();
+	captureFB->bind();
+	cubeVAO->bind();
+	environmentCM->bind(0);
+
+	// No need to resize the framebuffer's depth buffer.
+
+	glViewport(0, 0, IBL_PARAMETERS.irradianceSize, IBL_PARAMETERS.irradianceSize);
+
+	for (unsigned int i = 0; i < 6; ++i)
+	{
+		irradianceShader->setUniformMatrix4fv("uView", envViewMatrices[i]);
+		captureFB->bindColorBufferToFrameBuffer(irradianceCM->getID(), 0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		glDrawArrays(GL_TRIANGLES, 0, 36);
+	}
+
+	environmentCM->unbind();
+	cubeVAO->unbind();
+	captureFB->unbind();
+	irradianceShader->unbind();
+}
+
+// Generates the prefilter samples of the current parameters and uploads them for the GPU passes.
+void updatePrefilterSampleTable()
+{
+	delete prefilterSampleTable;
+
+	prefilterSampleTable = new GGXSampleTable(IBL_PARAMETERS.prefilterMipLevels, IBL_PARAMETERS.sampleCount, IBL_PARAMETERS.environmentSize, IBL_PARAMETERS.adaptiveSampleCount);
+
+	const std::vector<glm::vec4>& samples = prefilterSampleTable->getSamples();
+	int size = static_cast<int>(samples.size() * sizeof(glm::vec4));
+
+	if (!prefilterSampleBuffer)
+	{
+		prefilterSampleBuffer = new SSBO(size, samples.data(), GL_STATIC_DRAW);
+	}
+	else
+	{
+		prefilterSampleBuffer->setData(size, samples.data());
+	}
+}
+
+// Run a quasi monte-carlo simulation on the environment lighting to create a prefilter (cube)map.
+void bakePrefilterOnGPU()
+{
+	PROFILE_CPU("IBL prefilter (GPU bake)");
+	PROFILE_GPU("IBL prefilter");
+
+	prefilterShader->bind();
+	captureFB->bind();
+	cubeVAO->bind();
+	environmentCM->bind(0);
+	prefilterSampleBuffer->bindBase(PREFILTER_SAMPLE_BUFFER_BINDING);
+
+	unsigned int maxMipLevels = IBL_PARAMETERS.prefilterMipLevels;
+
+	for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
+	{
+		const GGXSampleTable::Level& level = prefilterSampleTable->getLevel(mip);
+		unsigned int mipWidth = static_cast<unsigned int>(IBL_PARAMETERS.prefilterSize * std::pow(0.5, mip));
+		unsigned int mipHeight = static_cast<unsigned int>(IBL_PARAMETERS.prefilterSize * std::pow(0.5, mip));
+
+		prefilterShader->setUniform1i("uFirstSample", level.firstSample);
+		prefilterShader->setUniform1i("uSampleCount", level.sampleCount);
+		prefilterShader->setUniform1f("uInverseTotalWeight", level.inverseTotalWeight);
+		captureFB->resizeDepthBuffer(mipWidth, mipHeight);
+
+		glViewport(0, 0, mipWidth, mipHeight);
+
+		for (unsigned int i = 0; i < 6; ++i)
+		{
+			prefilterShader->setUniformMatrix4fv("uView", envViewMatrices[i]);
+			captureFB->bindColorBufferToFrameBuffer(prefilterCM->getID(), 0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, mip);
+			
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			glDrawArrays(GL_TRIANGLES, 0, 36);
+		}
+	}
+
+	environmentCM->unbind();
+	cubeVAO->unbind();
+	captureFB->unbind();
+	prefilterShader->unbind();
+}
+
+// Generate a 2D LUT from the BRDF equations used.
+void bakeBRDFLUTOnGPU()
+{
+	PROFILE_CPU("IBL BRDF LUT (GPU bake)");
+	PROFILE_GPU("IBL BRDF LUT");
+
+	brdfShader->bind();
+	captureFB->bind();
+	quadVAO->bind();
+	brdfLUTTex->bind(0);
+
+	captureFB->resizeDepthBuffer(IBL_PARAMETERS.brdfLUTSize, IBL_PARAMETERS.brdfLUTSize);
+	captureFB->bindColorBufferToFrameBuffer(brdfLUTTex->getID(), 0, GL_TEXTURE_2D);
+
+	glViewport(0, 0, IBL_PARAMETERS.brdfLUTSize, IBL_PARAMETERS.brdfLUTSize);
+
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	brdfLUTTex->unbind();
+	quadVAO->unbind();
+	captureFB->unbind();
+	brdfShader->unbind();
+}
+
+// Work groups of 8x8 texels over a face, the six faces along z.
+int getBakeGroupCount(int size)
+{
+	return (size + 7) / 8;
+}
+
+// Same stages as the capture passes above, written with "imageStore" to every face of the level at once: no
+// framebuffer, depth buffer nor cube geometry. The sampling reads of the next stage wait for the stores.
+void bakeEnvironmentWithCompute()
+{
+	PROFILE_CPU("IBL environment (compute bake)");
+	PROFILE_GPU("IBL environment (compute)");
+
+	loadEquirectangularHDR();
+
+	equirectangularToCubemapComputeShader->bind();
+	equirectangularHDRTex->bind(0);
+
+	glBindImageTexture(0, environmentCM->getID(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+	int groups = getBakeGroupCount(IBL_PARAMETERS.environmentSize);
+
+	glDispatchCompute(groups, groups, 6);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+	equirectangularHDRTex->unbind();
+	equirectangularToCubemapComputeShader->unbind();
+
+	environmentCM->generateMipMaps();
+}
+
+void bakeIrradianceWithCompute()
+{
+	PROFILE_CPU("IBL irradiance (compute bake)");
+	PROFILE_GPU("IBL irradiance (compute)");
+
+	irradianceComputeShader->bind();
+	irradianceComputeShader->setUniform1f("uSampleDelta", IBL_PARAMETERS.sampleDelta);
+	environmentCM->bind(0);
+
+	glBindImageTexture(0, irradianceCM->getID(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+	int groups = getBakeGroupCount(IBL_PARAMETERS.irradianceSize);
+
+	glDispatchCompute(groups, groups, 6);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+	environmentCM->unbind();
+	irradianceComputeShader->unbind();
+}
+
+void bakePrefilterWithCompute()
+{
+	PROFILE_CPU("IBL prefilter (compute bake)");
+	PROFILE_GPU("IBL prefilter (compute)");
+
+	prefilterComputeShader->bind();
+	environmentCM->bind(0);
+	prefilterSampleBuffer->bindBase(PREFILTER_SAMPLE_BUFFER_BINDING);
+
+	int maxMipLevels = IBL_PARAMETERS.prefilterMipLevels;
+
+	for (int mip = 0; mip < maxMipLevels; ++mip)
+	{
+		const GGXSampleTable::Level& level = prefilterSampleTable->getLevel(mip);
+		int groups = getBakeGroupCount(std::max(IBL_PARAMETERS.prefilterSize >> mip, 1));
+
+		prefilterComputeShader->setUniform1i("uFirstSample", level.firstSample);
+		prefilterComputeShader->setUniform1i("uSampleCount", level.sampleCount);
+		prefilterComputeShader->setUniform1f("uInverseTotalWeight", level.inverseTotalWeight);
+
+		glBindImageTexture(0, prefilterCM->getID(), mip, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+		glDispatchCompute(groups, groups, 6);
+	}
+
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+	environmentCM->unbind();
+	prefilterComputeShader->unbind();
+}
+
+void bakeBRDFLUTWithCompute()
+{
+	PROFILE_CPU("IBL BRDF LUT (compute bake)");
+	PROFILE_GPU("IBL BRDF LUT (compute)");
+
+	brdfComputeShader->bind();
+	brdfComputeShader->setUniform1i("uSampleCount", static_cast<int>(IBL_PARAMETERS.sampleCount));
+
+	glBindImageTexture(0, brdfLUTTex->getID(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG16F);
+
+	int groups = getBakeGroupCount(IBL_PARAMETERS.brdfLUTSize);
+
+	glDispatchCompute(groups, groups, 1);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+	brdfComputeShader->unbind();
+}
+
+// Runs a GPU bake stage, timed up to its completion when benchmarking.
+void runGPUBakeStage(const char* name, void (*stage)())
+{
+	if (!benchmarkReport)
+	{
+		stage();
+
+		return;
+	}
+
+	glFinish();
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	stage();
+
+	glFinish();
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+	benchmarkReport->addValue("ibl_bake_ms", std::string(COMPUTE_IBL_BAKE ? "GPU compute " : "GPU raster ") + name, elapsed.count());
+}
+
+// False if the HDR couldn't be loaded, the maps being left as they were.
+bool bakeIBLOnGPU()
+{
+	loadEquirectangularHDR();
+
+	if (equirectangularHDRTex->getWidth() == 0)
+	{
+		freeEquirectangularHDR();
+
+		return false;
+	}
+
+	runGPUBakeStage("Equirectangular to cubemap", COMPUTE_IBL_BAKE ? bakeEnvironmentWithCompute : bakeEnvironmentOnGPU);
+
+	if (!IBL_PARAMETERS.irradianceSH)
+	{
+		runGPUBakeStage("Irradiance convolution", COMPUTE_IBL_BAKE ? bakeIrradianceWithCompute : bakeIrradianceOnGPU);
+	}
+
+	runGPUBakeStage("Prefilter convolution", COMPUTE_IBL_BAKE ? bakePrefilterWithCompute : bakePrefilterOnGPU);
+	runGPUBakeStage("BRDF LUT integration", COMPUTE_IBL_BAKE ? bakeBRDFLUTWithCompute : bakeBRDFLUTOnGPU);
+
+	// The SH9 projection is a single reduction over the HDR, cheaper on the CPU than any capture pass. It reads
+	// back the texture the environment stage sampled instead of decoding the file a second time.
+	//
+	if (IBL_PARAMETERS.irradianceSH)
+	{
+		PROFILE_CPU("IBL irradiance SH (CPU projection)");
+
+		HDRImage equirectangularMap = { equirectangularHDRTex->getWidth(), equirectangularHDRTex->getHeight(), {} };
+
+		equirectangularMap.pixels.resize(static_cast<size_t>(equirectangularMap.width) * equirectangularMap.height * 3);
+		equirectangularHDRTex->getData(GL_RGB, GL_FLOAT, equirectangularMap.pixels.data());
+
+		irradianceSH = SphericalHarmonics::projectIrradiance(equirectangularMap, ThreadPool::getInstance());
+	}
+
+	freeEquirectangularHDR();
+
+	return true;
+}
+
+// False if the HDR couldn't be loaded, the maps being left as they were.
+bool bakeIBLOnCPU()
+{
+	IBLBaker baker(ThreadPool::getInstance());
+
+	if (!baker.loadEquirectangularMap(ENVIRONMENT_FILEPATH.c_str()))
+	{
+		return false;
+	}
+
+	{
+		PROFILE_CPU("IBL environment (CPU bake)");
+
+		baker.bakeEnvironment(IBL_PARAMETERS.environmentSize);
+	}
+
+	if (IBL_PARAMETERS.irradianceSH)
+	{
+		PROFILE_CPU("IBL irradiance SH (CPU bake)");
+
+		baker.bakeIrradianceSH();
+
+		irradianceSH = baker.getIrradianceSH();
+	}
+	else
+	{
+		PROFILE_CPU("IBL irradiance (CPU bake)");
+
+		baker.bakeIrradiance(IBL_PARAMETERS.irradianceSize, IBL_PARAMETERS.sampleDelta);
+	}
+
+	{
+		PROFILE_CPU("IBL prefilter (CPU bake)");
+
+		baker.bakePrefilter(IBL_PARAMETERS.prefilterSize, *prefilterSampleTable);
+	}
+
+	{
+		PROFILE_CPU("IBL BRDF LUT (CPU bake)");
+
+		baker.bakeBRDFLUT(IBL_PARAMETERS.brdfLUTSize, IBL_PARAMETERS.sampleCount);
+	}
+
+	if (VALIDATE_IBL_BAKE && bakeIBLOnGPU())
+	{
+		if (!baker.validate(environmentCM, irradianceCM, prefilterCM, brdfLUTTex, IBL_BAKE_TOLERANCE))
+		{
+			std::cout << "[ERROR] IBL BAKER: CPU bake differs from the GPU bake above the tolerance." << std::endl;
+		}
+	}
+
+	{
+		PROFILE_CPU("IBL upload");
+
+		baker.upload(environmentCM, irradianceCM, prefilterCM, brdfLUTTex);
+	}
+
+	baker.printTimings();
+
+	if (benchmarkReport)
+	{
+		for (const IBLBaker::StageTiming& timing : baker.getTimings())
+		{
+			benchmarkReport->addValue("ibl_bake_ms", "CPU " + timing.name, timing.milliseconds);
+		}
+	}
+
+	return true;
+}
+
+// Permutation of a PBR program matching the current options, created on first use and built in the background
+// (see "ShaderProgram::submitPending"). Its uniforms are set by "setPBRUniforms", which waits for the build.
+// With a geometry shader, the program is the layered capture of the reflection probes (PROBE_CAPTURE), which doesn't sample them.
+ShaderProgram* createPBRShader(int numberOfLights, const char* vsFilepath = "sources/shaders/2_pbr_texturized_vs.glsl", const char* fsFilepath = "sources/shaders/2_pbr_texturized_fs.glsl",
+	const char* gsFilepath = nullptr)
+{
+	bool materialMaps = MATERIAL_NAME != "none";
+	int maxLightsPerCluster = std::min(numberOfLights, clusteredLighting->getMaxLightsPerCluster());
+
+	ShaderProgram::Defines defines = { "MAX_LIGHTS_PER_CLUSTER " + std::to_string(maxLightsPerCluster) };
+
+	if (materialMaps)
+	{
+		defines.push_back("MATERIAL_MAPS");
+
+		if (PACKED_ORM)
+		{
+			defines.push_back("PACKED_ORM");
+		}
+	}
+
+	if (IBL_ENABLED)
+	{
+		defines.push_back("IBL");
+
+		if (IBL_PARAMETERS.irradianceSH)
+		{
+			defines.push_back("IRRADIANCE_SH");
+		}
+
+		if (gsFilepath)
+		{
+			defines.push_back("PROBE_CAPTURE");
+		}
+		else if (REFLECTION_PROBES)
+		{
+			defines.push_back("REFLECTION_PROBES");
+		}
+	}
+
+	std::string key = std::string(vsFilepath) + ";" + (gsFilepath ? std::string(gsFilepath) + ";" : "") + fsFilepath + ";";
+
+	for (const std::string& define : defines)
+	{
+		key += define + ";";
+	}
+
+	auto iterator = pbrShaderPermutations.find(key);
+
+	if (iterator != pbrShaderPermutations.end())
+	{
+		return iterator->second;
+	}
+
+	ShaderProgram* shader = gsFilepath ? new ShaderProgram(vsFilepath, gsFilepath, fsFilepath, defines) : new ShaderProgram(vsFilepath, fsFilepath, defines);
+
+	pbrShaderPermutations[key] = shader;
+
+	return shader;
+}
+
+// Only the uniforms the permutation declares are set, the ones compiled out are skipped by the preprocessor instead of optimized away.
+// The G-buffer program has no lighting uniforms and the deferred lighting one no material uniforms.
+void setPBRUniforms(ShaderProgram* shader, bool materialUniforms = true, bool lightingUniforms = true)
+{
+	bool materialMaps = MATERIAL_NAME != "none";
+
+	shader->bind();
+
+	if (materialUniforms)
+	{
+		if (materialMaps)
+		{
+			// Bound on consecutive units by "MaterialLibrary::bind", the ORM maps taking the place of the metallic maps.
+			shader->setUniform1i("uAlbedoMaps", 0);
+			shader->setUniform1i("uNormalMaps", 1);
+
+			if (PACKED_ORM)
+			{
+				shader->setUniform1i("uORMMaps", 2);
+			}
+			else
+			{
+				shader->setUniform1i("uMetallicMaps", 2);
+				shader->setUniform1i("uRoughnessMaps", 3);
+				shader->setUniform1i("uAOMaps", 4);
+			}
+		}
+		else
+		{
+			shader->setUniform3f("uAlbedo", CONSTANT_ALBEDO);
+			shader->setUniform1f("uMetallic", CONSTANT_METALLIC);
+			shader->setUniform1f("uRoughness", CONSTANT_ROUGHNESS);
+		}
+	}
+
+	if (IBL_ENABLED && lightingUniforms)
+	{
+		if (IBL_PARAMETERS.irradianceSH)
+		{
+			Uniform<glm::vec3> irradianceSHUniform = shader->getUniform<glm::vec3>("uIrradianceSH");
+
+			for (int i = 0; i < 9; ++i)
+			{
+				irradianceSHUniform.set(i, irradianceSH.coefficients[i]);
+			}
+		}
+		else
+		{
+			shader->setUniform1i("uIrradianceMap", 5);
+		}
+
+		shader->setUniform1i("uPrefilterMap", 6);
+		shader->setUniform1i("uBRDFLUTMap", 7);
+	}
+
+	shader->unbind();
+}
+
+// Forward program and both deferred programs for "numberOfLights", so either path can be switched to at any frame,
+// and the probe capture when the probes are used.
+void createPBRShaders(int numberOfLights)
+{
+	pbrShader = createPBRShader(numberOfLights);
+	gBufferShader = createPBRShader(numberOfLights, "sources/shaders/2_pbr_texturized_vs.glsl", "sources/shaders/2_pbr_gbuffer_fs.glsl");
+	deferredLightingShader = createPBRShader(numberOfLights, "sources/shaders/2_deferred_lighting_vs.glsl", "sources/shaders/2_deferred_lighting_fs.glsl");
+
+	reflectionProbeCaptureShader = REFLECTION_PROBES && IBL_ENABLED ? createPBRShader(numberOfLights, "sources/shaders/7_reflection_probe_capture_vs.glsl",
+		"sources/shaders/7_reflection_probe_capture_fs.glsl", "sources/shaders/7_reflection_probe_capture_gs.glsl") : nullptr;
+}
+
+void setPBRShaderUniforms()
+{
+	setPBRUniforms(pbrShader);
+	setPBRUniforms(gBufferShader, true, false);
+	setPBRUniforms(deferredLightingShader, false, true);
+
+	// Bound by "GBuffer::bindTextures", the IBL maps staying on units 5 to 7.
+	deferredLightingShader->bind();
+	deferredLightingShader->setUniform1i("uGBufferAlbedo", 0);
+	deferredLightingShader->setUniform1i("uGBufferORM", 1);
+	deferredLightingShader->setUniform1i("uGBufferNormal", 2);
+	deferredLightingShader->setUniform1i("uGBufferDepth", 3);
+	deferredLightingShader->unbind();
+
+	// The probe atlas after the IBL maps.
+	if (reflectionProbeCaptureShader)
+	{
+		setPBRUniforms(reflectionProbeCaptureShader);
+
+		for (ShaderProgram* shader : { pbrShader, deferredLightingShader })
+		{
+			shader->bind();
+			shader->setUniform1i("uReflectionProbeMaps", 8);
+			shader->unbind();
+		}
+	}
+}
+
+void setupApplication()
+{
+	PROFILE_CPU("Setup");
+
+	auto setupStart = std::chrono::high_resolution_clock::now();
+
+	const unsigned int X_SEGMENTS = 64;
+	const unsigned int Y_SEGMENTS = 64;
+	const float PI = 3.14159265359f;
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> uvs;
+	std::vector<float> sphereVertices;
+	std::vector<unsigned int> sphereIndices;
+
+	for (unsigned int x = 0; x <= X_SEGMENTS; ++x)
+	{
+		for (unsigned int y = 0; y <= Y_SEGMENTS; ++y)
+		{
+			float xSegment = (float)x / (float)X_SEGMENTS;
+			float ySegment = (float)y / (float)Y_SEGMENTS;
+			float xPos = std::cos(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
+			float yPos = std::cos(ySegment * PI);
+			float zPos = std::sin(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
+
+			positions.push_back(glm::vec3(xPos, yPos, zPos));
+			normals.push_back(glm::vec3(xPos, yPos, zPos));
+			uvs.push_back(glm::vec2(xSegment, ySegment));
+		}
+	}
+
+	for (unsigned int y = 0; y < Y_SEGMENTS; ++y)
+	{
+		if (y % 2 == 0) // Even rows.
+		{
+			for (int x = 0; x <= X_SEGMENTS; ++x)
+			{
+				sphereIndices.push_back((y) * (X_SEGMENTS + 1) + x);
+				sphereIndices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
+			}
+		}
+		else // Odd rows.
+		{
+			for (int x = X_SEGMENTS; x >= 0; --x)
+			{
+				sphereIndices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
+				sphereIndices.push_back((y) * (X_SEGMENTS + 1) + x);
+			}
+		}
+	}
+
+	sphereIndexCount = static_cast<unsigned int>(sphereIndices.size());
+
+	for (unsigned int i = 0; i < positions.size(); ++i)
+	{
+		sphereVertices.push_back(positions[i].x);
+		sphereVertices.push_back(positions[i].y);
+		sphereVertices.push_back(positions[i].z);
+
+		if (normals.size() > 0)
+		{
+			sphereVertices.push_back(normals[i].x);
+			sphereVertices.push_back(normals[i].y);
+			sphereVertices.push_back(normals[i].z);
+		}
+
+		if (uvs.size() > 0)
+		{
+			sphereVertices.push_back(uvs[i].x);
+			sphereVertices.push_back(uvs[i].y);
+		}
+	}
+
+	float cubeVertices[] = {
+		// back face
+		-1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+		 1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+		 1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right
+		 1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+		-1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+		-1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
+		// front face
+		-1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+		 1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
+		 1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+		 1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+		-1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
+		-1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+		// left face
+		-1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+		-1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
+		-1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+		-1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+		-1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+		-1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+		// right face
+		 1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+		 1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+		 1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
+		 1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+		 1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+		 1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+		 // bottom face
+		-1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+		 1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
+		 1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+		 1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+		-1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+		-1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+		 // top face
+		-1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+		 1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+		 1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right
+		 1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+		-1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+		-1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f  // bottom-left
+	};
+
+	float quadVertices[] = {
+		// positions        // texture coords
+		-1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
+		-1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+		 1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
+		 1.0f, -1.0f, 0.0f, 1.0f, 0.0f
+	};
+
+	cameraUBO = new UBO(sizeof(CameraData), CAMERA_BLOCK_BINDING);
+	lightUBO = new UBO(sizeof(LightData), LIGHT_BLOCK_BINDING);
+
+	clusteredLighting = new ClusteredLighting();
+	clusteredLighting->setLights(createLights(NUMBER_OF_LIGHTS));
+	clusteredLighting->getLightData(NEAR_PLANE, FAR_PLANE, lightData);
+
+	objectCulling = new ObjectCulling();
+	objectCulling->setOcclusionCulling(OCCLUSION_CULLING);
+
+	// Fewer samples than the prefilter map, the probes being prefiltered at runtime. The benchmark compares both paths.
+	if ((REFLECTION_PROBES || benchmarkReport) && IBL_ENABLED)
+	{
+		reflectionProbes = new ReflectionProbes(MAX_REFLECTION_PROBES, REFLECTION_PROBE_SIZE, IBL_PARAMETERS.prefilterMipLevels, IBL_PARAMETERS.sampleCount / 4);
+	}
+	else
+	{
+		REFLECTION_PROBES = false;
+	}
+
+	if (SHADER_BINARY_CACHE)
+	{
+		ShaderProgram::setBinaryCacheDirectory("resources/cache/shaders");
+	}
+
+	equirectangularToCubemapShader = new ShaderProgram("sources/shaders/3_equirectangular2cubemap_vs.glsl", "sources/shaders/3_equirectangular2cubemap_fs.glsl");
+	environmentShader = new ShaderProgram("sources/shaders/3_environment_vs.glsl", "sources/shaders/3_environment_fs.glsl");
+	irradianceShader = new ShaderProgram("sources/shaders/3_irradiance_convolution_vs.glsl", "sources/shaders/3_irradiance_convolution_fs.glsl");
+	prefilterShader = new ShaderProgram("sources/shaders/4_prefilter_convolution_vs.glsl", "sources/shaders/4_prefilter_convolution_fs.glsl");
+	brdfShader = new ShaderProgram("sources/shaders/4_brdf_vs.glsl", "sources/shaders/4_brdf_fs.glsl");
+	equirectangularToCubemapComputeShader = new ShaderProgram("sources/shaders/3_equirectangular2cubemap_cs.glsl");
+	irradianceComputeShader = new ShaderProgram("sources/shaders/3_irradiance_convolution_cs.glsl");
+	prefilterComputeShader = new ShaderProgram("sources/shaders/4_prefilter_convolution_cs.glsl");
+	brdfComputeShader = new ShaderProgram("sources/shaders/4_brdf_cs.glsl");
+	depthPrepassShader = new ShaderProgram("sources/shaders/2_pbr_texturized_vs.glsl", "sources/shaders/2_depth_prepass_fs.glsl");
+	createPBRShaders(NUMBER_OF_LIGHTS);
+
+	// The maps are decoded on the thread pool while the rest of the setup (and the IBL bake) goes on.
+	textureLoader = new TextureLoader(ThreadPool::getInstance());
+	iblUpdateScheduler = new IBLUpdateScheduler(IBL_PARAMETERS, *textureLoader, ThreadPool::getInstance());
+
+	// Every program compiles in the driver from here on, each one only waited for when first used.
+	ShaderProgram::submitPending();
+
+	equirectangularToCubemapShader->bind();
+	equirectangularToCubemapShader->setUniform1i("uEquirectangularMap", 0);
+	equirectangularToCubemapShader->setUniformMatrix4fv("uProjection", envProjectionMatrix);
+	equirectangularToCubemapShader->unbind();
+
+	environmentShader->bind();
+	environmentShader->setUniform1i("uEnvironmentMap", 0);
+	environmentShader->unbind();
+
+	irradianceShader->bind();
+	irradianceShader->setUniform1i("uEnvironmentMap", 0);
+	irradianceShader->setUniformMatrix4fv("uProjection", envProjectionMatrix);
+	irradianceShader->unbind();
+
+	prefilterShader->bind();
+	prefilterShader->setUniform1i("uEnvironmentMap", 0);
+	prefilterShader->setUniformMatrix4fv("uProjection", envProjectionMatrix);
+	prefilterShader->unbind();
+
+	equirectangularToCubemapComputeShader->bind();
+	equirectangularToCubemapComputeShader->setUniform1i("uEquirectangularMap", 0);
+	equirectangularToCubemapComputeShader->unbind();
+
+	irradianceComputeShader->bind();
+	irradianceComputeShader->setUniform1i("uEnvironmentMap", 0);
+	irradianceComputeShader->unbind();
+
+	prefilterComputeShader->bind();
+	prefilterComputeShader->setUniform1i("uEnvironmentMap", 0);
+	prefilterComputeShader->unbind();
+
+	materialLibrary = new MaterialLibrary("resources/textures", "resources/cache/materials", *textureLoader, MATERIAL_TEXTURE_SIZE, PACKED_ORM);
+
+	sphereVAO = new VAO();
+	sphereVBO = new VBO(&sphereVertices[0], sphereVertices.size() * sizeof(float));
+	sphereIBO = new IBO(&sphereIndices[0], sphereIndices.size() * sizeof(unsigned int));
+
+	sphereVAO->bind();
+	sphereVBO->bind();
+	sphereIBO->bind();
+
+	sphereVAO->setVertexAttribute(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(0));
+	sphereVAO->setVertexAttribute(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+	sphereVAO->setVertexAttribute(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+
+	// Per-instance attributes, advanced once per instance (divisor of 1).
+	sphereInstanceVBO = new VBO(nullptr, 0);
+	sphereInstanceVBO->bind();
+
+	setSphereInstanceAttributes(sphereVAO);
+
+	sphereVAO->unbind();
+
+	culledSphereVAO = new VAO();
+
+	culledSphereVAO->bind();
+	sphereVBO->bind();
+	sphereIBO->bind();
+
+	culledSphereVAO->setVertexAttribute(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(0));
+	culledSphereVAO->setVertexAttribute(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+	culledSphereVAO->setVertexAttribute(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+
+	glBindBuffer(GL_ARRAY_BUFFER, objectCulling->getVisibleInstanceBufferID());
+
+	setSphereInstanceAttributes(culledSphereVAO);
+
+	culledSphereVAO->unbind();
+	sphereVBO->unbind();
+	sphereIBO->unbind();
+
+	createSphereGrid(SPHERE_GRID_SIZE);
+
+	cubeVAO = new VAO();
+	cubeVBO = new VBO(cubeVertices, sizeof(cubeVertices));
+
+	cubeVAO->bind();
+	cubeVBO->bind();
+
+	cubeVAO->setVertexAttribute(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(0));
+	cubeVAO->setVertexAttribute(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+	cubeVAO->setVertexAttribute(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+
+	cubeVAO->unbind();
+	cubeVBO->unbind();
+
+	quadVAO = new VAO();
+	quadVBO = new VBO(quadVertices, sizeof(quadVertices));
+
+	quadVAO->bind();
+	quadVBO->bind();
+
+	quadVAO->setVertexAttribute(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(0));
+	quadVAO->setVertexAttribute(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+
+	quadVAO->unbind();
+	quadVBO->unbind();
+
+	brdfLUTTex = new Texture(IBL_PARAMETERS.brdfLUTSize, IBL_PARAMETERS.brdfLUTSize, GL_RG16F, GL_RG, GL_FLOAT);
+
+	captureFB = new FrameBuffer(CAPTURE_FB_WIDTH, CAPTURE_FB_HEIGHT);
+
+	gBuffer = new GBuffer(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+	// RGBA, since image stores have no RGB formats (the drivers pad RGB16F to 8 bytes per texel anyway). The environment
+	// has mips for the prefilter samples, rebuilt after every bake.
+	//
+	environmentCM = new CubeMap(IBL_PARAMETERS.environmentSize, IBL_PARAMETERS.environmentSize, GL_RGBA16F, GL_RGBA, GL_FLOAT, true);
+	irradianceCM = new CubeMap(IBL_PARAMETERS.irradianceSize, IBL_PARAMETERS.irradianceSize, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+	prefilterCM = new CubeMap(IBL_PARAMETERS.prefilterSize, IBL_PARAMETERS.prefilterSize, GL_RGBA16F, GL_RGBA, GL_FLOAT, true);
+
+	updatePrefilterSampleTable();
+
+	// Reuse the maps baked by a previous run when neither the HDR nor the bake parameters changed.
+	IBLCache iblCache("resources/cache");
+
+	iblCache.computeKey(ENVIRONMENT_FILEPATH.c_str(), IBL_PARAMETERS);
+
+	bool iblCached = false;
+
+	// The benchmark always bakes, to time every stage.
+	if (!benchmarkReport)
+	{
+		PROFILE_CPU("IBL cache load");
+
+		iblCached = iblCache.load(environmentCM, irradianceCM, prefilterCM, brdfLUTTex, &irradianceSH);
+	}
+
+	if (!iblCached)
+	{
+		auto bakeStart = std::chrono::high_resolution_clock::now();
+
+		bool baked = CPU_IBL_BAKE ? bakeIBLOnCPU() : bakeIBLOnGPU();
+
+		if (benchmarkReport)
+		{
+			glFinish();
+
+			std::chrono::duration<double, std::milli> bakeTime = std::chrono::high_resolution_clock::now() - bakeStart;
+
+			benchmarkReport->addValue("ibl_bake_ms", "Total", bakeTime.count());
+		}
+
+		if (baked)
+		{
+			iblCache.save(environmentCM, irradianceCM, prefilterCM, brdfLUTTex, &irradianceSH);
+		}
+		else
+		{
+			std::cout << "[ERROR] PROGRAM: Failed to bake the IBL maps from \"" << ENVIRONMENT_FILEPATH << "\", nothing cached." << std::endl;
+		}
+	}
+
+	if (COMPRESSED_IBL)
+	{
+		DDSImage environmentDDS, prefilterDDS;
+
+		if (DDS::load(iblCache.getCompressedFilepath("environment"), environmentDDS) && DDS::load(iblCache.getCompressedFilepath("prefilter"), prefilterDDS))
+		{
+			delete environmentCM;
+			delete prefilterCM;
+
+			environmentCM = new CubeMap(environmentDDS);
+			prefilterCM = new CubeMap(prefilterDDS);
+
+			std::cout << "[INFO] PROGRAM: Using the BC6H environment and prefilter maps." << std::endl;
+		}
+		else
+		{
+			std::cout << "[ERROR] PROGRAM: Missing BC6H IBL maps, run with \"--compress-textures\" first." << std::endl;
+		}
+	}
+
+	// Set once the IBL bake is done, the SH9 coefficients being set with the other uniforms.
+	setPBRShaderUniforms();
+
+	std::chrono::duration<double, std::milli> setupTime = std::chrono::high_resolution_clock::now() - setupStart;
+	ShaderProgram::BuildStatistics buildStatistics = ShaderProgram::getBuildStatistics();
+
+	// Whatever isn't spent submitting or blocked overlapped with the rest of the setup.
+	std::cout << "[INFO] PROGRAM: Built " << buildStatistics.compiledPrograms + buildStatistics.cachedPrograms << " shader programs (" << buildStatistics.cachedPrograms
+		<< " from the binary cache): " << buildStatistics.preprocessMilliseconds << " ms preprocessing on the workers, " << buildStatistics.submitMilliseconds
+		<< " ms submitting and " << buildStatistics.waitMilliseconds << " ms blocked on the main thread, over a " << setupTime.count() << " ms setup." << std::endl;
+
+	if (benchmarkReport)
+	{
+		benchmarkReport->addValue("startup_ms", "Setup", setupTime.count());
+		benchmarkReport->addValue("startup_ms", "Shader preprocessing", buildStatistics.preprocessMilliseconds);
+		benchmarkReport->addValue("startup_ms", "Shader submission", buildStatistics.submitMilliseconds);
+		benchmarkReport->addValue("startup_ms", "Shader wait", buildStatistics.waitMilliseconds);
+	}
+
+	glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+}
+
+// Rebuilds in the background the programs depending on the shader files changed since the last frame, then swaps
+// the ones that linked and reruns the GPU bake stages fed by them (and only those), the other maps staying as they are.
+void updateShaderHotReload()
+{
+	std::vector<ShaderProgram*> programs = { equirectangularToCubemapShader, environmentShader, irradianceShader, prefilterShader, brdfShader, depthPrepassShader, clusteredLighting->getCullingShader(),
+		objectCulling->getCullingShader(), objectCulling->getDepthPyramidShader(), equirectangularToCubemapComputeShader, irradianceComputeShader, prefilterComputeShader, brdfComputeShader,
+		iblUpdateScheduler->getEnvironmentShader(), iblUpdateScheduler->getIrradianceShader(), iblUpdateScheduler->getPrefilterShader() };
+
+	if (reflectionProbes)
+	{
+		programs.push_back(reflectionProbes->getSkyShader());
+		programs.push_back(reflectionProbes->getPrefilterShader());
+	}
+
+	for (auto& permutation : pbrShaderPermutations)
+	{
+		programs.push_back(permutation.second);
+	}
+
+	for (const std::string& filepath : shaderWatcher->poll())
+	{
+		for (ShaderProgram* program : programs)
+		{
+			if (program->dependsOn(filepath))
+			{
+				program->reload();
+			}
+		}
+	}
+
+	// Only the programs of the bake path in use trigger a rebake.
+	bool environmentChanged = (COMPUTE_IBL_BAKE ? equirectangularToCubemapComputeShader : equirectangularToCubemapShader)->updateReload();
+	bool irradianceChanged = (COMPUTE_IBL_BAKE ? irradianceComputeShader : irradianceShader)->updateReload();
+	bool prefilterChanged = (COMPUTE_IBL_BAKE ? prefilterComputeShader : prefilterShader)->updateReload();
+	bool brdfLUTChanged = (COMPUTE_IBL_BAKE ? brdfComputeShader : brdfShader)->updateReload();
+
+	// The probes are captured again whatever changed in their passes.
+	if (reflectionProbes && REFLECTION_PROBES)
+	{
+		bool captureChanged = reflectionProbeCaptureShader->updateReload();
+		bool skyChanged = reflectionProbes->getSkyShader()->updateReload();
+		bool probePrefilterChanged = reflectionProbes->getPrefilterShader()->updateReload();
+
+		if (captureChanged || skyChanged || probePrefilterChanged)
+		{
+			reflectionProbes->invalidate();
+		}
+	}
+
+	for (ShaderProgram* program : programs)
+	{
+		program->updateReload();
+	}
+
+	if (!environmentChanged && !irradianceChanged && !prefilterChanged && !brdfLUTChanged)
+	{
+		return;
+	}
+
+	// The BC6H maps can be neither render targets nor images.
+	if (COMPRESSED_IBL)
+	{
+		std::cout << "[INFO] PROGRAM: IBL maps not rebaked, they are loaded compressed." << std::endl;
+
+		return;
+	}
+
+	// During an environment swap, the maps in use are about to be replaced by the ones being baked from the new HDR.
+	// That bake is restarted so they follow the reloaded shaders too, the BRDF LUT being the only map rebaked now.
+	//
+	if (iblUpdateScheduler->isUpdating() && (environmentChanged || irradianceChanged || prefilterChanged))
+	{
+		std::cout << "[INFO] PROGRAM: Environment swap to \"" << ENVIRONMENT_FILEPATH << "\" restarted with the reloaded shaders." << std::endl;
+
+		iblUpdateScheduler->start(ENVIRONMENT_FILEPATH);
+
+		environmentChanged = irradianceChanged = prefilterChanged = false;
+
+		if (!brdfLUTChanged)
+		{
+			return;
+		}
+	}
+
+	void (*bakeEnvironment)() = COMPUTE_IBL_BAKE ? bakeEnvironmentWithCompute : bakeEnvironmentOnGPU;
+	void (*bakeIrradiance)() = COMPUTE_IBL_BAKE ? bakeIrradianceWithCompute : bakeIrradianceOnGPU;
+	void (*bakePrefilter)() = COMPUTE_IBL_BAKE ? bakePrefilterWithCompute : bakePrefilterOnGPU;
+	void (*bakeBRDFLUT)() = COMPUTE_IBL_BAKE ? bakeBRDFLUTWithCompute : bakeBRDFLUTOnGPU;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// The irradiance and prefilter maps are convolutions of the environment map.
+	if (environmentChanged)
+	{
+		bakeEnvironment();
+
+		freeEquirectangularHDR();
+	}
+
+	if ((environmentChanged || irradianceChanged) && !IBL_PARAMETERS.irradianceSH)
+	{
+		bakeIrradiance();
+	}
+
+	if (environmentChanged || prefilterChanged)
+	{
+		bakePrefilter();
+	}
+
+	if (brdfLUTChanged)
+	{
+		bakeBRDFLUT();
+	}
+
+	if (reflectionProbes)
+	{
+		reflectionProbes->invalidate();
+	}
+
+	glFinish();
+
+	glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+	std::cout << "[INFO] PROGRAM: Rebaked the IBL maps depending on the reloaded shaders in " << elapsed.count() << " ms." << std::endl;
+}
+
+// Starts rebaking the maps from the HDR following the current one in "resources/textures/environment", wrapping
+// around (the same one again when it is alone there). The current maps stay in use until "updateIBL" swaps them.
+void swapEnvironment()
+{
+	// The BC6H maps can be neither render targets nor images.
+	if (COMPRESSED_IBL)
+	{
+		std::cout << "[INFO] PROGRAM: Environment not swapped, the IBL maps are loaded compressed." << std::endl;
+
+		return;
+	}
+
+	std::vector<std::string> filepaths;
+
+	for (const auto& entry : std::filesystem::directory_iterator("resources/textures/environment"))
+	{
+		if (entry.is_regular_file() && entry.path().extension() == ".hdr")
+		{
+			filepaths.push_back(entry.path().generic_string());
+		}
+	}
+
+	if (filepaths.empty())
+	{
+		std::cout << "[ERROR] PROGRAM: No HDR environment in \"resources/textures/environment\"." << std::endl;
+
+		return;
+	}
+
+	std::sort(filepaths.begin(), filepaths.end());
+
+	auto next = std::upper_bound(filepaths.begin(), filepaths.end(), ENVIRONMENT_FILEPATH);
+	const std::string& filepath = next != filepaths.end() ? *next : filepaths.front();
+
+	std::cout << "[INFO] PROGRAM: Swapping the environment to \"" << filepath << "\"." << std::endl;
+
+	iblUpdateScheduler->start(filepath);
+
+	ENVIRONMENT_FILEPATH = filepath;
+
+	// Loaded again from the new HDR by the next GPU bake (e.g. a shader reload).
+	freeEquirectangularHDR();
+}
+
+// Runs the jobs of the environment swap in progress fitting this frame, then swaps the new maps in once complete.
+void updateIBL()
+{
+	if (!iblUpdateScheduler->isUpdating())
+	{
+		return;
+	}
+
+	PROFILE_CPU("IBL update");
+
+	if (!iblUpdateScheduler->update(IBL_UPDATE_BUDGET, *prefilterSampleTable, prefilterSampleBuffer))
+	{
+		return;
+	}
+
+	iblUpdateScheduler->swap(environmentCM, irradianceCM, prefilterCM, irradianceSH);
+
+	// The probes see the environment behind the spheres, and the spheres lit by it.
+	if (reflectionProbes)
+	{
+		reflectionProbes->invalidate();
+	}
+
+	// The SH9 coefficients are uniforms.
+	setPBRShaderUniforms();
+
+	const IBLUpdateScheduler::Statistics& statistics = iblUpdateScheduler->getStatistics();
+
+	std::cout << "[INFO] PROGRAM: Environment swapped after " << statistics.frames << " frames (" << statistics.jobs << " jobs, " << statistics.milliseconds
+		<< " ms, at most " << statistics.maxGPUMilliseconds << " ms of GPU per frame)." << std::endl;
+}
+
+void renderSpheres()
+{
+	if (INSTANCED_RENDERING && OBJECT_CULLING)
+	{
+		culledSphereVAO->bind();
+
+		objectCulling->draw(GL_TRIANGLE_STRIP);
+
+		culledSphereVAO->unbind();
+
+		return;
+	}
+
+	sphereVAO->bind();
+
+	if (INSTANCED_RENDERING)
+	{
+		glDrawElementsInstanced(GL_TRIANGLE_STRIP, sphereIndexCount, GL_UNSIGNED_INT, 0, sphereInstanceCount);
+	}
+	else
+	{
+		// One draw call per sphere, the base instance selecting its per-instance attributes.
+		for (int i = 0; i < sphereInstanceCount; ++i)
+		{
+			glDrawElementsInstancedBaseInstance(GL_TRIANGLE_STRIP, sphereIndexCount, GL_UNSIGNED_INT, 0, 1, i);
+		}
+	}
+
+	sphereVAO->unbind();
+}
+
+void renderCube()
+{
+	cubeVAO->bind();
+
+	glDrawArrays(GL_TRIANGLES, 0, 36);
+
+	cubeVAO->unbind();
+}
+
+// Captures the invalid probes allowed this frame. The capture program samples the same maps as the forward pass, the
+// probes seeing every sphere whatever the culling of the camera.
+void updateReflectionProbes()
+{
+	materialLibrary->bind(0);
+
+	if (!IBL_PARAMETERS.irradianceSH)
+	{
+		irradianceCM->bind(5);
+	}
+
+	prefilterCM->bind(6);
+	brdfLUTTex->bind(7);
+
+	auto drawScene = []()
+	{
+		sphereVAO->bind();
+
+		glDrawElementsInstanced(GL_TRIANGLE_STRIP, sphereIndexCount, GL_UNSIGNED_INT, 0, sphereInstanceCount);
+
+		sphereVAO->unbind();
+	};
+
+	reflectionProbes->update(PROBE_CAPTURES_PER_FRAME, camera.getPosition(), reflectionProbeCaptureShader, drawScene, environmentCM, IBL_PARAMETERS.environmentSize);
+}
+
+// Spheres shaded as they are drawn, optionally after a depth prepass.
+void renderForward(bool spheresReady)
+{
+	// Depth only, the PBR shader then runs for the closest fragment of each pixel alone.
+	if (DEPTH_PREPASS && spheresReady)
+	{
+		PROFILE_CPU("Depth prepass");
+		PROFILE_GPU("Depth prepass");
+
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glDepthFunc(GL_LESS);
+
+		depthPrepassShader->bind();
+
+		renderSpheres();
+
+		depthPrepassShader->unbind();
+
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+	}
+
+	{
+		PROFILE_CPU("PBR spheres");
+		PROFILE_GPU("PBR spheres");
+
+		pbrShader->bind();
+
+		materialLibrary->bind(0); // Units 0 to 4 (0 to 2 with the ORM maps), the layer of each material being selected per instance.
+
+		if (IBL_ENABLED)
+		{
+			if (!IBL_PARAMETERS.irradianceSH)
+			{
+				irradianceCM->bind(5);
+			}
+
+			prefilterCM->bind(6);
+			brdfLUTTex->bind(7);
+
+			if (REFLECTION_PROBES)
+			{
+				reflectionProbes->bind(8);
+			}
+		}
+
+		if (spheresReady)
+		{
+			renderSpheres();
+		}
+
+		pbrShader->unbind();
+	}
+
+	if (DEPTH_PREPASS && spheresReady)
+	{
+		glDepthFunc(GL_LEQUAL);
+		glDepthMask(GL_TRUE);
+	}
+}
+
+// Spheres drawn to the G-buffer, then lit once per pixel into the bound framebuffer, which also receives their depth.
+void renderDeferred(bool spheresReady)
+{
+	GLint targetFramebuffer;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &targetFramebuffer);
+
+	gBuffer->resize(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+	{
+		PROFILE_CPU("G-buffer");
+		PROFILE_GPU("G-buffer");
+
+		gBuffer->bind();
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		gBufferShader->bind();
+
+		materialLibrary->bind(0);
+
+		if (spheresReady)
+		{
+			renderSpheres();
+		}
+
+		gBufferShader->unbind();
+
+		glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+	}
+
+	{
+		PROFILE_CPU("Deferred lighting");
+		PROFILE_GPU("Deferred lighting");
+
+		deferredLightingShader->bind();
+
+		gBuffer->bindTextures(0); // Units 0 to 3.
+
+		if (IBL_ENABLED)
+		{
+			if (!IBL_PARAMETERS.irradianceSH)
+			{
+				irradianceCM->bind(5);
+			}
+
+			prefilterCM->bind(6);
+			brdfLUTTex->bind(7);
+
+			if (REFLECTION_PROBES)
+			{
+				reflectionProbes->bind(8);
+			}
+		}
+
+		// The depth of the target was just cleared, every pixel covered by a sphere passes.
+		quadVAO->bind();
+
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+		quadVAO->unbind();
+
+		deferredLightingShader->unbind();
+	}
+}
+
+void render()
+{
+	// Also rebinds it after the IBL updates, which leave their capture framebuffer for the default one.
+	if (offscreenFB)
+	{
+		offscreenFB->bind();
+	}
+
+	glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// Per-frame uniform blocks, written once and read by every program below.
+	cameraData.projection = projectionMatrix;
+	cameraData.view = camera.getViewMatrix();
+	cameraData.inverseProjection = glm::inverse(projectionMatrix);
+	cameraData.position = glm::vec4(camera.getPosition(), 1.0f);
+	cameraData.viewport = glm::vec4(WINDOW_WIDTH, WINDOW_HEIGHT, NEAR_PLANE, FAR_PLANE);
+
+	cameraUBO->update(&cameraData);
+	lightUBO->update(&lightData);
+
+	{
+		PROFILE_CPU("Light culling");
+		PROFILE_GPU("Light culling");
+
+		if (CPU_LIGHT_CULLING)
+		{
+			clusteredLighting->cullOnCPU(cameraData, lightData, ThreadPool::getInstance());
+		}
+		else
+		{
+			clusteredLighting->cullOnGPU();
+		}
+	}
+
+	clusteredLighting->bind();
+
+	if (INSTANCED_RENDERING && OBJECT_CULLING)
+	{
+		PROFILE_CPU("Object culling");
+		PROFILE_GPU("Object culling");
+
+		objectCulling->cull(projectionMatrix * camera.getViewMatrix(), sphereIndexCount);
+	}
+
+	// Rendering material, once every map has been uploaded.
+	textureLoader->update();
+
+	bool spheresReady = materialLibrary->isReady();
+
+	// A few probes per frame, once the materials they capture are there.
+	if (REFLECTION_PROBES && spheresReady)
+	{
+		PROFILE_CPU("Reflection probes");
+		PROFILE_GPU("Reflection probes");
+
+		updateReflectionProbes();
+	}
+
+	if (DEFERRED_SHADING)
+	{
+		renderDeferred(spheresReady);
+	}
+	else
+	{
+		renderForward(spheresReady);
+	}
+
+	// Farthest depth of the spheres, tested against by the culling of the next frame.
+	if (INSTANCED_RENDERING && OBJECT_CULLING && OCCLUSION_CULLING)
+	{
+		PROFILE_CPU("Depth pyramid");
+		PROFILE_GPU("Depth pyramid");
+
+		objectCulling->buildDepthPyramid(WINDOW_WIDTH, WINDOW_HEIGHT, projectionMatrix * camera.getViewMatrix());
+	}
+
+	// Rendering background.
+	{
+		PROFILE_CPU("Skybox");
+		PROFILE_GPU("Skybox");
+
+		environmentShader->bind();
+
+		environmentCM->bind(0);
+
+		renderCube();
+
+		environmentShader->unbind();
+	}
+
+	cameraUBO->lock();
+	lightUBO->lock();
+}
+
+void renderHeadless()
+{
+	offscreenFB->bind(); // Read back by "glReadPixels".
+
+	int frameSize = WINDOW_WIDTH * WINDOW_HEIGHT * 4;
+
+	// Two pixel pack buffers: while frame N is read back into one of them, frame N - 1 is copied out of the other.
+	PBO readbackPBOs[2] = { PBO(frameSize), PBO(frameSize) };
+	ImageWriter imageWriter;
+
+	std::error_code error;
+	std::filesystem::create_directories(OUTPUT_DIRECTORY, error);
+
+	glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	ShaderProgram::resetUniformStatistics();
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (int frame = 0; frame <= HEADLESS_FRAMES; ++frame)
+	{
+		Profiler::getInstance().beginFrame();
+
+		if (frame < HEADLESS_FRAMES)
+		{
+			PROFILE_CPU("Frame");
+
+			render();
+
+			PROFILE_GPU("Readback");
+
+			readbackPBOs[frame % 2].readPixels(WINDOW_WIDTH, WINDOW_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE);
+		}
+
+		if (frame > 0)
+		{
+			PROFILE_CPU("Write frame");
+
+			PBO& previousPBO = readbackPBOs[(frame - 1) % 2];
+			const unsigned char* pixels = static_cast<const unsigned char*>(previousPBO.map());
+
+			if (pixels)
+			{
+				char filename[64];
+
+				std::snprintf(filename, sizeof(filename), "_%05d.png", frame - 1);
+
+				imageWriter.write(OUTPUT_DIRECTORY + "/" + MATERIAL_NAME + filename, WINDOW_WIDTH, WINDOW_HEIGHT, 4, std::vector<unsigned char>(pixels, pixels + frameSize));
+			}
+			else
+			{
+				std::cout << "[ERROR] HEADLESS: Failed to map the readback buffer of frame " << frame - 1 << "." << std::endl;
+			}
+
+			previousPBO.unmap();
+		}
+
+		Profiler::getInstance().endFrame();
+	}
+
+	std::chrono::duration<double> renderTime = std::chrono::high_resolution_clock::now() - start;
+
+	imageWriter.finish();
+
+	std::chrono::duration<double> totalTime = std::chrono::high_resolution_clock::now() - start;
+
+	std::cout << "[INFO] HEADLESS: Rendered " << HEADLESS_FRAMES << " frame(s) of " << WINDOW_WIDTH << "x" << WINDOW_HEIGHT << " in " << renderTime.count() << " s ("
+		<< HEADLESS_FRAMES / renderTime.count() << " frames/s), " << imageWriter.getNumberOfWrittenImages() << " image(s) written after " << totalTime.count() << " s ("
+		<< HEADLESS_FRAMES / totalTime.count() << " frames/s)." << std::endl;
+
+	ShaderProgram::UniformStatistics uniformStatistics = ShaderProgram::getUniformStatistics();
+
+	std::cout << "[INFO] HEADLESS: Uniform calls per frame: " << double(uniformStatistics.issuedCalls) / HEADLESS_FRAMES << " issued, "
+		<< double(uniformStatistics.skippedCalls) / HEADLESS_FRAMES << " skipped." << std::endl;
+
+	if (INSTANCED_RENDERING && OBJECT_CULLING)
+	{
+		ObjectCulling::Statistics cullingStatistics = objectCulling->getStatistics();
+
+		std::cout << "[INFO] HEADLESS: Object culling of the last frame read back: " << cullingStatistics.tested << " spheres tested, " << cullingStatistics.frustumCulled
+			<< " outside the frustum, " << cullingStatistics.occluded << " occluded, " << cullingStatistics.visible << " visible." << std::endl;
+	}
+
+	offscreenFB->unbind();
+}
+
+void benchmarkLightCulling()
+{
+	const int lightCounts[] = { 4, 64, 512, 4096 };
+	const int iterations = 20;
+
+	unsigned int timerQuery;
+	glGenQueries(1, &timerQuery);
+
+	glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+
+	bool cpuLightCulling = CPU_LIGHT_CULLING;
+
+	for (int numberOfLights : lightCounts)
+	{
+		clusteredLighting->setLights(createLights(numberOfLights));
+		clusteredLighting->getLightData(NEAR_PLANE, FAR_PLANE, lightData);
+
+		// The light loop of the permutation is bounded by the number of lights.
+		createPBRShaders(numberOfLights);
+		setPBRShaderUniforms();
+
+		CPU_LIGHT_CULLING = false;
+		render(); // Fills the frame data and warms up the pipeline.
+		glFinish();
+
+		// CPU binning, including the upload of the lists.
+		auto start = std::chrono::high_resolution_clock::now();
+
+		for (int i = 0; i < iterations; ++i)
+		{
+			clusteredLighting->cullOnCPU(cameraData, lightData, ThreadPool::getInstance());
+		}
+
+		glFinish();
+
+		std::chrono::duration<double, std::milli> cpuTime = std::chrono::high_resolution_clock::now() - start;
+
+		const std::vector<uint32_t>& clusterLightCounts = clusteredLighting->getLightCounts();
+		double averageLightsPerCluster = 0.0;
+
+		for (uint32_t count : clusterLightCounts)
+		{
+			averageLightsPerCluster += count;
+		}
+
+		averageLightsPerCluster /= std::max<size_t>(clusterLightCounts.size(), 1);
+
+		// GPU binning.
+		GLuint64 gpuTime = 0;
+
+		glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+
+		for (int i = 0; i < iterations; ++i)
+		{
+			clusteredLighting->cullOnGPU();
+		}
+
+		glEndQuery(GL_TIME_ELAPSED);
+		glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &gpuTime);
+
+		// Whole frame, GPU binning included.
+		GLuint64 frameTime = 0;
+
+		glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+
+		for (int i = 0; i < iterations; ++i)
+		{
+			render();
+		}
+
+		glEndQuery(GL_TIME_ELAPSED);
+		glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &frameTime);
+
+		std::cout << "[INFO] LIGHT CULLING: " << numberOfLights << " lights, " << clusteredLighting->getNumberOfClusters() << " clusters (" << averageLightsPerCluster
+			<< " lights/cluster on average): CPU " << cpuTime.count() / iterations << " ms, GPU " << gpuTime / 1e6 / iterations << " ms, frame "
+			<< frameTime / 1e6 / iterations << " ms." << std::endl;
+	}
+
+	CPU_LIGHT_CULLING = cpuLightCulling;
+
+	createPBRShaders(NUMBER_OF_LIGHTS);
+
+	glDeleteQueries(1, &timerQuery);
+}
+
+void benchmarkInstancing()
+{
+	const int gridSizes[] = { 10, 50, 100 };
+	const int iterations = 10;
+
+	unsigned int timerQuery;
+	glGenQueries(1, &timerQuery);
+
+	glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+
+	bool instancedRendering = INSTANCED_RENDERING;
+
+	for (int gridSize : gridSizes)
+	{
+		createSphereGrid(gridSize);
+		frameSphereGrid(gridSize);
+
+		clusteredLighting->getLightData(NEAR_PLANE, FAR_PLANE, lightData);
+
+		for (bool instanced : { false, true })
+		{
+			INSTANCED_RENDERING = instanced;
+
+			render(); // Warms up the pipeline.
+			glFinish();
+
+			GLuint64 gpuTime = 0;
+			auto start = std::chrono::high_resolution_clock::now();
+
+			glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+
+			for (int i = 0; i < iterations; ++i)
+			{
+				render();
+			}
+
+			glEndQuery(GL_TIME_ELAPSED);
+
+			std::chrono::duration<double, std::milli> cpuTime = std::chrono::high_resolution_clock::now() - start; // Submission only.
+
+			glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &gpuTime);
+
+			std::cout << "[INFO] INSTANCING: " << gridSize << "x" << gridSize << " spheres, " << (instanced ? "1 instanced draw call" : std::to_string(sphereInstanceCount) + " draw calls")
+				<< ": CPU " << cpuTime.count() / iterations << " ms, GPU " << gpuTime / 1e6 / iterations << " ms per frame." << std::endl;
+		}
+	}
+
+	INSTANCED_RENDERING = instancedRendering;
+
+	createSphereGrid(SPHERE_GRID_SIZE);
+	frameSphereGrid(SPHERE_GRID_SIZE);
+
+	clusteredLighting->getLightData(NEAR_PLANE, FAR_PLANE, lightData);
+
+	glDeleteQueries(1, &timerQuery);
+}
+
+// "GL_FRAGMENT_SHADER_INVOCATIONS" is core in OpenGL 4.6 only, an extension before (e.g. Mesa's llvmpipe, at 4.5).
+bool supportsPipelineStatistics()
+{
+	if (GLAD_GL_VERSION_4_6)
+	{
+		return true;
+	}
+
+	int numberOfExtensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &numberOfExtensions);
+
+	for (int i = 0; i < numberOfExtensions; ++i)
+	{
+		if (std::strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), "GL_ARB_pipeline_statistics_query") == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void benchmarkDepthPrepass()
+{
+	const int gridSizes[] = { 1, 10, 50 };
+	const int iterations = 10;
+
+	unsigned int queries[2];
+	glGenQueries(2, queries);
+
+	unsigned int timerQuery = queries[0], invocationQuery = queries[1];
+
+	bool pipelineStatistics = supportsPipelineStatistics();
+
+	if (!pipelineStatistics)
+	{
+		std::cout << "[INFO] DEPTH PREPASS: Pipeline statistics unavailable (\"GL_ARB_pipeline_statistics_query\"), timing the frames only." << std::endl;
+	}
+
+	glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+
+	bool depthPrepass = DEPTH_PREPASS;
+
+	for (int gridSize : gridSizes)
+	{
+		createSphereGrid(gridSize);
+
+		clusteredLighting->getLightData(NEAR_PLANE, FAR_PLANE, lightData);
+
+		// Facing the grid the spheres don't overlap, only their back faces are shaded twice. Along it they hide each other.
+		for (bool grazing : { false, true })
+		{
+			frameSphereGrid(gridSize);
+
+			if (grazing)
+			{
+				float extent = (gridSize - 1) * 2.5f * 0.5f;
+
+				camera = Camera(glm::vec3(-extent - 3.0f, 0.0f, 3.0f), glm::normalize(glm::vec3(1.0f, 0.0f, -0.25f)), glm::vec3(0.0f, 1.0f, 0.0f));
+			}
+
+			for (bool prepass : { false, true })
+			{
+				DEPTH_PREPASS = prepass;
+
+				render(); // Warms up the pipeline.
+				glFinish();
+
+				GLuint64 gpuTime = 0, invocations = 0;
+
+				glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+
+				if (pipelineStatistics)
+				{
+					glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS, invocationQuery);
+				}
+
+				for (int i = 0; i < iterations; ++i)
+				{
+					render();
+				}
+
+				if (pipelineStatistics)
+				{
+					glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS);
+					glGetQueryObjectui64v(invocationQuery, GL_QUERY_RESULT, &invocations);
+				}
+
+				glEndQuery(GL_TIME_ELAPSED);
+				glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &gpuTime);
+
+				std::cout << "[INFO] DEPTH PREPASS: " << gridSize << "x" << gridSize << " spheres, " << (grazing ? "grazing" : "facing") << " view, prepass "
+					<< (prepass ? "on" : "off") << ": " << (pipelineStatistics ? std::to_string(invocations / iterations) : "unavailable")
+					<< " fragment shader invocations, GPU " << gpuTime / 1e6 / iterations << " ms per frame." << std::endl;
+			}
+		}
+	}
+
+	DEPTH_PREPASS = depthPrepass;
+
+	createSphereGrid(SPHERE_GRID_SIZE);
+	frameSphereGrid(SPHERE_GRID_SIZE);
+
+	clusteredLighting->getLightData(NEAR_PLANE, FAR_PLANE, lightData);
+
+	glDeleteQueries(2, queries);
+}
+
+void benchmarkIBLBake()
+{
+	struct BakeStage
+	{
+		const char* name;
+		void (*raster)();
+		void (*compute)();
+		int rasterDraws;
+		int computeDispatches;
+	};
+
+	int mipLevels = IBL_PARAMETERS.prefilterMipLevels;
+
+	const BakeStage stages[] = {
+		{ "Equirectangular to cubemap", bakeEnvironmentOnGPU, bakeEnvironmentWithCompute, 6, 1 },
+		{ "Irradiance convolution", bakeIrradianceOnGPU, bakeIrradianceWithCompute, 6, 1 },
+		{ "Prefilter convolution", bakePrefilterOnGPU, bakePrefilterWithCompute, 6 * mipLevels, mipLevels },
+		{ "BRDF LUT integration", bakeBRDFLUTOnGPU, bakeBRDFLUTWithCompute, 1, 1 }
+	};
+
+	const int iterations = 5;
+
+	unsigned int timerQuery;
+	glGenQueries(1, &timerQuery);
+
+	auto timeBake = [&](void (*bake)())
+	{
+		bake(); // Warms up the pipeline.
+		glFinish();
+
+		GLuint64 gpuTime = 0;
+
+		glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+
+		for (int i = 0; i < iterations; ++i)
+		{
+			bake();
+		}
+
+		glEndQuery(GL_TIME_ELAPSED);
+		glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &gpuTime);
+
+		return gpuTime / 1e6 / iterations;
+	};
+
+	for (const BakeStage& stage : stages)
+	{
+		double rasterMilliseconds = timeBake(stage.raster);
+		double computeMilliseconds = timeBake(stage.compute);
+
+		std::cout << "[INFO] IBL BAKE: " << stage.name << ": raster " << rasterMilliseconds << " ms (" << stage.rasterDraws << " draws), compute " << computeMilliseconds
+			<< " ms (" << stage.computeDispatches << " dispatches)." << std::endl;
+	}
+
+	// Prefilter with every level at the full sample count (the reference) against the adaptive sample tables, timed in
+	// compute and compared level by level.
+	//
+	bool adaptiveSampleCount = IBL_PARAMETERS.adaptiveSampleCount;
+
+	std::vector<std::vector<float>> referenceFaces(6 * mipLevels), faces(6 * mipLevels);
+	std::vector<int> referenceSampleCounts;
+	double referenceMilliseconds = 0.0;
+
+	for (int adaptive = 0; adaptive < 2; ++adaptive)
+	{
+		IBL_PARAMETERS.adaptiveSampleCount = adaptive != 0;
+
+		updatePrefilterSampleTable();
+
+		double milliseconds = timeBake(bakePrefilterWithCompute);
+
+		for (int mip = 0; mip < mipLevels; ++mip)
+		{
+			int mipSize = std::max(IBL_PARAMETERS.prefilterSize >> mip, 1);
+
+			for (int face = 0; face < 6; ++face)
+			{
+				std::vector<float>& data = adaptive ? faces[mip * 6 + face] : referenceFaces[mip * 6 + face];
+
+				data.resize(static_cast<size_t>(mipSize) * mipSize * 3);
+
+				prefilterCM->getFaceData(face, mip, GL_RGB, GL_FLOAT, data.data());
+			}
+		}
+
+		if (!adaptive)
+		{
+			for (int mip = 0; mip < mipLevels; ++mip)
+			{
+				referenceSampleCounts.push_back(prefilterSampleTable->getLevel(mip).sampleCount);
+			}
+
+			referenceMilliseconds = milliseconds;
+
+			continue;
+		}
+
+		std::cout << "[INFO] IBL BAKE: Prefilter sample tables: reference " << referenceMilliseconds << " ms, adaptive " << milliseconds << " ms ("
+			<< referenceMilliseconds / milliseconds << "x)." << std::endl;
+
+		for (int mip = 0; mip < mipLevels; ++mip)
+		{
+			float error = 0.0f;
+
+			for (int face = 0; face < 6; ++face)
+			{
+				error = std::max(error, IBLBaker::maxRelativeError(referenceFaces[mip * 6 + face], faces[mip * 6 + face]));
+			}
+
+			std::cout << (error <= IBL_BAKE_TOLERANCE ? "  " : "  [ERROR] ") << "Level " << mip << ": " << referenceSampleCounts[mip] << " -> "
+				<< prefilterSampleTable->getLevel(mip).sampleCount << " samples, maximum relative error " << error << " (tolerance " << IBL_BAKE_TOLERANCE << ")" << std::endl;
+		}
+	}
+
+	IBL_PARAMETERS.adaptiveSampleCount = adaptiveSampleCount;
+
+	updatePrefilterSampleTable();
+	bakePrefilterWithCompute();
+
+	// The compute stages ran last, the maps in use are theirs.
+	glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+
+	glDeleteQueries(1, &timerQuery);
+}
+
+void benchmarkDeferredShading()
+{
+	const int gridSizes[] = { 10, 50 };
+	const int lightCounts[] = { 4, 256, 1024 };
+	const int iterations = 10;
+
+	unsigned int timerQuery;
+	glGenQueries(1, &timerQuery);
+
+	glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+
+	bool deferredShading = DEFERRED_SHADING;
+
+	for (int gridSize : gridSizes)
+	{
+		createSphereGrid(gridSize);
+		frameSphereGrid(gridSize);
+
+		for (int numberOfLights : lightCounts)
+		{
+			clusteredLighting->setLights(createLights(numberOfLights));
+			clusteredLighting->getLightData(NEAR_PLANE, FAR_PLANE, lightData);
+
+			createPBRShaders(numberOfLights);
+			setPBRShaderUniforms();
+
+			for (bool deferred : { false, true })
+			{
+				DEFERRED_SHADING = deferred;
+
+				render(); // Warms up the pipeline.
+				glFinish();
+
+				GLuint64 gpuTime = 0;
+
+				glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+
+				for (int i = 0; i < iterations; ++i)
+				{
+					render();
+				}
+
+				glEndQuery(GL_TIME_ELAPSED);
+				glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &gpuTime);
+
+				std::cout << "[INFO] DEFERRED SHADING: " << gridSize << "x" << gridSize << " spheres, " << numberOfLights << " lights, " << (deferred ? "deferred" : "forward")
+					<< ": GPU " << gpuTime / 1e6 / iterations << " ms per frame." << std::endl;
+			}
+		}
+	}
+
+	DEFERRED_SHADING = deferredShading;
+
+	createSphereGrid(SPHERE_GRID_SIZE);
+	frameSphereGrid(SPHERE_GRID_SIZE);
+
+	clusteredLighting->setLights(createLights(NUMBER_OF_LIGHTS));
+	clusteredLighting->getLightData(NEAR_PLANE, FAR_PLANE, lightData);
+
+	createPBRShaders(NUMBER_OF_LIGHTS);
+	setPBRShaderUniforms();
+
+	glDeleteQueries(1, &timerQuery);
+}
+
+// Renders "BENCHMARK_FRAMES" frames of a scene along a fixed path, timing each frame up to its completion.
+// With "environmentSwap", the environment is rebaked from the first frame on, and the scene goes on past the
+// frame count until the new maps are swapped in.
+void runBenchmarkScene(const char* name, int gridSize, int numberOfLights, bool environmentSwap = false)
+{
+	createSphereGrid(gridSize);
+	frameSphereGrid(gridSize);
+
+	clusteredLighting->setLights(createLights(numberOfLights));
+	clusteredLighting->getLightData(NEAR_PLANE, FAR_PLANE, lightData);
+
+	createPBRShaders(numberOfLights);
+	setPBRShaderUniforms();
+
+	render(); // Warms up the pipeline.
+	glFinish();
+
+	// Quarter turn around the grid: strafing right while turning back towards its center, the same steps every run
+	// instead of the input scaled by the frame time, so every run renders the same images.
+	float distance = camera.getPosition().z;
+	float angleStep = 90.0f / BENCHMARK_FRAMES;
+	float stepLength = distance * glm::radians(angleStep);
+
+	std::vector<double> frameMilliseconds;
+	frameMilliseconds.reserve(BENCHMARK_FRAMES);
+
+	bool pipelineStatistics = supportsPipelineStatistics();
+
+	unsigned int invocationQuery;
+	glGenQueries(1, &invocationQuery);
+
+	if (pipelineStatistics)
+	{
+		glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS, invocationQuery);
+	}
+
+	if (environmentSwap)
+	{
+		iblUpdateScheduler->start(ENVIRONMENT_FILEPATH);
+	}
+
+	int swapFrames = 0;
+
+	for (int frame = 0; frame < BENCHMARK_FRAMES || iblUpdateScheduler->isUpdating(); ++frame)
+	{
+		Profiler::getInstance().beginFrame();
+
+		camera.processTranslation(Camera::Direction::RIGHT, stepLength);
+		camera.processRotation(-angleStep, 0.0f);
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		{
+			PROFILE_CPU("Frame");
+
+			updateIBL();
+			render();
+		}
+
+		glFinish();
+
+		if (iblUpdateScheduler->isUpdating())
+		{
+			swapFrames = frame + 2;
+		}
+
+		std::chrono::duration<double, std::milli> frameTime = std::chrono::high_resolution_clock::now() - start;
+
+		frameMilliseconds.push_back(frameTime.count());
+
+		Profiler::getInstance().endFrame();
+	}
+
+	GLuint64 invocations = 0;
+
+	if (pipelineStatistics)
+	{
+		glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS);
+		glGetQueryObjectui64v(invocationQuery, GL_QUERY_RESULT, &invocations);
+	}
+
+	glDeleteQueries(1, &invocationQuery);
+
+	benchmarkReport->addScene(name, frameMilliseconds);
+
+	// Without the query the section is left out, "fragment_invocations" telling why.
+	if (pipelineStatistics)
+	{
+		benchmarkReport->addValue("fragment_invocations_per_frame", name, double(invocations) / frameMilliseconds.size());
+	}
+
+	if (environmentSwap)
+	{
+		const IBLUpdateScheduler::Statistics& statistics = iblUpdateScheduler->getStatistics();
+
+		benchmarkReport->addValue("ibl_update", "Frames to complete", swapFrames);
+		benchmarkReport->addValue("ibl_update", "Jobs", statistics.jobs);
+		benchmarkReport->addValue("ibl_update", "Total ms", statistics.milliseconds);
+		benchmarkReport->addValue("ibl_update", "Max GPU ms per frame", statistics.maxGPUMilliseconds);
+		benchmarkReport->addValue("ibl_update", "Budget ms per frame", IBL_UPDATE_BUDGET);
+	}
+}
+
+void runBenchmark()
+{
+	glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+
+	benchmarkReport->setProperty("renderer", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+	benchmarkReport->setProperty("gl_version", reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+	benchmarkReport->setProperty("material", MATERIAL_NAME);
+	benchmarkReport->setProperty("resolution", std::to_string(WINDOW_WIDTH) + "x" + std::to_string(WINDOW_HEIGHT));
+	benchmarkReport->setProperty("fragment_invocations", supportsPipelineStatistics() ? "available" : "unavailable");
+
+	runBenchmarkScene("one_sphere", 1, 4);
+	runBenchmarkScene("sphere_grid", 10, 4);
+
+	bool depthPrepass = DEPTH_PREPASS;
+
+	DEPTH_PREPASS = !depthPrepass;
+	runBenchmarkScene(depthPrepass ? "sphere_grid_no_depth_prepass" : "sphere_grid_depth_prepass", 10, 4);
+	DEPTH_PREPASS = depthPrepass;
+
+	// Same environment rebaked, so the frames compare with "sphere_grid".
+	if (!COMPRESSED_IBL)
+	{
+		runBenchmarkScene("sphere_grid_environment_swap", 10, 4, true);
+	}
+
+	// Captured over the first frames of the scene, "--probe-captures" at a time.
+	if (reflectionProbes)
+	{
+		bool reflectionProbesEnabled = REFLECTION_PROBES;
+
+		REFLECTION_PROBES = !reflectionProbesEnabled;
+		runBenchmarkScene(reflectionProbesEnabled ? "sphere_grid_no_reflection_probes" : "sphere_grid_reflection_probes", 10, 4);
+		REFLECTION_PROBES = reflectionProbesEnabled;
+
+		benchmarkReport->addValue("reflection_probes", "Probes", reflectionProbes->getStatistics().probes);
+		benchmarkReport->addValue("reflection_probes", "Captures per frame", PROBE_CAPTURES_PER_FRAME);
+	}
+
+	runBenchmarkScene("lights_256", 10, 256);
+	runBenchmarkScene("lights_1024", 10, 1024);
+
+	bool deferredShading = DEFERRED_SHADING;
+
+	DEFERRED_SHADING = !deferredShading;
+	runBenchmarkScene(deferredShading ? "lights_1024_forward" : "lights_1024_deferred", 10, 1024);
+	DEFERRED_SHADING = deferredShading;
+
+	benchmarkReport->addValue("memory_mb", "Peak resident", BenchmarkReport::getPeakMemoryUsage() / (1024.0 * 1024.0));
+
+	benchmarkReport->print();
+
+	if (benchmarkReport->write(BENCHMARK_OUTPUT))
+	{
+		std::cout << "[INFO] BENCHMARK: Report written to \"" << BENCHMARK_OUTPUT << "\"." << std::endl;
+	}
+}
+
+// Appends the faces of "levels" (one entry per mip level) as the layers of a BC6H cubemap.
+DDSImage encodeCubeMap(const std::vector<CubeMapLevel>& levels, ThreadPool& threadPool)
+{
+	DDSImage image = { DDSFormat::BC6H, levels[0].size, levels[0].size, static_cast<int>(levels.size()), 6, true, {} };
+
+	for (int face = 0; face < 6; ++face)
+	{
+		for (int mip = 0; mip < image.numberOfMipLevels; ++mip)
+		{
+			size_t offset = image.data.size();
+			image.data.resize(offset + DDS::getLevelSize(image, mip));
+
+			BCEncoder::encodeBC6H(levels[mip].faces[face].data(), levels[mip].size, levels[mip].size, &image.data[offset], threadPool);
+		}
+	}
+
+	return image;
+}
+
+size_t getNumberOfTexels(const DDSImage& image)
+{
+	size_t numberOfTexels = 0;
+
+	for (int mip = 0; mip < image.numberOfMipLevels; ++mip)
+	{
+		numberOfTexels += static_cast<size_t>(std::max(image.width >> mip, 1)) * std::max(image.height >> mip, 1) * image.numberOfLayers;
+	}
+
+	return numberOfTexels;
+}
+
+// Offline transcoding of every texture to block-compressed DDS files, reporting the memory footprint before and after.
+bool compressTextures()
+{
+	ThreadPool& threadPool = ThreadPool::getInstance();
+
+	std::vector<BCEncodingReport> reports;
+	bool success = MaterialLibrary::compress("resources/textures", "resources/cache/materials", MATERIAL_TEXTURE_SIZE, threadPool, reports);
+
+	size_t numberOfMaterialReports = reports.size();
+
+	// The uncompressed HDR maps are RGB16F, 6 bytes per texel.
+	auto reportHDR = [&reports](const std::string& name, const DDSImage& image, std::chrono::high_resolution_clock::time_point start)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+		reports.push_back({ name, image.format, getNumberOfTexels(image), getNumberOfTexels(image) * 6, image.data.size(), elapsed.count() });
+	};
+
+	IBLBaker baker(threadPool);
+
+	if (baker.loadEquirectangularMap(ENVIRONMENT_FILEPATH.c_str()))
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		const HDRImage& equirectangularMap = baker.getEquirectangularMap();
+
+		DDSImage equirectangularDDS = { DDSFormat::BC6H, equirectangularMap.width, equirectangularMap.height,
+			DDS::getNumberOfMipLevels(equirectangularMap.width, equirectangularMap.height), 1, false, {} };
+
+		BCEncoder::encodeLayer(equirectangularDDS, equirectangularMap.pixels.data(), threadPool);
+
+		std::filesystem::path ddsFilepath = std::filesystem::path(ENVIRONMENT_FILEPATH).replace_extension(".dds");
+
+		success = DDS::save(ddsFilepath.generic_string(), equirectangularDDS) && success;
+
+		reportHDR("environment/" + ddsFilepath.filename().string(), equirectangularDDS, start);
+
+		// The baked cubemaps are named after the IBL cache key, so they're only used with matching bake parameters.
+		IBLCache iblCache("resources/cache");
+
+		iblCache.computeKey(ENVIRONMENT_FILEPATH.c_str(), IBL_PARAMETERS);
+
+		baker.bakeEnvironment(IBL_PARAMETERS.environmentSize);
+		baker.bakePrefilter(IBL_PARAMETERS.prefilterSize, GGXSampleTable(IBL_PARAMETERS.prefilterMipLevels, IBL_PARAMETERS.sampleCount, IBL_PARAMETERS.environmentSize,
+			IBL_PARAMETERS.adaptiveSampleCount));
+
+		std::error_code error;
+		std::filesystem::create_directories("resources/cache", error);
+
+		start = std::chrono::high_resolution_clock::now();
+
+		DDSImage environmentDDS = encodeCubeMap(IBLBaker::buildMipChain(baker.getEnvironment()), threadPool);
+
+		success = DDS::save(iblCache.getCompressedFilepath("environment"), environmentDDS) && success;
+
+		reportHDR("cache/environment.dds", environmentDDS, start);
+
+		start = std::chrono::high_resolution_clock::now();
+
+		DDSImage prefilterDDS = encodeCubeMap(baker.getPrefilter(), threadPool);
+
+		success = DDS::save(iblCache.getCompressedFilepath("prefilter"), prefilterDDS) && success;
+
+		reportHDR("cache/prefilter.dds", prefilterDDS, start);
+	}
+	else
+	{
+		success = false;
+	}
+
+	const char* formatNames[] = { "BC4", "BC5", "BC6H", "BC7" };
+
+	size_t uncompressedTotal = 0, compressedTotal = 0;
+	double materialBitsBefore = 0.0, materialBitsAfter = 0.0;
+
+	std::cout << "[INFO] COMPRESSION: Texture, format, texels (mip chains included), size before -> after, bits per texel before -> after, time." << std::endl;
+
+	for (size_t i = 0; i < reports.size(); ++i)
+	{
+		const BCEncodingReport& report = reports[i];
+
+		int format = report.format == DDSFormat::BC4 ? 0 : (report.format == DDSFormat::BC5 ? 1 : (report.format == DDSFormat::BC6H ? 2 : 3));
+
+		double bitsBefore = 8.0 * report.uncompressedSize / report.numberOfTexels;
+		double bitsAfter = 8.0 * report.compressedSize / report.numberOfTexels;
+
+		std::cout << "    " << report.name << ", " << formatNames[format] << ", " << report.numberOfTexels << ", "
+			<< report.uncompressedSize / 1024.0 << " KB -> " << report.compressedSize / 1024.0 << " KB, "
+			<< bitsBefore << " -> " << bitsAfter << ", " << report.milliseconds << " ms" << std::endl;
+
+		// Both the separate and the packed ORM maps are written, only the ones the renderer uses count in the totals.
+		if (i < numberOfMaterialReports)
+		{
+			int map = static_cast<int>(i % MaterialLibrary::NUMBER_OF_MAPS);
+			bool packedMap = map == MaterialLibrary::METALLIC || map == MaterialLibrary::ROUGHNESS || map == MaterialLibrary::AO;
+
+			if (PACKED_ORM ? packedMap : map == MaterialLibrary::ORM)
+			{
+				continue;
+			}
+
+			// Averaged over the materials, each one having every map.
+			materialBitsBefore += bitsBefore * MaterialLibrary::NUMBER_OF_MAPS / numberOfMaterialReports;
+			materialBitsAfter += bitsAfter * MaterialLibrary::NUMBER_OF_MAPS / numberOfMaterialReports;
+		}
+
+		uncompressedTotal += report.uncompressedSize;
+		compressedTotal += report.compressedSize;
+	}
+
+	if (!reports.empty())
+	{
+		// Upper bound of the texel traffic of the material maps: one texel of every map per pixel, ignoring the caches.
+		double pixels = double(WINDOW_WIDTH) * WINDOW_HEIGHT;
+
+		std::cout << "[INFO] COMPRESSION: Memory footprint" << (PACKED_ORM ? " with the ORM maps " : " with the separate maps ") << uncompressedTotal / (1024.0 * 1024.0) << " MB -> " << compressedTotal / (1024.0 * 1024.0)
+			<< " MB (" << double(uncompressedTotal) / std::max(compressedTotal, size_t(1)) << "x smaller)." << std::endl;
+		std::cout << "[INFO] COMPRESSION: Sampled material texels at " << WINDOW_WIDTH << "x" << WINDOW_HEIGHT << ", " << materialBitsBefore << " -> " << materialBitsAfter
+			<< " bits per pixel, " << pixels * materialBitsBefore / 8.0 / (1024.0 * 1024.0) << " MB -> " << pixels * materialBitsAfter / 8.0 / (1024.0 * 1024.0) << " MB per frame." << std::endl;
+	}
+
+	return success;
+}
+
+// Decodes "filepath" with "stbi_loadf", then with "RadianceHDR" to every format, reporting the average times and how far
+// the texels are from the ones of "stbi_loadf". No GL context needed.
+bool benchmarkHDRDecode(const std::string& filepath)
+{
+	ThreadPool& threadPool = ThreadPool::getInstance();
+
+	const int iterations = 3;
+
+	auto elapsed = [](std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	};
+
+	// Mapped and read once before timing anything, so both decoders start from the page cache.
+	RadianceHDR image;
+
+	if (!image.open(filepath))
+	{
+		return false;
+	}
+
+	std::vector<unsigned char> warmUp(image.getDecodedSize(RadianceHDR::Format::RGBE8));
+
+	image.decode(RadianceHDR::Format::RGBE8, warmUp.data(), threadPool);
+
+	int width = image.getWidth(), height = image.getHeight();
+	size_t numberOfValues = static_cast<size_t>(width) * height * 3;
+
+	std::vector<float> reference;
+	double stbMilliseconds = 0.0, openMilliseconds = 0.0;
 
-			prefilterShader->setUniform1f("uRoughness", roughness);
-			captureFB->resizeDepthBuffer(mipWidth, mipHeight);
+	stbi_set_flip_vertically_on_load(true);
 
-			glViewport(0, 0, mipWidth, mipHeight);
+	for (int i = 0; i < iterations; ++i)
+	{
+		int stbWidth, stbHeight, colorChannels;
 
-			for (unsigned int i = 0; i < 6; ++i)
-			{
-				prefilterShader->setUniformMatrix4fv("uView", envViewMatrices[i]);
-				captureFB->bindColorBufferToFrameBuffer(prefilterCM->getID(), 0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, mip);
-				
-				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		auto start = std::chrono::high_resolution_clock::now();
 
-				glDrawArrays(GL_TRIANGLES, 0, 36);
-			}
+		float* data = stbi_loadf(filepath.c_str(), &stbWidth, &stbHeight, &colorChannels, 3);
+
+		stbMilliseconds += elapsed(start) / iterations;
+
+		if (!data || stbWidth != width || stbHeight != height)
+		{
+			std::cout << "[ERROR] HDR DECODE: \"stbi_loadf\" failed to load \"" << filepath << "\" or disagrees on its size." << std::endl;
+
+			stbi_image_free(data);
+
+			return false;
 		}
 
-		environmentCM->unbind();
-		cubeVAO->unbind();
-		captureFB->unbind();
-		prefilterShader->unbind();
+		reference.assign(data, data + numberOfValues);
+
+		stbi_image_free(data);
+
+		start = std::chrono::high_resolution_clock::now();
+
+		RadianceHDR timedImage;
+
+		timedImage.open(filepath);
+
+		openMilliseconds += elapsed(start) / iterations;
 	}
 
-	// Generate a 2D LUT from the BRDF equations used.
+	std::cout << "[INFO] HDR DECODE: \"" << filepath << "\", " << width << "x" << height << ", " << threadPool.getNumberOfThreads() << " worker threads, average of "
+		<< iterations << " decodes." << std::endl;
+	std::cout << "  stbi_loadf (RGB32F): " << stbMilliseconds << " ms" << std::endl;
+	std::cout << "  RadianceHDR open (map and index the scanlines): " << openMilliseconds << " ms" << std::endl;
+
+	const RadianceHDR::Format formats[] = { RadianceHDR::Format::RGB32F, RadianceHDR::Format::RGB16F, RadianceHDR::Format::RGBE8 };
+	const char* formatNames[] = { "RGB32F", "RGB16F", "RGBE8" };
+
+	for (int f = 0; f < 3; ++f)
 	{
-		brdfShader->bind();
-		captureFB->bind();
-		quadVAO->bind();
-		brdfLUTTex->bind(0);
+		std::vector<unsigned char> data(image.getDecodedSize(formats[f]));
+		double milliseconds = 0.0;
 
-		captureFB->resizeDepthBuffer(512, 512);
-		captureFB->bindColorBufferToFrameBuffer(brdfLUTTex->getID(), 0, GL_TEXTURE_2D);
+		for (int i = 0; i < iterations; ++i)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
 
-		glViewport(0, 0, 512, 512);
+			image.decode(formats[f], data.data(), threadPool);
 
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			milliseconds += elapsed(start) / iterations;
+		}
 
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		std::cout << "  RadianceHDR " << formatNames[f] << ": " << milliseconds << " ms, " << stbMilliseconds / (openMilliseconds + milliseconds) << "x faster open included";
 
-		brdfLUTTex->unbind();
-		quadVAO->unbind();
-		captureFB->unbind();
-		brdfShader->unbind();
+		if (formats[f] == RadianceHDR::Format::RGBE8)
+		{
+			std::cout << std::endl;
+
+			continue;
+		}
+
+		// Same measure as the bake validations. The half floats are compared to the clamped values, and the clamped ones counted.
+		const float* floats = reinterpret_cast<const float*>(data.data());
+		const uint16_t* halves = reinterpret_cast<const uint16_t*>(data.data());
+
+		float maxError = 0.0f;
+		size_t clampedValues = 0;
+
+		for (size_t i = 0; i < numberOfValues; ++i)
+		{
+			float expected = formats[f] == RadianceHDR::Format::RGB32F ? reference[i] : std::min(reference[i], 65504.0f);
+			float value = formats[f] == RadianceHDR::Format::RGB32F ? floats[i] : glm::unpackHalf1x16(halves[i]);
+
+			maxError = std::max(maxError, std::abs(expected - value) / std::max(std::abs(expected), 1.0f));
+			clampedValues += reference[i] > 65504.0f ? 1 : 0;
+		}
+
+		std::cout << ", maximum relative error " << maxError;
+
+		if (formats[f] == RadianceHDR::Format::RGB16F)
+		{
+			std::cout << " (" << clampedValues << " values clamped to 65504)";
+		}
+
+		std::cout << std::endl;
 	}
 
-	glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+	return true;
 }
 
-void renderSphere()
+bool parseArguments(int argc, char** argv)
 {
-	sphereVAO->bind();
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--headless") == 0 && i + 1 < argc)
+		{
+			HEADLESS = true;
+			HEADLESS_FRAMES = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (std::strcmp(argv[i], "--material") == 0 && i + 1 < argc)
+		{
+			MATERIAL_NAME = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+		{
+			OUTPUT_DIRECTORY = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--size") == 0 && i + 2 < argc)
+		{
+			WINDOW_WIDTH = std::max(std::atoi(argv[++i]), 1);
+			WINDOW_HEIGHT = std::max(std::atoi(argv[++i]), 1);
+			WINDOW_ASPECT_RATIO = (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT;
 
-	glDrawElements(GL_TRIANGLE_STRIP, sphereIndexCount, GL_UNSIGNED_INT, 0);
+			projectionMatrix = glm::perspective(glm::radians(FIELD_OF_VIEW), WINDOW_ASPECT_RATIO, NEAR_PLANE, FAR_PLANE);
+		}
+		else if (std::strcmp(argv[i], "--material-size") == 0 && i + 1 < argc)
+		{
+			MATERIAL_TEXTURE_SIZE = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (std::strcmp(argv[i], "--lights") == 0 && i + 1 < argc)
+		{
+			NUMBER_OF_LIGHTS = std::max(std::atoi(argv[++i]), 0);
+		}
+		else if (std::strcmp(argv[i], "--cpu-light-culling") == 0)
+		{
+			CPU_LIGHT_CULLING = true;
+		}
+		else if (std::strcmp(argv[i], "--benchmark-lights") == 0)
+		{
+			LIGHT_CULLING_BENCHMARK = true;
+		}
+		else if (std::strcmp(argv[i], "--grid") == 0 && i + 1 < argc)
+		{
+			SPHERE_GRID_SIZE = std::max(std::atoi(argv[++i]), 1);
 
-	sphereVAO->unbind();
+			frameSphereGrid(SPHERE_GRID_SIZE);
+		}
+		else if (std::strcmp(argv[i], "--draw-per-sphere") == 0)
+		{
+			INSTANCED_RENDERING = false;
+		}
+		else if (std::strcmp(argv[i], "--benchmark-instancing") == 0)
+		{
+			INSTANCING_BENCHMARK = true;
+		}
+		else if (std::strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc)
+		{
+			BENCHMARK_OUTPUT = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--benchmark-frames") == 0 && i + 1 < argc)
+		{
+			BENCHMARK_FRAMES = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (std::strcmp(argv[i], "--compress-textures") == 0)
+		{
+			COMPRESS_TEXTURES = true;
+		}
+		else if (std::strcmp(argv[i], "--compressed-ibl") == 0)
+		{
+			COMPRESSED_IBL = true;
+		}
+		else if (std::strcmp(argv[i], "--unpacked-maps") == 0)
+		{
+			PACKED_ORM = false;
+		}
+		else if (std::strcmp(argv[i], "--no-ibl") == 0)
+		{
+			IBL_ENABLED = false;
+		}
+		else if (std::strcmp(argv[i], "--no-shader-cache") == 0)
+		{
+			SHADER_BINARY_CACHE = false;
+		}
+		else if (std::strcmp(argv[i], "--serial-shader-compile") == 0)
+		{
+			PARALLEL_SHADER_COMPILE = false;
+		}
+		else if (std::strcmp(argv[i], "--no-hot-reload") == 0)
+		{
+			SHADER_HOT_RELOAD = false;
+		}
+		else if (std::strcmp(argv[i], "--no-culling") == 0)
+		{
+			OBJECT_CULLING = false;
+		}
+		else if (std::strcmp(argv[i], "--no-occlusion-culling") == 0)
+		{
+			OCCLUSION_CULLING = false;
+		}
+		else if (std::strcmp(argv[i], "--depth-prepass") == 0)
+		{
+			DEPTH_PREPASS = true;
+		}
+		else if (std::strcmp(argv[i], "--benchmark-prepass") == 0)
+		{
+			DEPTH_PREPASS_BENCHMARK = true;
+		}
+		else if (std::strcmp(argv[i], "--deferred") == 0)
+		{
+			DEFERRED_SHADING = true;
+		}
+		else if (std::strcmp(argv[i], "--benchmark-deferred") == 0)
+		{
+			DEFERRED_SHADING_BENCHMARK = true;
+		}
+		else if (std::strcmp(argv[i], "--gpu-ibl-bake") == 0)
+		{
+			CPU_IBL_BAKE = false;
+		}
+		else if (std::strcmp(argv[i], "--raster-ibl-bake") == 0)
+		{
+			CPU_IBL_BAKE = false;
+			COMPUTE_IBL_BAKE = false;
+		}
+		else if (std::strcmp(argv[i], "--benchmark-ibl-bake") == 0)
+		{
+			IBL_BAKE_BENCHMARK = true;
+		}
+		else if (std::strcmp(argv[i], "--ibl-update-budget") == 0 && i + 1 < argc)
+		{
+			IBL_UPDATE_BUDGET = std::max(static_cast<float>(std::atof(argv[++i])), 0.0f);
+		}
+		else if (std::strcmp(argv[i], "--reflection-probes") == 0)
+		{
+			REFLECTION_PROBES = true;
+		}
+		else if (std::strcmp(argv[i], "--probe-captures") == 0 && i + 1 < argc)
+		{
+			PROBE_CAPTURES_PER_FRAME = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (std::strcmp(argv[i], "--benchmark-hdr-decode") == 0 && i + 1 < argc)
+		{
+			HDR_DECODE_BENCHMARK = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+		{
+			PROFILE_OUTPUT = argv[++i];
+		}
+		else
+		{
+			std::cout << "[ERROR] PROGRAM: Unknown argument \"" << argv[i] << "\"." << std::endl;
+			std::cout << "Usage: PBR [--headless <frames>] [--material <name>] [--output <directory>] [--size <width> <height>] [--material-size <size>] [--lights <count>] [--cpu-light-culling] [--benchmark-lights]"
+				<< " [--grid <size>] [--draw-per-sphere] [--benchmark-instancing] [--compress-textures] [--compressed-ibl] [--unpacked-maps]"
+				<< " [--no-ibl] [--no-shader-cache] [--serial-shader-compile] [--no-hot-reload] [--profile <trace.json>]"
+				<< " [--benchmark <report.json>] [--benchmark-frames <count>] [--no-culling] [--no-occlusion-culling]"
+				<< " [--depth-prepass] [--benchmark-prepass] [--deferred] [--benchmark-deferred] [--gpu-ibl-bake] [--raster-ibl-bake] [--benchmark-ibl-bake]"
+				<< " [--ibl-update-budget <ms>] [--reflection-probes] [--probe-captures <count>] [--benchmark-hdr-decode <file.hdr>]" << std::endl;
+
+			return false;
+		}
+	}
+
+	return true;
 }
 
-void renderCube()
+// Destroys the window, or the windowless context of the offscreen modes.
+void destroyContext(GLFWwindow* window, OffscreenContext* offscreenContext)
 {
-	cubeVAO->bind();
-
-	glDrawArrays(GL_TRIANGLES, 0, 36);
+	delete offscreenContext;
 
-	cubeVAO->unbind();
+	if (window)
+	{
+		glfwDestroyWindow(window);
+		glfwTerminate();
+	}
 }
 
-void render()
+// Writes the trace of the whole run and the summary of the last frames, with "--profile".
+void finishProfiling()
 {
-	glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	Profiler& profiler = Profiler::getInstance();
 
-	pbrShader->bind();
+	if (!profiler.isEnabled())
+	{
+		return;
+	}
 
-	pbrShader->setUniformMatrix4fv("uProjection", projectionMatrix);
-	pbrShader->setUniformMatrix4fv("uView", camera.getViewMatrix());
-	pbrShader->setUniform3f("uCameraPos", camera.getPosition());
+	profiler.flush();
+	profiler.printSummary();
 
-	for (int n = 0; n < 4; ++n)
+	if (profiler.writeChromeTrace(PROFILE_OUTPUT))
 	{
-		pbrShader->setUniform3f(("uLightPositions[" + std::to_string(n) + "]").c_str(), lightPositions[n]);
-		pbrShader->setUniform3f(("uLightColors[" + std::to_string(n) + "]").c_str(), lightColors[n]);
+		std::cout << "[INFO] PROFILER: Trace written to \"" << PROFILE_OUTPUT << "\"." << std::endl;
 	}
+}
 
-	albedoTex->bind(0);
-	normalTex->bind(1);
-	metallicTex->bind(2);
-	roughnessTex->bind(3);
-	aoTex->bind(4);
-	irradianceCM->bind(5);
-	prefilterCM->bind(6);
-	brdfLUTTex->bind(7);
+int main(int argc, char** argv)
+{
+	// A mistyped option would otherwise run another mode, e.g. open the window in the middle of a batch job.
+	if (!parseArguments(argc, argv))
+	{
+		return -1;
+	}
 
-	// Rendering material.
-	glm::mat4 modelMatrix = glm::mat4(1.0f);
+	// Offline tools, no GL context needed.
+	if (COMPRESS_TEXTURES)
+	{
+		return compressTextures() ? 0 : -1;
+	}
 
-	pbrShader->setUniformMatrix4fv("uModel", modelMatrix);
-	pbrShader->setUniformMatrix3fv("uNormalMatrix", glm::transpose(glm::inverse(glm::mat3(modelMatrix))));
+	if (!HDR_DECODE_BENCHMARK.empty())
+	{
+		return benchmarkHDRDecode(HDR_DECODE_BENCHMARK) ? 0 : -1;
+	}
 
-	renderSphere();
+	bool offscreen = HEADLESS || LIGHT_CULLING_BENCHMARK || INSTANCING_BENCHMARK || DEPTH_PREPASS_BENCHMARK || DEFERRED_SHADING_BENCHMARK || IBL_BAKE_BENCHMARK
+		|| !BENCHMARK_OUTPUT.empty();
 
-	pbrShader->unbind();
+	GLFWwindow* window = nullptr;
+	OffscreenContext* offscreenContext = nullptr;
+	GLADloadproc getProcAddress = (GLADloadproc)glfwGetProcAddress;
 
-	// Rendering background.
-	environmentShader->bind();
+	// Offscreen modes render into their own framebuffers, so they don't need a window (nor a display server) when
+	// a windowless context can be created.
+	//
+	if (offscreen)
+	{
+		offscreenContext = new OffscreenContext();
 
-	environmentShader->setUniformMatrix4fv("uProjection", projectionMatrix);
-	environmentShader->setUniformMatrix4fv("uView", camera.getViewMatrix());
+		if (offscreenContext->create(CONTEXT_MAJOR_VERSION, CONTEXT_MINOR_VERSION, true))
+		{
+			std::cout << "[INFO] HEADLESS: Rendering without a window, through " << offscreenContext->getName() << "." << std::endl;
 
-	environmentCM->bind(0);
+			getProcAddress = OffscreenContext::getProcAddress;
+		}
+		else
+		{
+			std::cout << "[INFO] HEADLESS: No windowless context (EGL or OSMesa), rendering in a hidden window." << std::endl;
 
-	renderCube();
+			delete offscreenContext;
 
-	environmentShader->unbind();
-}
+			offscreenContext = nullptr;
+		}
+	}
 
-int main()
-{
-	if (!glfwInit())
+	if (!offscreenContext)
 	{
-		std::cout << "Failed to initialize GLFW!" << std::endl;
+		if (!glfwInit())
+		{
+			std::cout << "Failed to initialize GLFW!" << std::endl;
 
-		return -1;
-	}
+			return -1;
+		}
+
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, CONTEXT_MAJOR_VERSION);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, CONTEXT_MINOR_VERSION);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_SAMPLES, 4);
+		glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
 
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-	glfwWindowHint(GLFW_SAMPLES, 4);
-	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
+		if (offscreen)
+		{
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		}
 
-	GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "PBR", NULL, NULL);
+		window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "PBR", NULL, NULL);
 
-	if (!window)
-	{
-		std::cout << "Failed to create GLFW context/window!" << std::endl;
-		glfwTerminate();
+		if (!window)
+		{
+			std::cout << "Failed to create GLFW context/window!" << std::endl;
+			glfwTerminate();
 
-		return -1;
-	}
+			return -1;
+		}
 
-	glfwMakeContextCurrent(window);
+		glfwMakeContextCurrent(window);
 
-	glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
-	glfwSetKeyCallback(window, keyboardCallback);
-	glfwSetCursorPosCallback(window, cursorPositionCallback);
-	glfwSetScrollCallback(window, scrollCallback);
+		if (!offscreen)
+		{
+			glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+			glfwSetKeyCallback(window, keyboardCallback);
+			glfwSetCursorPosCallback(window, cursorPositionCallback);
+			glfwSetScrollCallback(window, scrollCallback);
 
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+			glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		}
+	}
 
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	if (!gladLoadGLLoader(getProcAddress))
 	{
 		std::cout << "Failed to initialize GLAD!" << std::endl;
-		glfwTerminate();
+		destroyContext(window, offscreenContext);
 
 		return -1;
 	}
 
+	if (PARALLEL_SHADER_COMPILE)
+	{
+		ShaderProgram::enableParallelCompile(getProcAddress);
+	}
+
+	if (!PROFILE_OUTPUT.empty())
+	{
+		Profiler::getInstance().setEnabled(true);
+		Profiler::getInstance().setThreadName("Main");
+	}
+
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LEQUAL); // Set depth function to "less than AND equal" for SKYBOX depth trick.
 	
@@ -560,22 +3127,175 @@ int main()
 		glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
 	}
 
+	if (!BENCHMARK_OUTPUT.empty())
+	{
+		benchmarkReport = new BenchmarkReport();
+	}
+
 	setupApplication();
 
+	// Offscreen modes draw into a framebuffer of their own, and need the final images: they don't start before every texture is uploaded.
+	if (offscreen)
+	{
+		offscreenTex = new Texture(WINDOW_WIDTH, WINDOW_HEIGHT, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+		offscreenFB = new FrameBuffer(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+		offscreenFB->bind();
+		offscreenFB->bindColorBufferToFrameBuffer(offscreenTex->getID(), 0, GL_TEXTURE_2D);
+
+		auto waitStart = std::chrono::high_resolution_clock::now();
+
+		textureLoader->finish();
+		materialLibrary->isReady();
+
+		std::chrono::duration<double, std::milli> waitTime = std::chrono::high_resolution_clock::now() - waitStart;
+
+		std::cout << "[INFO] TEXTURE LOADER: Slowest decode " << textureLoader->getSlowestDecodeTime() << " ms, "
+			<< textureLoader->getTotalDecodeTime() << " ms for all the decodes." << std::endl;
+
+		if (benchmarkReport)
+		{
+			benchmarkReport->addValue("texture_load_ms", "Slowest decode", textureLoader->getSlowestDecodeTime());
+			benchmarkReport->addValue("texture_load_ms", "Total decode", textureLoader->getTotalDecodeTime());
+			benchmarkReport->addValue("texture_load_ms", "Wait after setup", waitTime.count());
+		}
+	}
+
+	if (benchmarkReport)
+	{
+		runBenchmark();
+
+		finishProfiling();
+
+		delete benchmarkReport;
+
+		destroyContext(window, offscreenContext);
+
+		return 0;
+	}
+
+	if (LIGHT_CULLING_BENCHMARK || INSTANCING_BENCHMARK || DEPTH_PREPASS_BENCHMARK || DEFERRED_SHADING_BENCHMARK || IBL_BAKE_BENCHMARK)
+	{
+		if (LIGHT_CULLING_BENCHMARK)
+		{
+			benchmarkLightCulling();
+		}
+
+		if (INSTANCING_BENCHMARK)
+		{
+			benchmarkInstancing();
+		}
+
+		if (DEPTH_PREPASS_BENCHMARK)
+		{
+			benchmarkDepthPrepass();
+		}
+
+		if (DEFERRED_SHADING_BENCHMARK)
+		{
+			benchmarkDeferredShading();
+		}
+
+		if (IBL_BAKE_BENCHMARK && !COMPRESSED_IBL)
+		{
+			benchmarkIBLBake();
+		}
+
+		finishProfiling();
+
+		destroyContext(window, offscreenContext);
+
+		return 0;
+	}
+
+	if (HEADLESS)
+	{
+		renderHeadless();
+
+		finishProfiling();
+
+		destroyContext(window, offscreenContext);
+
+		return 0;
+	}
+
+	// Uniform call statistics shown in the window title, averaged per frame over one second.
+	float statisticsTime = static_cast<float>(glfwGetTime());
+	int statisticsFrames = 0;
+
+	ShaderProgram::resetUniformStatistics();
+
+	if (SHADER_HOT_RELOAD)
+	{
+		shaderWatcher = new FileWatcher("sources/shaders");
+	}
+
+	// Rolling profiler summary, printed every few seconds with "--profile".
+	float summaryTime = static_cast<float>(glfwGetTime());
+
 	while (!glfwWindowShouldClose(window))
 	{
+		Profiler::getInstance().beginFrame();
+
 		float currentFrame = static_cast<float>(glfwGetTime());
 
 		DELTA_TIME = currentFrame - LAST_FRAME;
 		LAST_FRAME = currentFrame;
 
+		if (SHADER_HOT_RELOAD)
+		{
+			updateShaderHotReload();
+		}
+
 		processInput(window);
-		render();
 
-		glfwSwapBuffers(window);
+		{
+			PROFILE_CPU("Frame");
+
+			updateIBL();
+			render();
+		}
+
+		statisticsFrames++;
+
+		if (currentFrame - statisticsTime >= 1.0f)
+		{
+			ShaderProgram::UniformStatistics uniformStatistics = ShaderProgram::getUniformStatistics();
+			ObjectCulling::Statistics cullingStatistics = objectCulling->getStatistics();
+			char title[208];
+
+			std::snprintf(title, sizeof(title), "PBR (%s) - %.1f FPS - uniform calls/frame: %.1f issued, %.1f skipped - spheres: %u/%u visible, %u outside, %u occluded",
+				DEFERRED_SHADING ? "deferred" : "forward", statisticsFrames / (currentFrame - statisticsTime), double(uniformStatistics.issuedCalls) / statisticsFrames, double(uniformStatistics.skippedCalls) / statisticsFrames,
+				cullingStatistics.visible, cullingStatistics.tested, cullingStatistics.frustumCulled, cullingStatistics.occluded);
+
+			glfwSetWindowTitle(window, title);
+
+			ShaderProgram::resetUniformStatistics();
+
+			statisticsTime = currentFrame;
+			statisticsFrames = 0;
+		}
+
+		if (Profiler::getInstance().isEnabled() && currentFrame - summaryTime >= 5.0f)
+		{
+			Profiler::getInstance().printSummary();
+
+			summaryTime = currentFrame;
+		}
+
+		{
+			PROFILE_CPU("Swap");
+
+			glfwSwapBuffers(window);
+		}
+
 		glfwPollEvents();
+
+		Profiler::getInstance().endFrame();
 	}
 
+	finishProfiling();
+
 	glfwDestroyWindow(window);
 	glfwTerminate();
 
@@ -590,7 +3310,7 @@ void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 
 	glViewport(0, 0, width, height);
 
-	projectionMatrix = glm::perspective(glm::radians(FIELD_OF_VIEW), WINDOW_ASPECT_RATIO, 0.1f, 100.0f);
+	projectionMatrix = glm::perspective(glm::radians(FIELD_OF_VIEW), WINDOW_ASPECT_RATIO, NEAR_PLANE, FAR_PLANE);
 }
 
 void keyboardCallback(GLFWwindow* window, int key, int scanCode, int action, int mods)
@@ -599,6 +3319,18 @@ void keyboardCallback(GLFWwindow* window, int key, int scanCode, int action, int
 	{
 		glfwSetWindowShouldClose(window, true);
 	}
+
+	if (key == GLFW_KEY_G && action == GLFW_PRESS) // Switch between the forward and deferred paths.
+	{
+		DEFERRED_SHADING = !DEFERRED_SHADING;
+
+		std::cout << "[INFO] PROGRAM: " << (DEFERRED_SHADING ? "Deferred" : "Forward") << " shading." << std::endl;
+	}
+
+	if (key == GLFW_KEY_E && action == GLFW_PRESS) // Swap to the next HDR environment, rebaked over the next frames.
+	{
+		swapEnvironment();
+	}
 }
 
 void cursorPositionCallback(GLFWwindow* window, double xPos, double yPos)
@@ -631,7 +3363,7 @@ void scrollCallback(GLFWwindow* window, double xOffset, double yOffset)
 	FIELD_OF_VIEW = FIELD_OF_VIEW - (float)yOffset;
 	FIELD_OF_VIEW = std::min(std::max(FIELD_OF_VIEW, 1.0f), 45.0f);
 
-	projectionMatrix = glm::perspective(glm::radians(FIELD_OF_VIEW), WINDOW_ASPECT_RATIO, 0.1f, 100.0f);
+	projectionMatrix = glm::perspective(glm::radians(FIELD_OF_VIEW), WINDOW_ASPECT_RATIO, NEAR_PLANE, FAR_PLANE);
 }
 
 void processInput(GLFWwindow* window)
@@ -0,0 +1,164 @@
+#include "clusteredlighting.h"
+
+static const int CULLING_GROUP_SIZE = 128; // "local_size_x" of "5_cluster_light_culling_cs.glsl".
+
+ClusteredLighting::ClusteredLighting(int sizeX, int sizeY, int sizeZ, int maxLightsPerCluster)
+	: sizeX(sizeX), sizeY(sizeY), sizeZ(sizeZ), maxLightsPerCluster(maxLightsPerCluster), lights(), lightCounts(), lightIndices(),
+	lightBuffer(nullptr), lightCountBuffer(nullptr), lightIndexBuffer(nullptr), cullingShader(nullptr)
+{
+	int numberOfClusters = getNumberOfClusters();
+
+	lightBuffer = new SSBO(sizeof(PointLight));
+	lightCountBuffer = new SSBO(numberOfClusters * sizeof(uint32_t));
+	lightIndexBuffer = new SSBO(numberOfClusters * maxLightsPerCluster * sizeof(uint32_t));
+
+	cullingShader = new ShaderProgram("sources/shaders/5_cluster_light_culling_cs.glsl");
+}
+
+void ClusteredLighting::setLights(const std::vector<PointLight>& lights)
+{
+	this->lights = lights;
+
+	if (!lights.empty())
+	{
+		lightBuffer->setData(static_cast<int>(lights.size() * sizeof(PointLight)), lights.data());
+	}
+}
+
+void ClusteredLighting::getLightData(float nearPlane, float farPlane, LightData& lightData)
+{
+	float logDepthRange = std::log(farPlane / nearPlane);
+
+	lightData.clusterGrid = glm::uvec4(sizeX, sizeY, sizeZ, maxLightsPerCluster);
+	lightData.clusterDepth = glm::vec4(sizeZ / logDepthRange, -sizeZ * std::log(nearPlane) / logDepthRange, 0.0f, 0.0f);
+	lightData.count = glm::ivec4(static_cast<int>(lights.size()), 0, 0, 0);
+}
+
+void ClusteredLighting::cullOnGPU()
+{
+	bind();
+
+	cullingShader->bind();
+
+	glDispatchCompute((getNumberOfClusters() + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE, 1, 1);
+
+	cullingShader->unbind();
+
+	// The lists are read by the fragment shader of the next draws.
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void ClusteredLighting::cullOnCPU(const CameraData& cameraData, const LightData& lightData, ThreadPool& threadPool)
+{
+	binLights(cameraData, lightData, lights, threadPool, lightCounts, lightIndices);
+
+	lightCountBuffer->setSubData(0, static_cast<int>(lightCounts.size() * sizeof(uint32_t)), lightCounts.data());
+	lightIndexBuffer->setSubData(0, static_cast<int>(lightIndices.size() * sizeof(uint32_t)), lightIndices.data());
+}
+
+void ClusteredLighting::bind()
+{
+	lightBuffer->bindBase(LIGHT_BUFFER_BINDING);
+	lightCountBuffer->bindBase(CLUSTER_LIGHT_COUNT_BUFFER_BINDING);
+	lightIndexBuffer->bindBase(CLUSTER_LIGHT_INDEX_BUFFER_BINDING);
+}
+
+int ClusteredLighting::getNumberOfClusters()
+{
+	return sizeX * sizeY * sizeZ;
+}
+
+void ClusteredLighting::binLights(const CameraData& cameraData, const LightData& lightData, const std::vector<PointLight>& lights, ThreadPool& threadPool,
+	std::vector<uint32_t>& lightCounts, std::vector<uint32_t>& lightIndices)
+{
+	int numberOfClusters = int(lightData.clusterGrid.x * lightData.clusterGrid.y * lightData.clusterGrid.z);
+	int numberOfLights = std::min(lightData.count.x, static_cast<int>(lights.size()));
+	uint32_t maxLightsPerCluster = lightData.clusterGrid.w;
+
+	lightCounts.assign(numberOfClusters, 0);
+	lightIndices.resize(static_cast<size_t>(numberOfClusters) * maxLightsPerCluster);
+
+	// View space position and radius of every light.
+	std::vector<glm::vec4> viewLights(numberOfLights);
+
+	threadPool.parallelFor(0, numberOfLights, 256, [&cameraData, &lights, &viewLights](int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
+		{
+			glm::vec3 viewPosition = glm::vec3(cameraData.view * glm::vec4(glm::vec3(lights[i].positionRadius), 1.0f));
+
+			viewLights[i] = glm::vec4(viewPosition, lights[i].positionRadius.w);
+		}
+	});
+
+	threadPool.parallelFor(0, numberOfClusters, 32, [&](int begin, int end)
+	{
+		for (int cluster = begin; cluster < end; ++cluster)
+		{
+			glm::vec3 aabbMin, aabbMax;
+
+			computeClusterBounds(cameraData, lightData, cluster, aabbMin, aabbMax);
+
+			uint32_t* indices = &lightIndices[static_cast<size_t>(cluster) * maxLightsPerCluster];
+			uint32_t count = 0;
+
+			// Same order as the compute shader, lights past the maximum are dropped.
+			for (int i = 0; i < numberOfLights && count < maxLightsPerCluster; ++i)
+			{
+				glm::vec3 center = glm::vec3(viewLights[i]);
+				glm::vec3 closestPoint = glm::clamp(center, aabbMin, aabbMax);
+				glm::vec3 offset = closestPoint - center;
+
+				if (glm::dot(offset, offset) <= viewLights[i].w * viewLights[i].w)
+				{
+					indices[count++] = static_cast<uint32_t>(i);
+				}
+			}
+
+			lightCounts[cluster] = count;
+		}
+	});
+}
+
+void ClusteredLighting::computeClusterBounds(const CameraData& cameraData, const LightData& lightData, int cluster, glm::vec3& aabbMin, glm::vec3& aabbMax)
+{
+	// Mirror of "computeClusterBounds" in "5_cluster_light_culling_cs.glsl".
+	glm::uvec4 grid = lightData.clusterGrid;
+
+	int x = cluster % grid.x;
+	int y = (cluster / grid.x) % grid.y;
+	int z = cluster / (grid.x * grid.y);
+
+	float nearPlane = cameraData.viewport.z, farPlane = cameraData.viewport.w;
+
+	// Corners of the screen tile, on the near plane.
+	glm::vec2 ndcMin = glm::vec2(float(x) / grid.x, float(y) / grid.y) * 2.0f - 1.0f;
+	glm::vec2 ndcMax = glm::vec2(float(x + 1) / grid.x, float(y + 1) / grid.y) * 2.0f - 1.0f;
+
+	glm::vec4 cornerMin = cameraData.inverseProjection * glm::vec4(ndcMin, -1.0f, 1.0f);
+	glm::vec4 cornerMax = cameraData.inverseProjection * glm::vec4(ndcMax, -1.0f, 1.0f);
+
+	glm::vec3 nearMin = glm::vec3(cornerMin) / cornerMin.w;
+	glm::vec3 nearMax = glm::vec3(cornerMax) / cornerMax.w;
+
+	// Depth range of the slice, then the corners moved along their view rays to both ends of it.
+	float sliceNear = nearPlane * std::pow(farPlane / nearPlane, float(z) / grid.z);
+	float sliceFar = nearPlane * std::pow(farPlane / nearPlane, float(z + 1) / grid.z);
+
+	glm::vec3 corners[4] = {
+		nearMin * (sliceNear / nearPlane),
+		nearMin * (sliceFar / nearPlane),
+		nearMax * (sliceNear / nearPlane),
+		nearMax * (sliceFar / nearPlane)
+	};
+
+	aabbMin = glm::min(glm::min(corners[0], corners[1]), glm::min(corners[2], corners[3]));
+	aabbMax = glm::max(glm::max(corners[0], corners[1]), glm::max(corners[2], corners[3]));
+}
+
+float ClusteredLighting::computeLightRadius(const glm::vec3& color, float cutoff)
+{
+	float intensity = std::max(color.r, std::max(color.g, color.b));
+
+	return std::sqrt(intensity / cutoff);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "ssbo.h"
+#include "shader.h"
+#include "uniformblocks.h"
+
+#include "../utils/threadpool.h"
+
+// Clustered forward light culling.
+//
+// The view frustum is split in "sizeX * sizeY * sizeZ" clusters (screen space tiles, logarithmic slices in depth)
+// and every light is binned in the clusters its sphere of influence overlaps, so the PBR shader only iterates over
+// the lights of the cluster of each fragment. The binning runs on "5_cluster_light_culling_cs.glsl", or on the
+// thread pool through "binLights", which doesn't touch OpenGL and produces the same lists.
+//
+class ClusteredLighting
+{
+public:
+	ClusteredLighting(int sizeX = 16, int sizeY = 9, int sizeZ = 24, int maxLightsPerCluster = 256);
+
+	void setLights(const std::vector<PointLight>& lights);
+
+	// Grid parameters and number of lights, as expected by the light block.
+	void getLightData(float nearPlane, float farPlane, LightData& lightData);
+
+	// Both bin the lights with the camera of the last frame data. The GPU path reads it from the bound uniform blocks.
+	void cullOnGPU();
+	void cullOnCPU(const CameraData& cameraData, const LightData& lightData, ThreadPool& threadPool);
+
+	// Binds the light, count and index buffers to their storage block bindings.
+	void bind();
+
+	int getNumberOfClusters();
+	int getMaxLightsPerCluster() { return maxLightsPerCluster; }
+	ShaderProgram* getCullingShader() { return cullingShader; }
+	const std::vector<uint32_t>& getLightCounts() { return lightCounts; }
+
+	// Light counts per cluster, then "maxLightsPerCluster" indices per cluster, laid out like the storage buffers.
+	static void binLights(const CameraData& cameraData, const LightData& lightData, const std::vector<PointLight>& lights, ThreadPool& threadPool,
+		std::vector<uint32_t>& lightCounts, std::vector<uint32_t>& lightIndices);
+
+	// View space bounding box of a cluster.
+	static void computeClusterBounds(const CameraData& cameraData, const LightData& lightData, int cluster, glm::vec3& aabbMin, glm::vec3& aabbMax);
+
+	// Distance at which the inverse square falloff of "color" drops below "cutoff".
+	static float computeLightRadius(const glm::vec3& color, float cutoff = 0.05f);
+
+private:
+	int sizeX, sizeY, sizeZ;
+	int maxLightsPerCluster;
+
+	std::vector<PointLight> lights;
+	std::vector<uint32_t> lightCounts;
+	std::vector<uint32_t> lightIndices;
+
+	SSBO* lightBuffer;
+	SSBO* lightCountBuffer;
+	SSBO* lightIndexBuffer;
+
+	ShaderProgram* cullingShader;
+};
@@ -40,11 +40,79 @@ CubeMap::CubeMap(int width, int height, int internalFormat, int format, int type
 	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
+CubeMap::CubeMap(const DDSImage& image)
+	: ID()
+{
+	if (!image.cubeMap || image.numberOfLayers != 6)
+	{
+		std::cout << "[ERROR] CUBEMAP: Compressed image isn't a single cubemap." << std::endl;
+	}
+
+	int internalFormat = DDS::getGLInternalFormat(image.format);
+
+	glGenTextures(1, &ID);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, ID);
+
+	for (int face = 0; face < 6 && face < image.numberOfLayers; ++face)
+	{
+		for (int mip = 0; mip < image.numberOfMipLevels; ++mip)
+		{
+			int mipWidth = std::max(image.width >> mip, 1), mipHeight = std::max(image.height >> mip, 1);
+
+			glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, mip, internalFormat, mipWidth, mipHeight, 0, static_cast<GLsizei>(DDS::getLevelSize(image, mip)),
+				image.data.data() + DDS::getLevelOffset(image, face, mip));
+		}
+	}
+
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, image.numberOfMipLevels - 1);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, image.numberOfMipLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+CubeMap::~CubeMap()
+{
+	glDeleteTextures(1, &ID);
+}
+
 unsigned int CubeMap::getID()
 {
 	return ID;
 }
 
+void CubeMap::setFaceData(int face, int mipLevel, int width, int height, int format, int type, const void* data)
+{
+	glBindTexture(GL_TEXTURE_CUBE_MAP, ID);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, mipLevel, 0, 0, width, height, format, type, data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+void CubeMap::getFaceData(int face, int mipLevel, int format, int type, void* data)
+{
+	glBindTexture(GL_TEXTURE_CUBE_MAP, ID);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, mipLevel, format, type, data);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+void CubeMap::generateMipMaps()
+{
+	glBindTexture(GL_TEXTURE_CUBE_MAP, ID);
+	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
 void CubeMap::bind(int unit)
 {
 	if (unit >= 0 && unit <= 15)
@@ -4,6 +4,8 @@
 
 #include <glad/glad.h>
 
+#include "../utils/dds.h"
+
 #if !defined _STB_IMAGE_INCLUDED
 #define _STB_IMAGE_INCLUDED
 
@@ -14,9 +16,20 @@ class CubeMap
 {
 public:
 	CubeMap(int width, int height, int internalFormat, int format, int type, bool generateMipMaps = false);
+	CubeMap(const DDSImage& image); // Block-compressed cubemap, with the mip levels of the image.
+	~CubeMap();
+
+	CubeMap(const CubeMap&) = delete;
+	CubeMap& operator=(const CubeMap&) = delete;
 
 	unsigned int getID();
 
+	void setFaceData(int face, int mipLevel, int width, int height, int format, int type, const void* data);
+	void getFaceData(int face, int mipLevel, int format, int type, void* data);
+
+	// Rebuilds the levels below the base one, for a cubemap created with mips.
+	void generateMipMaps();
+
 	void bind(int unit);
 	void unbind();
 
@@ -0,0 +1,46 @@
+#include "cubemaparray.h"
+
+CubeMapArray::CubeMapArray(int size, int numberOfCubeMaps, int internalFormat, int mipLevels)
+	: ID(), size(size), numberOfCubeMaps(numberOfCubeMaps), mipLevels(mipLevels)
+{
+	glGenTextures(1, &ID);
+	glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, ID);
+
+	glTexStorage3D(GL_TEXTURE_CUBE_MAP_ARRAY, mipLevels, internalFormat, size, size, 6 * numberOfCubeMaps);
+
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, mipLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+}
+
+CubeMapArray::~CubeMapArray()
+{
+	glDeleteTextures(1, &ID);
+}
+
+unsigned int CubeMapArray::getID()
+{
+	return ID;
+}
+
+void CubeMapArray::bind(int unit)
+{
+	if (unit >= 0 && unit <= 15)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, ID);
+	}
+	else
+	{
+		std::cout << "[ERROR] CUBEMAP ARRAY: Failed to bind cubemap array in " << unit << " unit." << std::endl;
+	}
+}
+
+void CubeMapArray::unbind()
+{
+	glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+}
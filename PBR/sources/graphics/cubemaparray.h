@@ -0,0 +1,32 @@
+#pragma once
+
+#include <iostream>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+// Cubemap array with immutable storage, every cubemap sharing the same size, format and mip levels. Its layers are
+// the faces of the cubemaps, cubemap "i" taking the layers "6 * i" to "6 * i + 5".
+class CubeMapArray
+{
+public:
+	CubeMapArray(int size, int numberOfCubeMaps, int internalFormat, int mipLevels = 1);
+	~CubeMapArray();
+
+	CubeMapArray(const CubeMapArray&) = delete;
+	CubeMapArray& operator=(const CubeMapArray&) = delete;
+
+	unsigned int getID();
+
+	int getSize() { return size; }
+	int getNumberOfCubeMaps() { return numberOfCubeMaps; }
+	int getNumberOfMipLevels() { return mipLevels; }
+
+	void bind(int unit);
+	void unbind();
+
+private:
+	unsigned int ID;
+	int size, numberOfCubeMaps;
+	int mipLevels;
+};
@@ -1,16 +1,29 @@
 #include "framebuffer.h"
 
-FrameBuffer::FrameBuffer(int width, int height)
+FrameBuffer::FrameBuffer(int width, int height, bool depthRenderBuffer)
 	: ID(), depthBufferID()
 {
 	glGenFramebuffers(1, &ID);
 	glBindFramebuffer(GL_FRAMEBUFFER, ID);
 
-	attachRenderBufferAsDepthBuffer(width, height);
+	if (depthRenderBuffer)
+	{
+		attachRenderBufferAsDepthBuffer(width, height);
+	}
 
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+FrameBuffer::~FrameBuffer()
+{
+	if (depthBufferID)
+	{
+		glDeleteRenderbuffers(1, &depthBufferID);
+	}
+
+	glDeleteFramebuffers(1, &ID);
+}
+
 void FrameBuffer::bind()
 {
 	glBindFramebuffer(GL_FRAMEBUFFER, ID);
@@ -26,13 +39,61 @@ void FrameBuffer::bindColorBufferToFrameBuffer(unsigned int colorBufferID, int a
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + attachmentNumber, target, colorBufferID, mipLevel);
 }
 
+void FrameBuffer::bindDepthTextureToFrameBuffer(unsigned int depthTextureID)
+{
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTextureID, 0);
+}
+
+void FrameBuffer::bindLayeredColorBufferToFrameBuffer(unsigned int colorBufferID, int attachmentNumber, int mipLevel)
+{
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + attachmentNumber, colorBufferID, mipLevel);
+}
+
+void FrameBuffer::bindLayeredDepthTextureToFrameBuffer(unsigned int depthTextureID)
+{
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTextureID, 0);
+}
+
 void FrameBuffer::resizeDepthBuffer(int width, int height)
 {
+	if (!depthBufferID)
+	{
+		std::cout << "[ERROR] FRAMEBUFFER: No depth render buffer to resize." << std::endl;
+
+		return;
+	}
+
 	glBindRenderbuffer(GL_RENDERBUFFER, depthBufferID);
 
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
 }
 
+void FrameBuffer::setDrawBuffers(int numberOfColorBuffers)
+{
+	GLenum drawBuffers[8];
+
+	for (int i = 0; i < numberOfColorBuffers && i < 8; ++i)
+	{
+		drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+	}
+
+	glDrawBuffers(std::min(numberOfColorBuffers, 8), drawBuffers);
+}
+
+bool FrameBuffer::isComplete()
+{
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "[ERROR] FRAMEBUFFER: Framebuffer incomplete, status 0x" << std::hex << status << std::dec << "." << std::endl;
+
+		return false;
+	}
+
+	return true;
+}
+
 void FrameBuffer::attachRenderBufferAsDepthBuffer(int width, int height)
 {
 	glGenRenderbuffers(1, &depthBufferID);
@@ -1,20 +1,37 @@
 #pragma once
 
 #include <iostream>
+#include <algorithm>
 
 #include <glad/glad.h>
 
 class FrameBuffer
 {
 public:
-	FrameBuffer(int width, int height);
+	// Without a depth render buffer, for a depth texture bound by "bindDepthTextureToFrameBuffer".
+	FrameBuffer(int width, int height, bool depthRenderBuffer = true);
+	~FrameBuffer();
+
+	FrameBuffer(const FrameBuffer&) = delete;
+	FrameBuffer& operator=(const FrameBuffer&) = delete;
 
 	void bind();
 	void unbind();
 
 	void bindColorBufferToFrameBuffer(unsigned int colorBufferID, int attachmentNumber, int target, int mipLevel = 0);
+	void bindDepthTextureToFrameBuffer(unsigned int depthTextureID);
+
+	// Every layer (cubemap face, array layer) of the level at once, the one written being selected by "gl_Layer".
+	void bindLayeredColorBufferToFrameBuffer(unsigned int colorBufferID, int attachmentNumber, int mipLevel = 0);
+	void bindLayeredDepthTextureToFrameBuffer(unsigned int depthTextureID);
+
 	void resizeDepthBuffer(int width, int height);
 
+	// Color attachments 0 to "numberOfColorBuffers" - 1 written at once, to the fragment shader outputs of the same locations.
+	void setDrawBuffers(int numberOfColorBuffers);
+
+	bool isComplete();
+
 private:
 	unsigned int ID, depthBufferID;
 
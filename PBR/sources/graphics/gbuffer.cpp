@@ -0,0 +1,97 @@
+#include "gbuffer.h"
+
+GBuffer::GBuffer(int width, int height)
+	: frameBuffer(nullptr), colorTextures(), depthTexture(0), width(width), height(height)
+{
+	frameBuffer = new FrameBuffer(width, height, false);
+
+	createTargets();
+}
+
+GBuffer::~GBuffer()
+{
+	deleteTargets();
+
+	delete frameBuffer;
+}
+
+void GBuffer::resize(int width, int height)
+{
+	if (width == this->width && height == this->height)
+	{
+		return;
+	}
+
+	this->width = width;
+	this->height = height;
+
+	deleteTargets();
+	createTargets();
+}
+
+void GBuffer::bind()
+{
+	frameBuffer->bind();
+}
+
+void GBuffer::bindTextures(int unit)
+{
+	for (int i = 0; i < NUMBER_OF_COLOR_TARGETS; ++i)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit + i);
+		glBindTexture(GL_TEXTURE_2D, colorTextures[i]);
+	}
+
+	glActiveTexture(GL_TEXTURE0 + unit + NUMBER_OF_COLOR_TARGETS);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+}
+
+void GBuffer::createTargets()
+{
+	const GLenum internalFormats[NUMBER_OF_COLOR_TARGETS] = { GL_RGBA8, GL_RGBA8, GL_RG16 };
+
+	glGenTextures(NUMBER_OF_COLOR_TARGETS, colorTextures);
+	glGenTextures(1, &depthTexture);
+
+	// Immutable storage, read with "texelFetch" only (no filtering, no mip levels).
+	for (int i = 0; i <= NUMBER_OF_COLOR_TARGETS; ++i)
+	{
+		bool depth = i == NUMBER_OF_COLOR_TARGETS;
+
+		glBindTexture(GL_TEXTURE_2D, depth ? depthTexture : colorTextures[i]);
+		glTexStorage2D(GL_TEXTURE_2D, 1, depth ? GL_DEPTH_COMPONENT32F : internalFormats[i], width, height);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GLint previousFramebuffer;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+	frameBuffer->bind();
+
+	for (int i = 0; i < NUMBER_OF_COLOR_TARGETS; ++i)
+	{
+		frameBuffer->bindColorBufferToFrameBuffer(colorTextures[i], i, GL_TEXTURE_2D);
+	}
+
+	frameBuffer->bindDepthTextureToFrameBuffer(depthTexture);
+	frameBuffer->setDrawBuffers(NUMBER_OF_COLOR_TARGETS);
+
+	if (frameBuffer->isComplete())
+	{
+		std::cout << "[INFO] G-BUFFER: " << width << "x" << height << " targets, " << width * height * 16 / (1024 * 1024) << " MB." << std::endl;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+}
+
+void GBuffer::deleteTargets()
+{
+	glDeleteTextures(NUMBER_OF_COLOR_TARGETS, colorTextures);
+	glDeleteTextures(1, &depthTexture);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <iostream>
+
+#include <glad/glad.h>
+
+#include "framebuffer.h"
+
+// Render targets of the deferred path, filled by "2_pbr_gbuffer_fs.glsl" and lit by "2_deferred_lighting_fs.glsl":
+//
+//  - color 0, RGBA8: albedo, gamma encoded (alpha unused);
+//  - color 1, RGBA8: ambient occlusion, roughness and metallic, laid out like the ORM maps (alpha unused);
+//  - color 2, RG16: world space normal, octahedral encoded;
+//  - depth, 32-bit float, from which the lighting pass rebuilds the position.
+//
+// 16 bytes per pixel, single sampled.
+//
+class GBuffer
+{
+public:
+	GBuffer(int width, int height);
+	~GBuffer();
+
+	GBuffer(const GBuffer&) = delete;
+	GBuffer& operator=(const GBuffer&) = delete;
+
+	// Reallocates the targets when the size changed.
+	void resize(int width, int height);
+
+	// Binds the framebuffer with the three color targets drawn to.
+	void bind();
+
+	// Albedo, ORM, normal and depth on "unit" to "unit" + 3.
+	void bindTextures(int unit);
+
+	int getWidth() { return width; }
+	int getHeight() { return height; }
+
+private:
+	static constexpr int NUMBER_OF_COLOR_TARGETS = 3;
+
+	FrameBuffer* frameBuffer;
+
+	unsigned int colorTextures[NUMBER_OF_COLOR_TARGETS];
+	unsigned int depthTexture;
+	int width, height;
+
+	void createTargets();
+	void deleteTargets();
+};
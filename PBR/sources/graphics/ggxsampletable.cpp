@@ -0,0 +1,107 @@
+#include "ggxsampletable.h"
+
+static const float PI = 3.14159265359f;
+
+GGXSampleTable::GGXSampleTable(int mipLevels, unsigned int maxSampleCount, int environmentSize, bool adaptiveSampleCount)
+	: levels(), samples()
+{
+	float saTexel = 4.0f * PI / (6.0f * float(environmentSize) * float(environmentSize));
+
+	for (int mip = 0; mip < mipLevels; ++mip)
+	{
+		float roughness = mipLevels > 1 ? (float)mip / (float)(mipLevels - 1) : 0.0f;
+
+		Level level = { roughness, static_cast<int>(samples.size()), 0, 1.0f };
+
+		if (roughness == 0.0f)
+		{
+			// Every GGX sample collapses onto the normal, the convolution is a single lookup of the base level.
+			samples.push_back(glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+
+			level.sampleCount = 1;
+			levels.push_back(level);
+
+			continue;
+		}
+
+		unsigned int sampleCount = getSampleCount(roughness, maxSampleCount, adaptiveSampleCount);
+		float a = roughness * roughness;
+		float a2 = a * a;
+		float totalWeight = 0.0f;
+
+		for (unsigned int i = 0; i < sampleCount; ++i)
+		{
+			float hx, hy, hz;
+
+			importanceSampleGGX(i, sampleCount, roughness, hx, hy, hz);
+
+			// "L = reflect(-V, H)" with "V = N".
+			float lx = 2.0f * hz * hx, ly = 2.0f * hz * hy, lz = 2.0f * hz * hz - 1.0f;
+
+			if (lz <= 0.0f)
+			{
+				continue;
+			}
+
+			// "D * NdotH / (4 * HdotV)" reduces to "D / 4" since "HdotV = NdotH". Same biases as the shaders had.
+			float denominator = hz * hz * (a2 - 1.0f) + 1.0f;
+			float D = a2 / (PI * denominator * denominator);
+			float pdf = D / 4.0f + 0.0001f;
+
+			float saSample = 1.0f / (float(sampleCount) * pdf + 0.0001f);
+			float lod = std::max(0.5f * std::log2(saSample / saTexel), 0.0f);
+
+			samples.push_back(glm::vec4(lx, ly, lz, lod));
+
+			totalWeight += lz;
+			level.sampleCount++;
+		}
+
+		level.inverseTotalWeight = 1.0f / totalWeight;
+		levels.push_back(level);
+	}
+}
+
+unsigned int GGXSampleTable::getSampleCount(float roughness, unsigned int maxSampleCount, bool adaptiveSampleCount)
+{
+	if (!adaptiveSampleCount)
+	{
+		return maxSampleCount;
+	}
+
+	// Narrower lobes need fewer samples, each reading a coarser level. Following alpha (roughness^2) drops too many on
+	// the smoother levels, where the bright spots of the environment then show through.
+	//
+	unsigned int sampleCount = static_cast<unsigned int>(std::ceil(float(maxSampleCount) * roughness));
+
+	return std::min(std::max(sampleCount, MIN_SAMPLE_COUNT), maxSampleCount);
+}
+
+void GGXSampleTable::importanceSampleGGX(unsigned int i, unsigned int sampleCount, float roughness, float& hx, float& hy, float& hz)
+{
+	float a = roughness * roughness;
+	float xi1 = float(i) / float(sampleCount);
+	float xi2 = radicalInverseVDC(i);
+
+	float phi = 2.0f * PI * xi1;
+	float cosTheta = std::sqrt((1.0f - xi2) / (1.0f + (a * a - 1.0f) * xi2));
+	float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+
+	hx = std::cos(phi) * sinTheta;
+	hy = std::sin(phi) * sinTheta;
+	hz = cosTheta;
+}
+
+// Efficient "VanDerCorpus" calculation, same as in "sampling.glsl".
+// http://holger.dammertz.org/stuff/notes_HammersleyOnHemisphere.html
+//
+float GGXSampleTable::radicalInverseVDC(unsigned int bits)
+{
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+
+	return float(bits) * 2.3283064365386963e-10f; // / 0x100000000
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+// GGX importance samples of the prefilter convolution, generated once on the CPU per roughness level instead of
+// per texel, and shared by "4_prefilter_convolution_*.glsl" (as a storage buffer) and "IBLBaker::bakePrefilter".
+//
+// With the "V = R = N" assumption the reflected directions only depend on the roughness, so a level is a list of
+// tangent space directions (N = +Z) stored as (L.x, L.y, L.z, lod). "L.z" is the weight of the sample (NdotL), the
+// ones below the horizon are dropped, and "lod" is the environment mip level whose texels cover the solid angle of
+// the sample. Fewer samples read coarser mips, so the sample count of a level grows with its roughness instead of
+// being the same everywhere, and the roughness 0 level is a single sample along the normal: a copy of the environment.
+//
+class GGXSampleTable
+{
+public:
+	struct Level
+	{
+		float roughness;
+		int firstSample;
+		int sampleCount; // Left after dropping the samples below the horizon.
+		float inverseTotalWeight;
+	};
+
+	// Without "adaptiveSampleCount", every level but the first takes "maxSampleCount" samples (the reference).
+	GGXSampleTable(int mipLevels, unsigned int maxSampleCount, int environmentSize, bool adaptiveSampleCount = true);
+
+	const std::vector<glm::vec4>& getSamples() const { return samples; }
+	const Level& getLevel(int mip) const { return levels[mip]; }
+	int getNumberOfLevels() const { return static_cast<int>(levels.size()); }
+
+	// Samples generated for "roughness", before dropping the ones below the horizon.
+	static unsigned int getSampleCount(float roughness, unsigned int maxSampleCount, bool adaptiveSampleCount);
+
+	// Hammersley point "i" of "sampleCount" mapped to a GGX halfway vector, in tangent space. Same as the shaders.
+	static void importanceSampleGGX(unsigned int i, unsigned int sampleCount, float roughness, float& hx, float& hy, float& hz);
+
+	static constexpr unsigned int MIN_SAMPLE_COUNT = 64;
+
+private:
+	std::vector<Level> levels;
+	std::vector<glm::vec4> samples;
+
+	static float radicalInverseVDC(unsigned int bits);
+};
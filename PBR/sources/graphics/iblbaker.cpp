@@ -0,0 +1,668 @@
+#include "iblbaker.h"
+
+static const float PI = 3.14159265359f;
+
+// Texel centers of one row, in [-1, 1]. Lanes past the end of the row repeat the last texel.
+static void getRowCoordinates(int size, int firstColumn, float* coordinates)
+{
+	for (int lane = 0; lane < SIMD_LANES; ++lane)
+	{
+		int column = std::min(firstColumn + lane, size - 1);
+
+		coordinates[lane] = 2.0f * (float(column) + 0.5f) / float(size) - 1.0f;
+	}
+}
+
+static SIMDVec3 getTexelDirections(int face, SIMDFloat u, SIMDFloat v)
+{
+	SIMDFloat one(1.0f), zero(0.0f);
+
+	switch (face)
+	{
+	case 0:  return { one, zero - v, zero - u };
+	case 1:  return { zero - one, zero - v, u };
+	case 2:  return { u, one, v };
+	case 3:  return { u, zero - one, zero - v };
+	case 4:  return { u, zero - v, one };
+	default: return { zero - u, zero - v, zero - one };
+	}
+}
+
+static void storeRow(std::vector<float>& face, int size, int row, int firstColumn, const SIMDFloat& r, const SIMDFloat& g, const SIMDFloat& b)
+{
+	float lanes[3][SIMD_LANES];
+
+	r.store(lanes[0]);
+	g.store(lanes[1]);
+	b.store(lanes[2]);
+
+	for (int lane = 0; lane < SIMD_LANES && firstColumn + lane < size; ++lane)
+	{
+		float* texel = &face[(static_cast<size_t>(row) * size + firstColumn + lane) * 3];
+
+		texel[0] = lanes[0][lane];
+		texel[1] = lanes[1][lane];
+		texel[2] = lanes[2][lane];
+	}
+}
+
+IBLBaker::IBLBaker(ThreadPool& threadPool)
+	: threadPool(threadPool), equirectangularMap(), environment(), irradiance(), irradianceSH(), brdfLUTSize()
+{
+}
+
+bool IBLBaker::loadEquirectangularMap(const char* filepath)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	RadianceHDR image;
+
+	if (!image.open(filepath))
+	{
+		std::cout << "[ERROR] IBL BAKER: Failed to load HDR image in \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	equirectangularMap.width = image.getWidth();
+	equirectangularMap.height = image.getHeight();
+	equirectangularMap.pixels.resize(static_cast<size_t>(equirectangularMap.width) * equirectangularMap.height * 3);
+
+	image.decode(RadianceHDR::Format::RGB32F, equirectangularMap.pixels.data(), threadPool);
+
+	recordTiming("HDR load", start);
+
+	return true;
+}
+
+void IBLBaker::bakeEnvironment(int size)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	environment.size = size;
+
+	for (int face = 0; face < 6; ++face)
+	{
+		environment.faces[face].assign(static_cast<size_t>(size) * size * 3, 0.0f);
+	}
+
+	threadPool.parallelFor(0, 6 * size, 4, [this, size](int begin, int end)
+	{
+		for (int index = begin; index < end; ++index)
+		{
+			int face = index / size, row = index % size;
+
+			for (int column = 0; column < size; ++column)
+			{
+				float u = 2.0f * (float(column) + 0.5f) / float(size) - 1.0f;
+				float v = 2.0f * (float(row) + 0.5f) / float(size) - 1.0f;
+				float x, y, z;
+
+				getTexelDirection(face, u, v, x, y, z);
+				sampleEquirectangularMap(equirectangularMap, x, y, z, &environment.faces[face][(static_cast<size_t>(row) * size + column) * 3]);
+			}
+		}
+	});
+
+	recordTiming("Equirectangular to cubemap", start);
+}
+
+void IBLBaker::bakeIrradiance(int size, float sampleDelta)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// The hemisphere samples are the same for every texel, only the tangent frame changes.
+	// Accumulate the angles in single precision just like the shader does, so both loops produce the same sample set.
+	//
+	std::vector<float> tangentSamples;
+	float nSamples = 0.0f;
+
+	for (float phi = 0.0f; phi < 2.0f * PI; phi += sampleDelta)
+	{
+		for (float theta = 0.0f; theta < 0.5f * PI; theta += sampleDelta)
+		{
+			tangentSamples.push_back(std::sin(theta) * std::cos(phi));
+			tangentSamples.push_back(std::sin(theta) * std::sin(phi));
+			tangentSamples.push_back(std::cos(theta));
+			tangentSamples.push_back(std::cos(theta) * std::sin(theta));
+
+			nSamples++;
+		}
+	}
+
+	irradiance.size = size;
+
+	for (int face = 0; face < 6; ++face)
+	{
+		irradiance.faces[face].assign(static_cast<size_t>(size) * size * 3, 0.0f);
+	}
+
+	float scale = PI * (1.0f / nSamples);
+
+	threadPool.parallelFor(0, 6 * size, 1, [this, size, scale, &tangentSamples](int begin, int end)
+	{
+		float coordinates[SIMD_LANES];
+		float sampleX[SIMD_LANES], sampleY[SIMD_LANES], sampleZ[SIMD_LANES];
+		float colors[3][SIMD_LANES];
+
+		for (int index = begin; index < end; ++index)
+		{
+			int face = index / size, row = index % size;
+			float v = 2.0f * (float(row) + 0.5f) / float(size) - 1.0f;
+
+			for (int column = 0; column < size; column += SIMD_LANES)
+			{
+				getRowCoordinates(size, column, coordinates);
+
+				SIMDVec3 normal = simdNormalize(getTexelDirections(face, SIMDFloat::load(coordinates), SIMDFloat(v)));
+				SIMDVec3 right = simdNormalize(simdCross({ SIMDFloat(0.0f), SIMDFloat(1.0f), SIMDFloat(0.0f) }, normal));
+				SIMDVec3 up = simdNormalize(simdCross(normal, right));
+
+				SIMDFloat r, g, b;
+
+				for (size_t s = 0; s < tangentSamples.size(); s += 4)
+				{
+					SIMDFloat tx(tangentSamples[s]), ty(tangentSamples[s + 1]), tz(tangentSamples[s + 2]), weight(tangentSamples[s + 3]);
+
+					(tx * right.x + ty * up.x + tz * normal.x).store(sampleX);
+					(tx * right.y + ty * up.y + tz * normal.y).store(sampleY);
+					(tx * right.z + ty * up.z + tz * normal.z).store(sampleZ);
+
+					for (int lane = 0; lane < SIMD_LANES; ++lane)
+					{
+						float rgb[3];
+
+						sampleCubeMap(environment, sampleX[lane], sampleY[lane], sampleZ[lane], rgb);
+
+						colors[0][lane] = rgb[0];
+						colors[1][lane] = rgb[1];
+						colors[2][lane] = rgb[2];
+					}
+
+					r += SIMDFloat::load(colors[0]) * weight;
+					g += SIMDFloat::load(colors[1]) * weight;
+					b += SIMDFloat::load(colors[2]) * weight;
+				}
+
+				storeRow(irradiance.faces[face], size, row, column, r * SIMDFloat(scale), g * SIMDFloat(scale), b * SIMDFloat(scale));
+			}
+		}
+	});
+
+	recordTiming("Irradiance convolution", start);
+}
+
+void IBLBaker::bakeIrradianceSH()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	irradianceSH = SphericalHarmonics::projectIrradiance(equirectangularMap, threadPool);
+
+	recordTiming("Irradiance SH9 projection", start);
+}
+
+void IBLBaker::bakePrefilter(int size, const GGXSampleTable& sampleTable)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// The samples read the environment at the level matching their solid angle, like "textureLod" on the GPU.
+	std::vector<CubeMapLevel> environmentLevels = buildMipChain(environment);
+
+	int mipLevels = sampleTable.getNumberOfLevels();
+
+	prefilter.assign(mipLevels, CubeMapLevel());
+
+	for (int mip = 0; mip < mipLevels; ++mip)
+	{
+		const GGXSampleTable::Level& sampleLevel = sampleTable.getLevel(mip);
+		const glm::vec4* samples = &sampleTable.getSamples()[sampleLevel.firstSample];
+		int mipSize = std::max(size >> mip, 1);
+
+		CubeMapLevel& level = prefilter[mip];
+
+		level.size = mipSize;
+
+		for (int face = 0; face < 6; ++face)
+		{
+			level.faces[face].assign(static_cast<size_t>(mipSize) * mipSize * 3, 0.0f);
+		}
+
+		threadPool.parallelFor(0, 6 * mipSize, 1, [mipSize, samples, &sampleLevel, &level, &environmentLevels](int begin, int end)
+		{
+			float coordinates[SIMD_LANES];
+			float tangentLanes[3][SIMD_LANES], bitangentLanes[3][SIMD_LANES];
+			float sampleX[SIMD_LANES], sampleY[SIMD_LANES], sampleZ[SIMD_LANES];
+			float colors[3][SIMD_LANES];
+
+			for (int index = begin; index < end; ++index)
+			{
+				int face = index / mipSize, row = index % mipSize;
+				float v = 2.0f * (float(row) + 0.5f) / float(mipSize) - 1.0f;
+
+				for (int column = 0; column < mipSize; column += SIMD_LANES)
+				{
+					getRowCoordinates(mipSize, column, coordinates);
+
+					SIMDVec3 normal = simdNormalize(getTexelDirections(face, SIMDFloat::load(coordinates), SIMDFloat(v)));
+
+					// The tangent frame has a branch on the normal, so it is built per lane.
+					normal.x.store(sampleX);
+					normal.y.store(sampleY);
+					normal.z.store(sampleZ);
+
+					for (int lane = 0; lane < SIMD_LANES; ++lane)
+					{
+						glm::vec3 N(sampleX[lane], sampleY[lane], sampleZ[lane]);
+						glm::vec3 up = std::abs(N.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+						glm::vec3 tangent = glm::normalize(glm::cross(up, N));
+						glm::vec3 bitangent = glm::cross(N, tangent);
+
+						tangentLanes[0][lane] = tangent.x; tangentLanes[1][lane] = tangent.y; tangentLanes[2][lane] = tangent.z;
+						bitangentLanes[0][lane] = bitangent.x; bitangentLanes[1][lane] = bitangent.y; bitangentLanes[2][lane] = bitangent.z;
+					}
+
+					SIMDVec3 tangent = { SIMDFloat::load(tangentLanes[0]), SIMDFloat::load(tangentLanes[1]), SIMDFloat::load(tangentLanes[2]) };
+					SIMDVec3 bitangent = { SIMDFloat::load(bitangentLanes[0]), SIMDFloat::load(bitangentLanes[1]), SIMDFloat::load(bitangentLanes[2]) };
+
+					SIMDFloat r, g, b;
+
+					for (int s = 0; s < sampleLevel.sampleCount; ++s)
+					{
+						const glm::vec4& sample = samples[s];
+						SIMDFloat lx(sample.x), ly(sample.y), lz(sample.z);
+
+						(lx * tangent.x + ly * bitangent.x + lz * normal.x).store(sampleX);
+						(lx * tangent.y + ly * bitangent.y + lz * normal.y).store(sampleY);
+						(lx * tangent.z + ly * bitangent.z + lz * normal.z).store(sampleZ);
+
+						for (int lane = 0; lane < SIMD_LANES; ++lane)
+						{
+							float rgb[3];
+
+							sampleCubeMap(environmentLevels, sampleX[lane], sampleY[lane], sampleZ[lane], sample.w, rgb);
+
+							colors[0][lane] = rgb[0];
+							colors[1][lane] = rgb[1];
+							colors[2][lane] = rgb[2];
+						}
+
+						r += SIMDFloat::load(colors[0]) * lz;
+						g += SIMDFloat::load(colors[1]) * lz;
+						b += SIMDFloat::load(colors[2]) * lz;
+					}
+
+					SIMDFloat scale(sampleLevel.inverseTotalWeight);
+
+					storeRow(level.faces[face], mipSize, row, column, r * scale, g * scale, b * scale);
+				}
+			}
+		});
+	}
+
+	recordTiming("Prefilter convolution", start);
+}
+
+void IBLBaker::bakeBRDFLUT(int size, unsigned int sampleCount)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	brdfLUTSize = size;
+	brdfLUT.assign(static_cast<size_t>(size) * size * 2, 0.0f);
+
+	threadPool.parallelFor(0, size, 4, [this, size, sampleCount](int begin, int end)
+	{
+		float coordinates[SIMD_LANES];
+		float lanes[2][SIMD_LANES];
+
+		for (int row = begin; row < end; ++row)
+		{
+			float roughness = (float(row) + 0.5f) / float(size);
+
+			// Note that we use a different "k" for IBL.
+			SIMDFloat k(roughness * roughness / 2.0f);
+			SIMDFloat one(1.0f), zero(0.0f);
+
+			for (int column = 0; column < size; column += SIMD_LANES)
+			{
+				for (int lane = 0; lane < SIMD_LANES; ++lane)
+				{
+					coordinates[lane] = (float(std::min(column + lane, size - 1)) + 0.5f) / float(size);
+				}
+
+				SIMDFloat NdotV = SIMDFloat::load(coordinates);
+				SIMDFloat vx = simdSqrt(one - NdotV * NdotV);
+				SIMDFloat vz = NdotV;
+				SIMDFloat G1V = NdotV / (NdotV * (one - k) + k);
+
+				SIMDFloat A, B;
+
+				for (unsigned int i = 0; i < sampleCount; ++i)
+				{
+					float hx, hy, hz;
+
+					GGXSampleTable::importanceSampleGGX(i, sampleCount, roughness, hx, hy, hz);
+
+					// Tangent frame of "N = (0, 0, 1)" in the shader: tangent = (0, -1, 0) and bitangent = (1, 0, 0).
+					SIMDFloat Hx(hy), Hz(hz);
+
+					SIMDFloat VdotH = simdMax(vx * Hx + vz * Hz, zero);
+					SIMDFloat NdotL = SIMDFloat(2.0f) * (vx * Hx + vz * Hz) * Hz - vz;
+					SIMDFloat NdotH(std::max(hz, 0.0f));
+
+					SIMDFloat clampedNdotL = simdMax(NdotL, zero);
+					SIMDFloat G = G1V * (clampedNdotL / (clampedNdotL * (one - k) + k));
+					SIMDFloat Gvis = (G * VdotH) / (NdotH * NdotV);
+
+					SIMDFloat oneMinusVdotH = one - VdotH;
+					SIMDFloat oneMinusVdotH2 = oneMinusVdotH * oneMinusVdotH;
+					SIMDFloat Fc = oneMinusVdotH2 * oneMinusVdotH2 * oneMinusVdotH;
+
+					A += simdSelectPositive(NdotL, (one - Fc) * Gvis);
+					B += simdSelectPositive(NdotL, Fc * Gvis);
+				}
+
+				(A / SIMDFloat(float(sampleCount))).store(lanes[0]);
+				(B / SIMDFloat(float(sampleCount))).store(lanes[1]);
+
+				for (int lane = 0; lane < SIMD_LANES && column + lane < size; ++lane)
+				{
+					float* texel = &brdfLUT[(static_cast<size_t>(row) * size + column + lane) * 2];
+
+					texel[0] = lanes[0][lane];
+					texel[1] = lanes[1][lane];
+				}
+			}
+		}
+	});
+
+	recordTiming("BRDF LUT integration", start);
+}
+
+void IBLBaker::upload(CubeMap* environmentCM, CubeMap* irradianceCM, CubeMap* prefilterCM, Texture* brdfLUTTex)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (int face = 0; face < 6; ++face)
+	{
+		environmentCM->setFaceData(face, 0, environment.size, environment.size, GL_RGB, GL_FLOAT, environment.faces[face].data());
+		if (irradiance.size > 0)
+		{
+			irradianceCM->setFaceData(face, 0, irradiance.size, irradiance.size, GL_RGB, GL_FLOAT, irradiance.faces[face].data());
+		}
+
+		for (int mip = 0; mip < static_cast<int>(prefilter.size()); ++mip)
+		{
+			prefilterCM->setFaceData(face, mip, prefilter[mip].size, prefilter[mip].size, GL_RGB, GL_FLOAT, prefilter[mip].faces[face].data());
+		}
+	}
+
+	environmentCM->generateMipMaps();
+
+	brdfLUTTex->setData(brdfLUTSize, brdfLUTSize, GL_RG, GL_FLOAT, brdfLUT.data());
+
+	recordTiming("Upload", start);
+}
+
+bool IBLBaker::validate(CubeMap* environmentCM, CubeMap* irradianceCM, CubeMap* prefilterCM, Texture* brdfLUTTex, float tolerance)
+{
+	std::vector<float> readback;
+	float environmentError = 0.0f, irradianceError = 0.0f, prefilterError = 0.0f, brdfLUTError = 0.0f;
+
+	for (int face = 0; face < 6; ++face)
+	{
+		readback.resize(environment.faces[face].size());
+		environmentCM->getFaceData(face, 0, GL_RGB, GL_FLOAT, readback.data());
+		environmentError = std::max(environmentError, maxRelativeError(readback, environment.faces[face]));
+
+		if (irradiance.size > 0)
+		{
+			readback.resize(irradiance.faces[face].size());
+			irradianceCM->getFaceData(face, 0, GL_RGB, GL_FLOAT, readback.data());
+			irradianceError = std::max(irradianceError, maxRelativeError(readback, irradiance.faces[face]));
+		}
+
+		for (int mip = 0; mip < static_cast<int>(prefilter.size()); ++mip)
+		{
+			readback.resize(prefilter[mip].faces[face].size());
+			prefilterCM->getFaceData(face, mip, GL_RGB, GL_FLOAT, readback.data());
+			prefilterError = std::max(prefilterError, maxRelativeError(readback, prefilter[mip].faces[face]));
+		}
+	}
+
+	readback.resize(brdfLUT.size());
+	brdfLUTTex->getData(GL_RG, GL_FLOAT, readback.data());
+	brdfLUTError = maxRelativeError(readback, brdfLUT);
+
+	std::cout << "[INFO] IBL BAKER: Maximum relative error against the GPU bake (tolerance " << tolerance << "):" << std::endl;
+	std::cout << "  Environment: " << environmentError << std::endl;
+	std::cout << "  Irradiance:  " << irradianceError << std::endl;
+	std::cout << "  Prefilter:   " << prefilterError << std::endl;
+	std::cout << "  BRDF LUT:    " << brdfLUTError << std::endl;
+
+	return std::max(std::max(environmentError, irradianceError), std::max(prefilterError, brdfLUTError)) <= tolerance;
+}
+
+void IBLBaker::printTimings()
+{
+	double total = 0.0;
+
+	std::cout << "[INFO] IBL BAKER: CPU bake on " << threadPool.getNumberOfThreads() << " thread(s), " << SIMD_LANES << " SIMD lane(s):" << std::endl;
+
+	for (const StageTiming& timing : timings)
+	{
+		std::cout << "  " << timing.name << ": " << timing.milliseconds << " ms" << std::endl;
+
+		total += timing.milliseconds;
+	}
+
+	std::cout << "  Total: " << total << " ms" << std::endl;
+}
+
+const HDRImage& IBLBaker::getEquirectangularMap()
+{
+	return equirectangularMap;
+}
+
+const CubeMapLevel& IBLBaker::getEnvironment()
+{
+	return environment;
+}
+
+const CubeMapLevel& IBLBaker::getIrradiance()
+{
+	return irradiance;
+}
+
+const SH9& IBLBaker::getIrradianceSH()
+{
+	return irradianceSH;
+}
+
+const std::vector<CubeMapLevel>& IBLBaker::getPrefilter()
+{
+	return prefilter;
+}
+
+const std::vector<float>& IBLBaker::getBRDFLUT()
+{
+	return brdfLUT;
+}
+
+void IBLBaker::getTexelDirection(int face, float u, float v, float& x, float& y, float& z)
+{
+	// Inverse of the major axis selection in the OpenGL specification (table 8.19), "u" and "v" in [-1, 1].
+	switch (face)
+	{
+	case 0:  x =  1.0f; y = -v;    z = -u;    break;
+	case 1:  x = -1.0f; y = -v;    z =  u;    break;
+	case 2:  x =  u;    y =  1.0f; z =  v;    break;
+	case 3:  x =  u;    y = -1.0f; z = -v;    break;
+	case 4:  x =  u;    y = -v;    z =  1.0f; break;
+	default: x = -u;    y = -v;    z = -1.0f; break;
+	}
+}
+
+void IBLBaker::sampleCubeMap(const CubeMapLevel& cubemap, float x, float y, float z, float* rgb)
+{
+	float ax = std::abs(x), ay = std::abs(y), az = std::abs(z);
+	float ma, sc, tc;
+	int face;
+
+	if (ax >= ay && ax >= az)
+	{
+		face = x > 0.0f ? 0 : 1;
+		ma = ax; sc = x > 0.0f ? -z : z; tc = -y;
+	}
+	else if (ay >= az)
+	{
+		face = y > 0.0f ? 2 : 3;
+		ma = ay; sc = x; tc = y > 0.0f ? z : -z;
+	}
+	else
+	{
+		face = z > 0.0f ? 4 : 5;
+		ma = az; sc = z > 0.0f ? x : -x; tc = -y;
+	}
+
+	int size = cubemap.size;
+	float s = (0.5f * (sc / ma + 1.0f)) * size - 0.5f;
+	float t = (0.5f * (tc / ma + 1.0f)) * size - 0.5f;
+
+	s = std::min(std::max(s, 0.0f), float(size - 1));
+	t = std::min(std::max(t, 0.0f), float(size - 1));
+
+	int s0 = static_cast<int>(s), t0 = static_cast<int>(t);
+	int s1 = std::min(s0 + 1, size - 1), t1 = std::min(t0 + 1, size - 1);
+	float fs = s - s0, ft = t - t0;
+
+	const float* data = cubemap.faces[face].data();
+	const float* c00 = &data[(static_cast<size_t>(t0) * size + s0) * 3];
+	const float* c10 = &data[(static_cast<size_t>(t0) * size + s1) * 3];
+	const float* c01 = &data[(static_cast<size_t>(t1) * size + s0) * 3];
+	const float* c11 = &data[(static_cast<size_t>(t1) * size + s1) * 3];
+
+	for (int c = 0; c < 3; ++c)
+	{
+		float top = c00[c] + (c10[c] - c00[c]) * fs;
+		float bottom = c01[c] + (c11[c] - c01[c]) * fs;
+
+		rgb[c] = top + (bottom - top) * ft;
+	}
+}
+
+void IBLBaker::sampleCubeMap(const std::vector<CubeMapLevel>& levels, float x, float y, float z, float lod, float* rgb)
+{
+	// Linear between the two nearest levels, clamped to the chain.
+	lod = std::min(std::max(lod, 0.0f), float(levels.size() - 1));
+
+	int level0 = static_cast<int>(lod);
+	int level1 = std::min(level0 + 1, static_cast<int>(levels.size()) - 1);
+	float fraction = lod - level0;
+
+	sampleCubeMap(levels[level0], x, y, z, rgb);
+
+	if (fraction > 0.0f && level1 != level0)
+	{
+		float next[3];
+
+		sampleCubeMap(levels[level1], x, y, z, next);
+
+		for (int c = 0; c < 3; ++c)
+		{
+			rgb[c] += (next[c] - rgb[c]) * fraction;
+		}
+	}
+}
+
+std::vector<CubeMapLevel> IBLBaker::buildMipChain(const CubeMapLevel& level)
+{
+	std::vector<CubeMapLevel> levels = { level };
+
+	while (levels.back().size > 1)
+	{
+		const CubeMapLevel& previous = levels.back();
+		CubeMapLevel next;
+
+		next.size = previous.size / 2;
+
+		for (int face = 0; face < 6; ++face)
+		{
+			const std::vector<float>& source = previous.faces[face];
+
+			next.faces[face].resize(static_cast<size_t>(next.size) * next.size * 3);
+
+			// 2x2 box filter, like "glGenerateMipmap" on power of two sizes.
+			for (int row = 0; row < next.size; ++row)
+			{
+				for (int column = 0; column < next.size; ++column)
+				{
+					const float* c00 = &source[(static_cast<size_t>(2 * row) * previous.size + 2 * column) * 3];
+					const float* c01 = c00 + static_cast<size_t>(previous.size) * 3;
+
+					for (int c = 0; c < 3; ++c)
+					{
+						next.faces[face][(static_cast<size_t>(row) * next.size + column) * 3 + c] = 0.25f * (c00[c] + c00[c + 3] + c01[c] + c01[c + 3]);
+					}
+				}
+			}
+		}
+
+		levels.push_back(std::move(next));
+	}
+
+	return levels;
+}
+
+void IBLBaker::sampleEquirectangularMap(const HDRImage& image, float x, float y, float z, float* rgb)
+{
+	float inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+
+	x *= inverseLength; y *= inverseLength; z *= inverseLength;
+
+	// Same mapping as "sampleSphericalMap" in "3_equirectangular2cubemap_fs.glsl".
+	float u = std::atan2(z, x) * 0.1591f + 0.5f;
+	float v = std::asin(std::min(std::max(y, -1.0f), 1.0f)) * 0.3183f + 0.5f;
+
+	float s = std::min(std::max(u * image.width - 0.5f, 0.0f), float(image.width - 1));
+	float t = std::min(std::max(v * image.height - 0.5f, 0.0f), float(image.height - 1));
+
+	int s0 = static_cast<int>(s), t0 = static_cast<int>(t);
+	int s1 = std::min(s0 + 1, image.width - 1), t1 = std::min(t0 + 1, image.height - 1);
+	float fs = s - s0, ft = t - t0;
+
+	const float* data = image.pixels.data();
+	const float* c00 = &data[(static_cast<size_t>(t0) * image.width + s0) * 3];
+	const float* c10 = &data[(static_cast<size_t>(t0) * image.width + s1) * 3];
+	const float* c01 = &data[(static_cast<size_t>(t1) * image.width + s0) * 3];
+	const float* c11 = &data[(static_cast<size_t>(t1) * image.width + s1) * 3];
+
+	for (int c = 0; c < 3; ++c)
+	{
+		float top = c00[c] + (c10[c] - c00[c]) * fs;
+		float bottom = c01[c] + (c11[c] - c01[c]) * fs;
+
+		rgb[c] = top + (bottom - top) * ft;
+	}
+}
+
+void IBLBaker::recordTiming(const char* name, std::chrono::high_resolution_clock::time_point start)
+{
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+	timings.push_back({ name, elapsed.count() });
+}
+
+float IBLBaker::maxRelativeError(const std::vector<float>& reference, const std::vector<float>& data)
+{
+	float maxError = 0.0f;
+
+	for (size_t i = 0; i < reference.size() && i < data.size(); ++i)
+	{
+		// Relative to the reference for HDR values, absolute below 1.0 (where the half float precision dominates).
+		float error = std::abs(reference[i] - data[i]) / std::max(std::abs(reference[i]), 1.0f);
+
+		maxError = std::max(maxError, error);
+	}
+
+	return maxError;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#if !defined _STB_IMAGE_INCLUDED
+#define _STB_IMAGE_INCLUDED
+
+#include <stbi/stb_image.h>
+#endif // _STB_IMAGE_INCLUDED
+
+#include "texture.h"
+#include "cubemap.h"
+#include "ggxsampletable.h"
+#include "sphericalharmonics.h"
+
+#include "../utils/simd.h"
+#include "../utils/threadpool.h"
+#include "../utils/radiancehdr.h"
+
+// RGB floating point image, with the first row at the bottom (like OpenGL expects it).
+struct HDRImage
+{
+	int width, height;
+	std::vector<float> pixels;
+};
+
+// One mip level of a RGB floating point cubemap. Faces follow the "GL_TEXTURE_CUBE_MAP_POSITIVE_X + i" order.
+struct CubeMapLevel
+{
+	int size;
+	std::vector<float> faces[6];
+};
+
+// Sizes and sample counts of the IBL maps. The defaults match the constants hardcoded in the "3_*" and "4_*" shaders.
+struct IBLBakeParameters
+{
+	int environmentSize = 512;
+	int irradianceSize = 32;
+	int prefilterSize = 128;
+	int prefilterMipLevels = 5;
+	int brdfLUTSize = 512;
+	unsigned int sampleCount = 1024;
+	float sampleDelta = 0.025f;
+	bool irradianceSH = true; // Represent the irradiance with SH9 coefficients instead of a cubemap.
+	bool adaptiveSampleCount = true; // Fewer prefilter samples on the smoother levels, see "GGXSampleTable".
+};
+
+// CPU implementation of the IBL pre-computations done by the "3_*" and "4_*" shaders.
+//
+// Every stage is split in rows of texels and distributed over a work-stealing thread pool. Inside a row,
+// the texels are processed "SIMD_LANES" at a time (8 with AVX, 4 with SSE2), sharing the same sample tables.
+//
+class IBLBaker
+{
+public:
+	struct StageTiming
+	{
+		std::string name;
+		double milliseconds;
+	};
+
+	IBLBaker(ThreadPool& threadPool);
+
+	bool loadEquirectangularMap(const char* filepath);
+
+	void bakeEnvironment(int size);
+	void bakeIrradiance(int size, float sampleDelta = 0.025f);
+	void bakeIrradianceSH();
+	void bakePrefilter(int size, const GGXSampleTable& sampleTable); // One mip level per level of the table.
+	void bakeBRDFLUT(int size, unsigned int sampleCount = 1024);
+
+	void upload(CubeMap* environmentCM, CubeMap* irradianceCM, CubeMap* prefilterCM, Texture* brdfLUTTex);
+
+	// Compares the CPU results against textures baked by the GPU passes, printing the maximum relative error per stage.
+	bool validate(CubeMap* environmentCM, CubeMap* irradianceCM, CubeMap* prefilterCM, Texture* brdfLUTTex, float tolerance);
+
+	void printTimings();
+
+	const std::vector<StageTiming>& getTimings() { return timings; }
+
+	const HDRImage& getEquirectangularMap();
+	const CubeMapLevel& getEnvironment();
+	const CubeMapLevel& getIrradiance();
+	const SH9& getIrradianceSH();
+	const std::vector<CubeMapLevel>& getPrefilter();
+	const std::vector<float>& getBRDFLUT();
+
+	static void getTexelDirection(int face, float u, float v, float& x, float& y, float& z);
+	static void sampleCubeMap(const CubeMapLevel& cubemap, float x, float y, float z, float* rgb);
+	static void sampleCubeMap(const std::vector<CubeMapLevel>& levels, float x, float y, float z, float lod, float* rgb);
+	static void sampleEquirectangularMap(const HDRImage& image, float x, float y, float z, float* rgb);
+
+	// Levels down to 1x1, each face halved from the previous one.
+	static std::vector<CubeMapLevel> buildMipChain(const CubeMapLevel& level);
+
+	static float maxRelativeError(const std::vector<float>& reference, const std::vector<float>& data);
+
+private:
+	ThreadPool& threadPool;
+
+	HDRImage equirectangularMap;
+	CubeMapLevel environment;
+	CubeMapLevel irradiance;
+	SH9 irradianceSH;
+	std::vector<CubeMapLevel> prefilter;
+	std::vector<float> brdfLUT;
+	int brdfLUTSize;
+
+	std::vector<StageTiming> timings;
+
+	void recordTiming(const char* name, std::chrono::high_resolution_clock::time_point start);
+};
@@ -0,0 +1,312 @@
+#include "iblcache.h"
+
+IBLCache::IBLCache(const char* directory)
+	: directory(directory), parameters(), key(), validKey(false)
+{
+}
+
+bool IBLCache::computeKey(const char* hdrFilepath, const IBLBakeParameters& parameters)
+{
+	this->parameters = parameters;
+
+	std::ifstream fileStream(hdrFilepath, std::ios::binary);
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] IBL CACHE: Failed to open HDR image in \"" << hdrFilepath << "\"." << std::endl;
+
+		validKey = false;
+
+		return false;
+	}
+
+	// 64-bit FNV-1a over the HDR bytes, followed by every parameter that changes the baked maps.
+	uint64_t hash = 14695981039346656037ull;
+	std::vector<char> buffer(1 << 20);
+
+	while (fileStream)
+	{
+		fileStream.read(buffer.data(), buffer.size());
+
+		hash = hashBytes(buffer.data(), static_cast<size_t>(fileStream.gcount()), hash);
+	}
+
+	int32_t sizes[] = { parameters.environmentSize, parameters.irradianceSize, parameters.prefilterSize, parameters.prefilterMipLevels, parameters.brdfLUTSize };
+
+	hash = hashBytes(sizes, sizeof(sizes), hash);
+	hash = hashBytes(&parameters.sampleCount, sizeof(parameters.sampleCount), hash);
+	hash = hashBytes(&parameters.sampleDelta, sizeof(parameters.sampleDelta), hash);
+	hash = hashBytes(&parameters.irradianceSH, sizeof(parameters.irradianceSH), hash);
+	hash = hashBytes(&parameters.adaptiveSampleCount, sizeof(parameters.adaptiveSampleCount), hash);
+	hash = hashBytes(&VERSION, sizeof(VERSION), hash);
+
+	key = hash;
+	validKey = true;
+
+	return true;
+}
+
+bool IBLCache::load(CubeMap* environmentCM, CubeMap* irradianceCM, CubeMap* prefilterCM, Texture* brdfLUTTex, SH9* irradianceSH)
+{
+	if (!validKey || (parameters.irradianceSH && !irradianceSH))
+	{
+		return false;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::string filepath = getFilepath();
+	std::ifstream fileStream(filepath, std::ios::binary | std::ios::ate);
+
+	if (!fileStream)
+	{
+		return false; // Cache miss, nothing to report.
+	}
+
+	std::vector<char> contents(static_cast<size_t>(fileStream.tellg()));
+
+	fileStream.seekg(0);
+	fileStream.read(contents.data(), contents.size());
+
+	Header header;
+
+	if (contents.size() < sizeof(Header))
+	{
+		std::cout << "[ERROR] IBL CACHE: Truncated cache file \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	std::memcpy(&header, contents.data(), sizeof(Header));
+
+	if (std::memcmp(header.magic, "IBLC", 4) != 0 || header.version != VERSION || header.key != key)
+	{
+		std::cout << "[ERROR] IBL CACHE: Invalid cache file \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	// Every record is checked against the one the current parameters expect before anything is uploaded, so a stale
+	// or incomplete file is a cache miss instead of uploads reading past its records.
+	//
+	std::vector<Record> records = getRecords();
+	std::vector<const char*> recordData(records.size(), nullptr);
+
+	size_t offset = sizeof(Header);
+
+	for (uint32_t i = 0; i < header.numberOfRecords; ++i)
+	{
+		Record record;
+
+		if (offset + sizeof(Record) > contents.size())
+		{
+			std::cout << "[ERROR] IBL CACHE: Truncated cache file \"" << filepath << "\"." << std::endl;
+
+			return false;
+		}
+
+		std::memcpy(&record, contents.data() + offset, sizeof(Record));
+		offset += sizeof(Record);
+
+		if (record.size > contents.size() - offset)
+		{
+			std::cout << "[ERROR] IBL CACHE: Truncated cache file \"" << filepath << "\"." << std::endl;
+
+			return false;
+		}
+
+		auto expected = std::find_if(records.begin(), records.end(), [&record](const Record& candidate)
+		{
+			return candidate.target == record.target && candidate.face == record.face && candidate.mipLevel == record.mipLevel;
+		});
+
+		size_t index = static_cast<size_t>(expected - records.begin());
+
+		if (expected == records.end() || expected->width != record.width || expected->height != record.height || expected->channels != record.channels
+			|| expected->size != record.size || recordData[index])
+		{
+			std::cout << "[ERROR] IBL CACHE: Unexpected record in cache file \"" << filepath << "\"." << std::endl;
+
+			return false;
+		}
+
+		// Copied as is into the coefficients, whatever size "getRecords" computes.
+		if (record.target == Target::IRRADIANCE_SH && record.size != sizeof(SH9::coefficients))
+		{
+			std::cout << "[ERROR] IBL CACHE: Unexpected SH9 record size in cache file \"" << filepath << "\"." << std::endl;
+
+			return false;
+		}
+
+		recordData[index] = contents.data() + offset;
+		offset += static_cast<size_t>(record.size);
+	}
+
+	if (std::find(recordData.begin(), recordData.end(), nullptr) != recordData.end())
+	{
+		std::cout << "[ERROR] IBL CACHE: Incomplete cache file \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		const Record& record = records[i];
+		const void* data = recordData[i];
+
+		switch (record.target)
+		{
+		case Target::ENVIRONMENT:
+			environmentCM->setFaceData(record.face, record.mipLevel, record.width, record.height, GL_RGB, GL_HALF_FLOAT, data);
+			break;
+
+		case Target::IRRADIANCE:
+			irradianceCM->setFaceData(record.face, record.mipLevel, record.width, record.height, GL_RGB, GL_HALF_FLOAT, data);
+			break;
+
+		case Target::PREFILTER:
+			prefilterCM->setFaceData(record.face, record.mipLevel, record.width, record.height, GL_RGB, GL_HALF_FLOAT, data);
+			break;
+
+		case Target::BRDF_LUT:
+			brdfLUTTex->setData(record.width, record.height, GL_RG, GL_HALF_FLOAT, data);
+			break;
+
+		case Target::IRRADIANCE_SH:
+			std::memcpy(irradianceSH->coefficients, data, sizeof(irradianceSH->coefficients));
+			break;
+		}
+	}
+
+	// Only the base level of the environment is stored, the prefilter passes read its mips.
+	environmentCM->generateMipMaps();
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+	std::cout << "[INFO] IBL CACHE: Loaded IBL maps from \"" << filepath << "\" in " << elapsed.count() << " ms." << std::endl;
+
+	return true;
+}
+
+bool IBLCache::save(CubeMap* environmentCM, CubeMap* irradianceCM, CubeMap* prefilterCM, Texture* brdfLUTTex, const SH9* irradianceSH)
+{
+	if (!validKey || (parameters.irradianceSH && !irradianceSH))
+	{
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+
+	std::string filepath = getFilepath();
+	std::ofstream fileStream(filepath, std::ios::binary | std::ios::trunc);
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] IBL CACHE: Failed to create cache file \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	std::vector<Record> records = getRecords();
+
+	Header header = { { 'I', 'B', 'L', 'C' }, VERSION, key, static_cast<uint32_t>(records.size()), 0 };
+
+	fileStream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+	std::vector<char> data;
+
+	for (const Record& record : records)
+	{
+		data.resize(static_cast<size_t>(record.size));
+
+		switch (record.target)
+		{
+		case Target::ENVIRONMENT: environmentCM->getFaceData(record.face, record.mipLevel, GL_RGB, GL_HALF_FLOAT, data.data()); break;
+		case Target::IRRADIANCE:  irradianceCM->getFaceData(record.face, record.mipLevel, GL_RGB, GL_HALF_FLOAT, data.data()); break;
+		case Target::PREFILTER:   prefilterCM->getFaceData(record.face, record.mipLevel, GL_RGB, GL_HALF_FLOAT, data.data()); break;
+		case Target::BRDF_LUT:    brdfLUTTex->getData(GL_RG, GL_HALF_FLOAT, data.data()); break;
+		case Target::IRRADIANCE_SH: std::memcpy(data.data(), irradianceSH->coefficients, data.size()); break;
+		}
+
+		fileStream.write(reinterpret_cast<const char*>(&record), sizeof(Record));
+		fileStream.write(data.data(), data.size());
+	}
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] IBL CACHE: Failed to write cache file \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+std::vector<IBLCache::Record> IBLCache::getRecords()
+{
+	std::vector<Record> records;
+
+	for (uint32_t face = 0; face < 6; ++face)
+	{
+		records.push_back({ Target::ENVIRONMENT, face, 0, uint32_t(parameters.environmentSize), uint32_t(parameters.environmentSize), 3, 0 });
+
+		if (!parameters.irradianceSH)
+		{
+			records.push_back({ Target::IRRADIANCE, face, 0, uint32_t(parameters.irradianceSize), uint32_t(parameters.irradianceSize), 3, 0 });
+		}
+
+		for (int mip = 0; mip < parameters.prefilterMipLevels; ++mip)
+		{
+			uint32_t mipSize = uint32_t(std::max(parameters.prefilterSize >> mip, 1));
+
+			records.push_back({ Target::PREFILTER, face, uint32_t(mip), mipSize, mipSize, 3, 0 });
+		}
+	}
+
+	records.push_back({ Target::BRDF_LUT, 0, 0, uint32_t(parameters.brdfLUTSize), uint32_t(parameters.brdfLUTSize), 2, 0 });
+
+	if (parameters.irradianceSH)
+	{
+		records.push_back({ Target::IRRADIANCE_SH, 0, 0, 9, 1, 3, 0 });
+	}
+
+	for (Record& record : records)
+	{
+		// Half floats, except for the SH9 coefficients which are kept in full precision.
+		record.size = uint64_t(record.width) * record.height * record.channels * (record.target == Target::IRRADIANCE_SH ? 4 : 2);
+	}
+
+	return records;
+}
+
+std::string IBLCache::getFilepath()
+{
+	char name[32];
+
+	std::snprintf(name, sizeof(name), "ibl_%016llx.bin", static_cast<unsigned long long>(key));
+
+	return (directory / name).string();
+}
+
+std::string IBLCache::getCompressedFilepath(const char* map)
+{
+	char name[64];
+
+	std::snprintf(name, sizeof(name), "ibl_%016llx_%s.dds", static_cast<unsigned long long>(key), map);
+
+	return (directory / name).string();
+}
+
+uint64_t IBLCache::hashBytes(const void* data, size_t size, uint64_t hash)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
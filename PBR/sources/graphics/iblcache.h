@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+#include <glad/glad.h>
+
+#include "texture.h"
+#include "cubemap.h"
+#include "iblbaker.h"
+#include "sphericalharmonics.h"
+
+// On-disk cache of the baked IBL maps, keyed by a hash of the source HDR content and the bake parameters.
+//
+// The container is a small header followed by one record per cubemap face/mip (and one for the BRDF LUT),
+// each holding raw half float texels exactly as the GPU stores them, so loading is a single read plus uploads.
+//
+class IBLCache
+{
+public:
+	IBLCache(const char* directory);
+
+	bool computeKey(const char* hdrFilepath, const IBLBakeParameters& parameters);
+
+	// With "IBLBakeParameters::irradianceSH" the irradiance is stored as SH9 coefficients instead of cubemap faces.
+	bool load(CubeMap* environmentCM, CubeMap* irradianceCM, CubeMap* prefilterCM, Texture* brdfLUTTex, SH9* irradianceSH = nullptr);
+	bool save(CubeMap* environmentCM, CubeMap* irradianceCM, CubeMap* prefilterCM, Texture* brdfLUTTex, const SH9* irradianceSH = nullptr);
+
+	std::string getFilepath();
+
+	// BC6H cubemap of one of the maps (e.g. "environment"), written next to the cache file by the offline compression.
+	std::string getCompressedFilepath(const char* map);
+
+private:
+	enum class Target : uint32_t { ENVIRONMENT, IRRADIANCE, PREFILTER, BRDF_LUT, IRRADIANCE_SH };
+
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t key;
+		uint32_t numberOfRecords;
+		uint32_t reserved;
+	};
+
+	struct Record
+	{
+		Target target;
+		uint32_t face, mipLevel;
+		uint32_t width, height, channels;
+		uint64_t size;
+	};
+
+	std::filesystem::path directory;
+	IBLBakeParameters parameters;
+	uint64_t key;
+	bool validKey;
+
+	static constexpr uint32_t VERSION = 3;
+
+	// Every record of a complete cache file for the current parameters, in the order "save" writes them.
+	std::vector<Record> getRecords();
+
+	static uint64_t hashBytes(const void* data, size_t size, uint64_t hash);
+};
@@ -0,0 +1,396 @@
+#include "iblupdatescheduler.h"
+
+static const float PI = 3.14159265359f;
+
+IBLUpdateScheduler::IBLUpdateScheduler(const IBLBakeParameters& parameters, TextureLoader& textureLoader, ThreadPool& threadPool)
+	: parameters(parameters), textureLoader(textureLoader), threadPool(threadPool), environmentShader(nullptr), irradianceShader(nullptr), prefilterShader(nullptr),
+	equirectangularTexture(0), environmentCM(nullptr), irradianceCM(nullptr), prefilterCM(nullptr), irradianceSH(), state(State::IDLE), generation(0), loading(), jobs(),
+	millisecondsPerCost(1e-5), timings(), currentTiming(0), statistics(), startTime()
+{
+	environmentShader = new ShaderProgram("sources/shaders/3_equirectangular2cubemap_cs.glsl");
+	irradianceShader = new ShaderProgram("sources/shaders/3_irradiance_convolution_cs.glsl");
+	prefilterShader = new ShaderProgram("sources/shaders/4_prefilter_convolution_cs.glsl");
+
+	glGenTextures(1, &equirectangularTexture);
+	glBindTexture(GL_TEXTURE_2D, equirectangularTexture);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	for (PendingTiming& timing : timings)
+	{
+		glGenQueries(2, timing.queries);
+
+		timing.cost = 0.0;
+		timing.pending = false;
+	}
+}
+
+IBLUpdateScheduler::~IBLUpdateScheduler()
+{
+	for (PendingTiming& timing : timings)
+	{
+		glDeleteQueries(2, timing.queries);
+	}
+
+	glDeleteTextures(1, &equirectangularTexture);
+
+	delete environmentCM;
+	delete irradianceCM;
+	delete prefilterCM;
+
+	delete environmentShader;
+	delete irradianceShader;
+	delete prefilterShader;
+}
+
+void IBLUpdateScheduler::start(const std::string& hdrFilepath)
+{
+	// Allocated on the first update, then exchanged with the maps in use at every swap.
+	if (!environmentCM)
+	{
+		environmentCM = new CubeMap(parameters.environmentSize, parameters.environmentSize, GL_RGBA16F, GL_RGBA, GL_FLOAT, true);
+		irradianceCM = new CubeMap(parameters.irradianceSize, parameters.irradianceSize, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+		prefilterCM = new CubeMap(parameters.prefilterSize, parameters.prefilterSize, GL_RGBA16F, GL_RGBA, GL_FLOAT, true);
+	}
+
+	int loadGeneration = ++generation;
+	bool projectSH = parameters.irradianceSH;
+	auto loadedSH = std::make_shared<SH9>();
+
+	TextureLoader::Process process = [this, projectSH, loadedSH](TextureLoader::Image& image)
+	{
+		if (projectSH)
+		{
+			HDRImage equirectangularMap = { image.width, image.height, {} };
+			const float* texels = reinterpret_cast<const float*>(image.data.data());
+
+			equirectangularMap.pixels.assign(texels, texels + static_cast<size_t>(image.width) * image.height * 3);
+
+			*loadedSH = SphericalHarmonics::projectIrradiance(equirectangularMap, threadPool);
+		}
+	};
+
+	TextureLoader::Upload upload = [this, loadGeneration, loadedSH](const TextureLoader::Image& image, const void* texels)
+	{
+		if (loadGeneration != generation)
+		{
+			return; // Replaced by a newer update.
+		}
+
+		glBindTexture(GL_TEXTURE_2D, equirectangularTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, image.width, image.height, 0, GL_RGB, GL_FLOAT, texels);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		irradianceSH = *loadedSH;
+	};
+
+	loading = textureLoader.load(hdrFilepath, 3, true, process, upload);
+
+	jobs.clear();
+
+	state = State::LOADING;
+	statistics = Statistics();
+	startTime = std::chrono::high_resolution_clock::now();
+}
+
+bool IBLUpdateScheduler::update(float budgetMilliseconds, const GGXSampleTable& prefilterSamples, SSBO* prefilterSampleBuffer)
+{
+	bool timingsRead = readTimings();
+
+	if (state == State::IDLE)
+	{
+		return false;
+	}
+
+	if (state == State::LOADING)
+	{
+		if (loading.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return false;
+		}
+
+		if (!loading.get())
+		{
+			std::cout << "[ERROR] IBL UPDATE: Failed to load the new environment, the current one is kept." << std::endl;
+
+			state = State::IDLE;
+
+			return false;
+		}
+
+		createJobs(prefilterSamples);
+
+		state = State::BAKING;
+	}
+
+	if (state == State::COMPLETE)
+	{
+		return timingsRead;
+	}
+
+	PendingTiming& timing = timings[currentTiming];
+	bool timed = !timing.pending;
+
+	if (timed)
+	{
+		glQueryCounter(timing.queries[0], GL_TIMESTAMP);
+	}
+
+	prefilterSampleBuffer->bindBase(PREFILTER_SAMPLE_BUFFER_BINDING);
+
+	// Always one job, so the update progresses whatever the budget and the estimate.
+	double budgetCost = budgetMilliseconds / millisecondsPerCost;
+	double issuedCost = 0.0;
+	bool firstJob = true;
+	Stage boundStage = jobs.front().stage;
+
+	bindStage(boundStage);
+
+	while (!jobs.empty() && (firstJob || issuedCost + jobs.front().cost <= budgetCost))
+	{
+		const Job& job = jobs.front();
+
+		// The next stage reads what the previous one wrote.
+		if (job.stage != boundStage)
+		{
+			glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+			boundStage = job.stage;
+			bindStage(boundStage);
+		}
+
+		runJob(job, prefilterSamples);
+
+		issuedCost += job.cost;
+		firstJob = false;
+		statistics.jobs++;
+
+		jobs.pop_front();
+	}
+
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+
+	if (timed)
+	{
+		glQueryCounter(timing.queries[1], GL_TIMESTAMP);
+
+		timing.cost = issuedCost;
+		timing.pending = true;
+
+		currentTiming = (currentTiming + 1) % TIMING_LATENCY;
+	}
+
+	statistics.frames++;
+
+	if (jobs.empty())
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+		statistics.milliseconds = elapsed.count();
+		state = State::COMPLETE;
+	}
+
+	return false;
+}
+
+void IBLUpdateScheduler::swap(CubeMap*& environmentCM, CubeMap*& irradianceCM, CubeMap*& prefilterCM, SH9& irradianceSH)
+{
+	if (state != State::COMPLETE)
+	{
+		std::cout << "[ERROR] IBL UPDATE: Maps swapped before their update completed." << std::endl;
+
+		return;
+	}
+
+	std::swap(environmentCM, this->environmentCM);
+	std::swap(irradianceCM, this->irradianceCM);
+	std::swap(prefilterCM, this->prefilterCM);
+
+	if (parameters.irradianceSH)
+	{
+		irradianceSH = this->irradianceSH;
+	}
+
+	state = State::IDLE;
+}
+
+void IBLUpdateScheduler::createJobs(const GGXSampleTable& prefilterSamples)
+{
+	addTiles(Stage::ENVIRONMENT, 0, parameters.environmentSize, 1.0);
+
+	// A single "glGenerateMipmap", reading about as many texels as the base level has.
+	jobs.push_back({ Stage::ENVIRONMENT_MIPS, 0, 0, 0, 0, parameters.environmentSize, 6.0 * parameters.environmentSize * parameters.environmentSize });
+
+	if (!parameters.irradianceSH)
+	{
+		addTiles(Stage::IRRADIANCE, 0, parameters.irradianceSize, getIrradianceSampleCount(parameters.sampleDelta));
+	}
+
+	for (int mip = 0; mip < prefilterSamples.getNumberOfLevels(); ++mip)
+	{
+		addTiles(Stage::PREFILTER, mip, std::max(parameters.prefilterSize >> mip, 1), prefilterSamples.getLevel(mip).sampleCount);
+	}
+}
+
+void IBLUpdateScheduler::addTiles(Stage stage, int mipLevel, int size, double readsPerTexel)
+{
+	int tileSize = size;
+
+	while (tileSize > TILE_ALIGNMENT && double(tileSize) * tileSize * readsPerTexel > MAX_JOB_COST)
+	{
+		tileSize /= 2;
+	}
+
+	for (int face = 0; face < 6; ++face)
+	{
+		for (int y = 0; y < size; y += tileSize)
+		{
+			for (int x = 0; x < size; x += tileSize)
+			{
+				double texels = double(std::min(tileSize, size - x)) * std::min(tileSize, size - y);
+
+				jobs.push_back({ stage, face, mipLevel, x, y, tileSize, texels * readsPerTexel });
+			}
+		}
+	}
+}
+
+void IBLUpdateScheduler::bindStage(Stage stage)
+{
+	switch (stage)
+	{
+	case Stage::ENVIRONMENT:
+		environmentShader->bind();
+		environmentShader->setUniform1i("uEquirectangularMap", 0);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, equirectangularTexture);
+		glBindImageTexture(0, environmentCM->getID(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+		break;
+
+	case Stage::ENVIRONMENT_MIPS:
+		break;
+
+	case Stage::IRRADIANCE:
+		irradianceShader->bind();
+		irradianceShader->setUniform1i("uEnvironmentMap", 0);
+		irradianceShader->setUniform1f("uSampleDelta", parameters.sampleDelta);
+
+		environmentCM->bind(0);
+		glBindImageTexture(0, irradianceCM->getID(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+		break;
+
+	case Stage::PREFILTER:
+		prefilterShader->bind();
+		prefilterShader->setUniform1i("uEnvironmentMap", 0);
+
+		environmentCM->bind(0);
+		break;
+	}
+}
+
+void IBLUpdateScheduler::runJob(const Job& job, const GGXSampleTable& prefilterSamples)
+{
+	int groups = (job.size + TILE_ALIGNMENT - 1) / TILE_ALIGNMENT;
+	glm::ivec3 texelOffset(job.x, job.y, job.face);
+
+	switch (job.stage)
+	{
+	case Stage::ENVIRONMENT:
+		environmentShader->setUniform3i("uTexelOffset", texelOffset);
+		break;
+
+	case Stage::ENVIRONMENT_MIPS:
+		environmentCM->generateMipMaps();
+		return;
+
+	case Stage::IRRADIANCE:
+		irradianceShader->setUniform3i("uTexelOffset", texelOffset);
+		break;
+
+	case Stage::PREFILTER:
+	{
+		const GGXSampleTable::Level& level = prefilterSamples.getLevel(job.mipLevel);
+
+		prefilterShader->setUniform1i("uFirstSample", level.firstSample);
+		prefilterShader->setUniform1i("uSampleCount", level.sampleCount);
+		prefilterShader->setUniform1f("uInverseTotalWeight", level.inverseTotalWeight);
+		prefilterShader->setUniform3i("uTexelOffset", texelOffset);
+
+		glBindImageTexture(0, prefilterCM->getID(), job.mipLevel, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+		break;
+	}
+	}
+
+	glDispatchCompute(groups, groups, 1);
+}
+
+bool IBLUpdateScheduler::readTimings()
+{
+	bool allRead = true;
+
+	for (PendingTiming& timing : timings)
+	{
+		if (!timing.pending)
+		{
+			continue;
+		}
+
+		GLint available = 0;
+		glGetQueryObjectiv(timing.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (!available)
+		{
+			allRead = false;
+
+			continue;
+		}
+
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(timing.queries[0], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(timing.queries[1], GL_QUERY_RESULT, &end);
+
+		double milliseconds = (end - begin) / 1e6;
+
+		statistics.maxGPUMilliseconds = std::max(statistics.maxGPUMilliseconds, milliseconds);
+
+		// Follows a slower GPU at once, a faster one halfway: overshooting the budget is what shows in the frame time.
+		if (timing.cost > 0.0)
+		{
+			double sample = milliseconds / timing.cost;
+
+			millisecondsPerCost = std::max(sample, 0.5 * (millisecondsPerCost + sample));
+		}
+
+		timing.pending = false;
+	}
+
+	return allRead;
+}
+
+int IBLUpdateScheduler::getIrradianceSampleCount(float sampleDelta)
+{
+	int phiSteps = 0, thetaSteps = 0;
+
+	// Accumulated in single precision like the shader, which may take one more step than the exact division.
+	for (float phi = 0.0f; phi < 2.0f * PI; phi += sampleDelta)
+	{
+		phiSteps++;
+	}
+
+	for (float theta = 0.0f; theta < 0.5f * PI; theta += sampleDelta)
+	{
+		thetaSteps++;
+	}
+
+	return phiSteps * thetaSteps;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <deque>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "ssbo.h"
+#include "shader.h"
+#include "cubemap.h"
+#include "iblbaker.h"
+#include "uniformblocks.h"
+#include "ggxsampletable.h"
+#include "textureloader.h"
+#include "sphericalharmonics.h"
+
+#include "../utils/threadpool.h"
+
+// Time-sliced rebake of the IBL maps depending on the environment (environment, irradiance and prefilter cubemaps),
+// to swap the HDR at runtime without stalling a frame for the whole bake.
+//
+// The HDR is decoded by the texture loader on the thread pool, which also projects its SH9 irradiance there. The bake
+// is then split in jobs of one tile of one face of one mip level, none reading more than "MAX_JOB_COST" texels, run
+// by the compute bake shaders into a second set of maps. Every frame, "update" dispatches jobs until their estimated
+// GPU time reaches the budget (at least one, so an update always completes). The estimate is calibrated by
+// timestamp queries read back once available, a few frames later, so the CPU never waits for the GPU.
+//
+// The maps in use are never written: rendering goes on with them until the new set is complete, then "swap"
+// exchanges both sets at once, between two frames.
+//
+class IBLUpdateScheduler
+{
+public:
+	struct Statistics
+	{
+		int frames;                // Frames that dispatched jobs.
+		int jobs;
+		double milliseconds;       // From "start" to the last job, the HDR decoding included.
+		double maxGPUMilliseconds; // Longest GPU time of the jobs of a frame.
+	};
+
+	IBLUpdateScheduler(const IBLBakeParameters& parameters, TextureLoader& textureLoader, ThreadPool& threadPool);
+	~IBLUpdateScheduler();
+
+	IBLUpdateScheduler(const IBLUpdateScheduler&) = delete;
+	IBLUpdateScheduler& operator=(const IBLUpdateScheduler&) = delete;
+
+	// Starts rebaking the maps from "hdrFilepath", dropping the update in progress if any.
+	void start(const std::string& hdrFilepath);
+
+	// Dispatches the jobs of this frame within "budgetMilliseconds" of GPU time. Returns true once the new maps are
+	// complete and the timings of their jobs read back, the maps being then swapped in with "swap".
+	bool update(float budgetMilliseconds, const GGXSampleTable& prefilterSamples, SSBO* prefilterSampleBuffer);
+
+	// Exchanges the maps in use with the completed ones, the former being the ones rebaked by the next update.
+	void swap(CubeMap*& environmentCM, CubeMap*& irradianceCM, CubeMap*& prefilterCM, SH9& irradianceSH);
+
+	bool isUpdating() { return state != State::IDLE; }
+
+	const Statistics& getStatistics() { return statistics; }
+
+	ShaderProgram* getEnvironmentShader() { return environmentShader; }
+	ShaderProgram* getIrradianceShader() { return irradianceShader; }
+	ShaderProgram* getPrefilterShader() { return prefilterShader; }
+
+private:
+	enum class State
+	{
+		IDLE,
+		LOADING,
+		BAKING,
+		COMPLETE
+	};
+
+	enum class Stage
+	{
+		ENVIRONMENT,
+		ENVIRONMENT_MIPS,
+		IRRADIANCE,
+		PREFILTER
+	};
+
+	struct Job
+	{
+		Stage stage;
+		int face, mipLevel;
+		int x, y, size; // Tile, in texels of the level.
+		double cost;    // Texels read.
+	};
+
+	struct PendingTiming
+	{
+		unsigned int queries[2]; // Timestamps before and after the jobs of a frame.
+		double cost;
+		bool pending;
+	};
+
+	static constexpr int TIMING_LATENCY = 4;
+	static constexpr int TILE_ALIGNMENT = 8; // Work group size of the bake shaders.
+	static constexpr double MAX_JOB_COST = 1 << 20;
+
+	IBLBakeParameters parameters;
+	TextureLoader& textureLoader;
+	ThreadPool& threadPool;
+
+	ShaderProgram* environmentShader;
+	ShaderProgram* irradianceShader;
+	ShaderProgram* prefilterShader;
+
+	unsigned int equirectangularTexture;
+	CubeMap* environmentCM;
+	CubeMap* irradianceCM;
+	CubeMap* prefilterCM;
+	SH9 irradianceSH;
+
+	State state;
+	int generation; // Incremented by every "start", so a load completing after a newer one is dropped.
+	std::shared_future<bool> loading;
+	std::deque<Job> jobs;
+
+	double millisecondsPerCost;
+	PendingTiming timings[TIMING_LATENCY];
+	int currentTiming;
+
+	Statistics statistics;
+	std::chrono::high_resolution_clock::time_point startTime;
+
+	void createJobs(const GGXSampleTable& prefilterSamples);
+	void addTiles(Stage stage, int mipLevel, int size, double readsPerTexel);
+
+	void bindStage(Stage stage);
+	void runJob(const Job& job, const GGXSampleTable& prefilterSamples);
+
+	// Reads back the timings available, without waiting. Returns true when none is left pending.
+	bool readTimings();
+
+	// Samples taken per texel by the irradiance convolution, following the loops of "convolveIrradiance".
+	static int getIrradianceSampleCount(float sampleDelta);
+};
@@ -0,0 +1,593 @@
+#include "materiallibrary.h"
+
+#include <stbi/stb_image_write.h>
+
+struct MapDescription
+{
+	const char* filename;
+	int channels;
+	int internalFormat;
+	int format;
+	unsigned char defaultValue[4];
+	const char* compressedFilename;
+	DDSFormat compressedFormat;
+	int compressedChannels; // Leading channels kept by the compressed format.
+};
+
+static const MapDescription MAP_DESCRIPTIONS[MaterialLibrary::NUMBER_OF_MAPS] = {
+	{ "albedo.png",    4, GL_RGBA8, GL_RGBA, { 255, 255, 255, 255 }, "albedo.dds",    DDSFormat::BC7, 4 },
+	{ "normal.png",    4, GL_RGBA8, GL_RGBA, { 128, 128, 255, 255 }, "normal.dds",    DDSFormat::BC5, 2 },
+	{ "metallic.png",  1, GL_R8,    GL_RED,  { 0 },                  "metallic.dds",  DDSFormat::BC4, 1 },
+	{ "roughness.png", 1, GL_R8,    GL_RED,  { 128 },                "roughness.dds", DDSFormat::BC4, 1 },
+	{ "ao.png",        1, GL_R8,    GL_RED,  { 255 },                "ao.dds",        DDSFormat::BC4, 1 },
+	{ "orm.png",       4, GL_RGBA8, GL_RGBA, { 255, 128, 0, 255 },   "orm.dds",       DDSFormat::BC7, 4 }
+};
+
+MaterialLibrary::MaterialLibrary(const char* directory, const char* cacheDirectory, TextureLoader& textureLoader, int size, bool packORM)
+	: size(size), ready(false), packORM(packORM), materialNames(findMaterials(directory)), mapArrays(), compressedMaps(), pendingMaps(), loadStart(std::chrono::high_resolution_clock::now())
+{
+	if (materialNames.empty())
+	{
+		std::cout << "[ERROR] MATERIAL LIBRARY: No material found in \"" << directory << "\"." << std::endl;
+	}
+
+	int numberOfLayers = std::max(static_cast<int>(materialNames.size()), 1);
+	int numberOfUsedMaps = 0, numberOfCompressedMaps = 0;
+
+	for (int map = 0; map < NUMBER_OF_MAPS; ++map)
+	{
+		const MapDescription& description = MAP_DESCRIPTIONS[map];
+
+		if (!isUsed(static_cast<Map>(map)))
+		{
+			continue;
+		}
+
+		numberOfUsedMaps++;
+
+		compressedMaps[map] = hasCompressedMaps(cacheDirectory, static_cast<Map>(map));
+		numberOfCompressedMaps += compressedMaps[map] ? 1 : 0;
+
+		int internalFormat = compressedMaps[map] ? DDS::getGLInternalFormat(description.compressedFormat) : description.internalFormat;
+
+		mapArrays[map] = new TextureArray(size, size, numberOfLayers, internalFormat);
+	}
+
+	if (numberOfCompressedMaps > 0)
+	{
+		std::cout << "[INFO] MATERIAL LIBRARY: Using block-compressed textures for " << numberOfCompressedMaps << " of " << numberOfUsedMaps << " maps." << std::endl;
+	}
+
+	// Every map is decoded at the same time, the slowest one bounding the loading time.
+	for (int material = 0; material < static_cast<int>(materialNames.size()); ++material)
+	{
+		for (int map = 0; map < NUMBER_OF_MAPS; ++map)
+		{
+			std::filesystem::path folder = std::filesystem::path(directory) / materialNames[material];
+			std::filesystem::path cacheFolder = std::filesystem::path(cacheDirectory) / materialNames[material];
+			std::filesystem::path filepath = folder / MAP_DESCRIPTIONS[map].filename;
+
+			if (!isUsed(static_cast<Map>(map)))
+			{
+				continue;
+			}
+
+			if (compressedMaps[map])
+			{
+				loadCompressedMap(textureLoader, material, static_cast<Map>(map), (cacheFolder / MAP_DESCRIPTIONS[map].compressedFilename).string());
+			}
+			else if (std::filesystem::exists(filepath))
+			{
+				loadMap(textureLoader, material, static_cast<Map>(map), filepath.string());
+			}
+			else if (map == ORM && std::filesystem::exists(cacheFolder / MAP_DESCRIPTIONS[map].filename))
+			{
+				loadMap(textureLoader, material, ORM, (cacheFolder / MAP_DESCRIPTIONS[map].filename).string());
+			}
+			else if (map == ORM)
+			{
+				// Not packed offline, the three maps are interleaved after decoding.
+				int numberOfSourceMaps = 0;
+
+				for (Map sourceMap : { AO, ROUGHNESS, METALLIC })
+				{
+					if (std::filesystem::exists(folder / MAP_DESCRIPTIONS[sourceMap].filename))
+					{
+						numberOfSourceMaps++;
+					}
+					else
+					{
+						std::cout << "[ERROR] MATERIAL LIBRARY: Missing texture \"" << (folder / MAP_DESCRIPTIONS[sourceMap].filename).string() << "\", using a default value." << std::endl;
+					}
+				}
+
+				if (numberOfSourceMaps > 0)
+				{
+					loadPackedMap(textureLoader, material, folder);
+				}
+				else
+				{
+					setDefaultMap(material, ORM);
+				}
+			}
+			else
+			{
+				std::cout << "[ERROR] MATERIAL LIBRARY: Missing texture \"" << filepath.string() << "\", using a default value." << std::endl;
+
+				setDefaultMap(material, static_cast<Map>(map));
+			}
+		}
+	}
+}
+
+bool MaterialLibrary::isReady()
+{
+	if (ready)
+	{
+		return true;
+	}
+
+	for (PendingMap& pendingMap : pendingMaps)
+	{
+		if (pendingMap.loaded.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return false;
+		}
+	}
+
+	for (PendingMap& pendingMap : pendingMaps)
+	{
+		if (!pendingMap.loaded.get())
+		{
+			setDefaultMap(pendingMap.material, pendingMap.map);
+		}
+	}
+
+	pendingMaps.clear();
+
+	for (TextureArray* mapArray : mapArrays)
+	{
+		if (mapArray)
+		{
+			mapArray->generateMipMaps();
+		}
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - loadStart;
+
+	std::cout << "[INFO] MATERIAL LIBRARY: " << materialNames.size() << " material(s) ready after " << elapsed.count() << " ms, "
+		<< getMemoryFootprint() / (1024.0 * 1024.0) << " MB of texture memory." << std::endl;
+
+	ready = true;
+
+	return true;
+}
+
+int MaterialLibrary::getNumberOfMaterials()
+{
+	return static_cast<int>(materialNames.size());
+}
+
+int MaterialLibrary::getMaterialIndex(const std::string& name)
+{
+	auto iterator = std::find(materialNames.begin(), materialNames.end(), name);
+
+	return iterator != materialNames.end() ? static_cast<int>(iterator - materialNames.begin()) : -1;
+}
+
+const std::string& MaterialLibrary::getMaterialName(int index)
+{
+	return materialNames[index];
+}
+
+void MaterialLibrary::bind(int firstUnit)
+{
+	int unit = firstUnit;
+
+	for (TextureArray* mapArray : mapArrays)
+	{
+		if (mapArray)
+		{
+			mapArray->bind(unit++);
+		}
+	}
+}
+
+size_t MaterialLibrary::getMemoryFootprint()
+{
+	size_t footprint = 0;
+	int numberOfLayers = std::max(static_cast<int>(materialNames.size()), 1);
+
+	for (int map = 0; map < NUMBER_OF_MAPS; ++map)
+	{
+		const MapDescription& description = MAP_DESCRIPTIONS[map];
+
+		if (!mapArrays[map])
+		{
+			continue;
+		}
+
+		DDSImage layout = { description.compressedFormat, size, size, DDS::getNumberOfMipLevels(size, size), 1, false, {} };
+
+		for (int mip = 0; mip < layout.numberOfMipLevels; ++mip)
+		{
+			size_t mipSize = static_cast<size_t>(std::max(size >> mip, 1));
+
+			footprint += (compressedMaps[map] ? DDS::getLevelSize(layout, mip) : mipSize * mipSize * description.channels) * numberOfLayers;
+		}
+	}
+
+	return footprint;
+}
+
+bool MaterialLibrary::compress(const char* directory, const char* cacheDirectory, int size, ThreadPool& threadPool, std::vector<BCEncodingReport>& reports)
+{
+	std::vector<std::string> names = findMaterials(directory);
+
+	if (names.empty())
+	{
+		std::cout << "[ERROR] MATERIAL LIBRARY: No material found in \"" << directory << "\"." << std::endl;
+
+		return false;
+	}
+
+	// Same orientation as the textures decoded by the loader.
+	stbi_flip_vertically_on_write(true);
+
+	bool success = true;
+
+	for (const std::string& name : names)
+	{
+		std::filesystem::path folder = std::filesystem::path(directory) / name;
+		std::filesystem::path cacheFolder = std::filesystem::path(cacheDirectory) / name;
+
+		std::error_code error;
+
+		if (!std::filesystem::create_directories(cacheFolder, error) && error)
+		{
+			std::cout << "[ERROR] MATERIAL LIBRARY: Failed to create \"" << cacheFolder.string() << "\"." << std::endl;
+
+			success = false;
+
+			continue;
+		}
+
+		for (int map = 0; map < NUMBER_OF_MAPS; ++map)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+
+			const MapDescription& description = MAP_DESCRIPTIONS[map];
+
+			TextureLoader::Image image;
+
+			// Missing maps are written with the default value, so every material has every compressed map.
+			if (map == ORM)
+			{
+				packMap(folder, size, image);
+
+				if (!stbi_write_png((cacheFolder / description.filename).string().c_str(), size, size, 4, image.data.data(), size * 4))
+				{
+					std::cout << "[ERROR] MATERIAL LIBRARY: Failed to write \"" << (cacheFolder / description.filename).string() << "\"." << std::endl;
+
+					success = false;
+				}
+			}
+			else
+			{
+				readMap(folder, static_cast<Map>(map), size, image);
+			}
+
+			// Drops the trailing channels the compressed format doesn't store (the z of the normals).
+			std::vector<unsigned char> texels(static_cast<size_t>(size) * size * description.compressedChannels);
+
+			for (size_t i = 0; i < static_cast<size_t>(size) * size; ++i)
+			{
+				for (int channel = 0; channel < description.compressedChannels; ++channel)
+				{
+					texels[i * description.compressedChannels + channel] = image.data[i * description.channels + channel];
+				}
+			}
+
+			DDSImage ddsImage = { description.compressedFormat, size, size, DDS::getNumberOfMipLevels(size, size), 1, false, {} };
+
+			BCEncoder::encodeLayer(ddsImage, texels.data(), description.compressedChannels, map == ALBEDO, threadPool);
+
+			success = DDS::save((cacheFolder / description.compressedFilename).string(), ddsImage) && success;
+
+			size_t numberOfTexels = 0;
+
+			for (int mip = 0; mip < ddsImage.numberOfMipLevels; ++mip)
+			{
+				size_t mipSize = static_cast<size_t>(std::max(size >> mip, 1));
+
+				numberOfTexels += mipSize * mipSize;
+			}
+
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+			reports.push_back({ name + "/" + description.compressedFilename, description.compressedFormat, numberOfTexels,
+				numberOfTexels * description.channels, ddsImage.data.size(), elapsed.count() });
+		}
+	}
+
+	return success;
+}
+
+void MaterialLibrary::loadMap(TextureLoader& textureLoader, int material, Map map, const std::string& filepath)
+{
+	const MapDescription& description = MAP_DESCRIPTIONS[map];
+	int size = this->size;
+
+	// Runs on a worker.
+	TextureLoader::Process process = [map, size](TextureLoader::Image& image)
+	{
+		prepareMap(image, map, size);
+	};
+
+	TextureArray* mapArray = mapArrays[map];
+
+	TextureLoader::Upload upload = [mapArray, material, description](const TextureLoader::Image&, const void* texels)
+	{
+		mapArray->setLayerData(material, description.format, GL_UNSIGNED_BYTE, texels);
+	};
+
+	pendingMaps.push_back({ material, map, textureLoader.load(filepath, description.channels == 1 ? 0 : description.channels, false, process, upload) });
+}
+
+void MaterialLibrary::loadPackedMap(TextureLoader& textureLoader, int material, const std::filesystem::path& folder)
+{
+	int size = this->size;
+
+	TextureLoader::Decode decode = [folder, size](TextureLoader::Image& image)
+	{
+		return packMap(folder, size, image);
+	};
+
+	TextureArray* mapArray = mapArrays[ORM];
+
+	TextureLoader::Upload upload = [mapArray, material](const TextureLoader::Image&, const void* texels)
+	{
+		mapArray->setLayerData(material, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+	};
+
+	pendingMaps.push_back({ material, ORM, textureLoader.load((folder / MAP_DESCRIPTIONS[ORM].filename).string(), decode, upload) });
+}
+
+void MaterialLibrary::setDefaultMap(int material, Map map)
+{
+	const MapDescription& description = MAP_DESCRIPTIONS[map];
+
+	if (compressedMaps[map])
+	{
+		// A constant map is the same block everywhere, at every level.
+		unsigned char texels[16 * 4];
+		unsigned char block[16];
+
+		for (int i = 0; i < 16 * description.compressedChannels; ++i)
+		{
+			texels[i] = description.defaultValue[i % description.compressedChannels];
+		}
+
+		switch (description.compressedFormat)
+		{
+		case DDSFormat::BC4: BCEncoder::encodeBC4Block(texels, block); break;
+		case DDSFormat::BC5: BCEncoder::encodeBC5Block(texels, block); break;
+		default:             BCEncoder::encodeBC7Block(texels, block); break;
+		}
+
+		DDSImage layout = { description.compressedFormat, size, size, DDS::getNumberOfMipLevels(size, size), 1, false, {} };
+		int blockSize = DDS::getBlockSize(description.compressedFormat);
+
+		for (int mip = 0; mip < layout.numberOfMipLevels; ++mip)
+		{
+			std::vector<unsigned char> blocks(DDS::getLevelSize(layout, mip));
+
+			for (size_t offset = 0; offset < blocks.size(); offset += blockSize)
+			{
+				std::memcpy(&blocks[offset], block, blockSize);
+			}
+
+			mapArrays[map]->setCompressedLayerData(material, mip, static_cast<int>(blocks.size()), blocks.data());
+		}
+
+		return;
+	}
+
+	std::vector<unsigned char> layer(static_cast<size_t>(size) * size * description.channels);
+
+	for (size_t i = 0; i < layer.size(); ++i)
+	{
+		layer[i] = description.defaultValue[i % description.channels];
+	}
+
+	mapArrays[map]->setLayerData(material, description.format, GL_UNSIGNED_BYTE, layer.data());
+}
+
+void MaterialLibrary::loadCompressedMap(TextureLoader& textureLoader, int material, Map map, const std::string& filepath)
+{
+	TextureArray* mapArray = mapArrays[map];
+
+	TextureLoader::Upload upload = [mapArray, material](const TextureLoader::Image& image, const void* blocks)
+	{
+		DDSImage layout = { image.format, image.width, image.height, image.numberOfMipLevels, 1, false, {} };
+
+		for (int mip = 0; mip < image.numberOfMipLevels; ++mip)
+		{
+			const unsigned char* levelBlocks = static_cast<const unsigned char*>(blocks) + DDS::getLevelOffset(layout, 0, mip);
+
+			mapArray->setCompressedLayerData(material, mip, static_cast<int>(DDS::getLevelSize(layout, mip)), levelBlocks);
+		}
+	};
+
+	pendingMaps.push_back({ material, map, textureLoader.loadCompressed(filepath, upload) });
+}
+
+bool MaterialLibrary::isUsed(Map map)
+{
+	if (map == METALLIC || map == ROUGHNESS || map == AO)
+	{
+		return !packORM;
+	}
+
+	return map != ORM || packORM;
+}
+
+bool MaterialLibrary::hasCompressedMaps(const char* cacheDirectory, Map map)
+{
+	const MapDescription& description = MAP_DESCRIPTIONS[map];
+
+	if (materialNames.empty())
+	{
+		return false;
+	}
+
+	// Only the headers are read, the blocks are loaded later by the texture loader.
+	for (const std::string& name : materialNames)
+	{
+		std::filesystem::path filepath = std::filesystem::path(cacheDirectory) / name / description.compressedFilename;
+
+		DDSImage header;
+
+		if (!std::filesystem::exists(filepath) || !DDS::loadHeader(filepath.string(), header))
+		{
+			return false;
+		}
+
+		if (header.format != description.compressedFormat || header.width != size || header.height != size || header.numberOfLayers != 1
+			|| header.numberOfMipLevels != DDS::getNumberOfMipLevels(size, size))
+		{
+			std::cout << "[INFO] MATERIAL LIBRARY: \"" << filepath.string() << "\" doesn't match the library size, using the uncompressed maps." << std::endl;
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+std::vector<std::string> MaterialLibrary::findMaterials(const char* directory)
+{
+	std::vector<std::string> names;
+	std::error_code error;
+
+	// Any folder with at least one of the source maps is a material.
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error))
+	{
+		if (!entry.is_directory())
+		{
+			continue;
+		}
+
+		for (const MapDescription& description : MAP_DESCRIPTIONS)
+		{
+			if (std::filesystem::exists(entry.path() / description.filename))
+			{
+				names.push_back(entry.path().filename().string());
+
+				break;
+			}
+		}
+	}
+
+	std::sort(names.begin(), names.end());
+
+	return names;
+}
+
+void MaterialLibrary::prepareMap(TextureLoader::Image& image, Map map, int size)
+{
+	const MapDescription& description = MAP_DESCRIPTIONS[map];
+
+	// Keeps the first channel of single channel maps (like the ".r" the shader used to read) and resamples.
+	if (image.channels != description.channels)
+	{
+		std::vector<unsigned char> pixels(static_cast<size_t>(image.width) * image.height * description.channels);
+
+		for (size_t i = 0; i < static_cast<size_t>(image.width) * image.height; ++i)
+		{
+			for (int channel = 0; channel < description.channels; ++channel)
+			{
+				pixels[i * description.channels + channel] = image.data[i * image.channels + channel];
+			}
+		}
+
+		image.data.swap(pixels);
+		image.channels = description.channels;
+	}
+
+	if (image.width != size || image.height != size)
+	{
+		std::vector<unsigned char> pixels(static_cast<size_t>(size) * size * description.channels);
+
+		if (map == ALBEDO)
+		{
+			// The albedo is stored in sRGB, filtered in linear space.
+			stbir_resize_uint8_srgb(image.data.data(), image.width, image.height, 0, pixels.data(), size, size, 0, description.channels, 3, 0);
+		}
+		else
+		{
+			stbir_resize_uint8(image.data.data(), image.width, image.height, 0, pixels.data(), size, size, 0, description.channels);
+		}
+
+		image.data.swap(pixels);
+		image.width = size;
+		image.height = size;
+	}
+}
+
+bool MaterialLibrary::readMap(const std::filesystem::path& folder, Map map, int size, TextureLoader::Image& image)
+{
+	const MapDescription& description = MAP_DESCRIPTIONS[map];
+
+	image = { 0, 0, 0, false, false, 1, description.compressedFormat, {}, 0.0 };
+
+	// Same orientation as the textures decoded by the loader.
+	stbi_set_flip_vertically_on_load_thread(true);
+
+	unsigned char* data = stbi_load((folder / description.filename).string().c_str(), &image.width, &image.height, &image.channels, description.channels == 1 ? 0 : description.channels);
+
+	if (data)
+	{
+		image.channels = description.channels == 1 ? image.channels : description.channels;
+		image.data.assign(data, data + static_cast<size_t>(image.width) * image.height * image.channels);
+
+		stbi_image_free(data);
+
+		prepareMap(image, map, size);
+
+		return true;
+	}
+
+	image.width = size;
+	image.height = size;
+	image.channels = description.channels;
+	image.data.resize(static_cast<size_t>(size) * size * description.channels);
+
+	for (size_t i = 0; i < image.data.size(); ++i)
+	{
+		image.data[i] = description.defaultValue[i % description.channels];
+	}
+
+	return false;
+}
+
+bool MaterialLibrary::packMap(const std::filesystem::path& folder, int size, TextureLoader::Image& image)
+{
+	TextureLoader::Image occlusion, roughness, metallic;
+
+	// Not short-circuited, every map has to be read or defaulted.
+	int numberOfMaps = static_cast<int>(readMap(folder, AO, size, occlusion)) + static_cast<int>(readMap(folder, ROUGHNESS, size, roughness))
+		+ static_cast<int>(readMap(folder, METALLIC, size, metallic));
+
+	image = { size, size, 4, false, false, 1, MAP_DESCRIPTIONS[ORM].compressedFormat, {}, 0.0 };
+	image.data.resize(static_cast<size_t>(size) * size * 4);
+
+	ChannelPacker::interleave(occlusion.data.data(), roughness.data.data(), metallic.data.data(), 255, static_cast<size_t>(size) * size, image.data.data());
+
+	if (numberOfMaps == 0)
+	{
+		std::cout << "[ERROR] MATERIAL LIBRARY: No occlusion, roughness or metallic map could be read in \"" << folder.string() << "\"." << std::endl;
+	}
+
+	return numberOfMaps > 0;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+#include <glad/glad.h>
+
+#include "texturearray.h"
+#include "textureloader.h"
+
+#include "../utils/dds.h"
+#include "../utils/bcencoder.h"
+#include "../utils/channelpacker.h"
+#include "../utils/threadpool.h"
+
+// Every material of "resources/textures", one texture array per map and one layer per material.
+//
+// A material is selected in the shader by its layer index, so spheres with different materials are drawn
+// without binding anything in between. Maps are resampled to a common size, missing ones replaced by
+// neutral values (white albedo and AO, flat normal, non-metallic, half rough).
+//
+// The maps are decoded and resampled in parallel by a "TextureLoader", so the arrays are only complete
+// once "isReady" returns true, which also generates their mip chains.
+//
+// By default the occlusion, roughness and metallic maps are packed in the red, green and blue channels of a
+// single ORM array, either from an "orm.png" (the material's own or the one written offline by "compress" in
+// the cache directory) or interleaved on the worker at load time, so the shader does one fetch instead of three.
+//
+// A map uses its block-compressed array when every material has the "<map>.dds" written by "compress" at the
+// library size in its cache folder: BC7 albedo and ORM, BC5 normal (the shader rebuilds z) and BC4 metallic, roughness and AO, their mip
+// chains being uploaded from the files instead of generated.
+//
+class MaterialLibrary
+{
+public:
+	enum Map { ALBEDO, NORMAL, METALLIC, ROUGHNESS, AO, ORM, NUMBER_OF_MAPS };
+
+	// The files generated by "compress" are read from "cacheDirectory", in a folder per material.
+	MaterialLibrary(const char* directory, const char* cacheDirectory, TextureLoader& textureLoader, int size = 1024, bool packORM = true);
+
+	// GL thread only, "TextureLoader::update" must be called for the loads to complete.
+	bool isReady();
+
+	int getNumberOfMaterials();
+	int getMaterialIndex(const std::string& name); // -1 if there's no such material.
+	const std::string& getMaterialName(int index);
+
+	bool isPackedORM() { return packORM; }
+
+	// Binds the arrays in use, in "Map" order, on consecutive units from "firstUnit" (albedo, normal and ORM when packed).
+	void bind(int firstUnit);
+
+	// Bytes of every map array, mip chains included.
+	size_t getMemoryFootprint();
+
+	// Offline: packs the "orm.png" of every material and encodes every map to "<map>.dds" files, resampled to
+	// "size", all written to "cacheDirectory" so the material folders are left untouched.
+	static bool compress(const char* directory, const char* cacheDirectory, int size, ThreadPool& threadPool, std::vector<BCEncodingReport>& reports);
+
+private:
+	struct PendingMap
+	{
+		int material;
+		Map map;
+		std::shared_future<bool> loaded;
+	};
+
+	int size;
+	bool ready;
+	bool packORM;
+
+	std::vector<std::string> materialNames;
+	TextureArray* mapArrays[NUMBER_OF_MAPS];
+	bool compressedMaps[NUMBER_OF_MAPS];
+
+	std::vector<PendingMap> pendingMaps;
+	std::chrono::high_resolution_clock::time_point loadStart;
+
+	void loadMap(TextureLoader& textureLoader, int material, Map map, const std::string& filepath);
+	void loadCompressedMap(TextureLoader& textureLoader, int material, Map map, const std::string& filepath);
+	void loadPackedMap(TextureLoader& textureLoader, int material, const std::filesystem::path& folder);
+	void setDefaultMap(int material, Map map);
+
+	bool isUsed(Map map);
+	bool hasCompressedMaps(const char* cacheDirectory, Map map);
+
+	static std::vector<std::string> findMaterials(const char* directory);
+	static void prepareMap(TextureLoader::Image& image, Map map, int size);
+
+	// Decoded and prepared map of "folder", or its default value if the file is missing or can't be decoded.
+	static bool readMap(const std::filesystem::path& folder, Map map, int size, TextureLoader::Image& image);
+	static bool packMap(const std::filesystem::path& folder, int size, TextureLoader::Image& image); // ORM, false if none of its maps could be read.
+};
@@ -0,0 +1,417 @@
+#include "objectculling.h"
+
+static const int CULLING_GROUP_SIZE = 64;      // "local_size_x" of "6_object_culling_cs.glsl".
+static const int DEPTH_PYRAMID_GROUP_SIZE = 8; // "local_size_x" and "local_size_y" of "6_depth_pyramid_cs.glsl".
+
+ObjectCulling::ObjectCulling()
+	: numberOfObjects(0), instanceStride(0), centersX(), centersY(), centersZ(), radii(), candidates(), boundsBuffer(nullptr), candidateBuffer(nullptr),
+	instanceBuffer(nullptr), visibleInstanceBuffer(nullptr), drawCommandBuffer(nullptr), cullingShader(nullptr), depthPyramidShader(nullptr), depthFramebuffer(0),
+	depthTexture(0), depthPyramidTexture(0), depthWidth(0), depthHeight(0), depthPyramidLevels(0), depthPyramidViewProjection(1.0f), depthFormat(GL_NONE), depthPyramidValid(false),
+	occlusionCulling(true), pendingStatistics(), currentStatistics(0), statistics()
+{
+	boundsBuffer = new SSBO(sizeof(glm::vec4));
+	candidateBuffer = new SSBO(sizeof(uint32_t));
+	instanceBuffer = new SSBO(sizeof(glm::vec4));
+	visibleInstanceBuffer = new SSBO(sizeof(glm::vec4));
+	drawCommandBuffer = new SSBO(sizeof(DrawElementsCommand));
+
+	for (PendingStatistics& pending : pendingStatistics)
+	{
+		glGenBuffers(1, &pending.buffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, pending.buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, sizeof(DrawElementsCommand), nullptr, GL_STREAM_READ);
+
+		pending.fence = nullptr;
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	cullingShader = new ShaderProgram("sources/shaders/6_object_culling_cs.glsl");
+	depthPyramidShader = new ShaderProgram("sources/shaders/6_depth_pyramid_cs.glsl");
+}
+
+ObjectCulling::~ObjectCulling()
+{
+	for (PendingStatistics& pending : pendingStatistics)
+	{
+		if (pending.fence)
+		{
+			glDeleteSync(pending.fence);
+		}
+
+		glDeleteBuffers(1, &pending.buffer);
+	}
+
+	deleteDepthPyramid();
+
+	delete boundsBuffer;
+	delete candidateBuffer;
+	delete instanceBuffer;
+	delete visibleInstanceBuffer;
+	delete drawCommandBuffer;
+
+	delete cullingShader;
+	delete depthPyramidShader;
+}
+
+void ObjectCulling::setObjects(const std::vector<glm::vec4>& boundingSpheres, const void* instances, int instanceStride)
+{
+	numberOfObjects = static_cast<int>(boundingSpheres.size());
+	this->instanceStride = instanceStride;
+
+	size_t paddedSize = (boundingSpheres.size() + SIMD_LANES - 1) / SIMD_LANES * SIMD_LANES;
+
+	centersX.assign(paddedSize, 0.0f);
+	centersY.assign(paddedSize, 0.0f);
+	centersZ.assign(paddedSize, 0.0f);
+	radii.assign(paddedSize, 0.0f);
+
+	for (size_t i = 0; i < boundingSpheres.size(); ++i)
+	{
+		centersX[i] = boundingSpheres[i].x;
+		centersY[i] = boundingSpheres[i].y;
+		centersZ[i] = boundingSpheres[i].z;
+		radii[i] = boundingSpheres[i].w;
+	}
+
+	if (numberOfObjects == 0)
+	{
+		return;
+	}
+
+	boundsBuffer->setData(static_cast<int>(boundingSpheres.size() * sizeof(glm::vec4)), boundingSpheres.data());
+	instanceBuffer->setData(numberOfObjects * instanceStride, instances);
+
+	// Only written by the GPU, grown when needed.
+	if (numberOfObjects * instanceStride > visibleInstanceBuffer->getSize())
+	{
+		visibleInstanceBuffer->setData(numberOfObjects * instanceStride, nullptr);
+	}
+
+	if (numberOfObjects * static_cast<int>(sizeof(uint32_t)) > candidateBuffer->getSize())
+	{
+		candidateBuffer->setData(numberOfObjects * sizeof(uint32_t), nullptr);
+	}
+}
+
+void ObjectCulling::cull(const glm::mat4& viewProjection, unsigned int indexCount)
+{
+	readStatistics();
+
+	cullFrustum(viewProjection, centersX, centersY, centersZ, radii, numberOfObjects, candidates);
+
+	// Instance count accumulated by the compute shader.
+	DrawElementsCommand command = { indexCount, 0, 0, 0, 0 };
+
+	drawCommandBuffer->setSubData(0, sizeof(DrawElementsCommand), &command);
+
+	if (!candidates.empty())
+	{
+		candidateBuffer->setSubData(0, static_cast<int>(candidates.size() * sizeof(uint32_t)), candidates.data());
+
+		boundsBuffer->bindBase(OBJECT_BOUNDS_BUFFER_BINDING);
+		candidateBuffer->bindBase(OBJECT_CANDIDATE_BUFFER_BINDING);
+		instanceBuffer->bindBase(OBJECT_INSTANCE_BUFFER_BINDING);
+		visibleInstanceBuffer->bindBase(VISIBLE_INSTANCE_BUFFER_BINDING);
+		drawCommandBuffer->bindBase(DRAW_COMMAND_BUFFER_BINDING);
+
+		cullingShader->bind();
+		cullingShader->setUniform1i("uNumberOfCandidates", static_cast<int>(candidates.size()));
+		cullingShader->setUniform1i("uInstanceStride", instanceStride / static_cast<int>(sizeof(glm::vec4)));
+		cullingShader->setUniform1i("uOcclusionCulling", occlusionCulling && depthPyramidValid);
+		cullingShader->setUniform1i("uDepthPyramid", 0);
+		cullingShader->setUniformMatrix4fv("uDepthPyramidViewProjection", depthPyramidViewProjection);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, depthPyramidTexture);
+
+		glDispatchCompute((static_cast<int>(candidates.size()) + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE, 1, 1);
+
+		cullingShader->unbind();
+	}
+
+	// The command and the instances are read by the indirect draw, the command by the statistics copy.
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	PendingStatistics& pending = pendingStatistics[currentStatistics];
+
+	// Still not signaled after a full ring of frames, dropped rather than waited for.
+	if (pending.fence)
+	{
+		glDeleteSync(pending.fence);
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, drawCommandBuffer->getID());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, pending.buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(DrawElementsCommand));
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	pending.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	pending.tested = static_cast<uint32_t>(numberOfObjects);
+	pending.candidates = static_cast<uint32_t>(candidates.size());
+
+	currentStatistics = (currentStatistics + 1) % STATISTICS_LATENCY;
+}
+
+void ObjectCulling::draw(int mode)
+{
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, drawCommandBuffer->getID());
+
+	glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, nullptr, 1, 0);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void ObjectCulling::buildDepthPyramid(int width, int height, const glm::mat4& viewProjection)
+{
+	GLint framebuffer;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+
+	GLenum format = getReadDepthFormat();
+
+	if (format == GL_NONE)
+	{
+		depthPyramidValid = false;
+
+		return;
+	}
+
+	if (width != depthWidth || height != depthHeight || format != depthFormat)
+	{
+		deleteDepthPyramid();
+		createDepthPyramid(width, height, format);
+	}
+
+	// Copy of the depth buffer (resolved if multisampled), the default framebuffer's one can't be sampled.
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, depthFramebuffer);
+
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+	depthPyramidShader->bind();
+	depthPyramidShader->setUniform1i("uSourceDepth", 0);
+
+	glActiveTexture(GL_TEXTURE0);
+
+	int levelWidth = std::max(width / 2, 1);
+	int levelHeight = std::max(height / 2, 1);
+
+	for (int level = 0; level < depthPyramidLevels; ++level)
+	{
+		// Each level reduces the previous one, the first the depth buffer.
+		glBindTexture(GL_TEXTURE_2D, level == 0 ? depthTexture : depthPyramidTexture);
+		depthPyramidShader->setUniform1i("uSourceLevel", std::max(level - 1, 0));
+
+		glBindImageTexture(0, depthPyramidTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+		glDispatchCompute((levelWidth + DEPTH_PYRAMID_GROUP_SIZE - 1) / DEPTH_PYRAMID_GROUP_SIZE, (levelHeight + DEPTH_PYRAMID_GROUP_SIZE - 1) / DEPTH_PYRAMID_GROUP_SIZE, 1);
+
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+		levelWidth = std::max(levelWidth / 2, 1);
+		levelHeight = std::max(levelHeight / 2, 1);
+	}
+
+	depthPyramidShader->unbind();
+
+	glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	depthPyramidViewProjection = viewProjection;
+	depthPyramidValid = true;
+}
+
+void ObjectCulling::cullFrustum(const glm::mat4& viewProjection, const std::vector<float>& centersX, const std::vector<float>& centersY,
+	const std::vector<float>& centersZ, const std::vector<float>& radii, int numberOfObjects, std::vector<uint32_t>& visibleObjects)
+{
+	// Planes of the clip space frustum, "-w <= x, y, z <= w", brought back to world space (Gribb and Hartmann).
+	glm::vec4 rows[4];
+
+	for (int i = 0; i < 4; ++i)
+	{
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+	}
+
+	glm::vec4 planes[6] = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2] };
+
+	for (glm::vec4& plane : planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+
+	visibleObjects.clear();
+
+	float distances[SIMD_LANES];
+
+	for (int i = 0; i < numberOfObjects; i += SIMD_LANES)
+	{
+		SIMDFloat x = SIMDFloat::load(&centersX[i]);
+		SIMDFloat y = SIMDFloat::load(&centersY[i]);
+		SIMDFloat z = SIMDFloat::load(&centersZ[i]);
+		SIMDFloat radius = SIMDFloat::load(&radii[i]);
+
+		// Smallest signed distance to the planes, pushed out by the radius: negative when fully outside one of them.
+		SIMDFloat distance = SIMDFloat(planes[0].x) * x + SIMDFloat(planes[0].y) * y + SIMDFloat(planes[0].z) * z + SIMDFloat(planes[0].w);
+
+		for (int plane = 1; plane < 6; ++plane)
+		{
+			distance = simdMin(distance, SIMDFloat(planes[plane].x) * x + SIMDFloat(planes[plane].y) * y + SIMDFloat(planes[plane].z) * z + SIMDFloat(planes[plane].w));
+		}
+
+		(distance + radius).store(distances);
+
+		for (int lane = 0; lane < SIMD_LANES && i + lane < numberOfObjects; ++lane)
+		{
+			if (distances[lane] >= 0.0f)
+			{
+				visibleObjects.push_back(static_cast<uint32_t>(i + lane));
+			}
+		}
+	}
+}
+
+void ObjectCulling::createDepthPyramid(int width, int height, GLenum format)
+{
+	depthWidth = width;
+	depthHeight = height;
+	depthFormat = format;
+
+	glGenTextures(1, &depthTexture);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	bool stencil = format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8;
+
+	glGenFramebuffers(1, &depthFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, depthFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "[ERROR] OBJECT CULLING: Incomplete depth copy framebuffer." << std::endl;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// Half the depth buffer down to a single texel.
+	int pyramidWidth = std::max(width / 2, 1);
+	int pyramidHeight = std::max(height / 2, 1);
+
+	depthPyramidLevels = 1 + static_cast<int>(std::floor(std::log2(std::max(pyramidWidth, pyramidHeight))));
+
+	glGenTextures(1, &depthPyramidTexture);
+	glBindTexture(GL_TEXTURE_2D, depthPyramidTexture);
+	glTexStorage2D(GL_TEXTURE_2D, depthPyramidLevels, GL_R32F, pyramidWidth, pyramidHeight);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void ObjectCulling::deleteDepthPyramid()
+{
+	glDeleteFramebuffers(1, &depthFramebuffer);
+	glDeleteTextures(1, &depthTexture);
+	glDeleteTextures(1, &depthPyramidTexture);
+
+	depthFramebuffer = 0;
+	depthTexture = 0;
+	depthPyramidTexture = 0;
+	depthWidth = 0;
+	depthHeight = 0;
+	depthFormat = GL_NONE;
+	depthPyramidValid = false;
+}
+
+void ObjectCulling::readStatistics()
+{
+	// Oldest first, stopping at the first copy the GPU hasn't reached yet.
+	for (int i = 0; i < STATISTICS_LATENCY; ++i)
+	{
+		PendingStatistics& pending = pendingStatistics[(currentStatistics + i) % STATISTICS_LATENCY];
+
+		if (!pending.fence)
+		{
+			continue;
+		}
+
+		GLenum status = glClientWaitSync(pending.fence, 0, 0);
+
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			break;
+		}
+
+		glDeleteSync(pending.fence);
+		pending.fence = nullptr;
+
+		DrawElementsCommand command;
+
+		glBindBuffer(GL_COPY_READ_BUFFER, pending.buffer);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(DrawElementsCommand), &command);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+		statistics.tested = pending.tested;
+		statistics.frustumCulled = pending.tested - pending.candidates;
+		statistics.visible = command.instanceCount;
+		statistics.occluded = pending.candidates - std::min(command.instanceCount, pending.candidates);
+	}
+}
+
+GLenum ObjectCulling::getReadDepthFormat()
+{
+	GLint framebuffer;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &framebuffer);
+
+	// The default framebuffer names its buffers differently.
+	GLenum depthAttachment = framebuffer == 0 ? GL_DEPTH : GL_DEPTH_ATTACHMENT;
+	GLenum stencilAttachment = framebuffer == 0 ? GL_STENCIL : GL_STENCIL_ATTACHMENT;
+
+	GLint depthType = GL_NONE, stencilType = GL_NONE;
+
+	glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, depthAttachment, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &depthType);
+	glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, stencilAttachment, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &stencilType);
+
+	if (depthType == GL_NONE)
+	{
+		return GL_NONE;
+	}
+
+	GLint depthBits = 0, componentType = GL_NONE, stencilBits = 0;
+
+	glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, depthAttachment, GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &depthBits);
+	glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, depthAttachment, GL_FRAMEBUFFER_ATTACHMENT_COMPONENT_TYPE, &componentType);
+
+	if (stencilType != GL_NONE)
+	{
+		glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, stencilAttachment, GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE, &stencilBits);
+	}
+
+	if (componentType == GL_FLOAT)
+	{
+		return stencilBits > 0 ? GL_DEPTH32F_STENCIL8 : GL_DEPTH_COMPONENT32F;
+	}
+
+	if (depthBits == 16)
+	{
+		return GL_DEPTH_COMPONENT16;
+	}
+
+	if (depthBits == 32)
+	{
+		return GL_DEPTH_COMPONENT32;
+	}
+
+	return stencilBits > 0 ? GL_DEPTH24_STENCIL8 : GL_DEPTH_COMPONENT24;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "ssbo.h"
+#include "shader.h"
+#include "uniformblocks.h"
+
+#include "../utils/simd.h"
+
+// Frustum and occlusion culling of the instances of a mesh, drawn with a single indirect call.
+//
+// Every object has a world space bounding sphere. They are first tested against the six planes of the view frustum
+// on the CPU, "SIMD_LANES" at a time, and the ones left are tested on "6_object_culling_cs.glsl" against a Hi-Z
+// pyramid (farthest depth per texel) built from the depth buffer of the previous frame. The visible objects append
+// their instance data to the buffer read by the instanced vertex attributes and increment the instance count of the
+// draw command, so the CPU never reads the result back.
+//
+// The pyramid lags one frame behind the camera. The objects are projected with the view-projection it was built with,
+// so their depth is compared with the depth of the same view, and an object disoccluded by a fast motion only appears
+// on the frame after. The statistics are read back a frame or more later too, once their fence is signaled.
+//
+class ObjectCulling
+{
+public:
+	struct Statistics
+	{
+		uint32_t tested;
+		uint32_t frustumCulled;
+		uint32_t occluded;
+		uint32_t visible;
+	};
+
+	ObjectCulling();
+	~ObjectCulling();
+
+	ObjectCulling(const ObjectCulling&) = delete;
+	ObjectCulling& operator=(const ObjectCulling&) = delete;
+
+	// One bounding sphere (xyz = center, w = radius) per instance, "instanceStride" bytes each (a multiple of 16).
+	void setObjects(const std::vector<glm::vec4>& boundingSpheres, const void* instances, int instanceStride);
+
+	// Culls with the camera of the bound camera block, "viewProjection" being the same matrices for the frustum test.
+	void cull(const glm::mat4& viewProjection, unsigned int indexCount);
+
+	// Draws the visible instances of the bound VAO, whose instanced attributes read "getVisibleInstanceBufferID".
+	void draw(int mode);
+
+	// Rebuilds the pyramid from the depth of the bound draw framebuffer, to cull the next frame. Call after the opaque draws,
+	// "viewProjection" being the matrices they were drawn with.
+	void buildDepthPyramid(int width, int height, const glm::mat4& viewProjection);
+
+	void setOcclusionCulling(bool enabled) { occlusionCulling = enabled; }
+
+	unsigned int getVisibleInstanceBufferID() { return visibleInstanceBuffer->getID(); }
+	const Statistics& getStatistics() { return statistics; }
+
+	ShaderProgram* getCullingShader() { return cullingShader; }
+	ShaderProgram* getDepthPyramidShader() { return depthPyramidShader; }
+
+	// Indices of the spheres intersecting the frustum whose planes are extracted from "viewProjection".
+	static void cullFrustum(const glm::mat4& viewProjection, const std::vector<float>& centersX, const std::vector<float>& centersY,
+		const std::vector<float>& centersZ, const std::vector<float>& radii, int numberOfObjects, std::vector<uint32_t>& visibleObjects);
+
+private:
+	struct PendingStatistics
+	{
+		unsigned int buffer; // Copy of the draw command.
+		GLsync fence;
+		uint32_t tested;
+		uint32_t candidates;
+	};
+
+	static constexpr int STATISTICS_LATENCY = 3;
+
+	int numberOfObjects;
+	int instanceStride;
+
+	// Bounding spheres as structures of arrays for the frustum test, padded to a multiple of "SIMD_LANES".
+	std::vector<float> centersX, centersY, centersZ, radii;
+	std::vector<uint32_t> candidates;
+
+	SSBO* boundsBuffer;
+	SSBO* candidateBuffer;
+	SSBO* instanceBuffer;
+	SSBO* visibleInstanceBuffer;
+	SSBO* drawCommandBuffer;
+
+	ShaderProgram* cullingShader;
+	ShaderProgram* depthPyramidShader;
+
+	unsigned int depthFramebuffer;
+	unsigned int depthTexture;
+	unsigned int depthPyramidTexture;
+	int depthWidth, depthHeight;
+	int depthPyramidLevels;
+	glm::mat4 depthPyramidViewProjection;
+	GLenum depthFormat;
+	bool depthPyramidValid;
+	bool occlusionCulling;
+
+	PendingStatistics pendingStatistics[STATISTICS_LATENCY];
+	int currentStatistics;
+	Statistics statistics;
+
+	void createDepthPyramid(int width, int height, GLenum format);
+	void deleteDepthPyramid();
+
+	void readStatistics();
+
+	// Depth format of the bound read framebuffer, which a depth blit must match.
+	static GLenum getReadDepthFormat();
+};
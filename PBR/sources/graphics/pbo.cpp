@@ -0,0 +1,47 @@
+#include "pbo.h"
+
+PBO::PBO(int size) : ID(), size(size)
+{
+	glGenBuffers(1, &ID);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, ID);
+	glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+PBO::~PBO()
+{
+	glDeleteBuffers(1, &ID);
+}
+
+void PBO::bind()
+{
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, ID);
+}
+
+void PBO::unbind()
+{
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void PBO::readPixels(int width, int height, int format, int type)
+{
+	// With a pixel pack buffer bound the last argument is an offset into it, and the call returns
+	// as soon as the transfer is queued instead of waiting for the frame to finish.
+	//
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, ID);
+	glReadPixels(0, 0, width, height, format, type, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+const void* PBO::map()
+{
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, ID);
+
+	return glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+}
+
+void PBO::unmap()
+{
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Pixel pack buffer, the target of asynchronous "glReadPixels" calls.
+class PBO
+{
+public:
+	PBO(int size);
+	~PBO();
+
+	PBO(const PBO&) = delete;
+	PBO& operator=(const PBO&) = delete;
+
+	void bind();
+	void unbind();
+
+	void readPixels(int width, int height, int format, int type);
+
+	const void* map();
+	void unmap();
+
+private:
+	unsigned int ID;
+	int size;
+};
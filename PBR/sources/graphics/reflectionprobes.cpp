@@ -0,0 +1,247 @@
+#include "reflectionprobes.h"
+
+// Same orientations as the capture passes of the environment, so the faces land where the cubemap lookups expect them.
+static const glm::vec3 FACE_DIRECTIONS[6] = {
+	glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3( 0.0f,  1.0f,  0.0f),
+	glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3( 0.0f,  0.0f, -1.0f)
+};
+
+static const glm::vec3 FACE_UPS[6] = {
+	glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3( 0.0f,  0.0f,  1.0f),
+	glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3( 0.0f, -1.0f,  0.0f)
+};
+
+ReflectionProbes::ReflectionProbes(int maxProbes, int size, int mipLevels, unsigned int sampleCount)
+	: maxProbes(maxProbes), size(size), probes(), valid(), probeData(maxProbes), atlas(nullptr), captureCM(nullptr), captureDepthCM(nullptr), captureFB(nullptr),
+	sampleTable(mipLevels, sampleCount, size), sampleBuffer(nullptr), probeBuffer(nullptr), skyShader(nullptr), prefilterShader(nullptr), statistics()
+{
+	for (ReflectionProbeData& data : probeData)
+	{
+		data = { glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f) };
+	}
+
+	atlas = new CubeMapArray(size, maxProbes, GL_RGBA16F, mipLevels);
+
+	// The capture keeps every mip level, read by the prefilter samples like the environment.
+	captureCM = new CubeMap(size, size, GL_RGBA16F, GL_RGBA, GL_FLOAT, true);
+	captureDepthCM = new CubeMap(size, size, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT);
+
+	captureFB = new FrameBuffer(size, size, false);
+
+	captureFB->bind();
+	captureFB->bindLayeredColorBufferToFrameBuffer(captureCM->getID(), 0);
+	captureFB->bindLayeredDepthTextureToFrameBuffer(captureDepthCM->getID());
+	captureFB->isComplete();
+	captureFB->unbind();
+
+	const std::vector<glm::vec4>& samples = sampleTable.getSamples();
+
+	sampleBuffer = new SSBO(static_cast<int>(samples.size() * sizeof(glm::vec4)), samples.data(), GL_STATIC_DRAW);
+	probeBuffer = new SSBO(static_cast<int>(probeData.size() * sizeof(ReflectionProbeData)), probeData.data());
+
+	skyShader = new ShaderProgram("sources/shaders/7_reflection_probe_sky_cs.glsl");
+	prefilterShader = new ShaderProgram("sources/shaders/7_reflection_probe_prefilter_cs.glsl");
+
+	statistics.probes = 0;
+	statistics.captured = 0;
+	statistics.invalid = 0;
+	statistics.totalCaptures = 0;
+}
+
+ReflectionProbes::~ReflectionProbes()
+{
+	delete skyShader;
+	delete prefilterShader;
+
+	delete sampleBuffer;
+	delete probeBuffer;
+
+	delete captureFB;
+	delete captureCM;
+	delete captureDepthCM;
+	delete atlas;
+}
+
+void ReflectionProbes::setProbes(const std::vector<Probe>& probes)
+{
+	if (static_cast<int>(probes.size()) > maxProbes)
+	{
+		std::cout << "[ERROR] REFLECTION PROBES: " << probes.size() << " probes, only the first " << maxProbes << " are kept." << std::endl;
+	}
+
+	this->probes.assign(probes.begin(), probes.begin() + std::min(static_cast<int>(probes.size()), maxProbes));
+
+	valid.assign(this->probes.size(), false);
+
+	for (ReflectionProbeData& data : probeData)
+	{
+		data = { glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f) };
+	}
+
+	for (int i = 0; i < static_cast<int>(this->probes.size()); ++i)
+	{
+		const Probe& probe = this->probes[i];
+
+		// Not captured yet (w = 0), skipped by the shading passes.
+		probeData[i].positionRadius = glm::vec4(probe.position, probe.radius);
+		probeData[i].boxMin = glm::vec4(probe.boxMin, 0.0f);
+		probeData[i].boxMax = glm::vec4(probe.boxMax, 0.0f);
+	}
+
+	probeBuffer->setSubData(0, static_cast<int>(probeData.size() * sizeof(ReflectionProbeData)), probeData.data());
+
+	statistics.probes = static_cast<int>(this->probes.size());
+	statistics.captured = 0;
+	statistics.invalid = statistics.probes;
+}
+
+void ReflectionProbes::invalidate()
+{
+	// The previous captures stay in use until replaced, closer to the new ones than the plain prefilter map.
+	valid.assign(probes.size(), false);
+
+	statistics.invalid = statistics.probes;
+}
+
+int ReflectionProbes::update(int maxCaptures, const glm::vec3& viewPosition, ShaderProgram* captureShader, const std::function<void()>& drawScene, CubeMap* environmentCM, int environmentSize)
+{
+	if (statistics.invalid == 0 || maxCaptures <= 0)
+	{
+		return 0;
+	}
+
+	std::vector<int> invalidProbes;
+
+	for (int i = 0; i < static_cast<int>(probes.size()); ++i)
+	{
+		if (!valid[i])
+		{
+			invalidProbes.push_back(i);
+		}
+	}
+
+	// The nearest probes are the ones reflected by what fills most of the screen.
+	std::sort(invalidProbes.begin(), invalidProbes.end(), [&](int a, int b)
+	{
+		glm::vec3 toA = probes[a].position - viewPosition, toB = probes[b].position - viewPosition;
+
+		return glm::dot(toA, toA) < glm::dot(toB, toB);
+	});
+
+	GLint targetFramebuffer;
+	GLint viewport[4];
+	GLfloat clearColor[4];
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &targetFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+	int captures = std::min(maxCaptures, static_cast<int>(invalidProbes.size()));
+
+	for (int i = 0; i < captures; ++i)
+	{
+		capture(invalidProbes[i], captureShader, drawScene, environmentCM, environmentSize);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+
+	statistics.invalid -= captures;
+	statistics.totalCaptures += captures;
+
+	return captures;
+}
+
+void ReflectionProbes::bind(int unit)
+{
+	atlas->bind(unit);
+	probeBuffer->bindBase(REFLECTION_PROBE_BUFFER_BINDING);
+}
+
+void ReflectionProbes::capture(int probe, ShaderProgram* captureShader, const std::function<void()>& drawScene, CubeMap* environmentCM, int environmentSize)
+{
+	const glm::vec3& position = probes[probe].position;
+	glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, CAPTURE_NEAR_PLANE, CAPTURE_FAR_PLANE);
+	int groups = (size + CAPTURE_GROUP_SIZE - 1) / CAPTURE_GROUP_SIZE;
+
+	// The scene, once for the six faces. Alpha stays zero where nothing is drawn.
+	captureFB->bind();
+
+	glViewport(0, 0, size, size);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	captureShader->bind();
+	captureShader->setUniform3f("uCapturePos", position);
+
+	// Taken on every capture, the program may have been reloaded since the last one.
+	Uniform<glm::mat4> viewProjectionsUniform = captureShader->getUniform<glm::mat4>("uCaptureViewProjections");
+
+	for (int face = 0; face < 6; ++face)
+	{
+		glm::mat4 view = glm::lookAt(position, position + FACE_DIRECTIONS[face], FACE_UPS[face]);
+
+		viewProjectionsUniform.set(face, projection * view);
+	}
+
+	drawScene();
+
+	captureShader->unbind();
+	captureFB->unbind();
+
+	// The environment behind, from the level whose texels match the ones of the capture.
+	skyShader->bind();
+	skyShader->setUniform1i("uEnvironmentMap", 0);
+	skyShader->setUniform1f("uEnvironmentLod", std::max(std::log2(float(environmentSize) / float(size)), 0.0f));
+
+	environmentCM->bind(0);
+	glBindImageTexture(0, captureCM->getID(), 0, GL_TRUE, 0, GL_READ_WRITE, GL_RGBA16F);
+
+	glDispatchCompute(groups, groups, 6);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+	captureCM->generateMipMaps();
+
+	// Every level of the probe in the atlas, from the mip chain of the capture.
+	prefilterShader->bind();
+	prefilterShader->setUniform1i("uCaptureMap", 0);
+	prefilterShader->setUniform1i("uProbe", probe);
+
+	captureCM->bind(0);
+	sampleBuffer->bindBase(PREFILTER_SAMPLE_BUFFER_BINDING);
+
+	for (int mip = 0; mip < sampleTable.getNumberOfLevels(); ++mip)
+	{
+		const GGXSampleTable::Level& level = sampleTable.getLevel(mip);
+		int mipGroups = (std::max(size >> mip, 1) + CAPTURE_GROUP_SIZE - 1) / CAPTURE_GROUP_SIZE;
+
+		prefilterShader->setUniform1i("uFirstSample", level.firstSample);
+		prefilterShader->setUniform1i("uSampleCount", level.sampleCount);
+		prefilterShader->setUniform1f("uInverseTotalWeight", level.inverseTotalWeight);
+
+		glBindImageTexture(0, atlas->getID(), mip, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+		glDispatchCompute(mipGroups, mipGroups, 6);
+	}
+
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+	captureCM->unbind();
+	prefilterShader->unbind();
+
+	if (!probeData[probe].boxMin.w)
+	{
+		probeData[probe].boxMin.w = 1.0f;
+
+		uploadProbe(probe);
+
+		statistics.captured++;
+	}
+
+	valid[probe] = true;
+}
+
+void ReflectionProbes::uploadProbe(int probe)
+{
+	probeBuffer->setSubData(probe * sizeof(ReflectionProbeData), sizeof(ReflectionProbeData), &probeData[probe]);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "ssbo.h"
+#include "shader.h"
+#include "cubemap.h"
+#include "cubemaparray.h"
+#include "framebuffer.h"
+#include "uniformblocks.h"
+#include "ggxsampletable.h"
+
+// Local reflection probes, prefiltered into the cubemaps of a single cubemap array (the atlas), one per probe.
+//
+// A probe is captured in a single layered pass: the scene is drawn once with a geometry shader emitting every triangle
+// to the faces of the capture cubemap it reaches ("gl_Layer"), then "7_reflection_probe_sky_cs.glsl" fills what the
+// scene left uncovered with the environment, and "7_reflection_probe_prefilter_cs.glsl" convolves it into the mip
+// levels of the probe in the atlas, through GGX samples generated for the capture size.
+//
+// Probes start invalid and are invalidated again when what they see changes. "update" only recaptures a few of them
+// per frame, the nearest to the camera first, and the shading passes skip the probes not captured yet. The probes
+// and their parallax boxes are read by "reflection_probes.glsl" from a storage buffer.
+//
+class ReflectionProbes
+{
+public:
+	struct Probe
+	{
+		glm::vec3 position; // Where it's captured from.
+		float radius;       // Of influence, its weight fading to zero there.
+		glm::vec3 boxMin;   // Parallax box, the volume the reflections are projected onto.
+		glm::vec3 boxMax;
+	};
+
+	struct Statistics
+	{
+		int probes;
+		int captured;       // Holding a capture, possibly invalidated since.
+		int invalid;        // Left to capture.
+		int totalCaptures;  // Since the creation.
+	};
+
+	// "size" and "mipLevels" of every prefiltered probe, "sampleCount" being the most GGX samples per texel.
+	ReflectionProbes(int maxProbes, int size, int mipLevels, unsigned int sampleCount);
+	~ReflectionProbes();
+
+	ReflectionProbes(const ReflectionProbes&) = delete;
+	ReflectionProbes& operator=(const ReflectionProbes&) = delete;
+
+	// Replaces the probes, none of them captured. The ones beyond "maxProbes" are dropped.
+	void setProbes(const std::vector<Probe>& probes);
+
+	// Every probe is captured again, what they see having changed (environment, lights, shaders).
+	void invalidate();
+
+	// Captures and prefilters at most "maxCaptures" invalid probes, the nearest to "viewPosition" first. "drawScene" draws
+	// the scene with "captureShader" bound (and its uniforms set), the textures it samples being bound by the caller.
+	// Returns the number of probes captured.
+	int update(int maxCaptures, const glm::vec3& viewPosition, ShaderProgram* captureShader, const std::function<void()>& drawScene, CubeMap* environmentCM, int environmentSize);
+
+	// The atlas on "unit" and the probes on their storage block, for the shading passes.
+	void bind(int unit);
+
+	const std::vector<Probe>& getProbes() { return probes; }
+	const Statistics& getStatistics() { return statistics; }
+
+	ShaderProgram* getSkyShader() { return skyShader; }
+	ShaderProgram* getPrefilterShader() { return prefilterShader; }
+
+private:
+	static constexpr float CAPTURE_NEAR_PLANE = 0.05f;
+	static constexpr float CAPTURE_FAR_PLANE = 100.0f;
+	static constexpr int CAPTURE_GROUP_SIZE = 8; // Work group size of the compute shaders.
+
+	int maxProbes;
+	int size;
+
+	std::vector<Probe> probes;
+	std::vector<bool> valid;
+	std::vector<ReflectionProbeData> probeData; // As uploaded, "maxProbes" long, the ones after the probes never captured.
+
+	CubeMapArray* atlas;
+	CubeMap* captureCM;
+	CubeMap* captureDepthCM;
+	FrameBuffer* captureFB;
+
+	GGXSampleTable sampleTable;
+	SSBO* sampleBuffer;
+	SSBO* probeBuffer;
+
+	ShaderProgram* skyShader;
+	ShaderProgram* prefilterShader;
+
+	Statistics statistics;
+
+	void capture(int probe, ShaderProgram* captureShader, const std::function<void()>& drawScene, CubeMap* environmentCM, int environmentSize);
+	void uploadProbe(int probe);
+};
@@ -1,66 +1,53 @@
 #include "shader.h"
 
-ShaderProgram::ShaderProgram(const char* vsFilepath, const char* fsFilepath) : ID()
-{
-	int success;
-	char infoLog[512];
-
-	unsigned int vsID = createShader(vsFilepath, GL_VERTEX_SHADER);
-	unsigned int fsID = createShader(fsFilepath, GL_FRAGMENT_SHADER);
-
-	ID = glCreateProgram();
-
-	glAttachShader(ID, vsID);
-	glAttachShader(ID, fsID);
-
-	glLinkProgram(ID);
-
-	glGetProgramiv(ID, GL_LINK_STATUS, &success);
-
-	if (!success)
-	{
-		glGetProgramInfoLog(ID, 512, NULL, infoLog);
-
-		std::cout << "[ERROR] SHADER PROGRAM: Linkage failed!\n" << infoLog << std::endl;
-	}
+ShaderProgram::UniformStatistics ShaderProgram::uniformStatistics = { 0, 0 };
+ShaderProgram::BuildStatistics ShaderProgram::buildStatistics = { 0, 0, 0.0, 0.0, 0.0 };
+std::filesystem::path ShaderProgram::binaryCacheDirectory;
+std::vector<ShaderProgram*> ShaderProgram::pendingPrograms;
+PFNMAXSHADERCOMPILERTHREADSPROC ShaderProgram::maxShaderCompilerThreads = nullptr;
 
-	glDeleteShader(vsID);
-	glDeleteShader(fsID);
+ShaderProgram::ShaderProgram(const char* vsFilepath, const char* fsFilepath, const Defines& defines) : ID(), buildState(BuildState::PREPROCESSING), key(), fromBinary(false), linked(false)
+{
+	build({ { vsFilepath, GL_VERTEX_SHADER }, { fsFilepath, GL_FRAGMENT_SHADER } }, defines);
 }
 
-ShaderProgram::ShaderProgram(const char* vsFilepath, const char* gsFilepath, const char* fsFileapth) : ID()
+ShaderProgram::ShaderProgram(const char* vsFilepath, const char* gsFilepath, const char* fsFilepath, const Defines& defines) : ID(), buildState(BuildState::PREPROCESSING), key(), fromBinary(false), linked(false)
 {
-	int success;
-	char infoLog[512];
-
-	unsigned int vsID = createShader(vsFilepath, GL_VERTEX_SHADER);
-	unsigned int gsID = createShader(gsFilepath, GL_GEOMETRY_SHADER);
-	unsigned int fsID = createShader(fsFileapth, GL_FRAGMENT_SHADER);
-
-	ID = glCreateProgram();
+	build({ { vsFilepath, GL_VERTEX_SHADER }, { gsFilepath, GL_GEOMETRY_SHADER }, { fsFilepath, GL_FRAGMENT_SHADER } }, defines);
+}
 
-	glAttachShader(ID, vsID);
-	glAttachShader(ID, gsID);
-	glAttachShader(ID, fsID);
+ShaderProgram::ShaderProgram(const char* csFilepath, const Defines& defines) : ID(), buildState(BuildState::PREPROCESSING), key(), fromBinary(false), linked(false)
+{
+	build({ { csFilepath, GL_COMPUTE_SHADER } }, defines);
+}
 
-	glLinkProgram(ID);
+ShaderProgram::ShaderProgram(const std::vector<Stage>& stages, const Defines& defines) : ID(), buildState(BuildState::PREPROCESSING), key(), fromBinary(false), linked(false)
+{
+	build(stages, defines);
+}
 
-	glGetProgramiv(ID, GL_LINK_STATUS, &success);
+ShaderProgram::~ShaderProgram()
+{
+	pendingPrograms.erase(std::remove(pendingPrograms.begin(), pendingPrograms.end(), this), pendingPrograms.end());
 
-	if (!success)
+	// Waits for the preprocessing job, which doesn't reference the program but shouldn't outlive the future either.
+	if (preprocessedStages.valid())
 	{
-		glGetProgramInfoLog(ID, 512, NULL, infoLog);
+		preprocessedStages.wait();
+	}
 
-		std::cout << "[ERROR] SHADER PROGRAM: Linkage failed!\n" << infoLog << std::endl;
+	for (unsigned int shaderID : shaderIDs)
+	{
+		glDeleteShader(shaderID);
 	}
 
-	glDeleteShader(vsID);
-	glDeleteShader(gsID);
-	glDeleteShader(fsID);
+	glDeleteProgram(ID);
 }
 
 void ShaderProgram::bind()
 {
+	finish();
+
 	glUseProgram(ID);
 }
 
@@ -71,11 +58,11 @@ void ShaderProgram::unbind()
 
 void ShaderProgram::setUniform1i(const char* uniformName, int data)
 {
-	int uniformLocation = glGetUniformLocation(ID, uniformName);
+	int uniformLocation = getUniformLocation(uniformName);
 
 	if (uniformLocation > -1)
 	{
-		glUniform1i(uniformLocation, data);
+		setUniform(uniformLocation, data);
 	}
 	else
 	{
@@ -85,11 +72,11 @@ void ShaderProgram::setUniform1i(const char* uniformName, int data)
 
 void ShaderProgram::setUniform1f(const char* uniformName, float data)
 {
-	int uniformLocation = glGetUniformLocation(ID, uniformName);
+	int uniformLocation = getUniformLocation(uniformName);
 
 	if (uniformLocation > -1)
 	{
-		glUniform1f(uniformLocation, data);
+		setUniform(uniformLocation, data);
 	}
 	else
 	{
@@ -99,11 +86,16 @@ void ShaderProgram::setUniform1f(const char* uniformName, float data)
 
 void ShaderProgram::setUniform3f(const char* uniformName, float x, float y, float z)
 {
-	int uniformLocation = glGetUniformLocation(ID, uniformName);
+	setUniform3f(uniformName, glm::vec3(x, y, z));
+}
+
+void ShaderProgram::setUniform3f(const char* uniformName, const glm::vec3& data)
+{
+	int uniformLocation = getUniformLocation(uniformName);
 
 	if (uniformLocation > -1)
 	{
-		glUniform3f(uniformLocation, x, y, z);
+		setUniform(uniformLocation, data);
 	}
 	else
 	{
@@ -111,13 +103,13 @@ void ShaderProgram::setUniform3f(const char* uniformName, float x, float y, floa
 	}
 }
 
-void ShaderProgram::setUniform3f(const char* uniformName, const glm::vec3& data)
+void ShaderProgram::setUniform3i(const char* uniformName, const glm::ivec3& data)
 {
-	int uniformLocation = glGetUniformLocation(ID, uniformName);
+	int uniformLocation = getUniformLocation(uniformName);
 
 	if (uniformLocation > -1)
 	{
-		glUniform3f(uniformLocation, data.x, data.y, data.z);
+		setUniform(uniformLocation, data);
 	}
 	else
 	{
@@ -127,11 +119,11 @@ void ShaderProgram::setUniform3f(const char* uniformName, const glm::vec3& data)
 
 void ShaderProgram::setUniform4f(const char* uniformName, const glm::vec4& data)
 {
-	int uniformLocation = glGetUniformLocation(ID, uniformName);
+	int uniformLocation = getUniformLocation(uniformName);
 
 	if (uniformLocation > -1)
 	{
-		glUniform4f(uniformLocation, data.x, data.y, data.z, data.w);
+		setUniform(uniformLocation, data);
 	}
 	else
 	{
@@ -141,11 +133,11 @@ void ShaderProgram::setUniform4f(const char* uniformName, const glm::vec4& data)
 
 void ShaderProgram::setUniformMatrix3fv(const char* uniformName, const glm::mat3& data)
 {
-	int uniformLocation = glGetUniformLocation(ID, uniformName);
+	int uniformLocation = getUniformLocation(uniformName);
 
 	if (uniformLocation > -1)
 	{
-		glUniformMatrix3fv(uniformLocation, 1, GL_FALSE, glm::value_ptr(data));
+		setUniform(uniformLocation, data);
 	}
 	else
 	{
@@ -155,11 +147,11 @@ void ShaderProgram::setUniformMatrix3fv(const char* uniformName, const glm::mat3
 
 void ShaderProgram::setUniformMatrix4fv(const char* uniformName, const glm::mat4& data)
 {
-	int uniformLocation = glGetUniformLocation(ID, uniformName);
+	int uniformLocation = getUniformLocation(uniformName);
 
 	if (uniformLocation > -1)
 	{
-		glUniformMatrix4fv(uniformLocation, 1, GL_FALSE, glm::value_ptr(data));
+		setUniform(uniformLocation, data);
 	}
 	else
 	{
@@ -167,20 +159,517 @@ void ShaderProgram::setUniformMatrix4fv(const char* uniformName, const glm::mat4
 	}
 }
 
-unsigned int ShaderProgram::createShader(const char* filepath, int shaderType)
+// The "glProgramUniform*" variants don't depend on the bound program, so handles stay valid whatever is bound.
+
+void ShaderProgram::setUniform(int location, int data)
+{
+	if (updateUniformShadow(location, &data, sizeof(data)))
+	{
+		glProgramUniform1i(ID, location, data);
+	}
+}
+
+void ShaderProgram::setUniform(int location, float data)
+{
+	if (updateUniformShadow(location, &data, sizeof(data)))
+	{
+		glProgramUniform1f(ID, location, data);
+	}
+}
+
+void ShaderProgram::setUniform(int location, const glm::vec3& data)
+{
+	if (updateUniformShadow(location, glm::value_ptr(data), sizeof(data)))
+	{
+		glProgramUniform3f(ID, location, data.x, data.y, data.z);
+	}
+}
+
+void ShaderProgram::setUniform(int location, const glm::ivec3& data)
+{
+	if (updateUniformShadow(location, glm::value_ptr(data), sizeof(data)))
+	{
+		glProgramUniform3i(ID, location, data.x, data.y, data.z);
+	}
+}
+
+void ShaderProgram::setUniform(int location, const glm::vec4& data)
+{
+	if (updateUniformShadow(location, glm::value_ptr(data), sizeof(data)))
+	{
+		glProgramUniform4f(ID, location, data.x, data.y, data.z, data.w);
+	}
+}
+
+void ShaderProgram::setUniform(int location, const glm::mat3& data)
+{
+	if (updateUniformShadow(location, glm::value_ptr(data), sizeof(data)))
+	{
+		glProgramUniformMatrix3fv(ID, location, 1, GL_FALSE, glm::value_ptr(data));
+	}
+}
+
+void ShaderProgram::setUniform(int location, const glm::mat4& data)
+{
+	if (updateUniformShadow(location, glm::value_ptr(data), sizeof(data)))
+	{
+		glProgramUniformMatrix4fv(ID, location, 1, GL_FALSE, glm::value_ptr(data));
+	}
+}
+
+bool ShaderProgram::isReady()
+{
+	if (buildState == BuildState::READY)
+	{
+		return true;
+	}
+
+	if (buildState == BuildState::PREPROCESSING)
+	{
+		if (preprocessedStages.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return false;
+		}
+
+		submit();
+	}
+
+	int completed = GL_TRUE;
+
+	if (maxShaderCompilerThreads)
+	{
+		glGetProgramiv(ID, COMPLETION_STATUS, &completed);
+	}
+
+	if (completed)
+	{
+		finish();
+	}
+
+	return completed == GL_TRUE;
+}
+
+bool ShaderProgram::dependsOn(const std::string& filepath)
+{
+	std::string normalizedFilepath = std::filesystem::path(filepath).lexically_normal().generic_string();
+
+	for (const Stage& stage : stages)
+	{
+		if (std::filesystem::path(stage.filepath).lexically_normal().generic_string() == normalizedFilepath)
+		{
+			return true;
+		}
+	}
+
+	// Includes, only known once the program has been preprocessed.
+	for (const std::vector<std::string>& stageFilepaths : sourceFilepaths)
+	{
+		if (std::find(stageFilepaths.begin(), stageFilepaths.end(), normalizedFilepath) != stageFilepaths.end())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ShaderProgram::reload()
+{
+	reloadedProgram.reset(new ShaderProgram(stages, defines));
+}
+
+bool ShaderProgram::updateReload()
+{
+	if (!reloadedProgram || !reloadedProgram->isReady())
+	{
+		return false;
+	}
+
+	std::unique_ptr<ShaderProgram> program = std::move(reloadedProgram);
+
+	if (!program->linked)
+	{
+		std::cout << "[ERROR] SHADER PROGRAM: Reload of \"" << stages.back().filepath << "\" failed, keeping the previous program." << std::endl;
+
+		return false;
+	}
+
+	finish();
+
+	program->copyUniforms(*this);
+
+	// The previous program is deleted along with "program".
+	std::swap(ID, program->ID);
+	std::swap(sourceFilepaths, program->sourceFilepaths);
+	std::swap(uniformLocations, program->uniformLocations);
+	std::swap(uniformShadows, program->uniformShadows);
+
+	std::cout << "[INFO] SHADER PROGRAM: Reloaded \"" << stages.back().filepath << "\"." << std::endl;
+
+	return true;
+}
+
+int ShaderProgram::getUniformLocation(const char* uniformName)
+{
+	finish();
+
+	auto iterator = uniformLocations.find(uniformName);
+
+	return iterator != uniformLocations.end() ? iterator->second : -1;
+}
+
+ShaderProgram::UniformStatistics ShaderProgram::getUniformStatistics()
+{
+	return uniformStatistics;
+}
+
+void ShaderProgram::resetUniformStatistics()
+{
+	uniformStatistics = { 0, 0 };
+}
+
+ShaderProgram::BuildStatistics ShaderProgram::getBuildStatistics()
+{
+	return buildStatistics;
+}
+
+void ShaderProgram::setBinaryCacheDirectory(const std::string& directory)
+{
+	binaryCacheDirectory = directory;
+}
+
+bool ShaderProgram::enableParallelCompile(GLADloadproc getProcAddress)
+{
+	int numberOfExtensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &numberOfExtensions);
+
+	const char* functionName = nullptr;
+
+	for (int i = 0; i < numberOfExtensions && !functionName; ++i)
+	{
+		const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+
+		if (std::strcmp(extension, "GL_KHR_parallel_shader_compile") == 0)
+		{
+			functionName = "glMaxShaderCompilerThreadsKHR";
+		}
+		else if (std::strcmp(extension, "GL_ARB_parallel_shader_compile") == 0)
+		{
+			functionName = "glMaxShaderCompilerThreadsARB";
+		}
+	}
+
+	maxShaderCompilerThreads = functionName ? reinterpret_cast<PFNMAXSHADERCOMPILERTHREADSPROC>(getProcAddress(functionName)) : nullptr;
+
+	if (!maxShaderCompilerThreads)
+	{
+		std::cout << "[INFO] SHADER PROGRAM: Parallel shader compilation not supported, programs are built one at a time." << std::endl;
+
+		return false;
+	}
+
+	// 0xFFFFFFFF lets the driver pick the number of threads.
+	maxShaderCompilerThreads(0xFFFFFFFF);
+
+	int numberOfThreads = 0;
+	glGetIntegerv(MAX_SHADER_COMPILER_THREADS, &numberOfThreads);
+
+	std::cout << "[INFO] SHADER PROGRAM: Parallel shader compilation enabled (" << (numberOfThreads == -1 ? std::string("driver defined") : std::to_string(numberOfThreads))
+		<< " compiler threads)." << std::endl;
+
+	return true;
+}
+
+void ShaderProgram::submitPending()
+{
+	// Copied, "submit" removing the program from the list.
+	std::vector<ShaderProgram*> programs = pendingPrograms;
+
+	for (ShaderProgram* program : programs)
+	{
+		program->submit();
+	}
+}
+
+void ShaderProgram::build(const std::vector<Stage>& stages, const Defines& defines)
+{
+	this->stages = stages;
+	this->defines = defines;
+
+	ID = glCreateProgram();
+
+	// Only reads files, the GL calls are left to "submit" on the thread owning the context.
+	auto promise = std::make_shared<std::promise<PreprocessedStages>>();
+
+	preprocessedStages = promise->get_future();
+
+	ThreadPool::getInstance().submit([promise, stages, defines]()
+	{
+		PROFILE_CPU("Preprocess shader");
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		PreprocessedStages result;
+
+		result.sourceFilepaths.resize(stages.size());
+
+		for (size_t i = 0; i < stages.size(); ++i)
+		{
+			result.sources.push_back(preprocess(stages[i].filepath, defines, result.sourceFilepaths[i]));
+		}
+
+		result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		promise->set_value(std::move(result));
+	});
+
+	pendingPrograms.push_back(this);
+}
+
+void ShaderProgram::submit()
+{
+	if (buildState != BuildState::PREPROCESSING)
+	{
+		return;
+	}
+
+	PROFILE_CPU("Submit shader");
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	PreprocessedStages result = preprocessedStages.get();
+
+	auto preprocessed = std::chrono::high_resolution_clock::now();
+
+	sources = std::move(result.sources);
+	sourceFilepaths = std::move(result.sourceFilepaths);
+
+	// 64-bit FNV-1a over every preprocessed stage and the driver, whose binaries are only valid for itself.
+	key = 14695981039346656037ull;
+
+	for (size_t i = 0; i < stages.size(); ++i)
+	{
+		key = hashBytes(&stages[i].shaderType, sizeof(stages[i].shaderType), key);
+		key = hashBytes(sources[i].data(), sources[i].size(), key);
+	}
+
+	for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+	{
+		const char* driverString = reinterpret_cast<const char*>(glGetString(name));
+
+		key = driverString ? hashBytes(driverString, std::strlen(driverString), key) : key;
+	}
+
+	fromBinary = loadBinary();
+
+	if (!fromBinary)
+	{
+		compileAndLink();
+	}
+
+	buildState = BuildState::SUBMITTED;
+
+	pendingPrograms.erase(std::remove(pendingPrograms.begin(), pendingPrograms.end(), this), pendingPrograms.end());
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	buildStatistics.preprocessMilliseconds += result.milliseconds;
+	buildStatistics.waitMilliseconds += std::chrono::duration<double, std::milli>(preprocessed - start).count();
+	buildStatistics.submitMilliseconds += std::chrono::duration<double, std::milli>(end - preprocessed).count();
+}
+
+void ShaderProgram::finish()
 {
+	if (buildState == BuildState::READY)
+	{
+		return;
+	}
+
+	// Submits the others too, so they compile while this one is waited for.
+	submitPending();
+
+	PROFILE_CPU("Wait for shader");
+
+	auto start = std::chrono::high_resolution_clock::now();
+
 	int success;
 	char infoLog[512];
 
-	std::ifstream fileStream(filepath);
-	std::stringstream stringStream; stringStream << fileStream.rdbuf();
-	std::string shaderSource = stringStream.str();
+	// Blocks until the driver is done with the program.
+	glGetProgramiv(ID, GL_LINK_STATUS, &success);
+
+	// A driver update may reject binaries it produced before, the program is then compiled again.
+	if (!success && fromBinary)
+	{
+		fromBinary = false;
+
+		compileAndLink();
+
+		glGetProgramiv(ID, GL_LINK_STATUS, &success);
+	}
+
+	for (size_t i = 0; i < shaderIDs.size(); ++i)
+	{
+		logShaderErrors(shaderIDs[i], sourceFilepaths[i]);
+
+		glDetachShader(ID, shaderIDs[i]);
+		glDeleteShader(shaderIDs[i]);
+	}
+
+	shaderIDs.clear();
+
+	if (!success)
+	{
+		glGetProgramInfoLog(ID, 512, NULL, infoLog);
+
+		std::cout << "[ERROR] SHADER PROGRAM: Linkage failed!\n" << infoLog << std::endl;
+	}
+	else if (!fromBinary)
+	{
+		saveBinary();
+	}
 
-	const char* shaderCode = shaderSource.c_str();
+	if (fromBinary)
+	{
+		buildStatistics.cachedPrograms++;
+	}
+	else
+	{
+		buildStatistics.compiledPrograms++;
+	}
+
+	sources.clear();
+
+	linked = success == GL_TRUE;
+
+	introspectUniforms();
+
+	buildState = BuildState::READY;
+
+	buildStatistics.waitMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void ShaderProgram::compileAndLink()
+{
+	for (size_t i = 0; i < stages.size(); ++i)
+	{
+		shaderIDs.push_back(createShader(sources[i], stages[i].shaderType));
+
+		glAttachShader(ID, shaderIDs.back());
+	}
+
+	if (!binaryCacheDirectory.empty())
+	{
+		glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	// Neither call waits for the driver, the statuses are only queried by "finish".
+	glLinkProgram(ID);
+}
+
+bool ShaderProgram::loadBinary()
+{
+	if (binaryCacheDirectory.empty())
+	{
+		return false;
+	}
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+
+	std::ifstream fileStream(binaryCacheDirectory / name, std::ios::binary);
+
+	if (!fileStream)
+	{
+		return false; // Cache miss, nothing to report.
+	}
+
+	BinaryHeader header;
+
+	fileStream.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader));
+
+	if (!fileStream || std::memcmp(header.magic, "PRGB", 4) != 0 || header.version != BINARY_VERSION || header.key != key)
+	{
+		std::cout << "[ERROR] SHADER PROGRAM: Invalid program binary \"" << (binaryCacheDirectory / name).string() << "\"." << std::endl;
+
+		return false;
+	}
+
+	std::vector<char> binary(header.size);
+
+	fileStream.read(binary.data(), binary.size());
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] SHADER PROGRAM: Truncated program binary \"" << (binaryCacheDirectory / name).string() << "\"." << std::endl;
+
+		return false;
+	}
+
+	// The link status is checked by "finish", falling back to the sources.
+	glProgramBinary(ID, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+	return true;
+}
+
+void ShaderProgram::saveBinary()
+{
+	int numberOfFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numberOfFormats);
+
+	if (binaryCacheDirectory.empty() || numberOfFormats == 0)
+	{
+		return;
+	}
+
+	int length = 0;
+	glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+
+	std::vector<char> binary(std::max(length, 0));
+	GLenum format = 0;
+
+	glGetProgramBinary(ID, length, &length, &format, binary.data());
+
+	if (length <= 0)
+	{
+		return;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(binaryCacheDirectory, error);
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+
+	std::ofstream fileStream(binaryCacheDirectory / name, std::ios::binary | std::ios::trunc);
+
+	BinaryHeader header = { { 'P', 'R', 'G', 'B' }, BINARY_VERSION, key, format, static_cast<uint32_t>(length) };
+
+	fileStream.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+	fileStream.write(binary.data(), length);
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] SHADER PROGRAM: Failed to write program binary \"" << (binaryCacheDirectory / name).string() << "\"." << std::endl;
+	}
+}
+
+unsigned int ShaderProgram::createShader(const std::string& source, int shaderType)
+{
+	const char* shaderCode = source.c_str();
 	unsigned int shaderID = glCreateShader(shaderType);
 
 	glShaderSource(shaderID, 1, &shaderCode, NULL);
 	glCompileShader(shaderID);
+
+	return shaderID;
+}
+
+void ShaderProgram::logShaderErrors(unsigned int shaderID, const std::vector<std::string>& sourceFilepaths)
+{
+	int success;
+	char infoLog[512];
+
 	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
 
 	if (!success)
@@ -189,10 +678,226 @@ unsigned int ShaderProgram::createShader(const char* filepath, int shaderType)
 
 		std::cout << "[ERROR] SHADER PROGRAM: Compilation failed!\n" << infoLog << std::endl;
 
-		glDeleteShader(shaderID);
+		// Errors are reported as "<file index>(<line>)".
+		for (size_t i = 0; i < sourceFilepaths.size(); ++i)
+		{
+			std::cout << "    " << i << ": \"" << sourceFilepaths[i] << "\"" << std::endl;
+		}
+	}
+}
+
+std::string ShaderProgram::preprocess(const std::string& filepath, const Defines& defines, std::vector<std::string>& sourceFilepaths)
+{
+	std::ifstream fileStream(filepath);
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] SHADER PROGRAM: Failed to open shader source \"" << filepath << "\"." << std::endl;
 
-		return -1;
+		return "";
 	}
 
-	return shaderID;
+	int fileIndex = static_cast<int>(sourceFilepaths.size());
+	sourceFilepaths.push_back(filepath);
+
+	std::stringstream output;
+	std::string line;
+
+	for (int lineNumber = 1; std::getline(fileStream, line); ++lineNumber)
+	{
+		size_t first = line.find_first_not_of(" \t");
+		std::string directive = first == std::string::npos ? "" : line.substr(first);
+
+		if (directive.compare(0, 8, "#version") == 0)
+		{
+			output << line << "\n";
+
+			for (const std::string& define : defines)
+			{
+				output << "#define " << define << "\n";
+			}
+
+			output << "#line " << lineNumber + 1 << " " << fileIndex << "\n";
+		}
+		else if (directive.compare(0, 8, "#include") == 0)
+		{
+			size_t open = directive.find('"'), close = directive.rfind('"');
+
+			if (open == std::string::npos || close <= open)
+			{
+				std::cout << "[ERROR] SHADER PROGRAM: Malformed include in \"" << filepath << "\" at line " << lineNumber << "." << std::endl;
+
+				continue;
+			}
+
+			std::filesystem::path includePath = std::filesystem::path(filepath).parent_path() / directive.substr(open + 1, close - open - 1);
+			std::string includeFilepath = includePath.lexically_normal().generic_string();
+
+			// Included once per stage, which also breaks include cycles.
+			if (std::find(sourceFilepaths.begin(), sourceFilepaths.end(), includeFilepath) == sourceFilepaths.end())
+			{
+				output << "#line 1 " << sourceFilepaths.size() << "\n";
+				output << preprocess(includeFilepath, {}, sourceFilepaths);
+				output << "#line " << lineNumber + 1 << " " << fileIndex << "\n";
+			}
+		}
+		else
+		{
+			output << line << "\n";
+		}
+	}
+
+	return output.str();
+}
+
+uint64_t ShaderProgram::hashBytes(const void* data, size_t size, uint64_t hash)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+void ShaderProgram::introspectUniforms()
+{
+	int numberOfUniforms = 0;
+	int maxNameLength = 0;
+
+	glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &numberOfUniforms);
+	glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+	std::vector<char> nameBuffer(std::max(maxNameLength, 1));
+	const GLenum properties[] = { GL_LOCATION, GL_ARRAY_SIZE };
+	int maxLocation = -1;
+
+	uniformLocations.clear();
+
+	for (int i = 0; i < numberOfUniforms; ++i)
+	{
+		int values[2];
+
+		glGetProgramResourceiv(ID, GL_UNIFORM, i, 2, properties, 2, nullptr, values);
+
+		int location = values[0], arraySize = values[1];
+
+		if (location < 0)
+		{
+			continue; // Member of a uniform block, not set through locations.
+		}
+
+		glGetProgramResourceName(ID, GL_UNIFORM, i, maxNameLength, nullptr, nameBuffer.data());
+
+		std::string name = nameBuffer.data();
+
+		// Arrays are reported as "name[0]", register every element and the bare name.
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+		{
+			std::string baseName = name.substr(0, name.size() - 3);
+
+			uniformLocations[baseName] = location;
+
+			for (int element = 0; element < arraySize; ++element)
+			{
+				uniformLocations[baseName + "[" + std::to_string(element) + "]"] = location + element;
+			}
+		}
+		else
+		{
+			uniformLocations[name] = location;
+		}
+
+		maxLocation = std::max(maxLocation, location + arraySize - 1);
+	}
+
+	uniformShadows.assign(maxLocation + 1, UniformShadow());
+}
+
+void ShaderProgram::copyUniforms(ShaderProgram& source)
+{
+	int numberOfUniforms = 0;
+	int maxNameLength = 0;
+
+	glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &numberOfUniforms);
+	glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+	std::vector<char> nameBuffer(std::max(maxNameLength, 1));
+	const GLenum properties[] = { GL_LOCATION, GL_ARRAY_SIZE, GL_TYPE };
+
+	for (int i = 0; i < numberOfUniforms; ++i)
+	{
+		int values[3];
+
+		glGetProgramResourceiv(ID, GL_UNIFORM, i, 3, properties, 3, nullptr, values);
+
+		int location = values[0], arraySize = values[1];
+		GLenum type = static_cast<GLenum>(values[2]);
+
+		if (location < 0)
+		{
+			continue;
+		}
+
+		glGetProgramResourceName(ID, GL_UNIFORM, i, maxNameLength, nullptr, nameBuffer.data());
+
+		std::string name = nameBuffer.data();
+
+		if (arraySize > 1 && name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+		{
+			name = name.substr(0, name.size() - 3);
+		}
+
+		for (int element = 0; element < arraySize; ++element)
+		{
+			int sourceLocation = source.getUniformLocation(arraySize > 1 ? (name + "[" + std::to_string(element) + "]").c_str() : name.c_str());
+
+			if (sourceLocation < 0)
+			{
+				continue; // New uniform, left to its default value.
+			}
+
+			float floats[16];
+			int integers[4];
+
+			switch (type)
+			{
+			case GL_FLOAT:      glGetUniformfv(source.ID, sourceLocation, floats); glProgramUniform1fv(ID, location + element, 1, floats); break;
+			case GL_FLOAT_VEC2: glGetUniformfv(source.ID, sourceLocation, floats); glProgramUniform2fv(ID, location + element, 1, floats); break;
+			case GL_FLOAT_VEC3: glGetUniformfv(source.ID, sourceLocation, floats); glProgramUniform3fv(ID, location + element, 1, floats); break;
+			case GL_FLOAT_VEC4: glGetUniformfv(source.ID, sourceLocation, floats); glProgramUniform4fv(ID, location + element, 1, floats); break;
+			case GL_FLOAT_MAT3: glGetUniformfv(source.ID, sourceLocation, floats); glProgramUniformMatrix3fv(ID, location + element, 1, GL_FALSE, floats); break;
+			case GL_FLOAT_MAT4: glGetUniformfv(source.ID, sourceLocation, floats); glProgramUniformMatrix4fv(ID, location + element, 1, GL_FALSE, floats); break;
+			case GL_INT_VEC3:   glGetUniformiv(source.ID, sourceLocation, integers); glProgramUniform3iv(ID, location + element, 1, integers); break;
+
+			// Integers, booleans and samplers, the only other types used by the shaders.
+			default: glGetUniformiv(source.ID, sourceLocation, integers); glProgramUniform1iv(ID, location + element, 1, integers); break;
+			}
+		}
+	}
+}
+
+bool ShaderProgram::updateUniformShadow(int location, const void* data, size_t size)
+{
+	if (location >= 0 && location < static_cast<int>(uniformShadows.size()))
+	{
+		UniformShadow& shadow = uniformShadows[location];
+
+		if (shadow.valid && std::memcmp(shadow.data, data, size) == 0)
+		{
+			uniformStatistics.skippedCalls++;
+
+			return false;
+		}
+
+		shadow.valid = true;
+		std::memcpy(shadow.data, data, size);
+	}
+
+	uniformStatistics.issuedCalls++;
+
+	return true;
 }
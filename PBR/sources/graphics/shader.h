@@ -1,8 +1,19 @@
 #pragma once
 
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <future>
+#include <memory>
+#include <filesystem>
+#include <unordered_map>
 
 #include <glad/glad.h>
 
@@ -10,25 +21,250 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "../utils/threadpool.h"
+#include "../utils/profiler.h"
+
+class ShaderProgram;
+
+// "glMaxShaderCompilerThreadsKHR/ARB", not loaded by glad. GL entry points are "__stdcall" on 32 bits Windows.
+typedef void (APIENTRY* PFNMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+
+// Pre-resolved uniform location of a program, typed by the value it accepts. The handle of an array is the one of
+// its first element, the others following at consecutive locations.
+//
+template<typename T>
+class Uniform
+{
+public:
+	Uniform() : program(nullptr), location(-1) {}
+	Uniform(ShaderProgram* program, int location) : program(program), location(location) {}
+
+	void set(const T& data);
+	void set(int element, const T& data);
+
+	int getLocation() { return location; }
+
+private:
+	ShaderProgram* program;
+	int location;
+};
+
+// Program built from GLSL files, optionally specialized by a set of "#define".
+//
+// Sources are preprocessed before compilation: "#include "file"" lines are replaced by the file (relative to the
+// including one, each file included once per stage, errors reported as "<file index>(<line>)"), and the defines
+// are inserted after the "#version" line, so every permutation compiles only the paths it uses.
+//
+// With a binary cache directory, linked programs are saved with "glGetProgramBinary", keyed by a hash of the
+// preprocessed sources and the driver strings, and later runs load them with "glProgramBinary" instead of compiling.
+//
+// Builds are deferred: the constructor only queues the file loading and preprocessing on the thread pool, then
+// "submitPending" hands the compilation and linkage of every program to the driver without waiting for any of them.
+// With "KHR_parallel_shader_compile" the driver compiles them concurrently and "isReady" polls them; the first use
+// of a program (binding it, looking up a uniform) blocks until that program alone is linked.
+//
+// "reload" rebuilds the program from its files the same way, in the background, and "updateReload" swaps it in once
+// linked, carrying the uniform values over. The uniform locations may change, "Uniform" handles must be taken again.
+//
 class ShaderProgram
 {
 public:
-	ShaderProgram(const char* vsFilepath, const char* fsFilepath);
-	ShaderProgram(const char* vsFilepath, const char* gsFilepath, const char* fsFilepath);
+	using Defines = std::vector<std::string>; // "NAME" or "NAME VALUE", one "#define" each.
+
+	ShaderProgram(const char* vsFilepath, const char* fsFilepath, const Defines& defines = {});
+	ShaderProgram(const char* vsFilepath, const char* gsFilepath, const char* fsFilepath, const Defines& defines = {});
+	ShaderProgram(const char* csFilepath, const Defines& defines = {}); // Compute program.
+	~ShaderProgram();
+
+	ShaderProgram(const ShaderProgram&) = delete;
+	ShaderProgram& operator=(const ShaderProgram&) = delete;
 
 	void bind();
 	void unbind();
 
+	// Whether the program is linked, without blocking when the driver compiles in parallel (always true otherwise).
+	bool isReady();
+
+	// Whether "filepath" is one of the files the program was built from, includes included.
+	bool dependsOn(const std::string& filepath);
+
+	// Starts a rebuild from the current sources, replacing any rebuild in progress.
+	void reload();
+
+	// Swaps the rebuilt program in if it's linked, returning true when it happened. A rebuild that fails to compile
+	// or link is dropped and the current program kept.
+	bool updateReload();
+
 	void setUniform1i(const char* uniformName, int data);
 	void setUniform1f(const char* uniformName, float data);
 	void setUniform3f(const char* uniformName, float x, float y, float z);
 	void setUniform3f(const char* uniformName, const glm::vec3& data);
+	void setUniform3i(const char* uniformName, const glm::ivec3& data);
 	void setUniform4f(const char* uniformName, const glm::vec4& data);
 	void setUniformMatrix3fv(const char* uniformName, const glm::mat3& data);
 	void setUniformMatrix4fv(const char* uniformName, const glm::mat4& data);
 
+	// Uploads by location. Values equal to the last ones uploaded to the same location are skipped.
+	void setUniform(int location, int data);
+	void setUniform(int location, float data);
+	void setUniform(int location, const glm::vec3& data);
+	void setUniform(int location, const glm::ivec3& data);
+	void setUniform(int location, const glm::vec4& data);
+	void setUniform(int location, const glm::mat3& data);
+	void setUniform(int location, const glm::mat4& data);
+
+	int getUniformLocation(const char* uniformName);
+
+	template<typename T>
+	Uniform<T> getUniform(const char* uniformName)
+	{
+		int uniformLocation = getUniformLocation(uniformName);
+
+		if (uniformLocation < 0)
+		{
+			std::cout << "[ERROR] SHADER PROGRAM: Failed to get location of uniform \"" << uniformName << "\"." << std::endl;
+		}
+
+		return Uniform<T>(this, uniformLocation);
+	}
+
+	struct UniformStatistics
+	{
+		unsigned long long issuedCalls;
+		unsigned long long skippedCalls;
+	};
+
+	// Uniform uploads over all programs since the last reset.
+	static UniformStatistics getUniformStatistics();
+	static void resetUniformStatistics();
+
+	struct BuildStatistics
+	{
+		unsigned int compiledPrograms;
+		unsigned int cachedPrograms;  // Loaded from the binary cache.
+		double preprocessMilliseconds; // On the worker threads, summed over the programs.
+		double submitMilliseconds;     // On the calling thread, issuing the compilation and linkage.
+		double waitMilliseconds;       // On the calling thread, blocked on a program not built yet.
+	};
+
+	static BuildStatistics getBuildStatistics();
+
+	// Empty to disable the binary cache (the default).
+	static void setBinaryCacheDirectory(const std::string& directory);
+
+	// Lets the driver compile on its own threads if it exposes "KHR_parallel_shader_compile" (or its ARB version).
+	// Returns false when it doesn't, the builds then completing in the order they are first used.
+	static bool enableParallelCompile(GLADloadproc getProcAddress);
+
+	// Submits every program still being preprocessed, waiting for the preprocessing but not for the driver.
+	static void submitPending();
+
 private:
+	struct UniformShadow
+	{
+		bool valid;
+		unsigned char data[sizeof(glm::mat4)];
+	};
+
+	struct Stage
+	{
+		std::string filepath;
+		int shaderType;
+	};
+
+	struct PreprocessedStages
+	{
+		std::vector<std::string> sources;
+		std::vector<std::vector<std::string>> sourceFilepaths; // Per stage, indexed like the "#line" directives.
+		double milliseconds;
+	};
+
+	enum class BuildState
+	{
+		PREPROCESSING,
+		SUBMITTED,
+		READY
+	};
+
+	struct BinaryHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t key;
+		uint32_t format;
+		uint32_t size;
+	};
+
 	unsigned int ID;
 
-	unsigned int createShader(const char* filepath, int shaderType);
+	std::vector<Stage> stages;
+	Defines defines;
+	std::future<PreprocessedStages> preprocessedStages;
+	std::vector<std::vector<std::string>> sourceFilepaths;
+	std::vector<std::string> sources; // Kept until linked, to compile again when the cached binary is rejected.
+	std::vector<unsigned int> shaderIDs;
+
+	BuildState buildState;
+	uint64_t key;
+	bool fromBinary;
+	bool linked;
+
+	std::unique_ptr<ShaderProgram> reloadedProgram;
+
+	std::unordered_map<std::string, int> uniformLocations;
+	std::vector<UniformShadow> uniformShadows;
+
+	static UniformStatistics uniformStatistics;
+	static BuildStatistics buildStatistics;
+	static std::filesystem::path binaryCacheDirectory;
+	static std::vector<ShaderProgram*> pendingPrograms;
+
+	// Entry point of "KHR_parallel_shader_compile", which the core profile loader doesn't provide.
+	static PFNMAXSHADERCOMPILERTHREADSPROC maxShaderCompilerThreads;
+
+	static constexpr uint32_t BINARY_VERSION = 1;
+
+	static constexpr GLenum MAX_SHADER_COMPILER_THREADS = 0x91B0; // GL_MAX_SHADER_COMPILER_THREADS_KHR.
+	static constexpr GLenum COMPLETION_STATUS = 0x91B1;           // GL_COMPLETION_STATUS_KHR.
+
+	ShaderProgram(const std::vector<Stage>& stages, const Defines& defines);
+
+	void build(const std::vector<Stage>& stages, const Defines& defines);
+
+	void submit();
+	void finish();
+
+	void compileAndLink();
+
+	bool loadBinary();
+	void saveBinary();
+
+	unsigned int createShader(const std::string& source, int shaderType);
+	void logShaderErrors(unsigned int shaderID, const std::vector<std::string>& sourceFilepaths);
+
+	// Resolves the includes of "filepath", appending every file read to "sourceFilepaths" (its index being the one of "#line").
+	static std::string preprocess(const std::string& filepath, const Defines& defines, std::vector<std::string>& sourceFilepaths);
+	static uint64_t hashBytes(const void* data, size_t size, uint64_t hash);
+
+	void introspectUniforms();
+	void copyUniforms(ShaderProgram& source);
+	bool updateUniformShadow(int location, const void* data, size_t size);
 };
+
+template<typename T>
+void Uniform<T>::set(const T& data)
+{
+	if (location > -1)
+	{
+		program->setUniform(location, data);
+	}
+}
+
+template<typename T>
+void Uniform<T>::set(int element, const T& data)
+{
+	if (location > -1)
+	{
+		program->setUniform(location + element, data);
+	}
+}
@@ -0,0 +1,90 @@
+#include "sphericalharmonics.h"
+
+#include "iblbaker.h"
+
+static const float PI = 3.14159265359f;
+
+SH9 SphericalHarmonics::projectIrradiance(const HDRImage& equirectangularMap, ThreadPool& threadPool)
+{
+	int width = equirectangularMap.width, height = equirectangularMap.height;
+
+	// One partial sum per row, reduced serially afterwards so the result doesn't depend on the scheduling.
+	std::vector<double> rowSums(static_cast<size_t>(height) * 27, 0.0);
+
+	threadPool.parallelFor(0, height, 8, [&equirectangularMap, &rowSums, width, height](int begin, int end)
+	{
+		float basis[9];
+
+		for (int row = begin; row < end; ++row)
+		{
+			// Inverse of "sampleSphericalMap" in "3_equirectangular2cubemap_fs.glsl", the first row being the bottom one.
+			float latitude = ((float(row) + 0.5f) / float(height) - 0.5f) * PI;
+			float cosLatitude = std::cos(latitude), sinLatitude = std::sin(latitude);
+
+			// Solid angle of a texel of this row.
+			float solidAngle = cosLatitude * (2.0f * PI / float(width)) * (PI / float(height));
+
+			double* sums = &rowSums[static_cast<size_t>(row) * 27];
+
+			for (int column = 0; column < width; ++column)
+			{
+				float longitude = ((float(column) + 0.5f) / float(width) - 0.5f) * 2.0f * PI;
+				glm::vec3 direction(cosLatitude * std::cos(longitude), sinLatitude, cosLatitude * std::sin(longitude));
+
+				const float* rgb = &equirectangularMap.pixels[(static_cast<size_t>(row) * width + column) * 3];
+
+				evaluateBasis(direction, basis);
+
+				for (int i = 0; i < 9; ++i)
+				{
+					float weight = basis[i] * solidAngle;
+
+					sums[i * 3 + 0] += rgb[0] * weight;
+					sums[i * 3 + 1] += rgb[1] * weight;
+					sums[i * 3 + 2] += rgb[2] * weight;
+				}
+			}
+		}
+	});
+
+	double totals[27] = {};
+
+	for (int row = 0; row < height; ++row)
+	{
+		for (int i = 0; i < 27; ++i)
+		{
+			totals[i] += rowSums[static_cast<size_t>(row) * 27 + i];
+		}
+	}
+
+	// Cosine lobe convolution per band (PI, 2PI/3, PI/4), divided by PI to match the irradiance map.
+	const float bandScales[3] = { 1.0f, 2.0f / 3.0f, 1.0f / 4.0f };
+	const int coefficientBands[9] = { 0, 1, 1, 1, 2, 2, 2, 2, 2 };
+
+	SH9 sh;
+
+	for (int i = 0; i < 9; ++i)
+	{
+		float scale = bandScales[coefficientBands[i]];
+
+		sh.coefficients[i] = glm::vec3(float(totals[i * 3]), float(totals[i * 3 + 1]), float(totals[i * 3 + 2])) * scale;
+	}
+
+	return sh;
+}
+
+void SphericalHarmonics::evaluateBasis(const glm::vec3& direction, float* basis)
+{
+	float x = direction.x, y = direction.y, z = direction.z;
+
+	// Same real basis as "evaluateIrradianceSH" in "2_pbr_texturized_fs.glsl".
+	basis[0] = 0.282095f;
+	basis[1] = 0.488603f * y;
+	basis[2] = 0.488603f * z;
+	basis[3] = 0.488603f * x;
+	basis[4] = 1.092548f * x * y;
+	basis[5] = 1.092548f * y * z;
+	basis[6] = 0.315392f * (3.0f * z * z - 1.0f);
+	basis[7] = 1.092548f * x * z;
+	basis[8] = 0.546274f * (x * x - y * y);
+}
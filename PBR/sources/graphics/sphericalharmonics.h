@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../utils/threadpool.h"
+
+struct HDRImage;
+
+// Irradiance as a 3rd order (9 coefficients per color channel) spherical harmonics expansion.
+//
+// The coefficients already include the cosine lobe convolution (Ramamoorthi and Hanrahan, "An Efficient
+// Representation for Irradiance Environment Maps") and the 1/PI of the irradiance map, so evaluating the
+// basis at the normal gives the same value the shader used to fetch from "uIrradianceMap".
+//
+struct SH9
+{
+	glm::vec3 coefficients[9];
+};
+
+class SphericalHarmonics
+{
+public:
+	static SH9 projectIrradiance(const HDRImage& equirectangularMap, ThreadPool& threadPool);
+
+	static void evaluateBasis(const glm::vec3& direction, float* basis);
+};
@@ -0,0 +1,56 @@
+#include "ssbo.h"
+
+SSBO::SSBO(int size, const void* data, int usage) : ID(), size(size), usage(usage)
+{
+	glGenBuffers(1, &ID);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, usage);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void SSBO::bind()
+{
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ID);
+}
+
+void SSBO::unbind()
+{
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void SSBO::bindBase(unsigned int binding)
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, ID);
+}
+
+void SSBO::setData(int size, const void* data)
+{
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ID);
+
+	if (size > this->size)
+	{
+		this->size = size;
+
+		glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, usage);
+	}
+	else
+	{
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void SSBO::setSubData(int offset, int size, const void* data)
+{
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ID);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, data);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void SSBO::getSubData(int offset, int size, void* data)
+{
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ID);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, data);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Shader storage buffer, read and written by shaders through "buffer" blocks.
+class SSBO
+{
+public:
+	SSBO(int size, const void* data = nullptr, int usage = GL_DYNAMIC_DRAW);
+
+	void bind();
+	void unbind();
+
+	void bindBase(unsigned int binding);
+
+	// Reallocates the storage when "size" exceeds the current one.
+	void setData(int size, const void* data);
+	void setSubData(int offset, int size, const void* data);
+	void getSubData(int offset, int size, void* data);
+
+	unsigned int getID() { return ID; }
+	int getSize() { return size; }
+
+private:
+	unsigned int ID;
+	int size;
+	int usage;
+};
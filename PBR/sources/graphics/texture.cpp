@@ -65,6 +65,59 @@ Texture::Texture(const char* filepath, bool hdr, bool gammaCorrection)
 
 		stbi_image_free(data);
 	}
+	else if (std::filesystem::path(filepath).extension() == ".hdr")
+	{
+		RadianceHDR image;
+
+		glGenTextures(1, &ID);
+		glBindTexture(GL_TEXTURE_2D, ID);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		if (image.open(filepath))
+		{
+			width = image.getWidth();
+			height = image.getHeight();
+			colorChannels = 3;
+
+			// Decoded on the thread pool straight into a staging buffer, already as the half floats of the texture.
+			size_t size = image.getDecodedSize(RadianceHDR::Format::RGB16F);
+			unsigned int stagingBuffer;
+
+			glGenBuffers(1, &stagingBuffer);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+
+			void* texels = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+			if (texels)
+			{
+				image.decode(RadianceHDR::Format::RGB16F, texels, ThreadPool::getInstance());
+
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_HALF_FLOAT, nullptr);
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			}
+			else
+			{
+				std::cout << "[ERROR] TEXTURE: Failed to map the staging buffer of \"" << filepath << "\"." << std::endl;
+			}
+
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glDeleteBuffers(1, &stagingBuffer);
+		}
+		else
+		{
+			std::cout << "[ERROR] TEXTURE: Failed to load HDR image in \"" << filepath << "\"." << std::endl;
+		}
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
 	else
 	{
 		float* data = stbi_loadf(filepath, &width, &height, &colorChannels, 0);
@@ -108,11 +161,63 @@ Texture::Texture(int width, int height, int internalFormat, int format, int type
 	glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+Texture::Texture(const DDSImage& image)
+	: ID(), width(image.width), height(image.height), colorChannels()
+{
+	int internalFormat = DDS::getGLInternalFormat(image.format);
+
+	glGenTextures(1, &ID);
+	glBindTexture(GL_TEXTURE_2D, ID);
+
+	for (int mip = 0; mip < image.numberOfMipLevels; ++mip)
+	{
+		int mipWidth = std::max(width >> mip, 1), mipHeight = std::max(height >> mip, 1);
+
+		glCompressedTexImage2D(GL_TEXTURE_2D, mip, internalFormat, mipWidth, mipHeight, 0, static_cast<GLsizei>(DDS::getLevelSize(image, mip)),
+			image.data.data() + DDS::getLevelOffset(image, 0, mip));
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.numberOfMipLevels - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, image.numberOfMipLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+Texture::~Texture()
+{
+	glDeleteTextures(1, &ID);
+}
+
 unsigned int Texture::getID()
 {
 	return ID;
 }
 
+void Texture::setData(int width, int height, int format, int type, const void* data)
+{
+	glBindTexture(GL_TEXTURE_2D, ID);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::getData(int format, int type, void* data)
+{
+	glBindTexture(GL_TEXTURE_2D, ID);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D, 0, format, type, data);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 void Texture::bind(int unit)
 {
 	if (unit >= 0 && unit <= 15)
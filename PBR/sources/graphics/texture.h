@@ -1,9 +1,13 @@
 #pragma once
 
 #include <iostream>
+#include <filesystem>
 
 #include <glad/glad.h>
 
+#include "../utils/dds.h"
+#include "../utils/radiancehdr.h"
+
 #if !defined _STB_IMAGE_INCLUDED
 #define _STB_IMAGE_INCLUDED
 
@@ -15,8 +19,18 @@ class Texture
 public:
 	Texture(const char* filepath, bool hdr = false, bool gammaCorrection = false);
 	Texture(int width, int height, int internalFormat, int format, int type);
+	Texture(const DDSImage& image); // Block-compressed, with the mip levels of the image.
+	~Texture();
+
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
 
 	unsigned int getID();
+	int getWidth() { return width; }
+	int getHeight() { return height; }
+
+	void setData(int width, int height, int format, int type, const void* data);
+	void getData(int format, int type, void* data);
 
 	void bind(int unit);
 	void unbind();
@@ -0,0 +1,102 @@
+#include "texturearray.h"
+
+TextureArray::TextureArray(int width, int height, int numberOfLayers, int internalFormat, bool generateMipMaps)
+	: ID(), width(width), height(height), numberOfLayers(numberOfLayers), internalFormat(internalFormat), mipMaps(generateMipMaps), compressed(false)
+{
+	int compressedFormat = GL_FALSE;
+
+	glGetInternalformativ(GL_TEXTURE_2D_ARRAY, internalFormat, GL_TEXTURE_COMPRESSED, 1, &compressedFormat);
+
+	compressed = compressedFormat == GL_TRUE;
+
+	int levels = 1;
+
+	if (generateMipMaps)
+	{
+		for (int size = width > height ? width : height; size > 1; size >>= 1)
+		{
+			levels++;
+		}
+	}
+
+	glGenTextures(1, &ID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, internalFormat, width, height, numberOfLayers);
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, generateMipMaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+unsigned int TextureArray::getID()
+{
+	return ID;
+}
+
+void TextureArray::setLayerData(int layer, int format, int type, const void* data)
+{
+	if (layer < 0 || layer >= numberOfLayers)
+	{
+		std::cout << "[ERROR] TEXTURE ARRAY: Layer " << layer << " out of range." << std::endl;
+
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, format, type, data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::generateMipMaps()
+{
+	if (mipMaps && !compressed)
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+}
+
+void TextureArray::setCompressedLayerData(int layer, int mipLevel, int size, const void* data)
+{
+	if (layer < 0 || layer >= numberOfLayers)
+	{
+		std::cout << "[ERROR] TEXTURE ARRAY: Layer " << layer << " out of range." << std::endl;
+
+		return;
+	}
+
+	int mipWidth = std::max(width >> mipLevel, 1), mipHeight = std::max(height >> mipLevel, 1);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+
+	glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, mipLevel, 0, 0, layer, mipWidth, mipHeight, 1, internalFormat, size, data);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::bind(int unit)
+{
+	if (unit >= 0 && unit <= 15)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+	}
+	else
+	{
+		std::cout << "[ERROR] TEXTURE ARRAY: Failed to bind texture array in " << unit << " unit." << std::endl;
+	}
+}
+
+void TextureArray::unbind()
+{
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
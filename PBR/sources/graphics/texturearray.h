@@ -0,0 +1,38 @@
+#pragma once
+
+#include <iostream>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+// 2D texture array with immutable storage, every layer sharing the same size and format.
+class TextureArray
+{
+public:
+	TextureArray(int width, int height, int numberOfLayers, int internalFormat, bool generateMipMaps = true);
+
+	unsigned int getID();
+
+	int getWidth() { return width; }
+	int getHeight() { return height; }
+	int getNumberOfLayers() { return numberOfLayers; }
+
+	// "data" must be "width * height" texels.
+	void setLayerData(int layer, int format, int type, const void* data);
+	void generateMipMaps(); // Nothing to do for compressed formats, their levels are uploaded one by one.
+
+	// Blocks of one mip level of a layer, for arrays created with a compressed internal format.
+	void setCompressedLayerData(int layer, int mipLevel, int size, const void* data);
+
+	bool isCompressed() { return compressed; }
+
+	void bind(int unit);
+	void unbind();
+
+private:
+	unsigned int ID;
+	int width, height, numberOfLayers;
+	int internalFormat;
+	bool mipMaps;
+	bool compressed;
+};
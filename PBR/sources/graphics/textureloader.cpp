@@ -0,0 +1,462 @@
+#include "textureloader.h"
+
+TextureLoader::TextureLoader(ThreadPool& threadPool, int stagingSize)
+	: threadPool(threadPool), ID(), stagingSize(static_cast<size_t>(stagingSize)), stagingHead(0), mappedData(nullptr), stagingRanges(),
+	dedicatedRanges(), decodedMutex(), decodedJobs(), stagedJobs(), waitingJobs(), pendingJobs(0), slowestDecodeTime(0.0), totalDecodeTime(0.0)
+{
+	mappedData = createStagingBuffer(this->stagingSize, ID);
+
+	if (!mappedData)
+	{
+		std::cout << "[ERROR] TEXTURE LOADER: Failed to map the staging buffer, uploading from client memory." << std::endl;
+	}
+}
+
+TextureLoader::~TextureLoader()
+{
+	finish();
+
+	for (StagingRange& range : stagingRanges)
+	{
+		glDeleteSync(range.fence);
+	}
+
+	// Deleting a buffer unmaps it.
+	for (StagingRange& range : dedicatedRanges)
+	{
+		glDeleteSync(range.fence);
+		glDeleteBuffers(1, &range.buffer);
+	}
+
+	if (mappedData)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ID);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		glDeleteBuffers(1, &ID);
+	}
+}
+
+std::shared_future<bool> TextureLoader::load(const std::string& filepath, int desiredChannels, bool hdr, const Process& process, const Upload& upload)
+{
+	std::shared_future<bool> future;
+	std::shared_ptr<Job> job = createJob(filepath, hdr, upload, future);
+
+	threadPool.submit([this, job, desiredChannels, process]()
+	{
+		PROFILE_CPU("Decode texture");
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		Image& image = job->image;
+
+		// Radiance HDRs are decoded by scanlines spread over the pool, this worker included. Unless the texels
+		// have to be processed first, that waits for the staging range so they are written there directly.
+		//
+		if (image.hdr && (desiredChannels == 0 || desiredChannels == 3) && std::filesystem::path(job->filepath).extension() == ".hdr")
+		{
+			if (process)
+			{
+				if (RadianceHDR::load(job->filepath, RadianceHDR::Format::RGB32F, threadPool, image.width, image.height, image.data))
+				{
+					image.channels = 3;
+
+					process(image);
+
+					job->success = true;
+				}
+			}
+			else
+			{
+				job->radianceHDR = std::make_shared<RadianceHDR>();
+
+				if (job->radianceHDR->open(job->filepath))
+				{
+					image.width = job->radianceHDR->getWidth();
+					image.height = job->radianceHDR->getHeight();
+					image.channels = 3;
+
+					job->size = job->radianceHDR->getDecodedSize(RadianceHDR::Format::RGB32F);
+					job->success = true;
+				}
+				else
+				{
+					job->radianceHDR.reset();
+				}
+			}
+
+			completeJob(job, start);
+
+			return;
+		}
+
+		// The flag is per thread, other decodes running at the same time aren't affected.
+		stbi_set_flip_vertically_on_load_thread(true);
+
+		void* data = image.hdr ? static_cast<void*>(stbi_loadf(job->filepath.c_str(), &image.width, &image.height, &image.channels, desiredChannels))
+			: static_cast<void*>(stbi_load(job->filepath.c_str(), &image.width, &image.height, &image.channels, desiredChannels));
+
+		if (data)
+		{
+			image.channels = desiredChannels ? desiredChannels : image.channels;
+
+			size_t size = static_cast<size_t>(image.width) * image.height * image.channels * (image.hdr ? sizeof(float) : 1);
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+			image.data.assign(bytes, bytes + size);
+
+			stbi_image_free(data);
+
+			if (process)
+			{
+				process(image);
+			}
+
+			job->success = true;
+		}
+
+		completeJob(job, start);
+	});
+
+	return future;
+}
+
+std::shared_future<bool> TextureLoader::loadCompressed(const std::string& filepath, const Upload& upload)
+{
+	Decode decode = [filepath](Image& image)
+	{
+		DDSImage ddsImage;
+
+		if (!DDS::load(filepath, ddsImage))
+		{
+			return false;
+		}
+
+		image.width = ddsImage.width;
+		image.height = ddsImage.height;
+		image.compressed = true;
+		image.numberOfMipLevels = ddsImage.numberOfMipLevels;
+		image.format = ddsImage.format;
+		image.data.swap(ddsImage.data);
+
+		return true;
+	};
+
+	return load(filepath, decode, upload);
+}
+
+std::shared_future<bool> TextureLoader::load(const std::string& name, const Decode& decode, const Upload& upload)
+{
+	std::shared_future<bool> future;
+	std::shared_ptr<Job> job = createJob(name, false, upload, future);
+
+	threadPool.submit([this, job, decode]()
+	{
+		PROFILE_CPU("Decode texture");
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		job->success = decode(job->image);
+
+		completeJob(job, start);
+	});
+
+	return future;
+}
+
+int TextureLoader::update()
+{
+	releaseStagingRanges();
+
+	std::deque<std::shared_ptr<Job>> decoded, staged;
+
+	{
+		std::lock_guard<std::mutex> lock(decodedMutex);
+
+		decoded.swap(decodedJobs);
+		staged.swap(stagedJobs);
+	}
+
+	for (std::shared_ptr<Job>& job : staged)
+	{
+		uploadJob(job);
+	}
+
+	waitingJobs.insert(waitingJobs.end(), decoded.begin(), decoded.end());
+
+	// In order, so a large image waiting for room isn't starved by the smaller ones behind it.
+	while (!waitingJobs.empty())
+	{
+		std::shared_ptr<Job> job = waitingJobs.front();
+
+		if (!job->success)
+		{
+			std::cout << "[ERROR] TEXTURE LOADER: Failed to load texture in \"" << job->filepath << "\"." << std::endl;
+
+			finishJob(job, false);
+		}
+		else if (reserveStaging(*job))
+		{
+			threadPool.submit([this, job]()
+			{
+				stageJob(job);
+			});
+		}
+		else
+		{
+			break; // Retried once the workers are done with the ranges in the way.
+		}
+
+		waitingJobs.pop_front();
+	}
+
+	return pendingJobs;
+}
+
+void TextureLoader::finish()
+{
+	while (update() > 0)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+std::shared_ptr<TextureLoader::Job> TextureLoader::createJob(const std::string& filepath, bool hdr, const Upload& upload, std::shared_future<bool>& future)
+{
+	std::shared_ptr<Job> job = std::make_shared<Job>();
+
+	job->filepath = filepath;
+	job->upload = upload;
+	job->image = { 0, 0, 0, hdr, false, 1, DDSFormat::BC7, {}, 0.0 };
+	job->success = false;
+	job->size = 0;
+	job->range = nullptr;
+	job->destination = nullptr;
+
+	future = job->promise.get_future().share();
+
+	pendingJobs++;
+
+	return job;
+}
+
+void TextureLoader::completeJob(const std::shared_ptr<Job>& job, std::chrono::high_resolution_clock::time_point start)
+{
+	job->image.decodeTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	if (!job->radianceHDR)
+	{
+		job->size = job->image.data.size();
+	}
+
+	std::lock_guard<std::mutex> lock(decodedMutex);
+
+	decodedJobs.push_back(job);
+}
+
+void TextureLoader::stageJob(const std::shared_ptr<Job>& job)
+{
+	PROFILE_CPU("Stage texture");
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	Image& image = job->image;
+
+	if (job->radianceHDR)
+	{
+		if (!job->destination)
+		{
+			image.data.resize(job->size);
+		}
+
+		job->radianceHDR->decode(RadianceHDR::Format::RGB32F, job->destination ? job->destination : image.data.data(), threadPool);
+
+		// Unmaps the file.
+		job->radianceHDR.reset();
+	}
+	else if (job->destination)
+	{
+		std::memcpy(job->destination, image.data.data(), job->size);
+
+		std::vector<unsigned char>().swap(image.data);
+	}
+
+	image.decodeTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	std::lock_guard<std::mutex> lock(decodedMutex);
+
+	stagedJobs.push_back(job);
+}
+
+void TextureLoader::uploadJob(const std::shared_ptr<Job>& job)
+{
+	if (job->range)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, job->range->buffer);
+
+		job->upload(job->image, reinterpret_cast<const void*>(job->range->offset));
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		job->range->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	else
+	{
+		job->upload(job->image, job->image.data.data());
+
+		std::vector<unsigned char>().swap(job->image.data);
+	}
+
+	finishJob(job, true);
+}
+
+void TextureLoader::finishJob(const std::shared_ptr<Job>& job, bool success)
+{
+	pendingJobs--;
+
+	slowestDecodeTime = std::max(slowestDecodeTime, job->image.decodeTime);
+	totalDecodeTime += job->image.decodeTime;
+
+	job->promise.set_value(success);
+}
+
+bool TextureLoader::reserveStaging(Job& job)
+{
+	job.range = nullptr;
+	job.destination = nullptr;
+
+	if (!mappedData)
+	{
+		return true;
+	}
+
+	if (job.size > stagingSize)
+	{
+		unsigned int buffer;
+		unsigned char* data = createStagingBuffer(job.size, buffer);
+
+		if (!data)
+		{
+			std::cout << "[ERROR] TEXTURE LOADER: Failed to map a staging buffer for \"" << job.filepath << "\", uploading from client memory." << std::endl;
+
+			return true;
+		}
+
+		std::cout << "[INFO] TEXTURE LOADER: \"" << job.filepath << "\" is larger than the staging buffer, staging it in a buffer of its own." << std::endl;
+
+		dedicatedRanges.push_back({ buffer, 0, job.size, nullptr });
+
+		job.range = &dedicatedRanges.back();
+		job.destination = data;
+
+		return true;
+	}
+
+	size_t offset;
+
+	if (!allocateStagingRange(job.size, offset))
+	{
+		return false;
+	}
+
+	stagingRanges.push_back({ ID, offset, job.size, nullptr });
+
+	job.range = &stagingRanges.back();
+	job.destination = mappedData + offset;
+
+	return true;
+}
+
+bool TextureLoader::allocateStagingRange(size_t size, size_t& offset)
+{
+	size_t head = (stagingHead + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+
+	offset = head + size <= stagingSize ? head : 0;
+
+	// Ranges are released in the order they were used, so waiting on the oldest ones first frees the space.
+	while (!stagingRanges.empty())
+	{
+		bool overlaps = false;
+
+		for (const StagingRange& range : stagingRanges)
+		{
+			if (range.offset < offset + size && offset < range.offset + range.size)
+			{
+				overlaps = true;
+
+				break;
+			}
+		}
+
+		if (!overlaps)
+		{
+			break;
+		}
+
+		StagingRange& oldest = stagingRanges.front();
+
+		// Still being written by a worker, there's no fence to wait on yet.
+		if (!oldest.fence)
+		{
+			return false;
+		}
+
+		glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(oldest.fence);
+
+		stagingRanges.pop_front();
+	}
+
+	stagingHead = offset + size;
+
+	return true;
+}
+
+void TextureLoader::releaseStagingRanges()
+{
+	// Releases the staging ranges the GPU is done with. The ones not uploaded yet hold back the ring.
+	while (!stagingRanges.empty() && stagingRanges.front().fence && glClientWaitSync(stagingRanges.front().fence, 0, 0) != GL_TIMEOUT_EXPIRED)
+	{
+		glDeleteSync(stagingRanges.front().fence);
+
+		stagingRanges.pop_front();
+	}
+
+	for (auto range = dedicatedRanges.begin(); range != dedicatedRanges.end();)
+	{
+		if (range->fence && glClientWaitSync(range->fence, 0, 0) != GL_TIMEOUT_EXPIRED)
+		{
+			glDeleteSync(range->fence);
+			glDeleteBuffers(1, &range->buffer);
+
+			range = dedicatedRanges.erase(range);
+		}
+		else
+		{
+			++range;
+		}
+	}
+}
+
+unsigned char* TextureLoader::createStagingBuffer(size_t size, unsigned int& buffer)
+{
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+
+	void* data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags);
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if (!data)
+	{
+		glDeleteBuffers(1, &buffer);
+
+		buffer = 0;
+	}
+
+	return static_cast<unsigned char*>(data);
+}
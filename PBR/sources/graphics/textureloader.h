@@ -0,0 +1,147 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <deque>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <iostream>
+#include <filesystem>
+#include <functional>
+
+#include <glad/glad.h>
+
+#if !defined _STB_IMAGE_INCLUDED
+#define _STB_IMAGE_INCLUDED
+
+#include <stbi/stb_image.h>
+#endif // _STB_IMAGE_INCLUDED
+
+#include "../utils/dds.h"
+#include "../utils/radiancehdr.h"
+#include "../utils/threadpool.h"
+#include "../utils/profiler.h"
+
+// Asynchronous image loading: files are decoded on the thread pool, and the texels written by the workers
+// into a persistently mapped pixel unpack buffer. The GL thread only reserves the staging ranges, which
+// needs the fences, and issues the "glTex(Sub)Image" calls from them, which return without waiting for
+// the transfer. Radiance HDRs are only indexed first and then decoded straight into their range.
+//
+// The staging buffer is used as a ring, every upload guarded by a fence so its range isn't overwritten
+// while the GPU is still reading it. Images larger than the whole ring get a staging buffer of their own,
+// deleted once their upload is done.
+//
+class TextureLoader
+{
+public:
+	struct Image
+	{
+		int width, height, channels;
+		bool hdr;                        // Texels are floats instead of unsigned bytes.
+		bool compressed;                 // "data" holds the blocks of every mip level, see "DDSImage".
+		int numberOfMipLevels;
+		DDSFormat format;                // Compressed images only.
+		std::vector<unsigned char> data; // Tightly packed, first row at the bottom. Released once staged.
+		double decodeTime;               // Milliseconds spent decoding, processing and staging on the workers.
+	};
+
+	// Runs on the worker after decoding, e.g. to convert or resize the texels.
+	using Process = std::function<void(Image& image)>;
+
+	// Runs on the worker instead of the default decoding, filling "image" (e.g. from several files). False on failure.
+	using Decode = std::function<bool(Image& image)>;
+
+	// Runs on the GL thread with the staging buffer bound, "texels" being the offset of the image in it
+	// (or a client memory pointer if no staging buffer could be mapped).
+	using Upload = std::function<void(const Image& image, const void* texels)>;
+
+	TextureLoader(ThreadPool& threadPool, int stagingSize = 64 << 20);
+	~TextureLoader();
+
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	// The future becomes ready once "upload" has been called on the GL thread, false if decoding failed.
+	std::shared_future<bool> load(const std::string& filepath, int desiredChannels, bool hdr, const Process& process, const Upload& upload);
+
+	// Same for a block-compressed DDS file (single layer), read as is on the worker.
+	std::shared_future<bool> loadCompressed(const std::string& filepath, const Upload& upload);
+
+	// Same with a custom decoding, "name" only being used to report errors.
+	std::shared_future<bool> load(const std::string& name, const Decode& decode, const Upload& upload);
+
+	// GL thread only: uploads every image staged so far, reserves staging for the ones decoded since
+	// the last call, and returns the number of loads still pending.
+	int update();
+
+	// GL thread only: waits for every pending load to be uploaded.
+	void finish();
+
+	double getSlowestDecodeTime() { return slowestDecodeTime; }
+	double getTotalDecodeTime() { return totalDecodeTime; }
+
+private:
+	struct StagingRange
+	{
+		unsigned int buffer;
+		size_t offset, size;
+		GLsync fence;                       // Null until the upload from the range was issued.
+	};
+
+	struct Job
+	{
+		std::string filepath;
+		Upload upload;
+		Image image;
+		bool success;
+		std::promise<bool> promise;
+		std::shared_ptr<RadianceHDR> radianceHDR; // Indexed only, decoded by the staging write.
+		size_t size;                              // Bytes of texels to stage.
+		StagingRange* range;                      // GL thread only, null when uploading from client memory.
+		unsigned char* destination;               // Mapped address of the range, written by a worker.
+	};
+
+	// Offsets in the ring are kept aligned for every texel type and the workers' SIMD stores.
+	static constexpr size_t STAGING_ALIGNMENT = 16;
+
+	ThreadPool& threadPool;
+
+	unsigned int ID;
+	size_t stagingSize;
+	size_t stagingHead;
+	unsigned char* mappedData;
+	std::deque<StagingRange> stagingRanges;  // Only popped at the front, so the jobs' pointers stay valid.
+	std::list<StagingRange> dedicatedRanges; // Buffers of their own for the images larger than the ring.
+
+	std::mutex decodedMutex;
+	std::deque<std::shared_ptr<Job>> decodedJobs, stagedJobs;
+	std::deque<std::shared_ptr<Job>> waitingJobs; // Decoded, waiting for room in the ring. GL thread only.
+
+	int pendingJobs;
+	double slowestDecodeTime, totalDecodeTime;
+
+	std::shared_ptr<Job> createJob(const std::string& filepath, bool hdr, const Upload& upload, std::shared_future<bool>& future);
+
+	void completeJob(const std::shared_ptr<Job>& job, std::chrono::high_resolution_clock::time_point start);
+
+	// Runs on a worker: writes the texels of the job into its staging range.
+	void stageJob(const std::shared_ptr<Job>& job);
+
+	void uploadJob(const std::shared_ptr<Job>& job);
+
+	void finishJob(const std::shared_ptr<Job>& job, bool success);
+
+	// False if the ring can't make room without waiting on ranges the workers are still writing.
+	bool reserveStaging(Job& job);
+
+	bool allocateStagingRange(size_t size, size_t& offset);
+
+	void releaseStagingRanges();
+
+	// Creates a persistently mapped pixel unpack buffer, returning its mapping or null on failure.
+	static unsigned char* createStagingBuffer(size_t size, unsigned int& buffer);
+};
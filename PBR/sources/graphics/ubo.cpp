@@ -0,0 +1,71 @@
+#include "ubo.h"
+
+UBO::UBO(int size, unsigned int binding, int numberOfRegions)
+	: ID(), binding(binding), size(size), regionSize(), numberOfRegions(numberOfRegions), currentRegion(numberOfRegions - 1), mappedData(nullptr), fences(numberOfRegions, nullptr)
+{
+	int alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+	// Every region has to start at a multiple of the offset alignment to be bound with "glBindBufferRange".
+	alignment = alignment > 0 ? alignment : 256;
+	regionSize = (size + alignment - 1) / alignment * alignment;
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &ID);
+	glBindBuffer(GL_UNIFORM_BUFFER, ID);
+	glBufferStorage(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(regionSize) * numberOfRegions, nullptr, flags);
+
+	mappedData = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(regionSize) * numberOfRegions, flags));
+
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UBO::update(const void* data)
+{
+	currentRegion = (currentRegion + 1) % numberOfRegions;
+
+	wait(currentRegion);
+
+	std::memcpy(mappedData + static_cast<size_t>(currentRegion) * regionSize, data, size);
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, ID, static_cast<GLintptr>(currentRegion) * regionSize, size);
+}
+
+void UBO::lock()
+{
+	if (fences[currentRegion])
+	{
+		glDeleteSync(fences[currentRegion]);
+	}
+
+	fences[currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void UBO::wait(int region)
+{
+	if (!fences[region])
+	{
+		return;
+	}
+
+	// Only blocks when the CPU runs more than "numberOfRegions" frames ahead of the GPU.
+	GLbitfield waitFlags = 0;
+	GLuint64 waitDuration = 0;
+
+	while (true)
+	{
+		GLenum waitResult = glClientWaitSync(fences[region], waitFlags, waitDuration);
+
+		if (waitResult == GL_ALREADY_SIGNALED || waitResult == GL_CONDITION_SATISFIED || waitResult == GL_WAIT_FAILED)
+		{
+			break;
+		}
+
+		waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		waitDuration = 1000000; // 1 ms.
+	}
+
+	glDeleteSync(fences[region]);
+	fences[region] = nullptr;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Uniform buffer written once per frame, bound at a fixed binding point shared by every program.
+//
+// The storage is persistently mapped and split into a ring of regions. Each frame writes the next region
+// while the GPU may still be reading the previous ones, a fence per region guarding against overwriting
+// data that is still in use.
+//
+class UBO
+{
+public:
+	UBO(int size, unsigned int binding, int numberOfRegions = 3);
+
+	// Waits for the next region to be released, copies "data" into it and binds it.
+	void update(const void* data);
+
+	// Called once the draws reading the current region have been issued.
+	void lock();
+
+	unsigned int getBinding() { return binding; }
+
+private:
+	unsigned int ID;
+	unsigned int binding;
+
+	int size;
+	int regionSize;
+	int numberOfRegions;
+	int currentRegion;
+
+	unsigned char* mappedData;
+	std::vector<GLsync> fences;
+
+	void wait(int region);
+};
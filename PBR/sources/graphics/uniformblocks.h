@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// C++ side of the uniform and storage blocks declared in "sources/shaders", laid out following std140 (std430 for
+// the storage blocks, identical for the structs below).
+//
+// vec3 members are stored as vec4 since std140 aligns them to 16 bytes anyway, and arrays of
+// scalars are avoided because std140 pads every element to 16 bytes.
+//
+enum UniformBlockBinding : unsigned int
+{
+	CAMERA_BLOCK_BINDING = 0,
+	LIGHT_BLOCK_BINDING  = 1
+};
+
+enum StorageBlockBinding : unsigned int
+{
+	LIGHT_BUFFER_BINDING                = 0,
+	CLUSTER_LIGHT_COUNT_BUFFER_BINDING  = 1,
+	CLUSTER_LIGHT_INDEX_BUFFER_BINDING  = 2,
+	OBJECT_BOUNDS_BUFFER_BINDING        = 3,
+	OBJECT_CANDIDATE_BUFFER_BINDING     = 4,
+	OBJECT_INSTANCE_BUFFER_BINDING      = 5,
+	VISIBLE_INSTANCE_BUFFER_BINDING     = 6,
+	DRAW_COMMAND_BUFFER_BINDING         = 7,
+	PREFILTER_SAMPLE_BUFFER_BINDING     = 8,
+	REFLECTION_PROBE_BUFFER_BINDING     = 9
+};
+
+struct CameraData
+{
+	glm::mat4 projection;
+	glm::mat4 view;
+	glm::mat4 inverseProjection;
+	glm::vec4 position; // w unused.
+	glm::vec4 viewport; // xy = size in pixels, z = near plane, w = far plane.
+};
+
+// Parameters of the clustered light culling, see "clusteredlighting.h".
+struct LightData
+{
+	glm::uvec4 clusterGrid;  // xyz = number of clusters along each axis, w = maximum number of lights per cluster.
+	glm::vec4  clusterDepth; // x = scale, y = bias of the logarithmic depth slicing, zw unused.
+	glm::ivec4 count;        // x = number of lights, yzw unused.
+};
+
+// Element of the light storage buffer.
+struct PointLight
+{
+	glm::vec4 positionRadius; // xyz = world space position, w = radius of influence.
+	glm::vec4 color;          // w unused.
+};
+
+// Element of the reflection probe buffer, see "reflectionprobes.h".
+struct ReflectionProbeData
+{
+	glm::vec4 positionRadius; // xyz = capture position, w = radius of influence.
+	glm::vec4 boxMin;         // xyz = corner of the parallax box, w = 1 once captured, 0 before.
+	glm::vec4 boxMax;         // w unused.
+};
+
+// Element of the draw command buffer, as read by "glMultiDrawElementsIndirect" and written by "6_object_culling_cs.glsl".
+struct DrawElementsCommand
+{
+	uint32_t count;
+	uint32_t instanceCount;
+	uint32_t firstIndex;
+	int32_t  baseVertex;
+	uint32_t baseInstance;
+};
+
+static_assert(sizeof(CameraData) == 224, "CameraData doesn't match the std140 layout of \"CameraBlock\".");
+static_assert(offsetof(CameraData, view) == 64 && offsetof(CameraData, inverseProjection) == 128, "CameraData doesn't match the std140 layout of \"CameraBlock\".");
+static_assert(offsetof(CameraData, position) == 192 && offsetof(CameraData, viewport) == 208, "CameraData doesn't match the std140 layout of \"CameraBlock\".");
+
+static_assert(sizeof(LightData) == 48, "LightData doesn't match the std140 layout of \"LightBlock\".");
+static_assert(offsetof(LightData, clusterDepth) == 16 && offsetof(LightData, count) == 32, "LightData doesn't match the std140 layout of \"LightBlock\".");
+
+static_assert(sizeof(PointLight) == 32, "PointLight doesn't match the std430 layout of \"LightBuffer\".");
+
+static_assert(sizeof(ReflectionProbeData) == 48, "ReflectionProbeData doesn't match the std430 layout of \"ReflectionProbeBuffer\".");
+
+static_assert(sizeof(DrawElementsCommand) == 20, "DrawElementsCommand doesn't match the layout of \"DrawCommandBuffer\".");
@@ -17,3 +17,10 @@ void VBO::unbind()
 {
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
+
+void VBO::setData(const void* data, int size)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, ID);
+	glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -10,6 +10,9 @@ public:
 	void bind();
 	void unbind();
 
+	// Replaces the whole content, reallocating the storage.
+	void setData(const void* data, int size);
+
 private:
 	unsigned int ID;
 };
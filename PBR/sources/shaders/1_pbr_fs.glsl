@@ -1,4 +1,4 @@
-#version 460 core
+#version 450 core
 
 in vec3 ioWorldPos;
 in vec3 ioNormal;
@@ -17,65 +17,13 @@ uniform samplerCube uIrradianceMap;
 uniform samplerCube uPrefilterMap;
 uniform sampler2D uBRDFLUTMap;
 
-// Lights parameters.
-uniform vec3 uLightPositions[4];
-uniform vec3 uLightColors[4];
-
-uniform vec3 uCameraPos;
-
-const float PI = 3.14159265359;
-
-float distributionGGX(vec3 N, vec3 H, float roughness)
-{
-    float a1 = roughness * roughness;
-    float a2 = a1 * a1;
-    float NdotH1 = max(dot(N, H), 0.0);
-    float NdotH2 = NdotH1 * NdotH1;
-
-    float numerator = a2;
-    float denominator = (NdotH2 * (a2 - 1.0) + 1.0);
-
-    denominator = PI * denominator * denominator;
-
-    return numerator / denominator;
-}
-
-float geometrySchlickGGX(float NdotV, float roughness)
-{
-    float r = (roughness + 1.0);
-    float k = (r * r) / 8.0;
-
-    float numerator = NdotV;
-    float denominator = NdotV * (1.0 - k) + k;
-
-    return numerator / denominator;
-}
-
-float geometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
-{
-    float NdotV = max(dot(N, V), 0.0);
-    float NdotL = max(dot(N, L), 0.0);
-
-    float numerator = geometrySchlickGGX(NdotV, roughness);
-    float denominator = geometrySchlickGGX(NdotL, roughness);
-
-    return numerator * denominator;
-}
-
-vec3 fresnelSchlick(vec3 F0, float cosTheta)
-{
-    return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
-}
-
-vec3 fresnelSchlickRoughness(float cosTheta, float roughness, vec3 F0)
-{
-    return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
-}
+#include "include/clustered_lights.glsl"
+#include "include/brdf.glsl"
 
 void main()
 {
     vec3 N = normalize(ioNormal);
-    vec3 V = normalize(uCameraPos - ioWorldPos);
+    vec3 V = normalize(uCameraPos.xyz - ioWorldPos);
     vec3 R = reflect(-V, N);
 
     // Calculate reflectance at normal incidence:
@@ -88,15 +36,24 @@ void main()
     // Reflectance equation.
     vec3 Lo = vec3(0.0);
 
-    for(int i = 0; i < 4; ++i)
+    // Only the lights overlapping the cluster of this fragment.
+    uint clusterIndex = getClusterIndex(ioWorldPos);
+    uint clusterLightCount = uClusterLightCounts[clusterIndex];
+    uint clusterLightOffset = clusterIndex * uClusterGrid.w;
+
+    for(uint i = 0; i < clusterLightCount; ++i)
     {
+        PointLight light = uLights[uClusterLightIndices[clusterLightOffset + i]];
+
         // Calculate per-light radiance.
-        vec3  L = normalize(uLightPositions[i] - ioWorldPos);
+        vec3  L = normalize(light.positionRadius.xyz - ioWorldPos);
         vec3  H = normalize(V + L);
 
-        float lightDistance = length(uLightPositions[i] - ioWorldPos);
-        float attenuation = 1.0 / (lightDistance * lightDistance);
-        vec3  radiance = uLightColors[i] * attenuation;
+        // Inverse square falloff, windowed to reach zero at the radius used for the binning.
+        float lightDistance = length(light.positionRadius.xyz - ioWorldPos);
+        float window = clamp(1.0 - pow(lightDistance / light.positionRadius.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (lightDistance * lightDistance);
+        vec3  radiance = light.color.rgb * attenuation;
 
         // Cook-Torrance BRDF.
         float NDF = distributionGGX(N, H, uRoughness);
@@ -1,4 +1,4 @@
-#version 460 core
+#version 450 core
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
@@ -8,9 +8,9 @@ out vec3 ioWorldPos;
 out vec3 ioNormal;
 out vec2 ioTexCoords;
 
+#include "include/camera_block.glsl"
+
 uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProjection;
 uniform mat3 uNormalMatrix;
 
 void main()
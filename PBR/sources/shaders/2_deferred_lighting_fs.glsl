@@ -0,0 +1,46 @@
+#version 450 core
+
+out vec4 oFragColor;
+
+// G-buffer filled by "2_pbr_gbuffer_fs.glsl", the same size as the viewport.
+uniform sampler2D uGBufferAlbedo;
+uniform sampler2D uGBufferORM;
+uniform sampler2D uGBufferNormal;
+uniform sampler2D uGBufferDepth;
+
+// Permutations IBL, IRRADIANCE_SH, REFLECTION_PROBES and MAX_LIGHTS_PER_CLUSTER, like "2_pbr_texturized_fs.glsl".
+#include "include/pbr_lighting.glsl"
+#include "include/gbuffer.glsl"
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(uGBufferDepth, texel, 0).r;
+
+    // Background, left to the skybox.
+    if (depth == 1.0)
+    {
+        discard;
+    }
+
+    vec3 albedo = pow(texelFetch(uGBufferAlbedo, texel, 0).rgb, vec3(2.2));
+    vec3 orm = texelFetch(uGBufferORM, texel, 0).rgb;
+    vec3 normal = decodeOctahedral(texelFetch(uGBufferNormal, texel, 0).rg);
+
+    // Position from the depth, back through the projection then the view matrix (a rotation and a translation).
+    vec4 viewPos = uInverseProjection * vec4(vec3(gl_FragCoord.xy / uViewport.xy, depth) * 2.0 - 1.0, 1.0);
+    viewPos /= viewPos.w;
+
+    vec3 worldPos = transpose(mat3(uView)) * (viewPos.xyz - uView[3].xyz);
+
+    // The G-buffer doesn't keep the objects, the reflection probes are selected per pixel.
+    vec3 color = shadeSurface(worldPos, worldPos, normal, albedo, orm.b, orm.g, orm.r);
+
+    color = color / (color + vec3(1.0)); // HDR tonemapping.
+    color = pow(color, vec3(1.0 / 2.2)); // Gamma correction.
+
+    oFragColor = vec4(color, 1.0);
+
+    // Depth of the spheres in the target too, for the skybox and the depth pyramid.
+    gl_FragDepth = depth;
+}
@@ -0,0 +1,9 @@
+#version 450 core
+
+layout (location = 0) in vec3 aPos;
+
+// Full-screen quad, the lighting pass fetching the G-buffer at "gl_FragCoord".
+void main()
+{
+    gl_Position = vec4(aPos, 1.0);
+}
@@ -0,0 +1,6 @@
+#version 450 core
+
+// Paired with "2_pbr_texturized_vs.glsl" for the depth prepass: no color is written, only the depth test runs.
+void main()
+{
+}
@@ -0,0 +1,27 @@
+#version 450 core
+
+in vec3 ioWorldPos;
+in vec3 ioNormal;
+in vec2 ioTexCoords;
+flat in vec3 ioMaterial; // x = metallic, y = roughness (negative to sample the material maps), z = material layer.
+
+// Paired with "2_pbr_texturized_vs.glsl" to fill the G-buffer, lit afterwards by "2_deferred_lighting_fs.glsl".
+layout (location = 0) out vec4 oAlbedo; // Gamma encoded, the 8 bits being spent where the eye sees them.
+layout (location = 1) out vec4 oORM;    // Occlusion, roughness and metallic.
+layout (location = 2) out vec2 oNormal; // Octahedral.
+
+// Permutations MATERIAL_MAPS and PACKED_ORM, like "2_pbr_texturized_fs.glsl".
+#include "include/pbr_material.glsl"
+#include "include/gbuffer.glsl"
+
+void main()
+{
+    vec3  albedo, normal;
+    float metallic, roughness, ao;
+
+    getSurface(albedo, normal, metallic, roughness, ao);
+
+    oAlbedo = vec4(pow(albedo, vec3(1.0 / 2.2)), 1.0);
+    oORM = vec4(ao, roughness, metallic, 1.0);
+    oNormal = encodeOctahedral(normal);
+}
@@ -1,23 +1,32 @@
-#version 460 core
+#version 450 core
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
+// Per instance, see "SphereInstance" in "program.cpp".
+layout (location = 3)  in mat4 aModel;        // Locations 3 to 6.
+layout (location = 7)  in mat3 aNormalMatrix; // Locations 7 to 9.
+layout (location = 10) in vec4 aMaterial;     // x = metallic, y = roughness (negative to sample the material maps), z = material layer.
+
 out vec3 ioWorldPos;
 out vec3 ioNormal;
 out vec2 ioTexCoords;
+flat out vec3 ioMaterial;
+flat out vec3 ioObjectPos; // Center of the instance, selecting its reflection probes.
+
+#include "include/camera_block.glsl"
 
-uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProjection;
-uniform mat3 uNormalMatrix;
+// Same depth in the prepass and the shading pass, which tests it for equality.
+invariant gl_Position;
 
 void main()
 {
-    ioWorldPos = vec3(uModel * vec4(aPos, 1.0));
-    ioNormal = uNormalMatrix * aNormal;
+    ioWorldPos = vec3(aModel * vec4(aPos, 1.0));
+    ioNormal = aNormalMatrix * aNormal;
     ioTexCoords = aTexCoords;
+    ioMaterial = aMaterial.xyz;
+    ioObjectPos = aModel[3].xyz;
 
     gl_Position =  uProjection * uView * vec4(ioWorldPos, 1.0);
 }
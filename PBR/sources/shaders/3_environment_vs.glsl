@@ -1,11 +1,10 @@
-#version 460 core
+#version 450 core
 
 layout (location = 0) in vec3 aPos;
 
 out vec3 ioWorldPos;
 
-uniform mat4 uView;
-uniform mat4 uProjection;
+#include "include/camera_block.glsl"
 
 void main()
 {
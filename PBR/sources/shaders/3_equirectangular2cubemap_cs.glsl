@@ -0,0 +1,28 @@
+#version 450 core
+
+// Compute version of "3_equirectangular2cubemap_fs.glsl": one invocation per texel, the six faces in a single dispatch
+// ("gl_GlobalInvocationID.z" being the face).
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (rgba16f, binding = 0) uniform writeonly imageCube uEnvironmentImage;
+
+uniform sampler2D uEquirectangularMap;
+uniform ivec3 uTexelOffset; // First texel and face of the dispatch, zero unless baked a tile at a time.
+
+#include "include/ibl_convolution.glsl"
+
+void main()
+{
+    ivec3 texel = ivec3(gl_GlobalInvocationID) + uTexelOffset;
+    int size = imageSize(uEnvironmentImage).x;
+
+    if (texel.x >= size || texel.y >= size)
+    {
+        return;
+    }
+
+    vec2 uv = sampleSphericalMap(getCubeMapTexelDirection(texel, size));
+    vec3 color = textureLod(uEquirectangularMap, uv, 0.0).rgb;
+
+    imageStore(uEnvironmentImage, texel, vec4(color, 1.0));
+}
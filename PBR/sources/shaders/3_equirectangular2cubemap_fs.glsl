@@ -1,4 +1,4 @@
-#version 460 core
+#version 450 core
 
 in vec3 ioWorldPos;
 
@@ -6,17 +6,7 @@ out vec4 oFragColor;
 
 uniform sampler2D uEquirectangularMap;
 
-const vec2 invatan = vec2(0.1591, 0.3183); // Inverse of "atan".
-
-vec2 sampleSphericalMap(vec3 v)
-{
-    vec2 uv = vec2(atan(v.z, v.x), asin(v.y));
-
-    uv *= invatan;
-    uv += 0.5;
-
-    return uv;
-}
+#include "include/ibl_convolution.glsl"
 
 void main()
 {
@@ -0,0 +1,27 @@
+#version 450 core
+
+// Compute version of "3_irradiance_convolution_fs.glsl", the six faces in a single dispatch.
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (rgba16f, binding = 0) uniform writeonly imageCube uIrradianceImage;
+
+uniform samplerCube uEnvironmentMap;
+uniform float uSampleDelta;
+uniform ivec3 uTexelOffset; // First texel and face of the dispatch, zero unless baked a tile at a time.
+
+#include "include/ibl_convolution.glsl"
+
+void main()
+{
+    ivec3 texel = ivec3(gl_GlobalInvocationID) + uTexelOffset;
+    int size = imageSize(uIrradianceImage).x;
+
+    if (texel.x >= size || texel.y >= size)
+    {
+        return;
+    }
+
+    vec3 irradiance = convolveIrradiance(uEnvironmentMap, getCubeMapTexelDirection(texel, size), uSampleDelta);
+
+    imageStore(uIrradianceImage, texel, vec4(irradiance, 1.0));
+}
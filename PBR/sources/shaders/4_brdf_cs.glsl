@@ -0,0 +1,25 @@
+#version 450 core
+
+// Compute version of "4_brdf_fs.glsl", NdotV along x and the roughness along y.
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (rg16f, binding = 0) uniform writeonly image2D uBRDFLUTImage;
+
+uniform int uSampleCount;
+
+#include "include/ibl_convolution.glsl"
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(uBRDFLUTImage);
+
+    if (texel.x >= size.x || texel.y >= size.y)
+    {
+        return;
+    }
+
+    vec2 texCoords = (vec2(texel) + 0.5) / vec2(size);
+
+    imageStore(uBRDFLUTImage, texel, vec4(integrateBRDF(texCoords.x, texCoords.y, uint(uSampleCount)), 0.0, 0.0));
+}
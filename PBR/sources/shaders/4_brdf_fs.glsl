@@ -1,124 +1,14 @@
-#version 460 core
+#version 450 core
 
 in vec2 ioTexCoords;
 
 out vec2 oFragColor;
 
-const float PI = 3.14159265359;
-
-// Efficient "VanDerCorpus" calculation.
-// http://holger.dammertz.org/stuff/notes_HammersleyOnHemisphere.html
-//
-float radicalInverseVDC(uint bits)
-{
-     bits = (bits << 16u) | (bits >> 16u);
-     bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
-     bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
-     bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
-     bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
-
-     return float(bits) * 2.3283064365386963e-10; // / 0x100000000
-}
-
-vec2 hammersley(uint i, uint N)
-{
-	return vec2(float(i) / float(N), radicalInverseVDC(i));
-}
-
-vec3 importanceSampleGGX(vec2 Xi, vec3 N, float roughness)
-{
-	float a = roughness * roughness;
-	
-	float phi = 2.0 * PI * Xi.x;
-	float cosTheta = sqrt((1.0 - Xi.y) / (1.0 + (a * a - 1.0) * Xi.y));
-	float sinTheta = sqrt(1.0 - cosTheta * cosTheta);
-	
-	// From spherical coordinates to cartesian coordinates (halfway vector).
-	vec3 H;
-
-	H.x = cos(phi) * sinTheta;
-	H.y = sin(phi) * sinTheta;
-	H.z = cosTheta;
-	
-	// From tangent-space vector (H) to world-space sample vector.
-	vec3 up = abs(N.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
-	vec3 tangent = normalize(cross(up, N));
-	vec3 bitangent = cross(N, tangent);
-	
-	vec3 sampleVec = tangent * H.x + bitangent * H.y + N * H.z;
-
-	return normalize(sampleVec);
-}
-
-float geometrySchlickGGX(float NdotV, float roughness)
-{
-    // Note that we use a different "k" for IBL.
-    float a = roughness;
-    float k = (a * a) / 2.0;
-
-    float numerator = NdotV;
-    float denominator = NdotV * (1.0 - k) + k;
-
-    return numerator / denominator;
-}
-
-float geometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
-{
-    float NdotV = max(dot(N, V), 0.0);
-    float NdotL = max(dot(N, L), 0.0);
-
-    float numerator = geometrySchlickGGX(NdotV, roughness);
-    float denominator = geometrySchlickGGX(NdotL, roughness);
-
-    return numerator * denominator;
-}
-
-vec2 integrateBRDF(float NdotV, float roughness)
-{
-    vec3 V;
-
-    V.x = sqrt(1.0 - NdotV * NdotV);
-    V.y = 0.0;
-    V.z = NdotV;
-
-    float A = 0.0;
-    float B = 0.0;
-
-    vec3 N = vec3(0.0, 0.0, 1.0);
-    
-    const uint SAMPLE_COUNT = 1024u;
-
-    for(uint i = 0u; i < SAMPLE_COUNT; ++i)
-    {
-        // Generates a sample vector that's biased towards the preferred alignment direction (importance sampling).
-        vec2 Xi = hammersley(i, SAMPLE_COUNT);
-        vec3 H = importanceSampleGGX(Xi, N, roughness);
-        vec3 L = normalize(2.0 * dot(V, H) * H - V);
-
-        float NdotL = max(L.z, 0.0);
-        float NdotH = max(H.z, 0.0);
-        float VdotH = max(dot(V, H), 0.0);
-
-        if(NdotL > 0.0)
-        {
-            float G = geometrySmith(N, V, L, roughness);
-            float Gvis = (G * VdotH) / (NdotH * NdotV);
-            float Fc = pow(1.0 - VdotH, 5.0);
-
-            A += (1.0 - Fc) * Gvis;
-            B += Fc * Gvis;
-        }
-    }
-
-    A /= float(SAMPLE_COUNT);
-    B /= float(SAMPLE_COUNT);
-
-    return vec2(A, B);
-}
+#include "include/ibl_convolution.glsl"
 
 void main() 
 {
-    vec2 integratedBRDF = integrateBRDF(ioTexCoords.x, ioTexCoords.y);
+    vec2 integratedBRDF = integrateBRDF(ioTexCoords.x, ioTexCoords.y, 1024u);
 
     oFragColor = integratedBRDF;
 }
@@ -0,0 +1,30 @@
+#version 450 core
+
+// Compute version of "4_prefilter_convolution_fs.glsl", the six faces of one mip level per dispatch.
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (rgba16f, binding = 0) uniform writeonly imageCube uPrefilterImage; // Bound at the mip level written.
+
+uniform samplerCube uEnvironmentMap;
+uniform int uFirstSample;
+uniform int uSampleCount;
+uniform float uInverseTotalWeight;
+uniform ivec3 uTexelOffset; // First texel and face of the dispatch, zero unless baked a tile at a time.
+
+#include "include/ibl_convolution.glsl"
+#include "include/prefilter_samples.glsl"
+
+void main()
+{
+    ivec3 texel = ivec3(gl_GlobalInvocationID) + uTexelOffset;
+    int size = imageSize(uPrefilterImage).x;
+
+    if (texel.x >= size || texel.y >= size)
+    {
+        return;
+    }
+
+    vec3 prefilteredColor = prefilterEnvironment(uEnvironmentMap, getCubeMapTexelDirection(texel, size), uFirstSample, uSampleCount, uInverseTotalWeight);
+
+    imageStore(uPrefilterImage, texel, vec4(prefilteredColor, 1.0));
+}
@@ -0,0 +1,105 @@
+#version 450 core
+
+// One invocation per cluster, see "clusteredlighting.h".
+layout (local_size_x = 128) in;
+
+#include "include/camera_block.glsl"
+
+#include "include/light_block.glsl"
+
+layout (std430, binding = 1) writeonly buffer ClusterLightCountBuffer
+{
+    uint uClusterLightCounts[];
+};
+
+layout (std430, binding = 2) writeonly buffer ClusterLightIndexBuffer
+{
+    uint uClusterLightIndices[];
+};
+
+// View space position and radius of the batch of lights tested by the whole group.
+shared vec4 sLights[128];
+
+void computeClusterBounds(uint cluster, out vec3 aabbMin, out vec3 aabbMax)
+{
+    uvec3 clusterID = uvec3(cluster % uClusterGrid.x, (cluster / uClusterGrid.x) % uClusterGrid.y, cluster / (uClusterGrid.x * uClusterGrid.y));
+
+    float nearPlane = uViewport.z;
+    float farPlane = uViewport.w;
+
+    // Corners of the screen tile, on the near plane.
+    vec2 ndcMin = vec2(clusterID.xy) / vec2(uClusterGrid.xy) * 2.0 - 1.0;
+    vec2 ndcMax = vec2(clusterID.xy + 1) / vec2(uClusterGrid.xy) * 2.0 - 1.0;
+
+    vec4 cornerMin = uInverseProjection * vec4(ndcMin, -1.0, 1.0);
+    vec4 cornerMax = uInverseProjection * vec4(ndcMax, -1.0, 1.0);
+
+    vec3 nearMin = cornerMin.xyz / cornerMin.w;
+    vec3 nearMax = cornerMax.xyz / cornerMax.w;
+
+    // Depth range of the slice, then the corners moved along their view rays to both ends of it.
+    float sliceNear = nearPlane * pow(farPlane / nearPlane, float(clusterID.z) / float(uClusterGrid.z));
+    float sliceFar = nearPlane * pow(farPlane / nearPlane, float(clusterID.z + 1) / float(uClusterGrid.z));
+
+    vec3 corner0 = nearMin * (sliceNear / nearPlane);
+    vec3 corner1 = nearMin * (sliceFar / nearPlane);
+    vec3 corner2 = nearMax * (sliceNear / nearPlane);
+    vec3 corner3 = nearMax * (sliceFar / nearPlane);
+
+    aabbMin = min(min(corner0, corner1), min(corner2, corner3));
+    aabbMax = max(max(corner0, corner1), max(corner2, corner3));
+}
+
+void main()
+{
+    uint cluster = gl_GlobalInvocationID.x;
+    uint numberOfClusters = uClusterGrid.x * uClusterGrid.y * uClusterGrid.z;
+    uint maxLightsPerCluster = uClusterGrid.w;
+    uint numberOfLights = uint(uLightCount.x);
+
+    bool validCluster = cluster < numberOfClusters;
+
+    vec3 aabbMin = vec3(0.0);
+    vec3 aabbMax = vec3(0.0);
+
+    if (validCluster)
+    {
+        computeClusterBounds(cluster, aabbMin, aabbMax);
+    }
+
+    uint count = 0;
+
+    for (uint batch = 0; batch < numberOfLights; batch += 128)
+    {
+        uint lightIndex = batch + gl_LocalInvocationIndex;
+
+        if (lightIndex < numberOfLights)
+        {
+            vec4 light = uLights[lightIndex].positionRadius;
+
+            sLights[gl_LocalInvocationIndex] = vec4((uView * vec4(light.xyz, 1.0)).xyz, light.w);
+        }
+
+        barrier();
+
+        uint batchSize = min(128, numberOfLights - batch);
+
+        for (uint i = 0; validCluster && i < batchSize && count < maxLightsPerCluster; ++i)
+        {
+            vec3 offset = clamp(sLights[i].xyz, aabbMin, aabbMax) - sLights[i].xyz;
+
+            if (dot(offset, offset) <= sLights[i].w * sLights[i].w)
+            {
+                uClusterLightIndices[cluster * maxLightsPerCluster + count] = batch + i;
+                count++;
+            }
+        }
+
+        barrier();
+    }
+
+    if (validCluster)
+    {
+        uClusterLightCounts[cluster] = count;
+    }
+}
@@ -0,0 +1,50 @@
+#version 450 core
+
+// One invocation per texel of the level written, see "objectculling.h".
+layout (local_size_x = 8, local_size_y = 8) in;
+
+// Depth buffer for the first level, the previous level of the pyramid for the others.
+uniform sampler2D uSourceDepth;
+uniform int uSourceLevel;
+
+layout (r32f, binding = 0) uniform writeonly image2D uDestination;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 destinationSize = imageSize(uDestination);
+
+    if (any(greaterThanEqual(texel, destinationSize)))
+    {
+        return;
+    }
+
+    ivec2 sourceSize = textureSize(uSourceDepth, uSourceLevel);
+    ivec2 base = texel * 2;
+
+    // The last texel of a level halved from an odd size also covers the extra row or column, so no depth is skipped.
+    ivec2 extent = ivec2(1);
+
+    if (texel.x == destinationSize.x - 1 && (sourceSize.x & 1) != 0)
+    {
+        extent.x = 2;
+    }
+
+    if (texel.y == destinationSize.y - 1 && (sourceSize.y & 1) != 0)
+    {
+        extent.y = 2;
+    }
+
+    // Farthest depth of the texels below.
+    float depth = 0.0;
+
+    for (int y = 0; y <= extent.y; ++y)
+    {
+        for (int x = 0; x <= extent.x; ++x)
+        {
+            depth = max(depth, texelFetch(uSourceDepth, min(base + ivec2(x, y), sourceSize - 1), uSourceLevel).r);
+        }
+    }
+
+    imageStore(uDestination, texel, vec4(depth));
+}
@@ -0,0 +1,112 @@
+#version 450 core
+
+// One invocation per object left by the frustum test, see "objectculling.h".
+layout (local_size_x = 64) in;
+
+#include "include/camera_block.glsl"
+
+layout (std430, binding = 3) readonly buffer ObjectBoundsBuffer
+{
+    vec4 uObjectBounds[]; // xyz = world space center, w = radius.
+};
+
+layout (std430, binding = 4) readonly buffer ObjectCandidateBuffer
+{
+    uint uCandidates[];
+};
+
+layout (std430, binding = 5) readonly buffer ObjectInstanceBuffer
+{
+    vec4 uInstances[];
+};
+
+layout (std430, binding = 6) writeonly buffer VisibleInstanceBuffer
+{
+    vec4 uVisibleInstances[];
+};
+
+// "DrawElementsCommand" in "uniformblocks.h", the instance count being reset before every dispatch.
+layout (std430, binding = 7) buffer DrawCommandBuffer
+{
+    uint uIndexCount;
+    uint uInstanceCount;
+    uint uFirstIndex;
+    int  uBaseVertex;
+    uint uBaseInstance;
+};
+
+uniform int uNumberOfCandidates;
+uniform int uInstanceStride; // In vec4.
+
+uniform bool uOcclusionCulling;
+uniform sampler2D uDepthPyramid; // Farthest depth of the previous frame, the first level being half the viewport.
+uniform mat4 uDepthPyramidViewProjection; // Camera of the previous frame, which the pyramid was built from.
+
+bool isOccluded(vec4 sphere)
+{
+    vec2 uvMin = vec2(1.0);
+    vec2 uvMax = vec2(0.0);
+    float nearestDepth = 1.0;
+
+    // Screen space bounds of the box around the sphere, in the view of the pyramid: the current camera would compare
+    // the depth of the sphere with the depth of other pixels once it moved.
+    for (int i = 0; i < 8; ++i)
+    {
+        vec3 corner = sphere.xyz + sphere.w * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = uDepthPyramidViewProjection * vec4(corner, 1.0);
+
+        // Crossing the near plane, nothing can be in front of it.
+        if (clip.w <= 0.0 || clip.z < -clip.w)
+        {
+            return false;
+        }
+
+        vec3 ndc = clip.xyz / clip.w;
+
+        uvMin = min(uvMin, ndc.xy * 0.5 + 0.5);
+        uvMax = max(uvMax, ndc.xy * 0.5 + 0.5);
+        nearestDepth = min(nearestDepth, ndc.z * 0.5 + 0.5);
+    }
+
+    vec2 pixelMin = clamp(uvMin, 0.0, 1.0) * uViewport.xy;
+    vec2 pixelMax = clamp(uvMax, 0.0, 1.0) * uViewport.xy;
+
+    // Level whose texels (2^(level + 1) pixels wide) are at least as large as the bounds, which then overlap 2x2 of them at most.
+    float extent = max(pixelMax.x - pixelMin.x, pixelMax.y - pixelMin.y);
+    int level = clamp(int(ceil(log2(max(extent, 1.0)))) - 1, 0, textureQueryLevels(uDepthPyramid) - 1);
+
+    ivec2 lastTexel = textureSize(uDepthPyramid, level) - 1;
+    ivec2 texelMin = min(ivec2(pixelMin) >> (level + 1), lastTexel);
+    ivec2 texelMax = min(ivec2(pixelMax) >> (level + 1), lastTexel);
+
+    float farthestDepth = max(max(texelFetch(uDepthPyramid, texelMin, level).r, texelFetch(uDepthPyramid, ivec2(texelMax.x, texelMin.y), level).r),
+                              max(texelFetch(uDepthPyramid, ivec2(texelMin.x, texelMax.y), level).r, texelFetch(uDepthPyramid, texelMax, level).r));
+
+    return nearestDepth > farthestDepth;
+}
+
+void main()
+{
+    uint candidate = gl_GlobalInvocationID.x;
+
+    if (candidate >= uint(uNumberOfCandidates))
+    {
+        return;
+    }
+
+    uint object = uCandidates[candidate];
+
+    if (uOcclusionCulling && isOccluded(uObjectBounds[object]))
+    {
+        return;
+    }
+
+    uint slot = atomicAdd(uInstanceCount, 1);
+
+    uint stride = uint(uInstanceStride);
+
+    for (uint i = 0; i < stride; ++i)
+    {
+        uVisibleInstances[slot * stride + i] = uInstances[object * stride + i];
+    }
+}
@@ -0,0 +1,26 @@
+#version 450 core
+
+in vec3 ioWorldPos;
+in vec3 ioNormal;
+in vec2 ioTexCoords;
+flat in vec3 ioMaterial; // x = metallic, y = roughness (negative to sample the material maps), z = material layer.
+
+out vec4 oFragColor;
+
+// Permutations of "2_pbr_texturized_fs.glsl" plus PROBE_CAPTURE (see "createPBRShader"): seen from the probe and lit
+// by every light, the clusters being the ones of the camera.
+#include "include/pbr_material.glsl"
+#include "include/pbr_lighting.glsl"
+
+void main()
+{
+    vec3  albedo, normal;
+    float metallic, roughness, ao;
+
+    getSurface(albedo, normal, metallic, roughness, ao);
+
+    vec3 color = shadeSurface(ioWorldPos, ioWorldPos, normal, albedo, metallic, roughness, ao);
+
+    // HDR, tonemapped after sampling the probe. Alpha tells the spheres from the background left to the environment.
+    oFragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,54 @@
+#version 450 core
+
+// Layered capture of a reflection probe: every triangle is emitted to each face of the capture cubemap it reaches,
+// one invocation per face, "gl_Layer" selecting the face.
+layout (triangles, invocations = 6) in;
+layout (triangle_strip, max_vertices = 3) out;
+
+in vec3 ioCaptureWorldPos[];
+in vec3 ioCaptureNormal[];
+in vec2 ioCaptureTexCoords[];
+flat in vec3 ioCaptureMaterial[];
+
+out vec3 ioWorldPos;
+out vec3 ioNormal;
+out vec2 ioTexCoords;
+flat out vec3 ioMaterial;
+
+uniform mat4 uCaptureViewProjections[6]; // Per face, from the position of the probe.
+
+void main()
+{
+    vec4 clipPos[3];
+
+    for (int i = 0; i < 3; ++i)
+    {
+        clipPos[i] = uCaptureViewProjections[gl_InvocationID] * vec4(ioCaptureWorldPos[i], 1.0);
+    }
+
+    // Triangles entirely on the outer side of a frustum plane of the face aren't emitted to it, most of them only
+    // reaching one or two faces.
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if ((clipPos[0][axis] < -clipPos[0].w && clipPos[1][axis] < -clipPos[1].w && clipPos[2][axis] < -clipPos[2].w)
+            || (clipPos[0][axis] > clipPos[0].w && clipPos[1][axis] > clipPos[1].w && clipPos[2][axis] > clipPos[2].w))
+        {
+            return;
+        }
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        gl_Layer = gl_InvocationID;
+        gl_Position = clipPos[i];
+
+        ioWorldPos = ioCaptureWorldPos[i];
+        ioNormal = ioCaptureNormal[i];
+        ioTexCoords = ioCaptureTexCoords[i];
+        ioMaterial = ioCaptureMaterial[i];
+
+        EmitVertex();
+    }
+
+    EndPrimitive();
+}
@@ -0,0 +1,24 @@
+#version 450 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+// Per instance, see "SphereInstance" in "program.cpp".
+layout (location = 3)  in mat4 aModel;        // Locations 3 to 6.
+layout (location = 7)  in mat3 aNormalMatrix; // Locations 7 to 9.
+layout (location = 10) in vec4 aMaterial;     // x = metallic, y = roughness (negative to sample the material maps), z = material layer.
+
+// World space only, projected once per face by "7_reflection_probe_capture_gs.glsl".
+out vec3 ioCaptureWorldPos;
+out vec3 ioCaptureNormal;
+out vec2 ioCaptureTexCoords;
+flat out vec3 ioCaptureMaterial;
+
+void main()
+{
+    ioCaptureWorldPos = vec3(aModel * vec4(aPos, 1.0));
+    ioCaptureNormal = aNormalMatrix * aNormal;
+    ioCaptureTexCoords = aTexCoords;
+    ioCaptureMaterial = aMaterial.xyz;
+}
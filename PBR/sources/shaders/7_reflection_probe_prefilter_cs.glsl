@@ -0,0 +1,32 @@
+#version 450 core
+
+// "4_prefilter_convolution_cs.glsl" for a reflection probe: from its capture into its cubemap of the probe atlas,
+// the six faces of one mip level per dispatch.
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (rgba16f, binding = 0) uniform writeonly imageCubeArray uProbeImage; // Bound at the mip level written.
+
+uniform samplerCube uCaptureMap;
+uniform int uProbe; // Cubemap of the atlas written.
+uniform int uFirstSample;
+uniform int uSampleCount;
+uniform float uInverseTotalWeight;
+
+#include "include/ibl_convolution.glsl"
+#include "include/prefilter_samples.glsl"
+
+void main()
+{
+    ivec3 texel = ivec3(gl_GlobalInvocationID);
+    int size = imageSize(uProbeImage).x;
+
+    if (texel.x >= size || texel.y >= size)
+    {
+        return;
+    }
+
+    vec3 prefilteredColor = prefilterEnvironment(uCaptureMap, getCubeMapTexelDirection(texel, size), uFirstSample, uSampleCount, uInverseTotalWeight);
+
+    // Layer-faces of a cubemap array, "6 * cubemap + face".
+    imageStore(uProbeImage, ivec3(texel.xy, 6 * uProbe + texel.z), vec4(prefilteredColor, 1.0));
+}
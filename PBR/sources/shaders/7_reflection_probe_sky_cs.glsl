@@ -0,0 +1,27 @@
+#version 450 core
+
+// Background of a reflection probe capture: the texels no object covered (alpha still zero) take the environment,
+// the six faces in a single dispatch ("gl_GlobalInvocationID.z" being the face).
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (rgba16f, binding = 0) uniform imageCube uCaptureImage;
+
+uniform samplerCube uEnvironmentMap;
+uniform float uEnvironmentLod; // Level whose texels are the size of the capture ones.
+
+#include "include/ibl_convolution.glsl"
+
+void main()
+{
+    ivec3 texel = ivec3(gl_GlobalInvocationID);
+    int size = imageSize(uCaptureImage).x;
+
+    if (texel.x >= size || texel.y >= size || imageLoad(uCaptureImage, texel).a > 0.0)
+    {
+        return;
+    }
+
+    vec3 color = textureLod(uEnvironmentMap, getCubeMapTexelDirection(texel, size), uEnvironmentLod).rgb;
+
+    imageStore(uCaptureImage, texel, vec4(color, 1.0));
+}
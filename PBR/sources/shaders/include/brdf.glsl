@@ -0,0 +1,64 @@
+// Cook-Torrance terms shared by the shading and the IBL precomputation passes.
+#include "constants.glsl"
+
+float distributionGGX(vec3 N, vec3 H, float roughness)
+{
+    float a1 = roughness * roughness;
+    float a2 = a1 * a1;
+    float NdotH1 = max(dot(N, H), 0.0);
+    float NdotH2 = NdotH1 * NdotH1;
+
+    float numerator = a2;
+    float denominator = (NdotH2 * (a2 - 1.0) + 1.0);
+
+    denominator = PI * denominator * denominator;
+
+    return numerator / denominator;
+}
+
+float geometrySchlickGGX(float NdotV, float k)
+{
+    float numerator = NdotV;
+    float denominator = NdotV * (1.0 - k) + k;
+
+    return numerator / denominator;
+}
+
+float geometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
+{
+    float NdotV = max(dot(N, V), 0.0);
+    float NdotL = max(dot(N, L), 0.0);
+
+    // Remapping for direct lighting.
+    float r = (roughness + 1.0);
+    float k = (r * r) / 8.0;
+
+    float numerator = geometrySchlickGGX(NdotV, k);
+    float denominator = geometrySchlickGGX(NdotL, k);
+
+    return numerator * denominator;
+}
+
+float geometrySmithIBL(vec3 N, vec3 V, vec3 L, float roughness)
+{
+    float NdotV = max(dot(N, V), 0.0);
+    float NdotL = max(dot(N, L), 0.0);
+
+    // Note that we use a different "k" for IBL.
+    float k = (roughness * roughness) / 2.0;
+
+    float numerator = geometrySchlickGGX(NdotV, k);
+    float denominator = geometrySchlickGGX(NdotL, k);
+
+    return numerator * denominator;
+}
+
+vec3 fresnelSchlick(vec3 F0, float cosTheta)
+{
+    return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+
+vec3 fresnelSchlickRoughness(float cosTheta, float roughness, vec3 F0)
+{
+    return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
@@ -0,0 +1,9 @@
+// Shared by every program, see "CameraData" in "uniformblocks.h".
+layout (std140, binding = 0) uniform CameraBlock
+{
+    mat4 uProjection;
+    mat4 uView;
+    mat4 uInverseProjection;
+    vec4 uCameraPos; // w unused.
+    vec4 uViewport;  // xy = size in pixels, z = near plane, w = far plane.
+};
@@ -0,0 +1,25 @@
+// Lights binned per cluster by "5_cluster_light_culling_cs.glsl", read by the shading passes.
+#include "camera_block.glsl"
+#include "light_block.glsl"
+
+layout (std430, binding = 1) readonly buffer ClusterLightCountBuffer
+{
+    uint uClusterLightCounts[];
+};
+
+layout (std430, binding = 2) readonly buffer ClusterLightIndexBuffer
+{
+    uint uClusterLightIndices[];
+};
+
+uint getClusterIndex(vec3 worldPos)
+{
+    float viewDepth = -(uView * vec4(worldPos, 1.0)).z;
+
+    uvec3 clusterID;
+    clusterID.xy = uvec2(gl_FragCoord.xy / uViewport.xy * vec2(uClusterGrid.xy));
+    clusterID.z = uint(max(log(viewDepth) * uClusterDepth.x + uClusterDepth.y, 0.0));
+    clusterID = min(clusterID, uClusterGrid.xyz - 1);
+
+    return clusterID.x + uClusterGrid.x * (clusterID.y + uClusterGrid.y * clusterID.z);
+}
@@ -0,0 +1,25 @@
+// Encoding of the G-buffer of the deferred path, see "gbuffer.h".
+
+// Unit vector to [0, 1]^2: projected on the octahedron |x| + |y| + |z| = 1, whose lower half is folded over the upper one.
+vec2 encodeOctahedral(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+
+    vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    vec2 folded = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signs;
+
+    return folded * 0.5 + 0.5;
+}
+
+vec3 decodeOctahedral(vec2 encoded)
+{
+    encoded = encoded * 2.0 - 1.0;
+
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-n.z, 0.0);
+
+    n.x += n.x >= 0.0 ? -fold : fold;
+    n.y += n.y >= 0.0 ? -fold : fold;
+
+    return normalize(n);
+}
@@ -0,0 +1,103 @@
+// Integrals of the IBL precomputation, shared by the raster passes ("3_*_fs.glsl", "4_*_fs.glsl") and their compute versions.
+#include "brdf.glsl"
+#include "sampling.glsl"
+
+const vec2 invatan = vec2(0.1591, 0.3183); // Inverse of "atan".
+
+vec2 sampleSphericalMap(vec3 v)
+{
+    vec2 uv = vec2(atan(v.z, v.x), asin(v.y));
+
+    uv *= invatan;
+    uv += 0.5;
+
+    return uv;
+}
+
+// "normal" acts as the normal of a tangent surface from the origin: all the incoming radiance of the environment
+// over its hemisphere, which is the radiance of light coming from -normal used in the PBR shader to sample irradiance.
+vec3 convolveIrradiance(samplerCube environmentMap, vec3 normal, float sampleDelta)
+{
+    vec3 irradiance = vec3(0.0);
+
+    // Tangent space calculation from origin point.
+    vec3 up    = vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(up, normal));
+    up         = normalize(cross(normal, right));
+
+    float nSamples = 0.0;
+
+    for(float phi = 0.0; phi < 2.0 * PI; phi += sampleDelta)
+    {
+        for(float theta = 0.0; theta < 0.5 * PI; theta += sampleDelta)
+        {
+            vec3 tangentSample = vec3(sin(theta) * cos(phi),  sin(theta) * sin(phi), cos(theta)); // Spherical to cartesian (in tangent space).
+            vec3 worldSample = tangentSample.x * right + tangentSample.y * up + tangentSample.z * normal; // Tangent space to world.
+
+            irradiance += textureLod(environmentMap, worldSample, 0.0).rgb * cos(theta) * sin(theta);
+
+            nSamples++;
+        }
+    }
+
+    return PI * irradiance * (1.0 / float(nSamples));
+}
+
+// Scale and bias of F0 of the split sum approximation.
+vec2 integrateBRDF(float NdotV, float roughness, uint sampleCount)
+{
+    vec3 V;
+
+    V.x = sqrt(1.0 - NdotV * NdotV);
+    V.y = 0.0;
+    V.z = NdotV;
+
+    float A = 0.0;
+    float B = 0.0;
+
+    vec3 N = vec3(0.0, 0.0, 1.0);
+
+    for(uint i = 0u; i < sampleCount; ++i)
+    {
+        // Generates a sample vector that's biased towards the preferred alignment direction (importance sampling).
+        vec2 Xi = hammersley(i, sampleCount);
+        vec3 H = importanceSampleGGX(Xi, N, roughness);
+        vec3 L = normalize(2.0 * dot(V, H) * H - V);
+
+        float NdotL = max(L.z, 0.0);
+        float NdotH = max(H.z, 0.0);
+        float VdotH = max(dot(V, H), 0.0);
+
+        if(NdotL > 0.0)
+        {
+            float G = geometrySmithIBL(N, V, L, roughness);
+            float Gvis = (G * VdotH) / (NdotH * NdotV);
+            float Fc = pow(1.0 - VdotH, 5.0);
+
+            A += (1.0 - Fc) * Gvis;
+            B += Fc * Gvis;
+        }
+    }
+
+    A /= float(sampleCount);
+    B /= float(sampleCount);
+
+    return vec2(A, B);
+}
+
+// Direction through the center of a texel of a cubemap face, "texel.z" being the face (the layer of a cube image).
+// Inverse of the major axis selection in the OpenGL specification (table 8.19), like "IBLBaker::getTexelDirection".
+vec3 getCubeMapTexelDirection(ivec3 texel, int size)
+{
+    vec2 uv = (vec2(texel.xy) + 0.5) / float(size) * 2.0 - 1.0;
+
+    switch (texel.z)
+    {
+    case 0:  return normalize(vec3( 1.0, -uv.y, -uv.x));
+    case 1:  return normalize(vec3(-1.0, -uv.y,  uv.x));
+    case 2:  return normalize(vec3( uv.x,  1.0,  uv.y));
+    case 3:  return normalize(vec3( uv.x, -1.0, -uv.y));
+    case 4:  return normalize(vec3( uv.x, -uv.y,  1.0));
+    default: return normalize(vec3(-uv.x, -uv.y, -1.0));
+    }
+}
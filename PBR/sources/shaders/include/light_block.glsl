@@ -0,0 +1,18 @@
+// Shared by every program, see "LightData" in "uniformblocks.h".
+layout (std140, binding = 1) uniform LightBlock
+{
+    uvec4 uClusterGrid;  // xyz = number of clusters, w = maximum number of lights per cluster.
+    vec4  uClusterDepth; // x = scale, y = bias of the logarithmic depth slicing.
+    ivec4 uLightCount;   // x = number of lights.
+};
+
+struct PointLight
+{
+    vec4 positionRadius; // xyz = world space position, w = radius of influence.
+    vec4 color;
+};
+
+layout (std430, binding = 0) readonly buffer LightBuffer
+{
+    PointLight uLights[];
+};
@@ -0,0 +1,159 @@
+// Direct lighting from the clustered lights and ambient light, shared by the forward and deferred shading passes.
+//
+// Permutations IBL, IRRADIANCE_SH, REFLECTION_PROBES, PROBE_CAPTURE and MAX_LIGHTS_PER_CLUSTER, see "createPBRShader".
+// Fragment stage only, the cluster of a fragment being found from "gl_FragCoord".
+//
+#ifndef MAX_LIGHTS_PER_CLUSTER
+#define MAX_LIGHTS_PER_CLUSTER 256
+#endif
+
+#ifdef IBL
+#ifdef IRRADIANCE_SH
+uniform vec3 uIrradianceSH[9]; // Already convolved with the cosine lobe, see "sphericalharmonics.h".
+#else
+uniform samplerCube uIrradianceMap;
+#endif
+uniform samplerCube uPrefilterMap;
+uniform sampler2D uBRDFLUTMap;
+#endif
+
+#ifdef PROBE_CAPTURE
+uniform vec3 uCapturePos; // Position of the probe being captured, seen from instead of the camera.
+#endif
+
+#include "clustered_lights.glsl"
+#include "brdf.glsl"
+
+#ifdef REFLECTION_PROBES
+#include "reflection_probes.glsl"
+#endif
+
+#ifdef IRRADIANCE_SH
+vec3 evaluateIrradianceSH(vec3 N)
+{
+    vec3 irradiance = uIrradianceSH[0] * 0.282095
+                    + uIrradianceSH[1] * 0.488603 * N.y
+                    + uIrradianceSH[2] * 0.488603 * N.z
+                    + uIrradianceSH[3] * 0.488603 * N.x
+                    + uIrradianceSH[4] * 1.092548 * N.x * N.y
+                    + uIrradianceSH[5] * 1.092548 * N.y * N.z
+                    + uIrradianceSH[6] * 0.315392 * (3.0 * N.z * N.z - 1.0)
+                    + uIrradianceSH[7] * 1.092548 * N.x * N.z
+                    + uIrradianceSH[8] * 0.546274 * (N.x * N.x - N.y * N.y);
+
+    return max(irradiance, vec3(0.0));
+}
+#endif
+
+// Outgoing radiance towards the camera, in HDR (before tonemapping). "objectPos" selects the reflection probes: the
+// center of the object when the pass knows it, so the whole object blends the same probes, the fragment otherwise.
+vec3 shadeSurface(vec3 worldPos, vec3 objectPos, vec3 normal, vec3 albedo, float metallic, float roughness, float ao)
+{
+#ifdef PROBE_CAPTURE
+    vec3 V = normalize(uCapturePos - worldPos);
+#else
+    vec3 V = normalize(uCameraPos.xyz - worldPos);
+#endif
+    vec3 R = reflect(-V, normal);
+
+    // Calculate reflectance at normal incidence:
+    //
+    //  - if dia-electric (like plastic) use F0 of 0.04;
+    //  - if it's a metal, use the albedo color as F0 (metallic workflow).
+    //
+    vec3 F0 = mix(vec3(0.04), albedo, metallic);
+
+    // Reflectance equation.
+    vec3 Lo = vec3(0.0);
+
+#if MAX_LIGHTS_PER_CLUSTER > 0
+#ifdef PROBE_CAPTURE
+    // Every light, the clusters being built for the camera, not for the probe.
+    uint clusterLightCount = uint(uLightCount.x);
+#else
+    // Only the lights overlapping the cluster of this fragment, never more than the lists hold.
+    uint clusterIndex = getClusterIndex(worldPos);
+    uint clusterLightCount = min(uClusterLightCounts[clusterIndex], uint(MAX_LIGHTS_PER_CLUSTER));
+    uint clusterLightOffset = clusterIndex * uClusterGrid.w;
+#endif
+
+    for(uint i = 0; i < clusterLightCount; ++i)
+    {
+#ifdef PROBE_CAPTURE
+        PointLight light = uLights[i];
+#else
+        PointLight light = uLights[uClusterLightIndices[clusterLightOffset + i]];
+#endif
+
+        // Calculate per-light radiance.
+        vec3  L = normalize(light.positionRadius.xyz - worldPos);
+        vec3  H = normalize(V + L);
+
+        // Inverse square falloff, windowed to reach zero at the radius used for the binning.
+        float lightDistance = length(light.positionRadius.xyz - worldPos);
+        float window = clamp(1.0 - pow(lightDistance / light.positionRadius.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (lightDistance * lightDistance);
+        vec3  radiance = light.color.rgb * attenuation;
+
+        // Cook-Torrance BRDF.
+        float NDF = distributionGGX(normal, H, roughness);
+        float G = geometrySmith(normal, V, L, roughness);
+        vec3  F = fresnelSchlick(F0, clamp(dot(H, V), 0.0, 1.0));
+           
+        vec3  numerator = NDF * G * F;
+        float denominator = 4.0 * max(dot(normal, V), 0.0) * max(dot(normal, L), 0.0) + 0.0001; // + 0.0001 to prevent division by zero.
+        vec3  specular = numerator / denominator;
+
+        vec3  kS = F; // kS is equal to Fresnel.
+
+        // For energy conservation, the diffuse and specular light can't be above 1.0 (unless the surface emits light);
+        // To preserve this relationship the diffuse component (kD) should equal 1.0 - kS.
+        //
+        vec3  kD = vec3(1.0) - kS;
+
+        // Multiply kD by the inverse metalness such that only non-metals have diffuse lighting, or
+        // a linear blend if partly metal (pure metals have no diffuse light).
+        //
+        kD *= 1.0 - metallic;
+
+        float NdotL = max(dot(normal, L), 0.0); // Scale light by NdotL.
+
+        // Note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again.
+        //
+        Lo += (kD * albedo / PI + specular) * radiance * NdotL;
+    }
+#endif
+
+#ifdef IBL
+    // Ambient light, IBL approach.
+    vec3 F = fresnelSchlickRoughness(max(dot(normal, V), 0.0), roughness, F0);
+    vec3 kS = F;
+    vec3 kD = 1.0 - kS;
+
+    kD *= 1.0 - metallic;
+    
+    const float MAX_REFLECTION_LOD = 4.0;
+
+#ifdef IRRADIANCE_SH
+    vec3 irradiance = evaluateIrradianceSH(normal);
+#else
+    vec3 irradiance = texture(uIrradianceMap, normal).rgb;
+#endif
+
+    vec3 prefilteredColor = textureLod(uPrefilterMap, R, roughness * MAX_REFLECTION_LOD).rgb;    
+
+#ifdef REFLECTION_PROBES
+    prefilteredColor = sampleReflectionProbes(objectPos, worldPos, R, roughness * MAX_REFLECTION_LOD, prefilteredColor);
+#endif
+    vec2 BRDF = texture(uBRDFLUTMap, vec2(max(dot(normal, V), 0.0), roughness)).rg;
+
+    vec3 diffuse = irradiance * albedo;
+    vec3 specular = prefilteredColor * (F * BRDF.x + BRDF.y);
+    vec3 ambient = (kD * diffuse + specular) * ao;
+#else
+    // Ambient light, old version.
+    vec3 ambient = vec3(0.03) * albedo * ao;
+#endif
+
+    return ambient + Lo;
+}
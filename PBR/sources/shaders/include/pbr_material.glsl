@@ -0,0 +1,71 @@
+// Surface parameters of the sphere instances, shared by the forward and G-buffer passes.
+//
+// Reads the varyings of "2_pbr_texturized_vs.glsl" ("ioWorldPos", "ioNormal", "ioTexCoords" and "ioMaterial"),
+// which the including shader declares. Permutations MATERIAL_MAPS and PACKED_ORM, see "createPBRShader".
+//
+#ifdef MATERIAL_MAPS
+// Material parameters, one layer per material (see "materiallibrary.h").
+uniform sampler2DArray uAlbedoMaps;
+uniform sampler2DArray uNormalMaps;
+#ifdef PACKED_ORM
+uniform sampler2DArray uORMMaps; // Occlusion, roughness and metallic in RGB.
+#else
+uniform sampler2DArray uMetallicMaps;
+uniform sampler2DArray uRoughnessMaps;
+uniform sampler2DArray uAOMaps;
+#endif
+#else
+// Material parameters, used where the instance doesn't override them.
+uniform  vec3 uAlbedo;
+uniform float uMetallic;
+uniform float uRoughness;
+#endif
+
+#ifdef MATERIAL_MAPS
+vec3 getNormalFromMap()
+{
+    // Only xy are read, z is rebuilt from the unit length since BC5 compressed maps don't store it.
+    vec3 tangentNormal;
+    tangentNormal.xy = texture(uNormalMaps, vec3(ioTexCoords, ioMaterial.z)).xy * 2.0 - 1.0;
+    tangentNormal.z = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
+
+    vec3 Q1 = dFdx(ioWorldPos);
+    vec3 Q2 = dFdy(ioWorldPos);
+    vec2 ST1 = dFdx(ioTexCoords);
+    vec2 ST2 = dFdy(ioTexCoords);
+
+    vec3 N = normalize(ioNormal);
+    vec3 T = normalize(Q1 * ST2.t - Q2 * ST1.t);
+    vec3 B = normalize(cross(N, T));
+    mat3 TBN = mat3(T, -B, N);
+
+    return normalize(TBN * tangentNormal);
+}
+#endif
+
+// Linear albedo, world space normal, metallic, roughness and ambient occlusion of the fragment.
+void getSurface(out vec3 albedo, out vec3 normal, out float metallic, out float roughness, out float ao)
+{
+#ifdef MATERIAL_MAPS
+    albedo = pow(texture(uAlbedoMaps, vec3(ioTexCoords, ioMaterial.z)).rgb, vec3(2.2));
+    normal = getNormalFromMap();
+
+#ifdef PACKED_ORM
+    vec3 orm = texture(uORMMaps, vec3(ioTexCoords, ioMaterial.z)).rgb;
+
+    metallic = ioMaterial.x < 0.0 ? orm.b : ioMaterial.x;
+    roughness = ioMaterial.y < 0.0 ? orm.g : ioMaterial.y;
+    ao = orm.r;
+#else
+    metallic = ioMaterial.x < 0.0 ? texture(uMetallicMaps, vec3(ioTexCoords, ioMaterial.z)).r : ioMaterial.x;
+    roughness = ioMaterial.y < 0.0 ? texture(uRoughnessMaps, vec3(ioTexCoords, ioMaterial.z)).r : ioMaterial.y;
+    ao = texture(uAOMaps, vec3(ioTexCoords, ioMaterial.z)).r;
+#endif
+#else
+    albedo = uAlbedo;
+    normal = normalize(ioNormal);
+    metallic = ioMaterial.x < 0.0 ? uMetallic : ioMaterial.x;
+    roughness = ioMaterial.y < 0.0 ? uRoughness : ioMaterial.y;
+    ao = 1.0;
+#endif
+}
@@ -0,0 +1,29 @@
+// Prefilter convolution over the GGX samples generated by "GGXSampleTable" (sources/graphics/ggxsampletable.h).
+//
+// Every mip level reads its own range of the buffer: tangent space directions in xyz (z being the weight, NdotL)
+// and the environment mip level to read in w.
+//
+layout (std430, binding = 8) readonly buffer PrefilterSampleBuffer
+{
+    vec4 uPrefilterSamples[];
+};
+
+// The GGX lobe of a level around "N", with "V = R = N".
+vec3 prefilterEnvironment(samplerCube environmentMap, vec3 N, int firstSample, int sampleCount, float inverseTotalWeight)
+{
+    vec3 up = abs(N.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+    vec3 tangent = normalize(cross(up, N));
+    vec3 bitangent = cross(N, tangent);
+
+    vec3 prefilteredColor = vec3(0.0);
+
+    for(int i = 0; i < sampleCount; ++i)
+    {
+        vec4 tangentSample = uPrefilterSamples[firstSample + i];
+        vec3 L = tangent * tangentSample.x + bitangent * tangentSample.y + N * tangentSample.z;
+
+        prefilteredColor += textureLod(environmentMap, L, tangentSample.w).rgb * tangentSample.z;
+    }
+
+    return prefilteredColor * inverseTotalWeight;
+}
@@ -0,0 +1,85 @@
+// Local reflection probes captured by "ReflectionProbes" (sources/graphics/reflectionprobes.h), blended over the
+// prefilter map in their radius of influence.
+//
+struct ReflectionProbe
+{
+    vec4 positionRadius; // xyz = capture position, w = radius of influence.
+    vec4 boxMin;         // xyz = corner of the parallax box, w = 1 once captured, 0 before.
+    vec4 boxMax;         // w unused.
+};
+
+layout (std430, binding = 9) readonly buffer ReflectionProbeBuffer
+{
+    ReflectionProbe uReflectionProbes[];
+};
+
+uniform samplerCubeArray uReflectionProbeMaps; // One prefiltered cubemap per probe, same levels as "uPrefilterMap".
+
+// Direction from the probe to the point of its parallax box hit by "R" from "worldPos", so the reflections line up
+// with the objects captured instead of looking infinitely far. "R" as is when "worldPos" is outside the box.
+vec3 getParallaxCorrectedDirection(ReflectionProbe probe, vec3 worldPos, vec3 R)
+{
+    if (any(lessThan(worldPos, probe.boxMin.xyz)) || any(greaterThan(worldPos, probe.boxMax.xyz)))
+    {
+        return R;
+    }
+
+    // Distance to the exit point, the nearest of the far planes along each axis.
+    vec3 maxPlanes = (probe.boxMax.xyz - worldPos) / R;
+    vec3 minPlanes = (probe.boxMin.xyz - worldPos) / R;
+    vec3 farPlanes = max(maxPlanes, minPlanes);
+    float hitDistance = min(min(farPlanes.x, farPlanes.y), farPlanes.z);
+
+    return worldPos + R * hitDistance - probe.positionRadius.xyz;
+}
+
+// Prefiltered radiance along "R" from the two captured probes nearest to "objectPos", weighted by how far inside their
+// radius of influence it is. Where the weights don't add up to one, "prefilteredColor" makes up the rest.
+vec3 sampleReflectionProbes(vec3 objectPos, vec3 worldPos, vec3 R, float lod, vec3 prefilteredColor)
+{
+    int nearestProbes[2] = int[2](-1, -1);
+    float nearestWeights[2] = float[2](0.0, 0.0);
+
+    for (int i = 0; i < uReflectionProbes.length(); ++i)
+    {
+        if (uReflectionProbes[i].boxMin.w == 0.0)
+        {
+            continue;
+        }
+
+        vec4 positionRadius = uReflectionProbes[i].positionRadius;
+        float weight = clamp(1.0 - distance(objectPos, positionRadius.xyz) / positionRadius.w, 0.0, 1.0);
+
+        if (weight > nearestWeights[0])
+        {
+            nearestProbes[1] = nearestProbes[0];
+            nearestWeights[1] = nearestWeights[0];
+            nearestProbes[0] = i;
+            nearestWeights[0] = weight;
+        }
+        else if (weight > nearestWeights[1])
+        {
+            nearestProbes[1] = i;
+            nearestWeights[1] = weight;
+        }
+    }
+
+    float totalWeight = nearestWeights[0] + nearestWeights[1];
+
+    if (totalWeight == 0.0)
+    {
+        return prefilteredColor;
+    }
+
+    vec3 probeColor = vec3(0.0);
+
+    for (int n = 0; n < 2 && nearestProbes[n] >= 0; ++n)
+    {
+        vec3 direction = getParallaxCorrectedDirection(uReflectionProbes[nearestProbes[n]], worldPos, R);
+
+        probeColor += textureLod(uReflectionProbeMaps, vec4(direction, float(nearestProbes[n])), lod).rgb * nearestWeights[n];
+    }
+
+    // Normalized where the probes overlap, faded into the prefilter map towards the edge of their influence.
+    return totalWeight >= 1.0 ? probeColor / totalWeight : probeColor + prefilteredColor * (1.0 - totalWeight);
+}
@@ -0,0 +1,506 @@
+#define STB_DXT_IMPLEMENTATION
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+
+#include "bcencoder.h"
+
+#include <stbi/stb_dxt.h>
+
+// Interpolation weights of 4 bits indices, shared by BC6H and BC7.
+static const int INDEX_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Writes "numberOfBits" bits of "value" at "position", least significant bit first.
+static void writeBits(unsigned char* block, int& position, uint32_t value, int numberOfBits)
+{
+	for (int i = 0; i < numberOfBits; ++i, ++position)
+	{
+		if ((value >> i) & 1)
+		{
+			block[position >> 3] |= static_cast<unsigned char>(1 << (position & 7));
+		}
+	}
+}
+
+// Principal axis of the texels (power iteration on the covariance matrix), then their extent along it.
+template<int CHANNELS>
+static void fitEndpoints(const float (&texels)[16][4], float (&endpoint0)[4], float (&endpoint1)[4])
+{
+	float mean[4] = {};
+
+	for (int i = 0; i < 16; ++i)
+	{
+		for (int c = 0; c < CHANNELS; ++c)
+		{
+			mean[c] += texels[i][c] / 16.0f;
+		}
+	}
+
+	float covariance[4][4] = {};
+
+	for (int i = 0; i < 16; ++i)
+	{
+		for (int a = 0; a < CHANNELS; ++a)
+		{
+			for (int b = 0; b < CHANNELS; ++b)
+			{
+				covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+			}
+		}
+	}
+
+	float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	for (int iteration = 0; iteration < 8; ++iteration)
+	{
+		float next[4] = {};
+		float length = 0.0f;
+
+		for (int a = 0; a < CHANNELS; ++a)
+		{
+			for (int b = 0; b < CHANNELS; ++b)
+			{
+				next[a] += covariance[a][b] * axis[b];
+			}
+
+			length += next[a] * next[a];
+		}
+
+		if (length < 1e-12f)
+		{
+			break; // Flat block, any axis works.
+		}
+
+		length = std::sqrt(length);
+
+		for (int a = 0; a < CHANNELS; ++a)
+		{
+			axis[a] = next[a] / length;
+		}
+	}
+
+	float minProjection = 1e30f, maxProjection = -1e30f;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		float projection = 0.0f;
+
+		for (int c = 0; c < CHANNELS; ++c)
+		{
+			projection += (texels[i][c] - mean[c]) * axis[c];
+		}
+
+		minProjection = std::min(minProjection, projection);
+		maxProjection = std::max(maxProjection, projection);
+	}
+
+	for (int c = 0; c < CHANNELS; ++c)
+	{
+		endpoint0[c] = mean[c] + axis[c] * minProjection;
+		endpoint1[c] = mean[c] + axis[c] * maxProjection;
+	}
+}
+
+// Index of the closest palette entry for every texel, evaluated "SIMD_LANES" texels at a time.
+template<int CHANNELS>
+static float selectIndices(const float (&texels)[16][4], const float (&palette)[16][4], int (&indices)[16])
+{
+	float totalError = 0.0f;
+
+	for (int first = 0; first < 16; first += SIMD_LANES)
+	{
+		SIMDFloat channels[CHANNELS];
+
+		for (int c = 0; c < CHANNELS; ++c)
+		{
+			float values[SIMD_LANES];
+
+			for (int lane = 0; lane < SIMD_LANES; ++lane)
+			{
+				values[lane] = texels[std::min(first + lane, 15)][c];
+			}
+
+			channels[c] = SIMDFloat::load(values);
+		}
+
+		float bestErrors[SIMD_LANES];
+		int bestIndices[SIMD_LANES] = {};
+
+		std::fill(bestErrors, bestErrors + SIMD_LANES, 1e30f);
+
+		for (int entry = 0; entry < 16; ++entry)
+		{
+			SIMDFloat error(0.0f);
+
+			for (int c = 0; c < CHANNELS; ++c)
+			{
+				SIMDFloat difference = channels[c] - SIMDFloat(palette[entry][c]);
+
+				error += difference * difference;
+			}
+
+			float errors[SIMD_LANES];
+			error.store(errors);
+
+			for (int lane = 0; lane < SIMD_LANES; ++lane)
+			{
+				if (errors[lane] < bestErrors[lane])
+				{
+					bestErrors[lane] = errors[lane];
+					bestIndices[lane] = entry;
+				}
+			}
+		}
+
+		for (int lane = 0; lane < SIMD_LANES && first + lane < 16; ++lane)
+		{
+			indices[first + lane] = bestIndices[lane];
+			totalError += bestErrors[lane];
+		}
+	}
+
+	return totalError;
+}
+
+// Writes the 4 bits indices, the first texel being the anchor whose most significant bit is implicitly 0.
+static void writeIndices(unsigned char* block, int& position, const int (&indices)[16])
+{
+	writeBits(block, position, indices[0], 3);
+
+	for (int i = 1; i < 16; ++i)
+	{
+		writeBits(block, position, indices[i], 4);
+	}
+}
+
+size_t BCEncoder::getCompressedSize(int width, int height, int blockSize)
+{
+	return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+template<typename T, typename Encode>
+void BCEncoder::encode(const T* texels, int width, int height, int channels, unsigned char* blocks, int blockSize, ThreadPool& threadPool, const Encode& encodeBlock)
+{
+	int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+
+	threadPool.parallelFor(0, blocksY, 1, [&](int begin, int end)
+	{
+		T blockTexels[16 * 4];
+
+		for (int blockY = begin; blockY < end; ++blockY)
+		{
+			for (int blockX = 0; blockX < blocksX; ++blockX)
+			{
+				for (int y = 0; y < 4; ++y)
+				{
+					for (int x = 0; x < 4; ++x)
+					{
+						int sourceX = std::min(blockX * 4 + x, width - 1);
+						int sourceY = std::min(blockY * 4 + y, height - 1);
+
+						const T* source = &texels[(static_cast<size_t>(sourceY) * width + sourceX) * channels];
+
+						std::copy(source, source + channels, &blockTexels[(y * 4 + x) * channels]);
+					}
+				}
+
+				encodeBlock(blockTexels, &blocks[(static_cast<size_t>(blockY) * blocksX + blockX) * blockSize]);
+			}
+		}
+	});
+}
+
+void BCEncoder::encodeBC4(const unsigned char* texels, int width, int height, unsigned char* blocks, ThreadPool& threadPool)
+{
+	encode(texels, width, height, 1, blocks, 8, threadPool, encodeBC4Block);
+}
+
+void BCEncoder::encodeBC5(const unsigned char* texels, int width, int height, unsigned char* blocks, ThreadPool& threadPool)
+{
+	encode(texels, width, height, 2, blocks, 16, threadPool, encodeBC5Block);
+}
+
+void BCEncoder::encodeBC7(const unsigned char* texels, int width, int height, unsigned char* blocks, ThreadPool& threadPool)
+{
+	encode(texels, width, height, 4, blocks, 16, threadPool, encodeBC7Block);
+}
+
+void BCEncoder::encodeBC6H(const float* texels, int width, int height, unsigned char* blocks, ThreadPool& threadPool)
+{
+	encode(texels, width, height, 3, blocks, 16, threadPool, encodeBC6HBlock);
+}
+
+void BCEncoder::encodeLayer(DDSImage& image, const unsigned char* texels, int channels, bool sRGB, ThreadPool& threadPool)
+{
+	std::vector<unsigned char> level(texels, texels + static_cast<size_t>(image.width) * image.height * channels);
+	std::vector<unsigned char> nextLevel;
+
+	for (int mip = 0; mip < image.numberOfMipLevels; ++mip)
+	{
+		int width = std::max(image.width >> mip, 1), height = std::max(image.height >> mip, 1);
+
+		size_t offset = image.data.size();
+		image.data.resize(offset + DDS::getLevelSize(image, mip));
+
+		switch (image.format)
+		{
+		case DDSFormat::BC4: encodeBC4(level.data(), width, height, &image.data[offset], threadPool); break;
+		case DDSFormat::BC5: encodeBC5(level.data(), width, height, &image.data[offset], threadPool); break;
+		case DDSFormat::BC7: encodeBC7(level.data(), width, height, &image.data[offset], threadPool); break;
+
+		default:
+			std::cout << "[ERROR] BC ENCODER: Format " << uint32_t(image.format) << " expects floating point texels." << std::endl;
+
+			return;
+		}
+
+		if (mip + 1 < image.numberOfMipLevels)
+		{
+			int nextWidth = std::max(width >> 1, 1), nextHeight = std::max(height >> 1, 1);
+
+			nextLevel.resize(static_cast<size_t>(nextWidth) * nextHeight * channels);
+
+			if (sRGB)
+			{
+				stbir_resize_uint8_srgb(level.data(), width, height, 0, nextLevel.data(), nextWidth, nextHeight, 0, channels, channels == 4 ? 3 : STBIR_ALPHA_CHANNEL_NONE, 0);
+			}
+			else
+			{
+				stbir_resize_uint8(level.data(), width, height, 0, nextLevel.data(), nextWidth, nextHeight, 0, channels);
+			}
+
+			level.swap(nextLevel);
+		}
+	}
+}
+
+void BCEncoder::encodeLayer(DDSImage& image, const float* texels, ThreadPool& threadPool)
+{
+	if (image.format != DDSFormat::BC6H)
+	{
+		std::cout << "[ERROR] BC ENCODER: Floating point texels can only be encoded to BC6H." << std::endl;
+
+		return;
+	}
+
+	std::vector<float> level(texels, texels + static_cast<size_t>(image.width) * image.height * 3);
+	std::vector<float> nextLevel;
+
+	for (int mip = 0; mip < image.numberOfMipLevels; ++mip)
+	{
+		int width = std::max(image.width >> mip, 1), height = std::max(image.height >> mip, 1);
+
+		size_t offset = image.data.size();
+		image.data.resize(offset + DDS::getLevelSize(image, mip));
+
+		encodeBC6H(level.data(), width, height, &image.data[offset], threadPool);
+
+		if (mip + 1 < image.numberOfMipLevels)
+		{
+			int nextWidth = std::max(width >> 1, 1), nextHeight = std::max(height >> 1, 1);
+
+			nextLevel.resize(static_cast<size_t>(nextWidth) * nextHeight * 3);
+
+			stbir_resize_float(level.data(), width, height, 0, nextLevel.data(), nextWidth, nextHeight, 0, 3);
+
+			level.swap(nextLevel);
+		}
+	}
+}
+
+void BCEncoder::encodeBC4Block(const unsigned char* texels, unsigned char* block)
+{
+	stb_compress_bc4_block(block, texels);
+}
+
+void BCEncoder::encodeBC5Block(const unsigned char* texels, unsigned char* block)
+{
+	stb_compress_bc5_block(block, texels);
+}
+
+void BCEncoder::encodeBC7Block(const unsigned char* texels, unsigned char* block)
+{
+	float values[16][4];
+
+	for (int i = 0; i < 16; ++i)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			values[i][c] = texels[i * 4 + c];
+		}
+	}
+
+	float endpoints[2][4];
+
+	fitEndpoints<4>(values, endpoints[0], endpoints[1]);
+
+	// Mode 6 endpoints are 7 bits per channel plus a shared bit per endpoint, pick the shared bit closest to the fit.
+	int quantized[2][4];
+	int sharedBits[2];
+	float palette[16][4];
+
+	for (int e = 0; e < 2; ++e)
+	{
+		float bestError = 1e30f;
+
+		for (int bit = 0; bit < 2; ++bit)
+		{
+			int candidate[4];
+			float error = 0.0f;
+
+			for (int c = 0; c < 4; ++c)
+			{
+				candidate[c] = glm::clamp(static_cast<int>(std::round((endpoints[e][c] - bit) / 2.0f)), 0, 127);
+
+				float difference = float((candidate[c] << 1) | bit) - endpoints[e][c];
+				error += difference * difference;
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				sharedBits[e] = bit;
+
+				std::copy(candidate, candidate + 4, quantized[e]);
+			}
+		}
+	}
+
+	int expanded[2][4];
+
+	for (int e = 0; e < 2; ++e)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			expanded[e][c] = (quantized[e][c] << 1) | sharedBits[e];
+		}
+	}
+
+	for (int entry = 0; entry < 16; ++entry)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			palette[entry][c] = float(((64 - INDEX_WEIGHTS[entry]) * expanded[0][c] + INDEX_WEIGHTS[entry] * expanded[1][c] + 32) >> 6);
+		}
+	}
+
+	int indices[16];
+
+	selectIndices<4>(values, palette, indices);
+
+	// The anchor texel must use an index below 8, swapping the endpoints mirrors all the indices.
+	if (indices[0] >= 8)
+	{
+		std::swap(quantized[0], quantized[1]);
+		std::swap(sharedBits[0], sharedBits[1]);
+
+		for (int& index : indices)
+		{
+			index = 15 - index;
+		}
+	}
+
+	std::memset(block, 0, 16);
+
+	int position = 0;
+
+	writeBits(block, position, 1 << 6, 7); // Mode 6.
+
+	for (int c = 0; c < 4; ++c)
+	{
+		writeBits(block, position, quantized[0][c], 7);
+		writeBits(block, position, quantized[1][c], 7);
+	}
+
+	writeBits(block, position, sharedBits[0], 1);
+	writeBits(block, position, sharedBits[1], 1);
+
+	writeIndices(block, position, indices);
+}
+
+void BCEncoder::encodeBC6HBlock(const float* texels, unsigned char* block)
+{
+	// The hardware interpolates the half float bit patterns, a roughly logarithmic space, so the fit is done there too.
+	float values[16][4];
+
+	for (int i = 0; i < 16; ++i)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			float texel = glm::clamp(texels[i * 3 + c], 0.0f, 65504.0f);
+
+			values[i][c] = float(glm::packHalf1x16(texel));
+		}
+
+		values[i][3] = 0.0f;
+	}
+
+	float endpoints[2][4];
+
+	fitEndpoints<3>(values, endpoints[0], endpoints[1]);
+
+	// Unsigned 10 bits endpoints, unquantized as "(q << 16 + 0x8000) >> 10" and scaled by 31/64 after interpolation,
+	// so a half float "h" is best represented by "h / 31".
+	int quantized[2][3];
+	float palette[16][4] = {};
+
+	for (int e = 0; e < 2; ++e)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			quantized[e][c] = glm::clamp(static_cast<int>(std::round(endpoints[e][c] / 31.0f)), 0, 1023);
+		}
+	}
+
+	int unquantized[2][3];
+
+	for (int e = 0; e < 2; ++e)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			int q = quantized[e][c];
+
+			unquantized[e][c] = q == 0 ? 0 : (q == 1023 ? 0xFFFF : ((q << 16) + 0x8000) >> 10);
+		}
+	}
+
+	for (int entry = 0; entry < 16; ++entry)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			int interpolated = ((64 - INDEX_WEIGHTS[entry]) * unquantized[0][c] + INDEX_WEIGHTS[entry] * unquantized[1][c] + 32) >> 6;
+
+			palette[entry][c] = float((interpolated * 31) >> 6);
+		}
+	}
+
+	int indices[16];
+
+	selectIndices<3>(values, palette, indices);
+
+	if (indices[0] >= 8)
+	{
+		std::swap(quantized[0], quantized[1]);
+
+		for (int& index : indices)
+		{
+			index = 15 - index;
+		}
+	}
+
+	std::memset(block, 0, 16);
+
+	int position = 0;
+
+	writeBits(block, position, 0x03, 5); // Mode 11.
+
+	for (int c = 0; c < 3; ++c)
+	{
+		writeBits(block, position, quantized[0][c], 10);
+	}
+
+	for (int c = 0; c < 3; ++c)
+	{
+		writeBits(block, position, quantized[1][c], 10);
+	}
+
+	writeIndices(block, position, indices);
+}
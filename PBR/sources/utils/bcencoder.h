@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <stbi/stb_image_resize.h>
+
+#include "dds.h"
+#include "simd.h"
+#include "threadpool.h"
+
+// CPU block compression to the BC formats sampled natively by the GPU, 4x4 texels per 8 or 16 bytes block.
+//
+//  - BC4 (one channel) and BC5 (two channels) through "stb_dxt";
+//  - BC7 with mode 6 only (one subset, RGBA 7.7.7.7 endpoints with a shared bit, 4 bits indices);
+//  - BC6H unsigned with mode 11 only (one region, 10 bits endpoints, 4 bits indices).
+//
+// Each format uses a single partition, which keeps the encoder fast and is enough for the mostly smooth PBR maps,
+// at the cost of some quality on blocks with sharp multi-colored edges. Block rows are spread over the thread
+// pool, and the index search of BC6H/BC7 is evaluated over several texels at once with "SIMDFloat".
+//
+// Inputs are tightly packed row after row, of any size (partial blocks repeat their last texels).
+//
+// "encodeLayer" appends a layer with its whole mip chain to a "DDSImage", the smaller levels being resampled
+// from the previous one before encoding (in linear space for sRGB colors).
+//
+// Sizes of one encoded texture, mip chains included, against its uncompressed format.
+struct BCEncodingReport
+{
+	std::string name;
+	DDSFormat format;
+	size_t numberOfTexels;
+	size_t uncompressedSize, compressedSize;
+	double milliseconds;
+};
+
+class BCEncoder
+{
+public:
+	static void encodeBC4(const unsigned char* texels, int width, int height, unsigned char* blocks, ThreadPool& threadPool);
+	static void encodeBC5(const unsigned char* texels, int width, int height, unsigned char* blocks, ThreadPool& threadPool);
+	static void encodeBC7(const unsigned char* texels, int width, int height, unsigned char* blocks, ThreadPool& threadPool);
+	static void encodeBC6H(const float* texels, int width, int height, unsigned char* blocks, ThreadPool& threadPool);
+
+	// "texels" are "image.width * image.height" texels of 1, 2 or 4 channels, matching "image.format".
+	static void encodeLayer(DDSImage& image, const unsigned char* texels, int channels, bool sRGB, ThreadPool& threadPool);
+	static void encodeLayer(DDSImage& image, const float* texels, ThreadPool& threadPool); // RGB, BC6H only.
+
+	// Single block versions, "texels" holding 16 texels of 1, 2, 4 (unsigned bytes) or 3 (floats) channels.
+	static void encodeBC4Block(const unsigned char* texels, unsigned char* block);
+	static void encodeBC5Block(const unsigned char* texels, unsigned char* block);
+	static void encodeBC7Block(const unsigned char* texels, unsigned char* block);
+	static void encodeBC6HBlock(const float* texels, unsigned char* block);
+
+	static size_t getCompressedSize(int width, int height, int blockSize);
+
+private:
+	template<typename T, typename Encode>
+	static void encode(const T* texels, int width, int height, int channels, unsigned char* blocks, int blockSize, ThreadPool& threadPool, const Encode& encodeBlock);
+};
@@ -0,0 +1,180 @@
+#include "benchmark.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+BenchmarkReport::BenchmarkReport()
+	: properties(), scenes(), sections()
+{
+}
+
+void BenchmarkReport::setProperty(const std::string& name, const std::string& value)
+{
+	properties.emplace_back(name, value);
+}
+
+void BenchmarkReport::addScene(const std::string& name, const std::vector<double>& frameMilliseconds)
+{
+	if (frameMilliseconds.empty())
+	{
+		std::cout << "[ERROR] BENCHMARK: No frame recorded for scene \"" << name << "\"." << std::endl;
+
+		return;
+	}
+
+	std::vector<double> sorted = frameMilliseconds;
+	std::sort(sorted.begin(), sorted.end());
+
+	double total = 0.0;
+
+	for (double milliseconds : sorted)
+	{
+		total += milliseconds;
+	}
+
+	scenes.push_back({ name, static_cast<int>(sorted.size()), sorted.front(), total / sorted.size(), percentile(sorted, 0.5), percentile(sorted, 0.9),
+		percentile(sorted, 0.95), percentile(sorted, 0.99), sorted.back() });
+}
+
+void BenchmarkReport::addValue(const std::string& section, const std::string& name, double value)
+{
+	auto iterator = std::find_if(sections.begin(), sections.end(), [&section](const Section& entry) { return entry.name == section; });
+
+	if (iterator == sections.end())
+	{
+		sections.push_back({ section, {} });
+		iterator = sections.end() - 1;
+	}
+
+	iterator->values.push_back({ name, value });
+}
+
+void BenchmarkReport::print()
+{
+	for (const Scene& scene : scenes)
+	{
+		std::cout << "[INFO] BENCHMARK: " << scene.name << ": " << scene.numberOfFrames << " frames, min " << scene.min << " ms, avg " << scene.average << " ms, p50 "
+			<< scene.p50 << " ms, p90 " << scene.p90 << " ms, p99 " << scene.p99 << " ms, max " << scene.max << " ms." << std::endl;
+	}
+
+	for (const Section& section : sections)
+	{
+		std::cout << "[INFO] BENCHMARK: " << section.name << ":" << std::endl;
+
+		for (const Value& value : section.values)
+		{
+			std::cout << "  " << value.name << ": " << value.value << std::endl;
+		}
+	}
+}
+
+bool BenchmarkReport::write(const std::string& filepath)
+{
+	std::ofstream fileStream(filepath, std::ios::trunc);
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] BENCHMARK: Failed to create report file \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	fileStream << std::fixed << std::setprecision(3);
+	fileStream << "{\n\t\"version\": 1";
+
+	for (const auto& property : properties)
+	{
+		fileStream << ",\n\t\"" << escape(property.first) << "\": \"" << escape(property.second) << "\"";
+	}
+
+	fileStream << ",\n\t\"scenes\": [";
+
+	for (size_t i = 0; i < scenes.size(); ++i)
+	{
+		const Scene& scene = scenes[i];
+
+		fileStream << (i > 0 ? "," : "") << "\n\t\t{ \"name\": \"" << escape(scene.name) << "\", \"frames\": " << scene.numberOfFrames << ", \"min_ms\": " << scene.min
+			<< ", \"avg_ms\": " << scene.average << ", \"p50_ms\": " << scene.p50 << ", \"p90_ms\": " << scene.p90 << ", \"p95_ms\": " << scene.p95
+			<< ", \"p99_ms\": " << scene.p99 << ", \"max_ms\": " << scene.max << " }";
+	}
+
+	fileStream << "\n\t]";
+
+	for (const Section& section : sections)
+	{
+		fileStream << ",\n\t\"" << escape(section.name) << "\": {";
+
+		for (size_t i = 0; i < section.values.size(); ++i)
+		{
+			fileStream << (i > 0 ? "," : "") << "\n\t\t\"" << escape(section.values[i].name) << "\": " << section.values[i].value;
+		}
+
+		fileStream << "\n\t}";
+	}
+
+	fileStream << "\n}\n";
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] BENCHMARK: Failed to write report file \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+uint64_t BenchmarkReport::getPeakMemoryUsage()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+	}
+#elif defined(__linux__) || defined(__APPLE__)
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+#if defined(__APPLE__)
+		return static_cast<uint64_t>(usage.ru_maxrss); // Bytes on macOS.
+#else
+		return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // Kilobytes on Linux.
+#endif
+	}
+#endif
+
+	return 0;
+}
+
+double BenchmarkReport::percentile(const std::vector<double>& sorted, double fraction)
+{
+	// Nearest rank, so every reported value is a frame that actually happened.
+	size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+
+	return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+std::string BenchmarkReport::escape(const std::string& text)
+{
+	std::string escaped;
+
+	for (char character : text)
+	{
+		if (character == '"' || character == '\\')
+		{
+			escaped += '\\';
+		}
+
+		escaped += static_cast<unsigned char>(character) < 0x20 ? ' ' : character;
+	}
+
+	return escaped;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+// Results of a benchmark run, written as JSON so successive runs can be compared by a script.
+//
+// Scenes hold the duration of every frame and are reported as percentiles, the other measurements are named values
+// grouped in sections ("ibl_bake_ms", "texture_load_ms", ...). Both keep the order they were added in.
+//
+class BenchmarkReport
+{
+public:
+	BenchmarkReport();
+
+	void setProperty(const std::string& name, const std::string& value);
+
+	void addScene(const std::string& name, const std::vector<double>& frameMilliseconds);
+	void addValue(const std::string& section, const std::string& name, double value);
+
+	void print();
+	bool write(const std::string& filepath);
+
+	// Highest resident memory of the process so far, in bytes (0 when the platform doesn't report it).
+	static uint64_t getPeakMemoryUsage();
+
+private:
+	struct Scene
+	{
+		std::string name;
+		int numberOfFrames;
+		double min, average, p50, p90, p95, p99, max;
+	};
+
+	struct Value
+	{
+		std::string name;
+		double value;
+	};
+
+	struct Section
+	{
+		std::string name;
+		std::vector<Value> values;
+	};
+
+	std::vector<std::pair<std::string, std::string>> properties;
+	std::vector<Scene> scenes;
+	std::vector<Section> sections;
+
+	static double percentile(const std::vector<double>& sorted, double fraction);
+	static std::string escape(const std::string& text);
+};
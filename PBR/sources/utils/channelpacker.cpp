@@ -0,0 +1,38 @@
+#include "channelpacker.h"
+
+void ChannelPacker::interleave(const unsigned char* r, const unsigned char* g, const unsigned char* b, unsigned char a, size_t count, unsigned char* rgba)
+{
+	size_t i = 0;
+
+#if defined(SIMD_AVX) || defined(SIMD_SSE)
+	__m128i alpha = _mm_set1_epi8(static_cast<char>(a));
+
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i red = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r + i));
+		__m128i green = _mm_loadu_si128(reinterpret_cast<const __m128i*>(g + i));
+		__m128i blue = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+
+		// RG and BA byte pairs, then RGBA words.
+		__m128i redGreenLow = _mm_unpacklo_epi8(red, green);
+		__m128i redGreenHigh = _mm_unpackhi_epi8(red, green);
+		__m128i blueAlphaLow = _mm_unpacklo_epi8(blue, alpha);
+		__m128i blueAlphaHigh = _mm_unpackhi_epi8(blue, alpha);
+
+		__m128i* destination = reinterpret_cast<__m128i*>(rgba + i * 4);
+
+		_mm_storeu_si128(destination + 0, _mm_unpacklo_epi16(redGreenLow, blueAlphaLow));
+		_mm_storeu_si128(destination + 1, _mm_unpackhi_epi16(redGreenLow, blueAlphaLow));
+		_mm_storeu_si128(destination + 2, _mm_unpacklo_epi16(redGreenHigh, blueAlphaHigh));
+		_mm_storeu_si128(destination + 3, _mm_unpackhi_epi16(redGreenHigh, blueAlphaHigh));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		rgba[i * 4 + 0] = r[i];
+		rgba[i * 4 + 1] = g[i];
+		rgba[i * 4 + 2] = b[i];
+		rgba[i * 4 + 3] = a;
+	}
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+
+#include "simd.h"
+
+// Interleaves separate single channel images into one RGBA image, e.g. the occlusion, roughness and metallic maps
+// into a single ORM texture. With SSE2 the texels are interleaved 16 at a time (two rounds of byte and word unpacks),
+// the tail being done one texel at a time.
+class ChannelPacker
+{
+public:
+	// "r", "g" and "b" hold "count" texels each, "rgba" receives "count * 4" bytes, alpha being the constant "a".
+	static void interleave(const unsigned char* r, const unsigned char* g, const unsigned char* b, unsigned char a, size_t count, unsigned char* rgba);
+};
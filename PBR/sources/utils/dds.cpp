@@ -0,0 +1,196 @@
+#include "dds.h"
+
+static const uint32_t DDS_MAGIC = 0x20534444; // "DDS ".
+static const uint32_t DX10_FOURCC = 0x30315844; // "DX10".
+
+static const uint32_t DDSD_REQUIRED = 0x1 | 0x2 | 0x4 | 0x1000; // CAPS, HEIGHT, WIDTH and PIXELFORMAT.
+static const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+static const uint32_t DDSD_LINEARSIZE = 0x80000;
+static const uint32_t DDPF_FOURCC = 0x4;
+static const uint32_t DDSCAPS_COMPLEX = 0x8;
+static const uint32_t DDSCAPS_TEXTURE = 0x1000;
+static const uint32_t DDSCAPS_MIPMAP = 0x400000;
+static const uint32_t DDSCAPS2_CUBEMAP_ALL_FACES = 0xFE00;
+static const uint32_t D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+static const uint32_t D3D11_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+bool DDS::load(const std::string& filepath, DDSImage& image)
+{
+	return read(filepath, image, false);
+}
+
+bool DDS::loadHeader(const std::string& filepath, DDSImage& image)
+{
+	return read(filepath, image, true);
+}
+
+bool DDS::save(const std::string& filepath, const DDSImage& image)
+{
+	std::ofstream fileStream(filepath, std::ios::binary | std::ios::trunc);
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] DDS: Failed to create file \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	Header header = {};
+
+	header.size = sizeof(Header);
+	header.flags = DDSD_REQUIRED | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header.height = uint32_t(image.height);
+	header.width = uint32_t(image.width);
+	header.pitchOrLinearSize = uint32_t(getLevelSize(image, 0));
+	header.mipMapCount = uint32_t(image.numberOfMipLevels);
+	header.pixelFormat.size = sizeof(PixelFormat);
+	header.pixelFormat.flags = DDPF_FOURCC;
+	header.pixelFormat.fourCC = DX10_FOURCC;
+	header.caps = DDSCAPS_TEXTURE | (image.numberOfMipLevels > 1 || image.numberOfLayers > 1 ? DDSCAPS_COMPLEX : 0) | (image.numberOfMipLevels > 1 ? DDSCAPS_MIPMAP : 0);
+	header.caps2 = image.cubeMap ? DDSCAPS2_CUBEMAP_ALL_FACES : 0;
+
+	// The array size of a cubemap counts whole cubes, not faces.
+	HeaderDX10 headerDX10 = { uint32_t(image.format), D3D10_RESOURCE_DIMENSION_TEXTURE2D, image.cubeMap ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0,
+		uint32_t(image.cubeMap ? image.numberOfLayers / 6 : image.numberOfLayers), 0 };
+
+	fileStream.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+	fileStream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	fileStream.write(reinterpret_cast<const char*>(&headerDX10), sizeof(HeaderDX10));
+	fileStream.write(reinterpret_cast<const char*>(image.data.data()), image.data.size());
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] DDS: Failed to write file \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+int DDS::getBlockSize(DDSFormat format)
+{
+	return format == DDSFormat::BC4 ? 8 : 16;
+}
+
+int DDS::getGLInternalFormat(DDSFormat format)
+{
+	switch (format)
+	{
+	case DDSFormat::BC4:  return GL_COMPRESSED_RED_RGTC1;
+	case DDSFormat::BC5:  return GL_COMPRESSED_RG_RGTC2;
+	case DDSFormat::BC6H: return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+	case DDSFormat::BC7:  return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+
+	return 0;
+}
+
+int DDS::getNumberOfMipLevels(int width, int height)
+{
+	int levels = 1;
+
+	for (int size = width > height ? width : height; size > 1; size >>= 1)
+	{
+		levels++;
+	}
+
+	return levels;
+}
+
+size_t DDS::getLevelSize(const DDSImage& image, int mipLevel)
+{
+	size_t width = static_cast<size_t>(std::max(image.width >> mipLevel, 1));
+	size_t height = static_cast<size_t>(std::max(image.height >> mipLevel, 1));
+
+	return ((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(image.format);
+}
+
+size_t DDS::getLevelOffset(const DDSImage& image, int layer, int mipLevel)
+{
+	size_t offset = getLayerSize(image) * layer;
+
+	for (int mip = 0; mip < mipLevel; ++mip)
+	{
+		offset += getLevelSize(image, mip);
+	}
+
+	return offset;
+}
+
+size_t DDS::getLayerSize(const DDSImage& image)
+{
+	size_t size = 0;
+
+	for (int mip = 0; mip < image.numberOfMipLevels; ++mip)
+	{
+		size += getLevelSize(image, mip);
+	}
+
+	return size;
+}
+
+bool DDS::read(const std::string& filepath, DDSImage& image, bool headerOnly)
+{
+	std::ifstream fileStream(filepath, std::ios::binary | std::ios::ate);
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] DDS: Failed to open file \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	size_t fileSize = static_cast<size_t>(fileStream.tellg());
+
+	uint32_t magic = 0;
+	Header header = {};
+	HeaderDX10 headerDX10 = {};
+
+	fileStream.seekg(0);
+	fileStream.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+	fileStream.read(reinterpret_cast<char*>(&header), sizeof(Header));
+	fileStream.read(reinterpret_cast<char*>(&headerDX10), sizeof(HeaderDX10));
+
+	if (!fileStream || magic != DDS_MAGIC || header.size != sizeof(Header) || header.pixelFormat.fourCC != DX10_FOURCC)
+	{
+		std::cout << "[ERROR] DDS: Unsupported file \"" << filepath << "\", only DX10 headers are read." << std::endl;
+
+		return false;
+	}
+
+	DDSFormat format = static_cast<DDSFormat>(headerDX10.dxgiFormat);
+
+	if (getGLInternalFormat(format) == 0 || headerDX10.resourceDimension != D3D10_RESOURCE_DIMENSION_TEXTURE2D)
+	{
+		std::cout << "[ERROR] DDS: Unsupported format " << headerDX10.dxgiFormat << " in \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	image.format = format;
+	image.width = int(header.width);
+	image.height = int(header.height);
+	image.numberOfMipLevels = std::max(int(header.mipMapCount), 1);
+	image.cubeMap = (headerDX10.miscFlag & D3D11_RESOURCE_MISC_TEXTURECUBE) != 0;
+	image.numberOfLayers = int(std::max(headerDX10.arraySize, 1u)) * (image.cubeMap ? 6 : 1);
+	image.data.clear();
+
+	size_t dataSize = getLayerSize(image) * image.numberOfLayers;
+
+	if (fileSize < sizeof(magic) + sizeof(Header) + sizeof(HeaderDX10) + dataSize)
+	{
+		std::cout << "[ERROR] DDS: Truncated file \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	if (!headerOnly)
+	{
+		image.data.resize(dataSize);
+
+		fileStream.read(reinterpret_cast<char*>(image.data.data()), dataSize);
+	}
+
+	return true;
+}
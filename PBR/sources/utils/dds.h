@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <glad/glad.h>
+
+// Block-compressed formats, valued as their "DXGI_FORMAT".
+enum class DDSFormat : uint32_t
+{
+	BC4  = 80, // DXGI_FORMAT_BC4_UNORM
+	BC5  = 83, // DXGI_FORMAT_BC5_UNORM
+	BC6H = 95, // DXGI_FORMAT_BC6H_UF16
+	BC7  = 98  // DXGI_FORMAT_BC7_UNORM
+};
+
+// Block-compressed 2D texture, array or cubemap (6 layers in the "GL_TEXTURE_CUBE_MAP_POSITIVE_X + i" order).
+//
+// "data" holds the layers one after the other, each with its whole mip chain, as in the DDS file. The rows
+// are stored in the order they are uploaded, first row at the bottom, like every other image of the renderer.
+//
+struct DDSImage
+{
+	DDSFormat format;
+	int width, height;
+	int numberOfMipLevels;
+	int numberOfLayers;
+	bool cubeMap;
+	std::vector<unsigned char> data;
+};
+
+// DDS files with the DX10 extended header.
+class DDS
+{
+public:
+	static bool load(const std::string& filepath, DDSImage& image);
+	static bool loadHeader(const std::string& filepath, DDSImage& image); // Leaves "image.data" empty.
+	static bool save(const std::string& filepath, const DDSImage& image);
+
+	static int getBlockSize(DDSFormat format);
+	static int getGLInternalFormat(DDSFormat format);
+
+	static int getNumberOfMipLevels(int width, int height); // Full chain, down to 1x1.
+
+	static size_t getLevelSize(const DDSImage& image, int mipLevel);
+	static size_t getLevelOffset(const DDSImage& image, int layer, int mipLevel);
+	static size_t getLayerSize(const DDSImage& image);
+
+private:
+	struct PixelFormat
+	{
+		uint32_t size, flags, fourCC, rgbBitCount;
+		uint32_t rBitMask, gBitMask, bBitMask, aBitMask;
+	};
+
+	struct Header
+	{
+		uint32_t size, flags, height, width, pitchOrLinearSize, depth, mipMapCount;
+		uint32_t reserved1[11];
+		PixelFormat pixelFormat;
+		uint32_t caps, caps2, caps3, caps4, reserved2;
+	};
+
+	struct HeaderDX10
+	{
+		uint32_t dxgiFormat, resourceDimension, miscFlag, arraySize, miscFlags2;
+	};
+
+	static bool read(const std::string& filepath, DDSImage& image, bool headerOnly);
+};
@@ -0,0 +1,164 @@
+#include "filewatcher.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+FileWatcher::FileWatcher(const std::string& directory, std::chrono::milliseconds pollInterval)
+	: directory(directory), pollInterval(pollInterval), lastPoll(std::chrono::steady_clock::now()), modificationTimes(), inotifyFD(-1), watchedDirectories()
+{
+#if defined(__linux__)
+	inotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (inotifyFD >= 0)
+	{
+		addWatch(this->directory);
+
+		std::error_code error;
+
+		for (auto iterator = std::filesystem::recursive_directory_iterator(this->directory, error); iterator != std::filesystem::recursive_directory_iterator(); iterator.increment(error))
+		{
+			if (iterator->is_directory())
+			{
+				addWatch(iterator->path());
+			}
+		}
+
+		return;
+	}
+
+	std::cout << "[ERROR] FILE WATCHER: Failed to initialize inotify, polling \"" << directory << "\" instead." << std::endl;
+#endif
+
+	// First scan, so only the later changes are reported.
+	scanModificationTimes();
+}
+
+FileWatcher::~FileWatcher()
+{
+#if defined(__linux__)
+	if (inotifyFD >= 0)
+	{
+		close(inotifyFD);
+	}
+#endif
+}
+
+std::vector<std::string> FileWatcher::poll()
+{
+	if (inotifyFD >= 0)
+	{
+		return readEvents();
+	}
+
+	auto now = std::chrono::steady_clock::now();
+
+	if (now - lastPoll < pollInterval)
+	{
+		return {};
+	}
+
+	lastPoll = now;
+
+	return scanModificationTimes();
+}
+
+void FileWatcher::addWatch(const std::filesystem::path& path)
+{
+#if defined(__linux__)
+	// Editors either write the file in place or write a temporary one and rename it over the original.
+	int watchDescriptor = inotify_add_watch(inotifyFD, path.string().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+	if (watchDescriptor < 0)
+	{
+		std::cout << "[ERROR] FILE WATCHER: Failed to watch \"" << path.string() << "\"." << std::endl;
+
+		return;
+	}
+
+	watchedDirectories[watchDescriptor] = path;
+#endif
+}
+
+std::vector<std::string> FileWatcher::readEvents()
+{
+	std::vector<std::string> modifiedFiles;
+
+#if defined(__linux__)
+	alignas(inotify_event) char buffer[4096];
+
+	for (;;)
+	{
+		ssize_t length = read(inotifyFD, buffer, sizeof(buffer));
+
+		if (length <= 0)
+		{
+			break; // EAGAIN, nothing left to read.
+		}
+
+		for (ssize_t offset = 0; offset < length; )
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+
+			offset += sizeof(inotify_event) + event->len;
+
+			auto iterator = watchedDirectories.find(event->wd);
+
+			if (iterator == watchedDirectories.end() || event->len == 0)
+			{
+				continue;
+			}
+
+			std::filesystem::path path = iterator->second / event->name;
+
+			if (event->mask & IN_ISDIR)
+			{
+				if (event->mask & (IN_CREATE | IN_MOVED_TO))
+				{
+					addWatch(path);
+				}
+			}
+			else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+			{
+				std::string filepath = path.lexically_normal().generic_string();
+
+				if (std::find(modifiedFiles.begin(), modifiedFiles.end(), filepath) == modifiedFiles.end())
+				{
+					modifiedFiles.push_back(filepath);
+				}
+			}
+		}
+	}
+#endif
+
+	return modifiedFiles;
+}
+
+std::vector<std::string> FileWatcher::scanModificationTimes()
+{
+	std::vector<std::string> modifiedFiles;
+	std::error_code error;
+
+	for (auto iterator = std::filesystem::recursive_directory_iterator(directory, error); iterator != std::filesystem::recursive_directory_iterator(); iterator.increment(error))
+	{
+		if (!iterator->is_regular_file(error))
+		{
+			continue;
+		}
+
+		std::string filepath = iterator->path().lexically_normal().generic_string();
+		std::filesystem::file_time_type modificationTime = iterator->last_write_time(error);
+
+		auto previous = modificationTimes.find(filepath);
+
+		if (previous != modificationTimes.end() && previous->second != modificationTime)
+		{
+			modifiedFiles.push_back(filepath);
+		}
+
+		modificationTimes[filepath] = modificationTime;
+	}
+
+	return modifiedFiles;
+}
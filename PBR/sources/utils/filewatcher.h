@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+
+// Reports the files written under a directory (and its subdirectories) since the last "poll", without blocking.
+//
+// On Linux the changes come from inotify, so polling is only a read of the pending events. Elsewhere, or when
+// inotify can't be initialized, the modification times of every file are compared at most every "pollInterval".
+//
+class FileWatcher
+{
+public:
+	FileWatcher(const std::string& directory, std::chrono::milliseconds pollInterval = std::chrono::milliseconds(500));
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	// Paths of the modified files, as "<directory>/<relative path>" with forward slashes, each reported once.
+	std::vector<std::string> poll();
+
+private:
+	std::filesystem::path directory;
+	std::chrono::milliseconds pollInterval;
+	std::chrono::steady_clock::time_point lastPoll;
+
+	std::unordered_map<std::string, std::filesystem::file_time_type> modificationTimes;
+
+	int inotifyFD;
+	std::unordered_map<int, std::filesystem::path> watchedDirectories; // By watch descriptor.
+
+	void addWatch(const std::filesystem::path& path);
+
+	std::vector<std::string> readEvents();
+	std::vector<std::string> scanModificationTimes();
+};
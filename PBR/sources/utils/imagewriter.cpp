@@ -0,0 +1,85 @@
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+
+#include "imagewriter.h"
+
+#include <stbi/stb_image_write.h>
+
+ImageWriter::ImageWriter()
+	: running(true), numberOfWrittenImages(0)
+{
+	stbi_flip_vertically_on_write(true);
+
+	worker = std::thread(&ImageWriter::workerLoop, this);
+}
+
+ImageWriter::~ImageWriter()
+{
+	finish();
+}
+
+void ImageWriter::write(const std::string& filepath, int width, int height, int channels, std::vector<unsigned char>&& pixels)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		jobs.push({ filepath, width, height, channels, std::move(pixels) });
+	}
+
+	condition.notify_one();
+}
+
+void ImageWriter::finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		running = false;
+	}
+
+	condition.notify_one();
+
+	if (worker.joinable())
+	{
+		worker.join();
+	}
+}
+
+unsigned int ImageWriter::getNumberOfWrittenImages()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	return numberOfWrittenImages;
+}
+
+void ImageWriter::workerLoop()
+{
+	while (true)
+	{
+		Job job;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			condition.wait(lock, [this]() { return !jobs.empty() || !running; });
+
+			if (jobs.empty())
+			{
+				return; // Stopped and drained.
+			}
+
+			job = std::move(jobs.front());
+			jobs.pop();
+		}
+
+		if (!stbi_write_png(job.filepath.c_str(), job.width, job.height, job.channels, job.pixels.data(), job.width * job.channels))
+		{
+			std::cout << "[ERROR] IMAGE WRITER: Failed to write image \"" << job.filepath << "\"." << std::endl;
+
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		numberOfWrittenImages++;
+	}
+}
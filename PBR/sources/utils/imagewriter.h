@@ -0,0 +1,46 @@
+#pragma once
+
+#include <queue>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <condition_variable>
+
+// Encodes and writes PNG images on a background thread, so the render loop only pays for a copy.
+class ImageWriter
+{
+public:
+	ImageWriter();
+	~ImageWriter();
+
+	ImageWriter(const ImageWriter&) = delete;
+	ImageWriter& operator=(const ImageWriter&) = delete;
+
+	// Pixels are expected bottom row first, as returned by "glReadPixels".
+	void write(const std::string& filepath, int width, int height, int channels, std::vector<unsigned char>&& pixels);
+
+	void finish();
+
+	unsigned int getNumberOfWrittenImages();
+
+private:
+	struct Job
+	{
+		std::string filepath;
+		int width, height, channels;
+		std::vector<unsigned char> pixels;
+	};
+
+	std::thread worker;
+	std::queue<Job> jobs;
+
+	std::mutex mutex;
+	std::condition_variable condition;
+
+	bool running;
+	unsigned int numberOfWrittenImages;
+
+	void workerLoop();
+};
@@ -0,0 +1,128 @@
+#include "mappedfile.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(_WIN32)
+MappedFile::MappedFile()
+	: data(nullptr), size(0), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+{
+}
+#else
+MappedFile::MappedFile()
+	: data(nullptr), size(0), fileDescriptor(-1)
+{
+}
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& filepath)
+{
+	close();
+
+#if defined(_WIN32)
+	fileHandle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	LARGE_INTEGER fileSize;
+
+	if (fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(fileHandle, &fileSize))
+	{
+		std::cout << "[ERROR] MAPPED FILE: Failed to open file \"" << filepath << "\"." << std::endl;
+
+		close();
+
+		return false;
+	}
+
+	size = static_cast<size_t>(fileSize.QuadPart);
+
+	if (size > 0)
+	{
+		mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		data = mappingHandle ? static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+	}
+#else
+	fileDescriptor = ::open(filepath.c_str(), O_RDONLY);
+
+	struct stat fileStatus;
+
+	if (fileDescriptor < 0 || fstat(fileDescriptor, &fileStatus) != 0)
+	{
+		std::cout << "[ERROR] MAPPED FILE: Failed to open file \"" << filepath << "\"." << std::endl;
+
+		close();
+
+		return false;
+	}
+
+	size = static_cast<size_t>(fileStatus.st_size);
+
+	if (size > 0)
+	{
+		void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+		data = mapping != MAP_FAILED ? static_cast<const unsigned char*>(mapping) : nullptr;
+	}
+#endif
+
+	if (size > 0 && !data)
+	{
+		std::cout << "[ERROR] MAPPED FILE: Failed to map file \"" << filepath << "\"." << std::endl;
+
+		close();
+
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::close()
+{
+#if defined(_WIN32)
+	if (data)
+	{
+		UnmapViewOfFile(data);
+	}
+
+	if (mappingHandle)
+	{
+		CloseHandle(mappingHandle);
+	}
+
+	if (fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(fileHandle);
+	}
+
+	mappingHandle = nullptr;
+	fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (data)
+	{
+		munmap(const_cast<unsigned char*>(data), size);
+	}
+
+	if (fileDescriptor >= 0)
+	{
+		::close(fileDescriptor);
+	}
+
+	fileDescriptor = -1;
+#endif
+
+	data = nullptr;
+	size = 0;
+}
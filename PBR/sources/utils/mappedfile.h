@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <iostream>
+
+// Read-only view of a whole file mapped in memory: its pages are read from the disk (or the page cache) on first
+// access, and shared with the other mappings of the file instead of being copied into a buffer.
+//
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Maps "filepath", closing the file mapped before if any. An empty file has no data.
+	bool open(const std::string& filepath);
+	void close();
+
+	const unsigned char* getData() { return data; }
+	size_t getSize() { return size; }
+
+private:
+	const unsigned char* data;
+	size_t size;
+
+#if defined(_WIN32)
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+};
@@ -0,0 +1,354 @@
+#include "offscreencontext.h"
+
+#if defined(__linux__)
+#include <dlfcn.h>
+#include <cstring>
+
+#include <glad/glad.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+// OSMesa has no header in most distributions without its development package, only the few entry points used here.
+typedef struct osmesa_context* OSMesaContext;
+typedef void (*OSMESAproc)();
+
+#define OSMESA_FORMAT                0x22
+#define OSMESA_DEPTH_BITS            0x30
+#define OSMESA_STENCIL_BITS          0x31
+#define OSMESA_PROFILE               0x33
+#define OSMESA_CORE_PROFILE          0x34
+#define OSMESA_CONTEXT_MAJOR_VERSION 0x36
+#define OSMESA_CONTEXT_MINOR_VERSION 0x37
+
+struct OffscreenContext::EGLFunctions
+{
+	PFNEGLGETPROCADDRESSPROC getProcAddress;
+	PFNEGLQUERYSTRINGPROC queryString;
+	PFNEGLINITIALIZEPROC initialize;
+	PFNEGLTERMINATEPROC terminate;
+	PFNEGLBINDAPIPROC bindAPI;
+	PFNEGLCHOOSECONFIGPROC chooseConfig;
+	PFNEGLCREATECONTEXTPROC createContext;
+	PFNEGLDESTROYCONTEXTPROC destroyContext;
+	PFNEGLMAKECURRENTPROC makeCurrent;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay; // Extensions, null if not exposed.
+	PFNEGLQUERYDEVICESEXTPROC queryDevices;
+};
+
+struct OffscreenContext::OSMesaFunctions
+{
+	OSMesaContext (*createContextAttribs)(const int* attributes, OSMesaContext sharedContext);
+	GLboolean (*makeCurrent)(OSMesaContext context, void* buffer, GLenum type, GLsizei width, GLsizei height);
+	void (*destroyContext)(OSMesaContext context);
+	OSMESAproc (*getProcAddress)(const char* functionName);
+};
+
+// Whether the space separated "extensions" list "extension".
+static bool hasExtension(const char* extensions, const char* extension)
+{
+	size_t length = std::strlen(extension);
+
+	for (const char* start = extensions; start && *start; )
+	{
+		const char* end = std::strchr(start, ' ');
+		size_t size = end ? static_cast<size_t>(end - start) : std::strlen(start);
+
+		if (size == length && std::strncmp(start, extension, length) == 0)
+		{
+			return true;
+		}
+
+		start = end ? end + 1 : nullptr;
+	}
+
+	return false;
+}
+#else
+struct OffscreenContext::EGLFunctions {};
+struct OffscreenContext::OSMesaFunctions {};
+#endif
+
+OffscreenContext* OffscreenContext::current = nullptr;
+
+OffscreenContext::OffscreenContext()
+	: name(), library(nullptr), display(nullptr), context(nullptr), egl(nullptr), osmesa(nullptr), colorBuffer()
+{
+}
+
+OffscreenContext::~OffscreenContext()
+{
+	destroy();
+}
+
+bool OffscreenContext::create(int majorVersion, int minorVersion, bool debug)
+{
+	destroy();
+
+	if (!createEGLContext(majorVersion, minorVersion, debug) && !createOSMesaContext(majorVersion, minorVersion))
+	{
+		return false;
+	}
+
+	current = this;
+
+	return true;
+}
+
+void* OffscreenContext::getProcAddress(const char* functionName)
+{
+#if defined(__linux__)
+	if (current && current->egl)
+	{
+		return reinterpret_cast<void*>(current->egl->getProcAddress(functionName));
+	}
+
+	if (current && current->osmesa)
+	{
+		return reinterpret_cast<void*>(current->osmesa->getProcAddress(functionName));
+	}
+#endif
+
+	return nullptr;
+}
+
+bool OffscreenContext::createEGLContext(int majorVersion, int minorVersion, bool debug)
+{
+#if defined(__linux__)
+	library = dlopen("libEGL.so.1", RTLD_NOW | RTLD_LOCAL);
+
+	if (!library)
+	{
+		return false;
+	}
+
+	egl = new EGLFunctions();
+
+	egl->getProcAddress = reinterpret_cast<PFNEGLGETPROCADDRESSPROC>(dlsym(library, "eglGetProcAddress"));
+	egl->queryString = reinterpret_cast<PFNEGLQUERYSTRINGPROC>(dlsym(library, "eglQueryString"));
+	egl->initialize = reinterpret_cast<PFNEGLINITIALIZEPROC>(dlsym(library, "eglInitialize"));
+	egl->terminate = reinterpret_cast<PFNEGLTERMINATEPROC>(dlsym(library, "eglTerminate"));
+	egl->bindAPI = reinterpret_cast<PFNEGLBINDAPIPROC>(dlsym(library, "eglBindAPI"));
+	egl->chooseConfig = reinterpret_cast<PFNEGLCHOOSECONFIGPROC>(dlsym(library, "eglChooseConfig"));
+	egl->createContext = reinterpret_cast<PFNEGLCREATECONTEXTPROC>(dlsym(library, "eglCreateContext"));
+	egl->destroyContext = reinterpret_cast<PFNEGLDESTROYCONTEXTPROC>(dlsym(library, "eglDestroyContext"));
+	egl->makeCurrent = reinterpret_cast<PFNEGLMAKECURRENTPROC>(dlsym(library, "eglMakeCurrent"));
+
+	if (!egl->getProcAddress || !egl->queryString || !egl->initialize || !egl->terminate || !egl->bindAPI || !egl->chooseConfig
+		|| !egl->createContext || !egl->destroyContext || !egl->makeCurrent)
+	{
+		destroy();
+
+		return false;
+	}
+
+	egl->getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(egl->getProcAddress("eglGetPlatformDisplayEXT"));
+	egl->queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(egl->getProcAddress("eglQueryDevicesEXT"));
+
+	// Null without "EGL_EXT_client_extensions", and then there are no platforms to pick from.
+	const char* clientExtensions = egl->queryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+	if (egl->getPlatformDisplay && hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")
+		&& createEGLContext(egl->getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr), majorVersion, minorVersion, debug))
+	{
+		name = "EGL (surfaceless)";
+
+		return true;
+	}
+
+	EGLDeviceEXT devices[16];
+	EGLint numberOfDevices = 0;
+
+	if (egl->getPlatformDisplay && egl->queryDevices && hasExtension(clientExtensions, "EGL_EXT_platform_device")
+		&& egl->queryDevices(16, devices, &numberOfDevices))
+	{
+		for (EGLint i = 0; i < numberOfDevices; ++i)
+		{
+			if (createEGLContext(egl->getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[i], nullptr), majorVersion, minorVersion, debug))
+			{
+				name = "EGL (device " + std::to_string(i) + ")";
+
+				return true;
+			}
+		}
+	}
+
+	destroy();
+#endif
+
+	return false;
+}
+
+bool OffscreenContext::createEGLContext(void* display, int majorVersion, int minorVersion, bool debug)
+{
+#if defined(__linux__)
+	EGLDisplay eglDisplay = static_cast<EGLDisplay>(display);
+	EGLint eglMajorVersion, eglMinorVersion;
+
+	if (eglDisplay == EGL_NO_DISPLAY || !egl->initialize(eglDisplay, &eglMajorVersion, &eglMinorVersion))
+	{
+		return false;
+	}
+
+	const char* extensions = egl->queryString(eglDisplay, EGL_EXTENSIONS);
+
+	// Without a surface, the context is made current alone and only renders into framebuffer objects.
+	if (!hasExtension(extensions, "EGL_KHR_create_context") || !hasExtension(extensions, "EGL_KHR_surfaceless_context") || !egl->bindAPI(EGL_OPENGL_API))
+	{
+		egl->terminate(eglDisplay);
+
+		return false;
+	}
+
+	EGLConfig config = EGL_NO_CONFIG_KHR;
+
+	if (!hasExtension(extensions, "EGL_KHR_no_config_context"))
+	{
+		const EGLint configAttributes[] = { EGL_SURFACE_TYPE, 0, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+		EGLint numberOfConfigs = 0;
+
+		if (!egl->chooseConfig(eglDisplay, configAttributes, &config, 1, &numberOfConfigs) || numberOfConfigs == 0)
+		{
+			egl->terminate(eglDisplay);
+
+			return false;
+		}
+	}
+
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION_KHR, majorVersion,
+		EGL_CONTEXT_MINOR_VERSION_KHR, minorVersion,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+		EGL_CONTEXT_FLAGS_KHR, debug ? EGL_CONTEXT_OPENGL_DEBUG_BIT_KHR : 0,
+		EGL_NONE
+	};
+
+	EGLContext eglContext = egl->createContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+
+	if (eglContext == EGL_NO_CONTEXT || !egl->makeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext))
+	{
+		if (eglContext != EGL_NO_CONTEXT)
+		{
+			egl->destroyContext(eglDisplay, eglContext);
+		}
+
+		egl->terminate(eglDisplay);
+
+		return false;
+	}
+
+	this->display = eglDisplay;
+	context = eglContext;
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool OffscreenContext::createOSMesaContext(int majorVersion, int minorVersion)
+{
+#if defined(__linux__)
+	for (const char* libraryName : { "libOSMesa.so.8", "libOSMesa.so.6", "libOSMesa.so" })
+	{
+		library = dlopen(libraryName, RTLD_NOW | RTLD_LOCAL);
+
+		if (library)
+		{
+			break;
+		}
+	}
+
+	if (!library)
+	{
+		return false;
+	}
+
+	osmesa = new OSMesaFunctions();
+
+	osmesa->createContextAttribs = reinterpret_cast<OSMesaContext (*)(const int*, OSMesaContext)>(dlsym(library, "OSMesaCreateContextAttribs"));
+	osmesa->makeCurrent = reinterpret_cast<GLboolean (*)(OSMesaContext, void*, GLenum, GLsizei, GLsizei)>(dlsym(library, "OSMesaMakeCurrent"));
+	osmesa->destroyContext = reinterpret_cast<void (*)(OSMesaContext)>(dlsym(library, "OSMesaDestroyContext"));
+	osmesa->getProcAddress = reinterpret_cast<OSMESAproc (*)(const char*)>(dlsym(library, "OSMesaGetProcAddress"));
+
+	if (!osmesa->createContextAttribs || !osmesa->makeCurrent || !osmesa->destroyContext || !osmesa->getProcAddress)
+	{
+		destroy();
+
+		return false;
+	}
+
+	// The depth and stencil bits are those of the unused default framebuffer, kept small.
+	const int attributes[] = {
+		OSMESA_FORMAT, GL_RGBA,
+		OSMESA_DEPTH_BITS, 0,
+		OSMESA_STENCIL_BITS, 0,
+		OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+		OSMESA_CONTEXT_MAJOR_VERSION, majorVersion,
+		OSMESA_CONTEXT_MINOR_VERSION, minorVersion,
+		0
+	};
+
+	OSMesaContext osmesaContext = osmesa->createContextAttribs(attributes, nullptr);
+
+	if (!osmesaContext || !osmesa->makeCurrent(osmesaContext, colorBuffer, GL_UNSIGNED_BYTE, 1, 1))
+	{
+		if (osmesaContext)
+		{
+			osmesa->destroyContext(osmesaContext);
+		}
+
+		destroy();
+
+		return false;
+	}
+
+	context = osmesaContext;
+	name = "OSMesa";
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+void OffscreenContext::destroy()
+{
+#if defined(__linux__)
+	if (egl && context)
+	{
+		egl->makeCurrent(static_cast<EGLDisplay>(display), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		egl->destroyContext(static_cast<EGLDisplay>(display), static_cast<EGLContext>(context));
+	}
+
+	if (egl && display)
+	{
+		egl->terminate(static_cast<EGLDisplay>(display));
+	}
+
+	if (osmesa && context)
+	{
+		osmesa->destroyContext(static_cast<OSMesaContext>(context));
+	}
+
+	if (library)
+	{
+		dlclose(library);
+	}
+#endif
+
+	delete egl;
+	delete osmesa;
+
+	name.clear();
+	library = nullptr;
+	display = nullptr;
+	context = nullptr;
+	egl = nullptr;
+	osmesa = nullptr;
+
+	if (current == this)
+	{
+		current = nullptr;
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <iostream>
+
+// Windowless OpenGL context for the offscreen modes, so they run without a display server (e.g. a GPU-less Linux
+// box rendering with Mesa's llvmpipe). It has no default framebuffer: everything is drawn into the program's own.
+//
+// On Linux, EGL is tried first on the surfaceless platform ("EGL_MESA_platform_surfaceless"), then on every device
+// of "EGL_EXT_platform_device", and OSMesa last. Both libraries are loaded at run time, so neither is needed to build
+// the program or to run it with a window. Elsewhere "create" fails, the offscreen modes using a hidden window instead.
+//
+class OffscreenContext
+{
+public:
+	OffscreenContext();
+	~OffscreenContext();
+
+	OffscreenContext(const OffscreenContext&) = delete;
+	OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+	// Creates a core profile context of at least "majorVersion.minorVersion" and makes it current on the calling thread.
+	bool create(int majorVersion, int minorVersion, bool debug);
+
+	// How the context was created, e.g. "EGL (surfaceless)".
+	const std::string& getName() { return name; }
+
+	// Loader for "gladLoadGLLoader", once a context is current.
+	static void* getProcAddress(const char* functionName);
+
+private:
+	struct EGLFunctions;
+	struct OSMesaFunctions;
+
+	std::string name;
+	void* library;
+	void* display;                // EGLDisplay.
+	void* context;                // EGLContext or OSMesaContext.
+	EGLFunctions* egl;
+	OSMesaFunctions* osmesa;
+	unsigned char colorBuffer[4]; // OSMesa only makes a context current with a color buffer, a single texel here.
+
+	static OffscreenContext* current;
+
+	bool createEGLContext(int majorVersion, int minorVersion, bool debug);
+	bool createEGLContext(void* display, int majorVersion, int minorVersion, bool debug);
+	bool createOSMesaContext(int majorVersion, int minorVersion);
+
+	void destroy();
+};
@@ -0,0 +1,420 @@
+#include "profiler.h"
+
+thread_local Profiler::ThreadBuffer* Profiler::threadBuffer = nullptr;
+
+Profiler::CPUZone::CPUZone(const char* name)
+	: name(nullptr), start(0)
+{
+	Profiler& profiler = Profiler::getInstance();
+
+	if (profiler.isEnabled())
+	{
+		this->name = name;
+		start = profiler.now();
+	}
+}
+
+Profiler::CPUZone::~CPUZone()
+{
+	if (name)
+	{
+		Profiler& profiler = Profiler::getInstance();
+
+		profiler.record(name, start, profiler.now());
+	}
+}
+
+Profiler::GPUZone::GPUZone(const char* name)
+	: querySet(-1), zone(-1)
+{
+	Profiler::getInstance().beginGPUZone(name, querySet, zone);
+}
+
+Profiler::GPUZone::~GPUZone()
+{
+	Profiler::getInstance().endGPUZone(querySet, zone);
+}
+
+Profiler::Profiler()
+	: enabled(false), epoch(std::chrono::steady_clock::now()), threadBuffers(), querySets(), currentQuerySet(0), gpuEvents(GPU_EVENTS), numberOfGPUEvents(0),
+	droppedGPUZones(0), frameThreadBuffer(nullptr), frameEventCursor(0), zoneStatistics()
+{
+	for (QuerySet& querySet : querySets)
+	{
+		querySet.clockOffset = 0;
+		querySet.pending = false;
+	}
+}
+
+Profiler::~Profiler()
+{
+	// The queries aren't deleted, the context is gone by the time static objects are destroyed.
+}
+
+Profiler& Profiler::getInstance()
+{
+	static Profiler profiler;
+
+	return profiler;
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+	// Calibrates the GPU clock of the zones recorded before the first frame, which needs a current context.
+	if (enabled && !this->enabled)
+	{
+		GLint64 gpuTime = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+
+		querySets[currentQuerySet].clockOffset = now() - gpuTime;
+	}
+
+	this->enabled = enabled;
+}
+
+void Profiler::setThreadName(const char* name)
+{
+	ThreadBuffer* buffer = getThreadBuffer();
+
+	std::lock_guard<std::mutex> lock(threadBuffersMutex);
+
+	buffer->threadName = name;
+}
+
+void Profiler::beginFrame()
+{
+	if (!enabled)
+	{
+		return;
+	}
+
+	frameThreadBuffer = getThreadBuffer();
+
+	currentQuerySet = (currentQuerySet + 1) % FRAME_LATENCY;
+
+	for (int i = 0; i < FRAME_LATENCY; ++i)
+	{
+		if (i != currentQuerySet && querySets[i].pending)
+		{
+			resolveQuerySet(querySets[i], false);
+		}
+	}
+
+	QuerySet& querySet = querySets[currentQuerySet];
+
+	// Still not available after "FRAME_LATENCY" frames, the queries are reused rather than waited for.
+	if (querySet.pending)
+	{
+		droppedGPUZones += querySet.zones.size();
+	}
+
+	querySet.zones.clear();
+	querySet.pending = false;
+
+	GLint64 gpuTime = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+
+	querySet.clockOffset = now() - gpuTime;
+}
+
+void Profiler::endFrame()
+{
+	if (!enabled || !frameThreadBuffer)
+	{
+		return;
+	}
+
+	uint64_t count = frameThreadBuffer->count.load(std::memory_order_acquire);
+
+	// Events overwritten since the last frame are skipped.
+	frameEventCursor = std::max(frameEventCursor, count > EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD : 0);
+
+	for (; frameEventCursor < count; ++frameEventCursor)
+	{
+		const Event& event = frameThreadBuffer->events[frameEventCursor % EVENTS_PER_THREAD];
+
+		addSample(std::string("CPU ") + event.name, float(event.end - event.start) / 1e6f);
+	}
+}
+
+void Profiler::flush()
+{
+	if (!enabled)
+	{
+		return;
+	}
+
+	glFinish();
+
+	for (QuerySet& querySet : querySets)
+	{
+		if (querySet.pending)
+		{
+			resolveQuerySet(querySet, true);
+		}
+	}
+
+	endFrame();
+}
+
+bool Profiler::writeChromeTrace(const std::string& filepath)
+{
+	std::ofstream fileStream(filepath, std::ios::trunc);
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] PROFILER: Failed to create trace file \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	// Complete ("X") events in microseconds, one track per thread and one for the GPU.
+	const uint32_t gpuTrack = 1000;
+
+	auto writeEvent = [&fileStream](const Event& event, uint32_t track, const char* category)
+	{
+		fileStream << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << track
+			<< ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+	};
+
+	fileStream << std::fixed << std::setprecision(3);
+	fileStream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	fileStream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << gpuTrack << ",\"args\":{\"name\":\"GPU\"}}";
+
+	struct ThreadSnapshot
+	{
+		uint32_t threadIndex;
+		std::string threadName;
+		std::vector<Event> events; // Oldest first.
+	};
+
+	std::vector<ThreadSnapshot> snapshots;
+
+	// The rings are copied under their locks, the workers blocking on them only for the copy and not the file writes.
+	{
+		std::lock_guard<std::mutex> lock(threadBuffersMutex);
+
+		snapshots.reserve(threadBuffers.size());
+
+		for (const std::unique_ptr<ThreadBuffer>& buffer : threadBuffers)
+		{
+			ThreadSnapshot snapshot = { buffer->threadIndex, buffer->threadName, {} };
+
+			std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+
+			uint64_t count = buffer->count.load(std::memory_order_relaxed);
+
+			snapshot.events.reserve(static_cast<size_t>(std::min<uint64_t>(count, EVENTS_PER_THREAD)));
+
+			for (uint64_t i = count > EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD : 0; i < count; ++i)
+			{
+				snapshot.events.push_back(buffer->events[i % EVENTS_PER_THREAD]);
+			}
+
+			snapshots.push_back(std::move(snapshot));
+		}
+	}
+
+	uint64_t numberOfEvents = 0;
+
+	for (const ThreadSnapshot& snapshot : snapshots)
+	{
+		fileStream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << snapshot.threadIndex << ",\"args\":{\"name\":\"" << snapshot.threadName << "\"}}";
+
+		for (const Event& event : snapshot.events)
+		{
+			writeEvent(event, snapshot.threadIndex, "cpu");
+		}
+
+		numberOfEvents += snapshot.events.size();
+	}
+
+	for (uint64_t i = numberOfGPUEvents > GPU_EVENTS ? numberOfGPUEvents - GPU_EVENTS : 0; i < numberOfGPUEvents; ++i)
+	{
+		writeEvent(gpuEvents[i % GPU_EVENTS], gpuTrack, "gpu");
+	}
+
+	numberOfEvents += std::min<uint64_t>(numberOfGPUEvents, GPU_EVENTS);
+
+	fileStream << "\n]}\n";
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] PROFILER: Failed to write trace file \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	std::cout << "[INFO] PROFILER: Wrote " << numberOfEvents << " events to \"" << filepath << "\"." << std::endl;
+
+	return true;
+}
+
+void Profiler::printSummary()
+{
+	std::vector<float> sorted;
+
+	for (const auto& entry : zoneStatistics)
+	{
+		const ZoneStatistics& statistics = entry.second;
+
+		sorted.assign(statistics.milliseconds.begin(), statistics.milliseconds.begin() + std::min<uint64_t>(statistics.numberOfSamples, WINDOW_SIZE));
+		std::sort(sorted.begin(), sorted.end());
+
+		double total = 0.0;
+
+		for (float milliseconds : sorted)
+		{
+			total += milliseconds;
+		}
+
+		size_t p99 = std::min(sorted.size() - 1, static_cast<size_t>(std::ceil(0.99 * sorted.size())) - 1);
+
+		std::cout << "[INFO] PROFILER: " << entry.first << ": min " << sorted.front() << " ms, avg " << total / sorted.size() << " ms, p99 " << sorted[p99]
+			<< " ms (last " << sorted.size() << " of " << statistics.numberOfSamples << " samples)." << std::endl;
+	}
+
+	if (droppedGPUZones > 0)
+	{
+		std::cout << "[INFO] PROFILER: " << droppedGPUZones << " GPU zones dropped, their queries not being ready after " << FRAME_LATENCY << " frames." << std::endl;
+	}
+}
+
+int64_t Profiler::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+Profiler::ThreadBuffer* Profiler::getThreadBuffer()
+{
+	if (!threadBuffer)
+	{
+		std::lock_guard<std::mutex> lock(threadBuffersMutex);
+
+		std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+
+		buffer->threadIndex = static_cast<uint32_t>(threadBuffers.size());
+		buffer->threadName = "Thread " + std::to_string(buffer->threadIndex);
+		buffer->events.resize(EVENTS_PER_THREAD);
+		buffer->count = 0;
+
+		threadBuffer = buffer.get();
+		threadBuffers.push_back(std::move(buffer));
+	}
+
+	return threadBuffer;
+}
+
+void Profiler::record(const char* name, int64_t start, int64_t end)
+{
+	ThreadBuffer* buffer = getThreadBuffer();
+
+	// Single writer per buffer, the lock only keeps the export from copying the event while it's written.
+	std::lock_guard<std::mutex> lock(buffer->mutex);
+
+	uint64_t index = buffer->count.load(std::memory_order_relaxed);
+
+	buffer->events[index % EVENTS_PER_THREAD] = { name, start, end };
+	buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::beginGPUZone(const char* name, int& querySet, int& zone)
+{
+	if (!enabled)
+	{
+		return;
+	}
+
+	QuerySet& current = querySets[currentQuerySet];
+
+	size_t queryIndex = current.zones.size() * 2;
+
+	if (current.queries.size() < queryIndex + 2)
+	{
+		unsigned int queries[2];
+		glGenQueries(2, queries);
+
+		current.queries.push_back(queries[0]);
+		current.queries.push_back(queries[1]);
+	}
+
+	glQueryCounter(current.queries[queryIndex], GL_TIMESTAMP);
+
+	current.zones.push_back({ name, current.queries[queryIndex], 0 });
+	current.pending = true;
+
+	querySet = currentQuerySet;
+	zone = static_cast<int>(current.zones.size() - 1);
+}
+
+void Profiler::endGPUZone(int querySet, int zone)
+{
+	if (querySet < 0 || zone >= static_cast<int>(querySets[querySet].zones.size()))
+	{
+		return;
+	}
+
+	GPUQuery& query = querySets[querySet].zones[zone];
+
+	query.endQuery = querySets[querySet].queries[zone * 2 + 1];
+
+	glQueryCounter(query.endQuery, GL_TIMESTAMP);
+}
+
+void Profiler::resolveQuerySet(QuerySet& querySet, bool wait)
+{
+	if (!wait)
+	{
+		for (const GPUQuery& query : querySet.zones)
+		{
+			int available = GL_FALSE;
+
+			if (query.endQuery)
+			{
+				glGetQueryObjectiv(query.endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+			}
+
+			if (!available)
+			{
+				return; // Tried again next frame.
+			}
+		}
+	}
+
+	for (const GPUQuery& query : querySet.zones)
+	{
+		if (!query.endQuery)
+		{
+			continue; // Zone never closed.
+		}
+
+		GLuint64 begin = 0, end = 0;
+
+		glGetQueryObjectui64v(query.beginQuery, GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(query.endQuery, GL_QUERY_RESULT, &end);
+
+		gpuEvents[numberOfGPUEvents % GPU_EVENTS] = { query.name, int64_t(begin) + querySet.clockOffset, int64_t(end) + querySet.clockOffset };
+		numberOfGPUEvents++;
+
+		addSample(std::string("GPU ") + query.name, float(end - begin) / 1e6f);
+	}
+
+	querySet.zones.clear();
+	querySet.pending = false;
+}
+
+void Profiler::addSample(const std::string& name, float milliseconds)
+{
+	ZoneStatistics& statistics = zoneStatistics[name];
+
+	if (statistics.milliseconds.empty())
+	{
+		statistics.milliseconds.resize(WINDOW_SIZE);
+		statistics.next = 0;
+		statistics.numberOfSamples = 0;
+	}
+
+	statistics.milliseconds[statistics.next] = milliseconds;
+	statistics.next = (statistics.next + 1) % WINDOW_SIZE;
+	statistics.numberOfSamples++;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+#include <glad/glad.h>
+
+// Frame profiler with CPU zones on any thread and GPU zones on the thread owning the context.
+//
+// CPU zones are written to a buffer owned by their thread, so recording only takes the buffer's own lock, which is
+// uncontended unless a trace is being exported: the export copies every ring under its lock, so events overwritten
+// while it runs are never read half written. GPU zones are a pair of "glQueryCounter"
+// timestamps per zone, from a ring of "FRAME_LATENCY" query sets: a set is read back frames later, only if its
+// results are available, and dropped otherwise, so the CPU never waits for the GPU.
+//
+// Zone names must outlive the profiler (string literals). Everything is exported as a Chrome trace ("chrome://tracing",
+// Perfetto), and the durations of the last "WINDOW_SIZE" samples of each zone give a min/avg/p99 summary.
+//
+class Profiler
+{
+public:
+	class CPUZone
+	{
+	public:
+		CPUZone(const char* name);
+		~CPUZone();
+
+	private:
+		const char* name;
+		int64_t start;
+	};
+
+	class GPUZone
+	{
+	public:
+		GPUZone(const char* name);
+		~GPUZone();
+
+	private:
+		int querySet; // Negative when the profiler is disabled.
+		int zone;
+	};
+
+	static Profiler& getInstance();
+
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	void setEnabled(bool enabled);
+	bool isEnabled() { return enabled; }
+
+	// Names the calling thread in the trace.
+	void setThreadName(const char* name);
+
+	// Reads back the GPU zones that are available and starts a new query set. Called by the context thread.
+	void beginFrame();
+	void endFrame();
+
+	// Waits for every GPU zone still in flight, only meant for the end of a run.
+	void flush();
+
+	bool writeChromeTrace(const std::string& filepath);
+	void printSummary();
+
+private:
+	struct Event
+	{
+		const char* name;
+		int64_t start; // Nanoseconds since the creation of the profiler.
+		int64_t end;
+	};
+
+	struct ThreadBuffer
+	{
+		uint32_t threadIndex;
+		std::string threadName;
+		std::mutex mutex;          // Held by the owning thread while recording and by the export while copying.
+		std::vector<Event> events; // Ring of "EVENTS_PER_THREAD" events.
+		std::atomic<uint64_t> count;
+	};
+
+	struct GPUQuery
+	{
+		const char* name;
+		unsigned int beginQuery;
+		unsigned int endQuery;
+	};
+
+	struct QuerySet
+	{
+		std::vector<unsigned int> queries;
+		std::vector<GPUQuery> zones;
+		int64_t clockOffset; // CPU time minus GPU time when the set was started, in nanoseconds.
+		bool pending;
+	};
+
+	struct ZoneStatistics
+	{
+		std::vector<float> milliseconds; // Ring of "WINDOW_SIZE" samples.
+		size_t next;
+		uint64_t numberOfSamples;
+	};
+
+	static constexpr size_t EVENTS_PER_THREAD = 1 << 16;
+	static constexpr size_t GPU_EVENTS = 1 << 16;
+	static constexpr int FRAME_LATENCY = 3;
+	static constexpr size_t WINDOW_SIZE = 512;
+
+	std::atomic<bool> enabled;
+	std::chrono::steady_clock::time_point epoch;
+
+	std::mutex threadBuffersMutex; // Only taken by the first zone of every thread, "setThreadName" and the export.
+	std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+
+	QuerySet querySets[FRAME_LATENCY];
+	int currentQuerySet;
+
+	std::vector<Event> gpuEvents; // Ring of "GPU_EVENTS" events, context thread only.
+	uint64_t numberOfGPUEvents;
+	uint64_t droppedGPUZones;
+
+	ThreadBuffer* frameThreadBuffer; // Thread calling "beginFrame", whose zones feed the summary.
+	uint64_t frameEventCursor;
+
+	std::map<std::string, ZoneStatistics> zoneStatistics;
+
+	Profiler();
+	~Profiler();
+
+	int64_t now();
+
+	ThreadBuffer* getThreadBuffer();
+	void record(const char* name, int64_t start, int64_t end);
+
+	void beginGPUZone(const char* name, int& querySet, int& zone);
+	void endGPUZone(int querySet, int zone);
+
+	void resolveQuerySet(QuerySet& querySet, bool wait);
+	void addSample(const std::string& name, float milliseconds);
+
+	static thread_local ThreadBuffer* threadBuffer;
+};
+
+#define PROFILE_CONCATENATE_(a, b) a##b
+#define PROFILE_CONCATENATE(a, b) PROFILE_CONCATENATE_(a, b)
+
+// Profiles the rest of the enclosing scope.
+#define PROFILE_CPU(name) Profiler::CPUZone PROFILE_CONCATENATE(cpuZone, __LINE__)(name)
+#define PROFILE_GPU(name) Profiler::GPUZone PROFILE_CONCATENATE(gpuZone, __LINE__)(name)
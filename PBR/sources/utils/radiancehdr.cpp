@@ -0,0 +1,378 @@
+#include "radiancehdr.h"
+
+#include <cstdio>
+
+static const char* PIXEL_FORMAT = "FORMAT=32-bit_rle_rgbe";
+
+// Scanlines of these widths are never run-length encoded, the length being stored on 15 bits.
+static const int MIN_ENCODED_WIDTH = 8;
+static const int MAX_ENCODED_WIDTH = 32767;
+
+// "ldexp(1, exponent - (128 + 8))" for every exponent, the mantissas being 8 bits. Zero stays black.
+static const float* getExponentScales()
+{
+	static const std::vector<float> scales = []()
+	{
+		std::vector<float> exponentScales(256, 0.0f);
+
+		for (int exponent = 1; exponent < 256; ++exponent)
+		{
+			exponentScales[exponent] = static_cast<float>(std::ldexp(1.0f, exponent - (128 + 8)));
+		}
+
+		return exponentScales;
+	}();
+
+	return scales.data();
+}
+
+RadianceHDR::RadianceHDR()
+	: filepath(), file(), width(0), height(0), scanlineOffsets(), encodedScanlines()
+{
+}
+
+bool RadianceHDR::open(const std::string& filepath)
+{
+	this->filepath = filepath;
+
+	width = 0;
+	height = 0;
+	scanlineOffsets.clear();
+	encodedScanlines.clear();
+
+	size_t offset = 0;
+
+	if (!file.open(filepath) || !readHeader(offset))
+	{
+		file.close();
+
+		return false;
+	}
+
+	const unsigned char* data = file.getData();
+	size_t size = file.getSize();
+
+	auto isEncoded = [&](size_t scanlineOffset)
+	{
+		// Can't be a flat texel: the high bit of the 15 bits length would make one of its channels at least 128.
+		return scanlineOffset + 4 <= size && data[scanlineOffset] == 2 && data[scanlineOffset + 1] == 2 && !(data[scanlineOffset + 2] & 0x80);
+	};
+
+	// Every scanline takes 4 bytes at least, checked before reserving the offsets of a corrupt height.
+	if (static_cast<size_t>(height) > (size - offset) / 4)
+	{
+		std::cout << "[ERROR] RADIANCE HDR: Truncated file \"" << filepath << "\"." << std::endl;
+
+		file.close();
+
+		return false;
+	}
+
+	// Like "stbi_loadf", the whole image is flat when its first scanline is.
+	bool encodedImage = width >= MIN_ENCODED_WIDTH && width <= MAX_ENCODED_WIDTH && isEncoded(offset);
+
+	scanlineOffsets.reserve(static_cast<size_t>(height) + 1);
+	encodedScanlines.reserve(height);
+
+	for (int row = 0; row < height; ++row)
+	{
+		bool encoded = encodedImage && isEncoded(offset);
+
+		scanlineOffsets.push_back(offset);
+		encodedScanlines.push_back(encoded);
+
+		offset = encoded ? skipEncodedScanline(offset) : offset + static_cast<size_t>(width) * 4;
+
+		if (offset == 0 || offset > size)
+		{
+			std::cout << "[ERROR] RADIANCE HDR: Corrupt or truncated scanline " << row << " in \"" << filepath << "\"." << std::endl;
+
+			file.close();
+
+			return false;
+		}
+	}
+
+	scanlineOffsets.push_back(offset);
+
+	return true;
+}
+
+void RadianceHDR::decode(Format format, void* destination, ThreadPool& threadPool)
+{
+	size_t rowSize = static_cast<size_t>(width) * getTexelSize(format);
+	unsigned char* rows = static_cast<unsigned char*>(destination);
+
+	threadPool.parallelFor(0, height, 4, [this, format, rowSize, rows](int begin, int end)
+	{
+		std::vector<unsigned char> planes(4 * static_cast<size_t>(getPlaneSize()), 0);
+
+		for (int row = begin; row < end; ++row)
+		{
+			expandScanline(row, planes.data());
+
+			// The file starts with the top row.
+			convertScanline(format, planes.data(), rows + static_cast<size_t>(height - 1 - row) * rowSize);
+		}
+	});
+}
+
+size_t RadianceHDR::getDecodedSize(Format format)
+{
+	return static_cast<size_t>(width) * height * getTexelSize(format);
+}
+
+bool RadianceHDR::load(const std::string& filepath, Format format, ThreadPool& threadPool, int& width, int& height, std::vector<unsigned char>& data)
+{
+	RadianceHDR image;
+
+	if (!image.open(filepath))
+	{
+		return false;
+	}
+
+	width = image.getWidth();
+	height = image.getHeight();
+
+	data.resize(image.getDecodedSize(format));
+
+	image.decode(format, data.data(), threadPool);
+
+	return true;
+}
+
+int RadianceHDR::getTexelSize(Format format)
+{
+	switch (format)
+	{
+	case Format::RGB32F: return 3 * sizeof(float);
+	case Format::RGB16F: return 3 * sizeof(uint16_t);
+	default:             return 4;
+	}
+}
+
+bool RadianceHDR::readHeader(size_t& dataOffset)
+{
+	const char* data = reinterpret_cast<const char*>(file.getData());
+	size_t size = file.getSize();
+
+	// Lines end with '\n' only, the header with an empty one, followed by the resolution line.
+	auto readLine = [&](std::string& line)
+	{
+		const char* end = data ? static_cast<const char*>(std::memchr(data + dataOffset, '\n', size - dataOffset)) : nullptr;
+
+		if (!end)
+		{
+			return false;
+		}
+
+		line.assign(data + dataOffset, end);
+		dataOffset = static_cast<size_t>(end - data) + 1;
+
+		return true;
+	};
+
+	std::string line;
+
+	if (!readLine(line) || (line != "#?RADIANCE" && line != "#?RGBE"))
+	{
+		std::cout << "[ERROR] RADIANCE HDR: \"" << filepath << "\" isn't a Radiance HDR file." << std::endl;
+
+		return false;
+	}
+
+	bool supportedFormat = false;
+
+	while (readLine(line) && !line.empty())
+	{
+		supportedFormat = supportedFormat || line == PIXEL_FORMAT;
+	}
+
+	if (!supportedFormat)
+	{
+		std::cout << "[ERROR] RADIANCE HDR: Missing header or unsupported pixel format in \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	if (!readLine(line) || std::sscanf(line.c_str(), "-Y %d +X %d", &height, &width) != 2 || width <= 0 || height <= 0)
+	{
+		std::cout << "[ERROR] RADIANCE HDR: Unsupported resolution \"" << line << "\" in \"" << filepath << "\", only \"-Y height +X width\" is." << std::endl;
+
+		width = 0;
+		height = 0;
+
+		return false;
+	}
+
+	return true;
+}
+
+size_t RadianceHDR::skipEncodedScanline(size_t offset)
+{
+	const unsigned char* data = file.getData();
+	size_t size = file.getSize();
+
+	if (((data[offset + 2] << 8) | data[offset + 3]) != width)
+	{
+		return 0;
+	}
+
+	offset += 4;
+
+	for (int channel = 0; channel < 4; ++channel)
+	{
+		int x = 0;
+
+		while (x < width)
+		{
+			if (offset >= size)
+			{
+				return 0;
+			}
+
+			// Above 128, a run of the same byte. Otherwise that many bytes follow as they are.
+			int count = data[offset];
+			bool run = count > 128;
+
+			count = run ? count - 128 : count;
+
+			if (count == 0 || count > width - x)
+			{
+				return 0;
+			}
+
+			offset += run ? 2 : 1 + static_cast<size_t>(count);
+			x += count;
+		}
+	}
+
+	return offset <= size ? offset : 0;
+}
+
+void RadianceHDR::expandScanline(int row, unsigned char* planes)
+{
+	const unsigned char* data = file.getData() + scanlineOffsets[row];
+	int planeSize = getPlaneSize();
+
+	if (!encodedScanlines[row])
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				planes[channel * planeSize + x] = data[x * 4 + channel];
+			}
+		}
+
+		return;
+	}
+
+	// The runs were checked by "open".
+	data += 4;
+
+	for (int channel = 0; channel < 4; ++channel)
+	{
+		unsigned char* plane = planes + channel * planeSize;
+		int x = 0;
+
+		while (x < width)
+		{
+			int count = *data++;
+
+			if (count > 128)
+			{
+				count -= 128;
+
+				std::memset(plane + x, *data++, count);
+			}
+			else
+			{
+				std::memcpy(plane + x, data, count);
+
+				data += count;
+			}
+
+			x += count;
+		}
+	}
+}
+
+void RadianceHDR::convertScanline(Format format, const unsigned char* planes, unsigned char* destination)
+{
+	int planeSize = getPlaneSize();
+
+	const unsigned char* red = planes;
+	const unsigned char* green = planes + planeSize;
+	const unsigned char* blue = planes + 2 * planeSize;
+	const unsigned char* exponent = planes + 3 * planeSize;
+
+	if (format == Format::RGBE8)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			destination[x * 4 + 0] = red[x];
+			destination[x * 4 + 1] = green[x];
+			destination[x * 4 + 2] = blue[x];
+			destination[x * 4 + 3] = exponent[x];
+		}
+
+		return;
+	}
+
+	const float* exponentScales = getExponentScales();
+
+	float* floats = reinterpret_cast<float*>(destination);
+	uint16_t* halves = reinterpret_cast<uint16_t*>(destination);
+
+	// The lanes past the width (in the padding of the planes) are converted, but never written.
+	for (int x = 0; x < width; x += SIMD_LANES)
+	{
+		float scales[SIMD_LANES], reds[SIMD_LANES], greens[SIMD_LANES], blues[SIMD_LANES];
+
+		for (int i = 0; i < SIMD_LANES; ++i)
+		{
+			scales[i] = exponentScales[exponent[x + i]];
+			reds[i] = red[x + i];
+			greens[i] = green[x + i];
+			blues[i] = blue[x + i];
+		}
+
+		SIMDFloat scale = SIMDFloat::load(scales);
+
+		SIMDFloat r = SIMDFloat::load(reds) * scale;
+		SIMDFloat g = SIMDFloat::load(greens) * scale;
+		SIMDFloat b = SIMDFloat::load(blues) * scale;
+
+		int texels = std::min(SIMD_LANES, width - x);
+
+		if (format == Format::RGB32F)
+		{
+			r.store(reds);
+			g.store(greens);
+			b.store(blues);
+
+			for (int i = 0; i < texels; ++i)
+			{
+				floats[(x + i) * 3 + 0] = reds[i];
+				floats[(x + i) * 3 + 1] = greens[i];
+				floats[(x + i) * 3 + 2] = blues[i];
+			}
+		}
+		else
+		{
+			uint16_t redHalves[SIMD_LANES], greenHalves[SIMD_LANES], blueHalves[SIMD_LANES];
+
+			simdStoreHalf(r, redHalves);
+			simdStoreHalf(g, greenHalves);
+			simdStoreHalf(b, blueHalves);
+
+			for (int i = 0; i < texels; ++i)
+			{
+				halves[(x + i) * 3 + 0] = redHalves[i];
+				halves[(x + i) * 3 + 1] = greenHalves[i];
+				halves[(x + i) * 3 + 2] = blueHalves[i];
+			}
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#include "simd.h"
+#include "threadpool.h"
+#include "mappedfile.h"
+
+// Radiance ".hdr" (RGBE) images, decoded in parallel from the memory-mapped file.
+//
+// Every scanline is either flat (4 bytes per texel) or adaptive run-length encoded, one channel after the other, so
+// none can be decoded before the previous ones were skimmed to know where it starts. "open" does that once, serially,
+// only reading the run lengths, and keeps the offset of every scanline. "decode" then expands them on the thread pool,
+// a few rows per task, and converts the texels with "SIMD_LANES" wide operations straight into the destination (e.g. a
+// mapped pixel unpack buffer), with the first row at the bottom like every other image of the renderer.
+//
+// Same files as "stbi_loadf" (the "-Y height +X width" layout only), with the same float texels.
+//
+class RadianceHDR
+{
+public:
+	enum class Format
+	{
+		RGB32F, // 3 floats per texel, as "stbi_loadf" returns them.
+		RGB16F, // 3 half floats, ready for "GL_RGB16F" textures. Clamped to 65504, the largest half.
+		RGBE8   // The 4 bytes of the file, expanded only.
+	};
+
+	RadianceHDR();
+
+	RadianceHDR(const RadianceHDR&) = delete;
+	RadianceHDR& operator=(const RadianceHDR&) = delete;
+
+	// Maps the file, reads its header and indexes the scanlines, checking the runs fit in the image.
+	bool open(const std::string& filepath);
+
+	// Decodes every scanline into "destination", "getDecodedSize(format)" bytes with tightly packed rows.
+	void decode(Format format, void* destination, ThreadPool& threadPool);
+
+	int getWidth() { return width; }
+	int getHeight() { return height; }
+
+	size_t getDecodedSize(Format format);
+
+	// Opens and decodes "filepath" into "data".
+	static bool load(const std::string& filepath, Format format, ThreadPool& threadPool, int& width, int& height, std::vector<unsigned char>& data);
+
+	static int getTexelSize(Format format);
+
+private:
+	std::string filepath;
+	MappedFile file;
+	int width, height;
+	std::vector<size_t> scanlineOffsets; // One per row of the file (top to bottom), and the end of the last one.
+	std::vector<bool> encodedScanlines;
+
+	bool readHeader(size_t& dataOffset);
+
+	// Offset just past the run-length encoded scanline at "offset", or zero if its runs are corrupt.
+	size_t skipEncodedScanline(size_t offset);
+
+	// Expands the scanline into its 4 channel planes, each "getPlaneSize()" bytes.
+	void expandScanline(int row, unsigned char* planes);
+
+	void convertScanline(Format format, const unsigned char* planes, unsigned char* destination);
+
+	// Texels per channel plane, rounded up to whole SIMD iterations.
+	int getPlaneSize() { return (width + SIMD_LANES - 1) / SIMD_LANES * SIMD_LANES; }
+};
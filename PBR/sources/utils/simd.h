@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Thin wrapper over the widest float vector available at compile time:
+//
+//  - AVX:  8 lanes (__m256);
+//  - SSE2: 4 lanes (__m128), always available on x64;
+//  - otherwise a scalar fallback with a single lane.
+//
+// Kernels are written once in terms of "SIMDFloat" and process "SIMD_LANES" texels per iteration.
+//
+#if defined(__AVX__)
+#define SIMD_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE
+#include <emmintrin.h>
+#endif
+
+#if defined(SIMD_AVX) || defined(SIMD_SSE)
+// Float to half of positive values at most 65504, in the low 16 bits of each 32 bits lane (without F16C, which x64 doesn't
+// guarantee). Follows "float_to_half_fast3_rtne" of https://gist.github.com/rygorous/2156668.
+//
+inline __m128i simdFloatToHalf(__m128 a)
+{
+	const __m128i denormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+
+	__m128i bits = _mm_castps_si128(a);
+
+	// Below the smallest normal half (2^-14), adding the magic number lets the float addition round the mantissa where
+	// the denormal half keeps it.
+	__m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(a, _mm_castsi128_ps(denormalMagic))), denormalMagic);
+
+	// Otherwise the exponent is rebiased, and the mantissa rounded to nearest even before dropping its 13 low bits.
+	__m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+	__m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(bits, _mm_set1_epi32(static_cast<int>(((15u - 127u) << 23) + 0xfffu))), mantissaOdd), 13);
+
+	__m128i isDenormal = _mm_cmplt_epi32(bits, _mm_set1_epi32(113 << 23));
+
+	return _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal));
+}
+#endif
+
+#if defined(SIMD_AVX)
+
+constexpr int SIMD_LANES = 8;
+
+struct SIMDFloat
+{
+	__m256 v;
+
+	SIMDFloat() : v(_mm256_setzero_ps()) {}
+	SIMDFloat(__m256 v) : v(v) {}
+	SIMDFloat(float s) : v(_mm256_set1_ps(s)) {}
+
+	static SIMDFloat load(const float* p) { return _mm256_loadu_ps(p); }
+	void store(float* p) const { _mm256_storeu_ps(p, v); }
+};
+
+inline SIMDFloat operator+(SIMDFloat a, SIMDFloat b) { return _mm256_add_ps(a.v, b.v); }
+inline SIMDFloat operator-(SIMDFloat a, SIMDFloat b) { return _mm256_sub_ps(a.v, b.v); }
+inline SIMDFloat operator*(SIMDFloat a, SIMDFloat b) { return _mm256_mul_ps(a.v, b.v); }
+inline SIMDFloat operator/(SIMDFloat a, SIMDFloat b) { return _mm256_div_ps(a.v, b.v); }
+
+inline SIMDFloat simdMin(SIMDFloat a, SIMDFloat b) { return _mm256_min_ps(a.v, b.v); }
+inline SIMDFloat simdMax(SIMDFloat a, SIMDFloat b) { return _mm256_max_ps(a.v, b.v); }
+inline SIMDFloat simdSqrt(SIMDFloat a) { return _mm256_sqrt_ps(a.v); }
+
+// Returns "a" where "mask > 0.0", zero otherwise.
+inline SIMDFloat simdSelectPositive(SIMDFloat mask, SIMDFloat a) { return _mm256_and_ps(_mm256_cmp_ps(mask.v, _mm256_setzero_ps(), _CMP_GT_OQ), a.v); }
+
+// Stores the lanes as half floats, rounded to nearest even. The values must be positive or zero, the ones beyond the
+// largest half (65504) being clamped to it rather than becoming infinities.
+//
+inline void simdStoreHalf(SIMDFloat a, uint16_t* p)
+{
+	__m256 clamped = _mm256_min_ps(a.v, _mm256_set1_ps(65504.0f));
+
+	// MSVC has no "__F16C__", but every AVX2 CPU also has F16C.
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_cvtps_ph(clamped, _MM_FROUND_TO_NEAREST_INT));
+#else
+	// AVX alone has no 256 bits integer operations, each half of the lanes goes through the SSE2 conversion.
+	__m128i halves = _mm_packs_epi32(simdFloatToHalf(_mm256_castps256_ps128(clamped)), simdFloatToHalf(_mm256_extractf128_ps(clamped, 1)));
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(p), halves);
+#endif
+}
+
+#elif defined(SIMD_SSE)
+
+constexpr int SIMD_LANES = 4;
+
+struct SIMDFloat
+{
+	__m128 v;
+
+	SIMDFloat() : v(_mm_setzero_ps()) {}
+	SIMDFloat(__m128 v) : v(v) {}
+	SIMDFloat(float s) : v(_mm_set1_ps(s)) {}
+
+	static SIMDFloat load(const float* p) { return _mm_loadu_ps(p); }
+	void store(float* p) const { _mm_storeu_ps(p, v); }
+};
+
+inline SIMDFloat operator+(SIMDFloat a, SIMDFloat b) { return _mm_add_ps(a.v, b.v); }
+inline SIMDFloat operator-(SIMDFloat a, SIMDFloat b) { return _mm_sub_ps(a.v, b.v); }
+inline SIMDFloat operator*(SIMDFloat a, SIMDFloat b) { return _mm_mul_ps(a.v, b.v); }
+inline SIMDFloat operator/(SIMDFloat a, SIMDFloat b) { return _mm_div_ps(a.v, b.v); }
+
+inline SIMDFloat simdMin(SIMDFloat a, SIMDFloat b) { return _mm_min_ps(a.v, b.v); }
+inline SIMDFloat simdMax(SIMDFloat a, SIMDFloat b) { return _mm_max_ps(a.v, b.v); }
+inline SIMDFloat simdSqrt(SIMDFloat a) { return _mm_sqrt_ps(a.v); }
+
+// Returns "a" where "mask > 0.0", zero otherwise.
+inline SIMDFloat simdSelectPositive(SIMDFloat mask, SIMDFloat a) { return _mm_and_ps(_mm_cmpgt_ps(mask.v, _mm_setzero_ps()), a.v); }
+
+// Stores the lanes as half floats, rounded to nearest even. The values must be positive or zero, the ones beyond the
+// largest half (65504) being clamped to it rather than becoming infinities.
+//
+inline void simdStoreHalf(SIMDFloat a, uint16_t* p)
+{
+	__m128i halves = simdFloatToHalf(_mm_min_ps(a.v, _mm_set1_ps(65504.0f)));
+
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packs_epi32(halves, halves));
+}
+
+#else
+
+constexpr int SIMD_LANES = 1;
+
+struct SIMDFloat
+{
+	float v;
+
+	SIMDFloat() : v(0.0f) {}
+	SIMDFloat(float s) : v(s) {}
+
+	static SIMDFloat load(const float* p) { return *p; }
+	void store(float* p) const { *p = v; }
+};
+
+inline SIMDFloat operator+(SIMDFloat a, SIMDFloat b) { return a.v + b.v; }
+inline SIMDFloat operator-(SIMDFloat a, SIMDFloat b) { return a.v - b.v; }
+inline SIMDFloat operator*(SIMDFloat a, SIMDFloat b) { return a.v * b.v; }
+inline SIMDFloat operator/(SIMDFloat a, SIMDFloat b) { return a.v / b.v; }
+
+inline SIMDFloat simdMin(SIMDFloat a, SIMDFloat b) { return a.v < b.v ? a.v : b.v; }
+inline SIMDFloat simdMax(SIMDFloat a, SIMDFloat b) { return a.v > b.v ? a.v : b.v; }
+inline SIMDFloat simdSqrt(SIMDFloat a) { return std::sqrt(a.v); }
+
+// Returns "a" where "mask > 0.0", zero otherwise.
+inline SIMDFloat simdSelectPositive(SIMDFloat mask, SIMDFloat a) { return mask.v > 0.0f ? a.v : 0.0f; }
+
+// Same bit manipulations as "simdFloatToHalf", one value at a time.
+inline void simdStoreHalf(SIMDFloat a, uint16_t* p)
+{
+	const uint32_t denormalMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+
+	float clamped = a.v < 65504.0f ? a.v : 65504.0f;
+	uint32_t bits;
+
+	std::memcpy(&bits, &clamped, sizeof(bits));
+
+	if (bits < (113u << 23))
+	{
+		float magic, sum;
+
+		std::memcpy(&magic, &denormalMagic, sizeof(magic));
+
+		sum = clamped + magic;
+
+		std::memcpy(&bits, &sum, sizeof(bits));
+
+		*p = static_cast<uint16_t>(bits - denormalMagic);
+	}
+	else
+	{
+		*p = static_cast<uint16_t>((bits + ((15u - 127u) << 23) + 0xfffu + ((bits >> 13) & 1u)) >> 13);
+	}
+}
+
+#endif
+
+inline SIMDFloat& operator+=(SIMDFloat& a, SIMDFloat b) { a = a + b; return a; }
+inline SIMDFloat& operator*=(SIMDFloat& a, SIMDFloat b) { a = a * b; return a; }
+
+// Structure of arrays 3D vector, one direction per lane.
+struct SIMDVec3
+{
+	SIMDFloat x, y, z;
+};
+
+inline SIMDFloat simdDot(const SIMDVec3& a, const SIMDVec3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline SIMDVec3 simdCross(const SIMDVec3& a, const SIMDVec3& b)
+{
+	return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+inline SIMDVec3 simdNormalize(const SIMDVec3& a)
+{
+	SIMDFloat inverseLength = SIMDFloat(1.0f) / simdSqrt(simdDot(a, a));
+
+	return { a.x * inverseLength, a.y * inverseLength, a.z * inverseLength };
+}
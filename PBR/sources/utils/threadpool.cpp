@@ -0,0 +1,190 @@
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(unsigned int numberOfThreads)
+	: pendingTasks(0), nextQueue(0), running(true)
+{
+	if (numberOfThreads == 0)
+	{
+		// Keep one hardware thread free for the thread that owns the OpenGL context.
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+
+		numberOfThreads = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	for (unsigned int i = 0; i < numberOfThreads; ++i)
+	{
+		queues.push_back(new WorkQueue());
+	}
+
+	for (unsigned int i = 0; i < numberOfThreads; ++i)
+	{
+		workers.emplace_back(&ThreadPool::workerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+
+		running = false;
+	}
+
+	sleepCondition.notify_all();
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	for (WorkQueue* queue : queues)
+	{
+		delete queue;
+	}
+}
+
+unsigned int ThreadPool::getNumberOfThreads()
+{
+	return static_cast<unsigned int>(workers.size());
+}
+
+void ThreadPool::submit(const std::function<void()>& task)
+{
+	unsigned int queueIndex = nextQueue.fetch_add(1) % queues.size();
+
+	{
+		std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+
+		queues[queueIndex]->tasks.push_back(task);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+
+		pendingTasks.fetch_add(1);
+	}
+
+	sleepCondition.notify_one();
+}
+
+void ThreadPool::parallelFor(int begin, int end, int grainSize, const std::function<void(int, int)>& task)
+{
+	if (end <= begin)
+	{
+		return;
+	}
+
+	grainSize = std::max(grainSize, 1);
+
+	// The chunks are spread over all the worker queues, and idle workers steal from the busy ones.
+	// The calling thread also executes chunks while it waits, so nested calls can't deadlock the pool.
+	//
+	std::atomic<int> remainingChunks((end - begin + grainSize - 1) / grainSize);
+
+	for (int chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize)
+	{
+		int chunkEnd = std::min(chunkBegin + grainSize, end);
+
+		submit([&task, &remainingChunks, chunkBegin, chunkEnd]()
+		{
+			task(chunkBegin, chunkEnd);
+
+			remainingChunks.fetch_sub(1);
+		});
+	}
+
+	std::function<void()> stolenTask;
+
+	while (remainingChunks.load() > 0)
+	{
+		if (stealTask(static_cast<unsigned int>(queues.size()), stolenTask))
+		{
+			stolenTask();
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+ThreadPool& ThreadPool::getInstance()
+{
+	static ThreadPool instance;
+
+	return instance;
+}
+
+void ThreadPool::workerLoop(unsigned int workerIndex)
+{
+	std::function<void()> task;
+
+	while (true)
+	{
+		if (popTask(workerIndex, task) || stealTask(workerIndex, task))
+		{
+			task();
+
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+
+		sleepCondition.wait(lock, [this]() { return pendingTasks.load() > 0 || !running; });
+
+		if (!running && pendingTasks.load() == 0)
+		{
+			return;
+		}
+	}
+}
+
+bool ThreadPool::popTask(unsigned int queueIndex, std::function<void()>& task)
+{
+	WorkQueue* queue = queues[queueIndex];
+	std::lock_guard<std::mutex> lock(queue->mutex);
+
+	if (queue->tasks.empty())
+	{
+		return false;
+	}
+
+	task = std::move(queue->tasks.back());
+	queue->tasks.pop_back();
+
+	pendingTasks.fetch_sub(1);
+
+	return true;
+}
+
+bool ThreadPool::stealTask(unsigned int thiefIndex, std::function<void()>& task)
+{
+	unsigned int numberOfQueues = static_cast<unsigned int>(queues.size());
+
+	for (unsigned int i = 1; i <= numberOfQueues; ++i)
+	{
+		unsigned int victimIndex = (thiefIndex + i) % numberOfQueues;
+
+		if (victimIndex == thiefIndex)
+		{
+			continue;
+		}
+
+		WorkQueue* queue = queues[victimIndex];
+		std::unique_lock<std::mutex> lock(queue->mutex, std::try_to_lock);
+
+		if (!lock.owns_lock() || queue->tasks.empty())
+		{
+			continue;
+		}
+
+		task = std::move(queue->tasks.front());
+		queue->tasks.pop_front();
+
+		pendingTasks.fetch_sub(1);
+
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <mutex>
+#include <algorithm>
+#include <deque>
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+class ThreadPool
+{
+public:
+	ThreadPool(unsigned int numberOfThreads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	unsigned int getNumberOfThreads();
+
+	void submit(const std::function<void()>& task);
+	void parallelFor(int begin, int end, int grainSize, const std::function<void(int, int)>& task);
+
+	static ThreadPool& getInstance();
+
+private:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::thread> workers;
+	std::vector<WorkQueue*> queues;
+
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+
+	std::atomic<int> pendingTasks;
+	std::atomic<unsigned int> nextQueue;
+	std::atomic<bool> running;
+
+	void workerLoop(unsigned int workerIndex);
+
+	bool popTask(unsigned int queueIndex, std::function<void()>& task);
+	bool stealTask(unsigned int thiefIndex, std::function<void()>& task);
+};
@@ -0,0 +1,237 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../sources/graphics/clusteredlighting.h"
+#include "../sources/utils/threadpool.h"
+
+// GPU-free check of "ClusteredLighting::binLights": no context is created, so no OpenGL function is ever called.
+//
+// Every cluster's lists are compared against a brute force pass over the lights, with bounds and overlap tests written
+// independently of the binning. Lights whose sphere grazes the cluster box within "EPSILON" may be binned or not.
+//
+
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE  = 100.0f;
+const float EPSILON    = 1e-3f; // Relative to the squared radius.
+
+struct TestCase
+{
+	const char* name;
+	int numberOfLights;
+	int maxLightsPerCluster;
+	float minRadius, maxRadius;
+	bool expectOverflow; // At least one cluster must overlap more lights than it can hold.
+};
+
+CameraData createCamera(int width, int height)
+{
+	CameraData cameraData;
+
+	cameraData.projection = glm::perspective(glm::radians(45.0f), float(width) / float(height), NEAR_PLANE, FAR_PLANE);
+	cameraData.view = glm::lookAt(glm::vec3(4.0f, 3.0f, 12.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	cameraData.inverseProjection = glm::inverse(cameraData.projection);
+	cameraData.position = glm::vec4(4.0f, 3.0f, 12.0f, 1.0f);
+	cameraData.viewport = glm::vec4(width, height, NEAR_PLANE, FAR_PLANE);
+
+	return cameraData;
+}
+
+// Same parameters as "ClusteredLighting::getLightData", which needs the storage buffers of an instance.
+LightData createLightData(int sizeX, int sizeY, int sizeZ, int maxLightsPerCluster, int numberOfLights)
+{
+	float logDepthRange = std::log(FAR_PLANE / NEAR_PLANE);
+
+	LightData lightData;
+
+	lightData.clusterGrid = glm::uvec4(sizeX, sizeY, sizeZ, maxLightsPerCluster);
+	lightData.clusterDepth = glm::vec4(sizeZ / logDepthRange, -sizeZ * std::log(NEAR_PLANE) / logDepthRange, 0.0f, 0.0f);
+	lightData.count = glm::ivec4(numberOfLights, 0, 0, 0);
+
+	return lightData;
+}
+
+// Fixed seed, so every run bins the same lights.
+std::vector<PointLight> createLights(int numberOfLights, float minRadius, float maxRadius)
+{
+	std::mt19937 generator(1234);
+	std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+	std::uniform_real_distribution<float> radius(minRadius, maxRadius);
+
+	std::vector<PointLight> lights(numberOfLights);
+
+	for (PointLight& light : lights)
+	{
+		light.positionRadius = glm::vec4(position(generator), position(generator) * 0.5f, position(generator), radius(generator));
+		light.color = glm::vec4(1.0f);
+	}
+
+	return lights;
+}
+
+// View space box of a cluster, from the eight corners of its frustum: the screen tile unprojected, then scaled to the slice depths.
+void computeExpectedBounds(const CameraData& cameraData, const glm::uvec4& grid, int cluster, glm::vec3& aabbMin, glm::vec3& aabbMax)
+{
+	int x = cluster % grid.x;
+	int y = (cluster / grid.x) % grid.y;
+	int z = cluster / (grid.x * grid.y);
+
+	float sliceDepths[2] = {
+		NEAR_PLANE * std::pow(FAR_PLANE / NEAR_PLANE, float(z) / grid.z),
+		NEAR_PLANE * std::pow(FAR_PLANE / NEAR_PLANE, float(z + 1) / grid.z)
+	};
+
+	aabbMin = glm::vec3(INFINITY);
+	aabbMax = glm::vec3(-INFINITY);
+
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		float ndcX = float(x + (corner & 1)) / grid.x * 2.0f - 1.0f;
+		float ndcY = float(y + ((corner >> 1) & 1)) / grid.y * 2.0f - 1.0f;
+
+		glm::vec4 ray = cameraData.inverseProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+		glm::vec3 direction = glm::vec3(ray) / ray.w;
+
+		glm::vec3 point = direction * (sliceDepths[corner >> 2] / -direction.z);
+
+		aabbMin = glm::min(aabbMin, point);
+		aabbMax = glm::max(aabbMax, point);
+	}
+}
+
+// Squared distance from the center to the box, accumulated per axis.
+float computeSquaredDistance(const glm::vec3& center, const glm::vec3& aabbMin, const glm::vec3& aabbMax)
+{
+	float distance = 0.0f;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		float outside = std::max(std::max(aabbMin[axis] - center[axis], center[axis] - aabbMax[axis]), 0.0f);
+
+		distance += outside * outside;
+	}
+
+	return distance;
+}
+
+bool runTestCase(const TestCase& testCase, ThreadPool& threadPool)
+{
+	CameraData cameraData = createCamera(1280, 720);
+	LightData lightData = createLightData(16, 9, 24, testCase.maxLightsPerCluster, testCase.numberOfLights);
+	std::vector<PointLight> lights = createLights(testCase.numberOfLights, testCase.minRadius, testCase.maxRadius);
+
+	std::vector<uint32_t> lightCounts, lightIndices;
+
+	ClusteredLighting::binLights(cameraData, lightData, lights, threadPool, lightCounts, lightIndices);
+
+	int numberOfClusters = 16 * 9 * 24;
+	uint32_t maxLightsPerCluster = lightData.clusterGrid.w;
+
+	if (lightCounts.size() != size_t(numberOfClusters) || lightIndices.size() != size_t(numberOfClusters) * maxLightsPerCluster)
+	{
+		std::cout << "[ERROR] " << testCase.name << ": " << lightCounts.size() << " counts and " << lightIndices.size() << " indices returned." << std::endl;
+
+		return false;
+	}
+
+	int failures = 0, overflows = 0, binnedLights = 0;
+
+	for (int cluster = 0; cluster < numberOfClusters; ++cluster)
+	{
+		glm::vec3 aabbMin, aabbMax;
+
+		computeExpectedBounds(cameraData, lightData.clusterGrid, cluster, aabbMin, aabbMax);
+
+		// Certainly overlapping, and overlapping within the tolerance.
+		std::vector<bool> inside(lights.size()), touching(lights.size());
+		uint32_t numberOfOverlaps = 0;
+
+		for (size_t i = 0; i < lights.size(); ++i)
+		{
+			glm::vec3 center = glm::vec3(cameraData.view * glm::vec4(glm::vec3(lights[i].positionRadius), 1.0f));
+			float squaredRadius = lights[i].positionRadius.w * lights[i].positionRadius.w;
+			float squaredDistance = computeSquaredDistance(center, aabbMin, aabbMax);
+
+			inside[i] = squaredDistance <= squaredRadius * (1.0f - EPSILON);
+			touching[i] = squaredDistance <= squaredRadius * (1.0f + EPSILON);
+
+			numberOfOverlaps += inside[i] ? 1 : 0;
+		}
+
+		uint32_t count = lightCounts[cluster];
+		const uint32_t* indices = &lightIndices[size_t(cluster) * maxLightsPerCluster];
+
+		bool full = count == maxLightsPerCluster;
+		bool valid = count <= maxLightsPerCluster;
+
+		// Binned in increasing order (the order of the compute shader), and all overlapping.
+		for (uint32_t i = 0; i < count && valid; ++i)
+		{
+			valid = indices[i] < lights.size() && touching[indices[i]] && (i == 0 || indices[i] > indices[i - 1]);
+		}
+
+		// None missing: every overlapping light when the cluster isn't full, the ones before the last binned one otherwise.
+		uint32_t lastIndex = (full && count > 0) ? indices[count - 1] : uint32_t(lights.size());
+		uint32_t position = 0;
+
+		for (uint32_t i = 0; i < lastIndex && valid; ++i)
+		{
+			while (position < count && indices[position] < i)
+			{
+				++position;
+			}
+
+			valid = !inside[i] || (position < count && indices[position] == i);
+		}
+
+		overflows += numberOfOverlaps > maxLightsPerCluster ? 1 : 0;
+		binnedLights += count;
+
+		if (!valid)
+		{
+			if (failures++ < 8)
+			{
+				std::cout << "[ERROR] " << testCase.name << ": cluster " << cluster << " binned " << count << " light(s), " << numberOfOverlaps << " overlapping." << std::endl;
+			}
+		}
+	}
+
+	if (testCase.expectOverflow && overflows == 0)
+	{
+		std::cout << "[ERROR] " << testCase.name << ": no cluster overlaps more than " << maxLightsPerCluster << " lights, the limit isn't exercised." << std::endl;
+
+		failures++;
+	}
+
+	std::cout << "[" << (failures == 0 ? "PASSED" : "FAILED") << "] " << testCase.name << ": " << testCase.numberOfLights << " lights, " << binnedLights
+		<< " binned over " << numberOfClusters << " clusters (" << overflows << " over the limit of " << maxLightsPerCluster << ")." << std::endl;
+
+	return failures == 0;
+}
+
+int main()
+{
+	const TestCase testCases[] = {
+		{ "no_lights",            0,    256, 1.0f, 4.0f,  false },
+		{ "sparse_lights",        64,   256, 0.5f, 3.0f,  false },
+		{ "dense_lights",         1024, 256, 1.0f, 6.0f,  false },
+		{ "over_max_per_cluster", 512,  16,  4.0f, 12.0f, true  }
+	};
+
+	ThreadPool threadPool;
+
+	bool success = true;
+
+	for (const TestCase& testCase : testCases)
+	{
+		success = runTestCase(testCase, threadPool) && success;
+	}
+
+	return success ? 0 : -1;
+}